@@ -99,9 +99,14 @@ enum
   PROP_DEFAULT_GRID,
   PROP_UNDO_LEVELS,
   PROP_UNDO_SIZE,
+  PROP_UNDO_COMPRESSION,
+  PROP_UNDO_SWAP_SIZE,
   PROP_UNDO_PREVIEW_SIZE,
+  PROP_BRUSH_CACHE_SIZE,
   PROP_FILTER_HISTORY_SIZE,
   PROP_PLUGINRC_PATH,
+  PROP_PLUG_IN_WORKERS,
+  PROP_PLUG_IN_WORKER_TIMEOUT,
   PROP_LAYER_PREVIEWS,
   PROP_GROUP_LAYER_PREVIEWS,
   PROP_LAYER_PREVIEW_SIZE,
@@ -114,6 +119,9 @@ enum
   PROP_IMPORT_PROMOTE_DITHER,
   PROP_IMPORT_ADD_ALPHA,
   PROP_IMPORT_RAW_PLUG_IN,
+  PROP_XCF_ZSTD_LEVEL,
+  PROP_XCF_LAZY_LOAD,
+  PROP_XCF_INCREMENTAL_SAVE,
   PROP_EXPORT_FILE_TYPE,
   PROP_EXPORT_COLOR_PROFILE,
   PROP_EXPORT_COMMENT,
@@ -586,6 +594,20 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                             GIMP_PARAM_STATIC_STRINGS |
                             GIMP_CONFIG_PARAM_CONFIRM);
 
+  GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_UNDO_COMPRESSION,
+                            "undo-compression",
+                            "Undo compression",
+                            UNDO_COMPRESSION_BLURB,
+                            FALSE,
+                            GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_MEMSIZE (object_class, PROP_UNDO_SWAP_SIZE,
+                            "undo-swap-size",
+                            "Undo swap size",
+                            UNDO_SWAP_SIZE_BLURB,
+                            0, GIMP_MAX_MEMSIZE, 0,
+                            GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_ENUM (object_class, PROP_UNDO_PREVIEW_SIZE,
                          "undo-preview-size",
                          "Undo preview size",
@@ -595,6 +617,13 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                          GIMP_PARAM_STATIC_STRINGS |
                          GIMP_CONFIG_PARAM_RESTART);
 
+  GIMP_CONFIG_PROP_MEMSIZE (object_class, PROP_BRUSH_CACHE_SIZE,
+                            "brush-cache-size",
+                            "Brush cache size",
+                            BRUSH_CACHE_SIZE_BLURB,
+                            0, GIMP_MAX_MEMSIZE, 1 << 26, /* 64MB */
+                            GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_INT (object_class, PROP_FILTER_HISTORY_SIZE,
                         "plug-in-history-size", /* compat name */
                         "Filter history size",
@@ -613,6 +642,20 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                          GIMP_PARAM_STATIC_STRINGS |
                          GIMP_CONFIG_PARAM_RESTART);
 
+  GIMP_CONFIG_PROP_INT (object_class, PROP_PLUG_IN_WORKERS,
+                        "plug-in-workers",
+                        "Plug-in workers",
+                        PLUG_IN_WORKERS_BLURB,
+                        0, 64, 0,
+                        GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_INT (object_class, PROP_PLUG_IN_WORKER_TIMEOUT,
+                        "plug-in-worker-timeout",
+                        "Plug-in worker timeout",
+                        PLUG_IN_WORKER_TIMEOUT_BLURB,
+                        1, 3600, 60,
+                        GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_LAYER_PREVIEWS,
                             "layer-previews",
                             "Layer previews",
@@ -744,6 +787,27 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                          GIMP_PARAM_STATIC_STRINGS |
                          GIMP_CONFIG_PARAM_RESTART);
 
+  GIMP_CONFIG_PROP_INT (object_class, PROP_XCF_ZSTD_LEVEL,
+                        "xcf-zstd-level",
+                        "XCF zstd compression level",
+                        XCF_ZSTD_LEVEL_BLURB,
+                        0, 19, 0,
+                        GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_XCF_LAZY_LOAD,
+                            "xcf-lazy-load",
+                            "Load XCF pixels on demand",
+                            XCF_LAZY_LOAD_BLURB,
+                            FALSE,
+                            GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_XCF_INCREMENTAL_SAVE,
+                            "xcf-incremental-save",
+                            "Save XCF files incrementally",
+                            XCF_INCREMENTAL_SAVE_BLURB,
+                            TRUE,
+                            GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_ENUM (object_class, PROP_EXPORT_FILE_TYPE,
                          "export-file-type",
                          "Default export file type",
@@ -1105,9 +1169,24 @@ gimp_core_config_set_property (GObject      *object,
     case PROP_UNDO_SIZE:
       core_config->undo_size = g_value_get_uint64 (value);
       break;
+    case PROP_UNDO_COMPRESSION:
+      core_config->undo_compression = g_value_get_boolean (value);
+      break;
+    case PROP_UNDO_SWAP_SIZE:
+      core_config->undo_swap_size = g_value_get_uint64 (value);
+      break;
     case PROP_UNDO_PREVIEW_SIZE:
       core_config->undo_preview_size = g_value_get_enum (value);
       break;
+    case PROP_BRUSH_CACHE_SIZE:
+      core_config->brush_cache_size = g_value_get_uint64 (value);
+      break;
+    case PROP_PLUG_IN_WORKERS:
+      core_config->plug_in_workers = g_value_get_int (value);
+      break;
+    case PROP_PLUG_IN_WORKER_TIMEOUT:
+      core_config->plug_in_worker_timeout = g_value_get_int (value);
+      break;
     case PROP_PLUGINRC_PATH:
       g_set_str (&core_config->plug_in_rc_path,
                  g_value_get_string (value));
@@ -1181,6 +1260,15 @@ gimp_core_config_set_property (GObject      *object,
       g_set_str (&core_config->import_raw_plug_in,
                  g_value_get_string (value));
       break;
+    case PROP_XCF_ZSTD_LEVEL:
+      core_config->xcf_zstd_level = g_value_get_int (value);
+      break;
+    case PROP_XCF_LAZY_LOAD:
+      core_config->xcf_lazy_load = g_value_get_boolean (value);
+      break;
+    case PROP_XCF_INCREMENTAL_SAVE:
+      core_config->xcf_incremental_save = g_value_get_boolean (value);
+      break;
     case PROP_EXPORT_FILE_TYPE:
       core_config->export_file_type = g_value_get_enum (value);
       break;
@@ -1389,12 +1477,27 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_UNDO_SIZE:
       g_value_set_uint64 (value, core_config->undo_size);
       break;
+    case PROP_UNDO_COMPRESSION:
+      g_value_set_boolean (value, core_config->undo_compression);
+      break;
+    case PROP_UNDO_SWAP_SIZE:
+      g_value_set_uint64 (value, core_config->undo_swap_size);
+      break;
     case PROP_UNDO_PREVIEW_SIZE:
       g_value_set_enum (value, core_config->undo_preview_size);
       break;
+    case PROP_BRUSH_CACHE_SIZE:
+      g_value_set_uint64 (value, core_config->brush_cache_size);
+      break;
     case PROP_PLUGINRC_PATH:
       g_value_set_string (value, core_config->plug_in_rc_path);
       break;
+    case PROP_PLUG_IN_WORKERS:
+      g_value_set_int (value, core_config->plug_in_workers);
+      break;
+    case PROP_PLUG_IN_WORKER_TIMEOUT:
+      g_value_set_int (value, core_config->plug_in_worker_timeout);
+      break;
     case PROP_LAYER_PREVIEWS:
       g_value_set_boolean (value, core_config->layer_previews);
       break;
@@ -1452,6 +1555,15 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_IMPORT_RAW_PLUG_IN:
       g_value_set_string (value, core_config->import_raw_plug_in);
       break;
+    case PROP_XCF_ZSTD_LEVEL:
+      g_value_set_int (value, core_config->xcf_zstd_level);
+      break;
+    case PROP_XCF_LAZY_LOAD:
+      g_value_set_boolean (value, core_config->xcf_lazy_load);
+      break;
+    case PROP_XCF_INCREMENTAL_SAVE:
+      g_value_set_boolean (value, core_config->xcf_incremental_save);
+      break;
     case PROP_EXPORT_FILE_TYPE:
       g_value_set_enum (value, core_config->export_file_type);
       break;
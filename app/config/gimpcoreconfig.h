@@ -82,9 +82,14 @@ struct _GimpCoreConfig
   GimpGrid               *default_grid;
   gint                    levels_of_undo;
   guint64                 undo_size;
+  gboolean                undo_compression;
+  guint64                 undo_swap_size;
   GimpViewSize            undo_preview_size;
+  guint64                 brush_cache_size;
   gint                    filter_history_size;
   gchar                  *plug_in_rc_path;
+  gint                    plug_in_workers;
+  gint                    plug_in_worker_timeout;
   gboolean                layer_previews;
   gboolean                group_layer_previews;
   GimpViewSize            layer_preview_size;
@@ -97,6 +102,9 @@ struct _GimpCoreConfig
   gboolean                import_promote_dither;
   gboolean                import_add_alpha;
   gchar                  *import_raw_plug_in;
+  gint                    xcf_zstd_level;
+  gboolean                xcf_lazy_load;
+  gboolean                xcf_incremental_save;
   GimpExportFileType      export_file_type;
   gboolean                export_color_profile;
   gboolean                export_comment;
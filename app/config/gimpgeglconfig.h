@@ -40,6 +40,7 @@ struct _GimpGeglConfig
   gint      num_processors;
   guint64   tile_cache_size;
   gboolean  use_opencl;
+  gboolean  threaded_projection;
 };
 
 struct _GimpGeglConfigClass
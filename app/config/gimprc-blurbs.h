@@ -12,6 +12,11 @@ _("When enabled, an image will become the active image when its image " \
   "window receives the focus. This is useful for window managers using " \
   "\"click to focus\".")
 
+#define BRUSH_CACHE_SIZE_BLURB \
+_("Sets the amount of memory used to keep scaled and rotated copies " \
+  "of the brush in use.  Painting with dynamics which vary the brush " \
+  "size or angle is faster when more copies fit.")
+
 #define BRUSH_PATH_BLURB \
 "Sets the brush search path."
 
@@ -227,6 +232,23 @@ _("Add an alpha channel to all layers of imported images.")
 #define IMPORT_RAW_PLUG_IN_BLURB \
 _("Which plug-in to use for importing raw digital camera files.")
 
+#define XCF_ZSTD_LEVEL_BLURB \
+_("When saving compressed XCF files, use Zstandard compression at this " \
+  "level instead of zlib.  A value of 0 keeps using zlib, which older " \
+  "versions of GIMP can read.")
+
+#define XCF_LAZY_LOAD_BLURB \
+_("When opening XCF files, read the pixels of layers and channels only " \
+  "when they are first needed, instead of all of them up front.  This " \
+  "makes opening large files faster, but the file must stay unmodified " \
+  "while the image is open.")
+
+#define XCF_INCREMENTAL_SAVE_BLURB \
+_("When saving an XCF file, copy the pixel data which didn't change " \
+  "since the image was last saved from the previous version of the " \
+  "file, instead of compressing it again.  This makes saving large " \
+  "images much faster.")
+
 #define EXPORT_FILE_TYPE_BLURB \
 _("Export file type used by default.")
 
@@ -374,6 +396,15 @@ _("Sets how many threads GIMP should use for operations that support it.")
 #define PLUGINRC_PATH_BLURB \
 "Sets the pluginrc search path."
 
+#define PLUG_IN_WORKERS_BLURB \
+"How many plug-ins which support it are kept running after they return, " \
+"to serve later calls without being started again.  A value of 0 " \
+"disables this."
+
+#define PLUG_IN_WORKER_TIMEOUT_BLURB \
+"How many seconds a plug-in kept running may stay unused before it is " \
+"stopped."
+
 #define LAYER_PREVIEWS_BLURB \
 _("Sets whether GIMP should create previews of layers and channels. " \
   "Previews in the layers and channels dialog are nice to have but they " \
@@ -728,6 +759,14 @@ _("Sets the default border style for the 'Border Selection' dialog.")
 #define STROKE_OPTIONS_BLURB \
 "The default stroke options for the stroke dialogs."
 
+#define THREADED_PROJECTION_BLURB \
+_("When enabled, the tiles of each area of the image being rendered " \
+  "for display are rendered concurrently, using the threads set by " \
+  "num-processors.  This is experimental: it relies on all the " \
+  "operations in the image's layer stack being able to process disjoint " \
+  "areas at the same time, which is true of GEGL's own operations, but " \
+  "not necessarily of third-party ones.")
+
 #define THUMBNAIL_SIZE_BLURB \
 _("Sets the size of the thumbnail shown in the Open dialog.")
 
@@ -783,6 +822,15 @@ _("Sets an upper limit to the memory that is used per image to keep " \
   "operations on the undo stack. Regardless of this setting, at least " \
   "as many undo-levels as configured can be undone.")
 
+#define UNDO_COMPRESSION_BLURB \
+_("When enabled, the pixel data of older undo steps is compressed in the " \
+  "background, so that more steps fit into the undo-size limit.")
+
+#define UNDO_SWAP_SIZE_BLURB \
+_("Sets the disk space per image to which the oldest undo steps are " \
+  "swapped out once the undo-size limit is reached, instead of being " \
+  "discarded. Set to 0 to disable swapping undo steps.")
+
 #define UNDO_PREVIEW_SIZE_BLURB \
 _("Sets the size of the previews in the Undo History.")
 
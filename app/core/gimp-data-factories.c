@@ -35,6 +35,7 @@
 #include "gimpcontainer.h"
 #include "gimpbrush-load.h"
 #include "gimpbrush.h"
+#include "gimpbrushcache.h"
 #include "gimpbrushclipboard.h"
 #include "gimpbrushgenerated-load.h"
 #include "gimpbrushpipe-load.h"
@@ -60,6 +61,9 @@
 #include "gimp-intl.h"
 
 
+static void   gimp_data_factories_notify_brush_cache_size (GimpCoreConfig *config);
+
+
 void
 gimp_data_factories_init (Gimp *gimp)
 {
@@ -289,6 +293,13 @@ gimp_data_factories_exit (Gimp *gimp)
 {
   g_return_if_fail (GIMP_IS_GIMP (gimp));
 
+  if (gimp->config)
+    {
+      g_signal_handlers_disconnect_by_func (gimp->config,
+                                            (gpointer) gimp_data_factories_notify_brush_cache_size,
+                                            NULL);
+    }
+
   g_clear_object (&gimp->brush_factory);
   g_clear_object (&gimp->dynamics_factory);
   g_clear_object (&gimp->mybrush_factory);
@@ -354,6 +365,12 @@ gimp_data_factories_load (Gimp               *gimp,
 {
   g_return_if_fail (GIMP_IS_GIMP (gimp));
 
+  gimp_data_factories_notify_brush_cache_size (gimp->config);
+
+  g_signal_connect (gimp->config, "notify::brush-cache-size",
+                    G_CALLBACK (gimp_data_factories_notify_brush_cache_size),
+                    NULL);
+
   /*  initialize the list of gimp brushes    */
   status_callback (NULL, _("Brushes"), 0.1);
   gimp_data_factory_data_init (gimp->brush_factory, gimp->user_context,
@@ -440,3 +457,12 @@ gimp_data_factories_save (Gimp *gimp)
 
   gimp_palettes_save (gimp);
 }
+
+
+/*  private functions  */
+
+static void
+gimp_data_factories_notify_brush_cache_size (GimpCoreConfig *config)
+{
+  gimp_brush_cache_set_max_memsize (config->brush_cache_size);
+}
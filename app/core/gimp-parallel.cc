@@ -46,7 +46,7 @@ extern "C"
 
 
 #define GIMP_PARALLEL_MAX_THREADS           64
-#define GIMP_PARALLEL_RUN_ASYNC_MAX_THREADS  1
+#define GIMP_PARALLEL_RUN_ASYNC_MAX_THREADS GIMP_PARALLEL_MAX_THREADS
 
 
 typedef struct
@@ -58,11 +58,33 @@ typedef struct
   GDestroyNotify    user_data_destroy_func;
 } GimpParallelRunAsyncTask;
 
+typedef struct
+{
+  GimpParallelRunAsyncTask *task;
+
+  /* number of predecessors which haven't stopped yet, plus one while the
+   * predecessors are being registered
+   */
+  gint                      n_pending;
+  gint                      n_aborted;
+} GimpParallelRunAsyncDeferredTask;
+
 typedef struct
 {
   GThread   *thread;
+  gint       index;
+
+  /* each thread owns a priority-ordered deque of tasks, protected by its own
+   * mutex.  idle threads steal tasks from the other threads' deques.
+   */
+  GMutex     mutex;
+  GCond      cond;
+  GQueue     queue;
 
   gboolean   quit;
+  gboolean   wakeup;
+  gint       idle;
+  gint       n_queued;
 
   GimpAsync *current_async;
 } GimpParallelRunAsyncThread;
@@ -70,20 +92,35 @@ typedef struct
 
 /*  local function prototypes  */
 
-static void                       gimp_parallel_notify_num_processors   (GimpGeglConfig             *config);
-
-static void                       gimp_parallel_set_n_threads           (gint                        n_threads,
-                                                                         gboolean                    finish_tasks);
-
-static void                       gimp_parallel_run_async_set_n_threads (gint                        n_threads,
-                                                                         gboolean                    finish_tasks);
-static gpointer                   gimp_parallel_run_async_thread_func   (GimpParallelRunAsyncThread *thread);
-static void                       gimp_parallel_run_async_enqueue_task  (GimpParallelRunAsyncTask   *task);
-static GimpParallelRunAsyncTask * gimp_parallel_run_async_dequeue_task  (void);
-static gboolean                   gimp_parallel_run_async_execute_task  (GimpParallelRunAsyncTask   *task);
-static void                       gimp_parallel_run_async_abort_task    (GimpParallelRunAsyncTask   *task);
-static void                       gimp_parallel_run_async_cancel        (GimpAsync                  *async);
-static void                       gimp_parallel_run_async_waiting       (GimpAsync                  *async);
+static void                         gimp_parallel_notify_num_processors         (GimpGeglConfig                   *config);
+
+static void                         gimp_parallel_set_n_threads                 (gint                              n_threads,
+                                                                                 gboolean                          finish_tasks);
+
+static void                         gimp_parallel_run_async_set_n_threads       (gint                              n_threads,
+                                                                                 gboolean                          finish_tasks);
+static gpointer                     gimp_parallel_run_async_thread_func         (GimpParallelRunAsyncThread       *thread);
+static void                         gimp_parallel_run_async_run_task            (GimpParallelRunAsyncThread       *thread,
+                                                                                 GimpParallelRunAsyncTask         *task);
+static void                         gimp_parallel_run_async_submit_task         (GimpParallelRunAsyncTask         *task);
+static void                         gimp_parallel_run_async_predecessor_stopped (GimpAsync                        *predecessor,
+                                                                                 GimpParallelRunAsyncDeferredTask *deferred_task);
+static void                         gimp_parallel_run_async_dependent_cancel    (GimpAsync                        *async);
+static void                         gimp_parallel_run_async_dependent_waiting   (GimpAsync                        *async);
+static GimpParallelRunAsyncThread * gimp_parallel_run_async_get_target_thread   (gboolean                         *claimed);
+static void                         gimp_parallel_run_async_push_task           (GimpParallelRunAsyncThread       *thread,
+                                                                                 GimpParallelRunAsyncTask         *task,
+                                                                                 gboolean                          claimed);
+static void                         gimp_parallel_run_async_wake_idle_thread    (GimpParallelRunAsyncThread       *busy_thread);
+static void                         gimp_parallel_run_async_enqueue_task        (GimpParallelRunAsyncThread       *thread,
+                                                                                 GimpParallelRunAsyncTask         *task);
+static GimpParallelRunAsyncTask *   gimp_parallel_run_async_dequeue_task        (GimpParallelRunAsyncThread       *thread);
+static GimpParallelRunAsyncTask *   gimp_parallel_run_async_steal_task          (GimpParallelRunAsyncThread       *thief);
+static GimpParallelRunAsyncThread * gimp_parallel_run_async_lock_task_thread    (GimpAsync                        *async);
+static gboolean                     gimp_parallel_run_async_execute_task        (GimpParallelRunAsyncTask         *task);
+static void                         gimp_parallel_run_async_abort_task          (GimpParallelRunAsyncTask         *task);
+static void                         gimp_parallel_run_async_cancel              (GimpAsync                        *async);
+static void                         gimp_parallel_run_async_waiting             (GimpAsync                        *async);
 
 
 /*  local variables  */
@@ -91,9 +128,11 @@ static void                       gimp_parallel_run_async_waiting       (GimpAsy
 static gint                       gimp_parallel_run_async_n_threads = 0;
 static GimpParallelRunAsyncThread gimp_parallel_run_async_threads[GIMP_PARALLEL_RUN_ASYNC_MAX_THREADS];
 
-static GMutex                     gimp_parallel_run_async_mutex;
-static GCond                      gimp_parallel_run_async_cond;
-static GQueue                     gimp_parallel_run_async_queue = G_QUEUE_INIT;
+static GPrivate                   gimp_parallel_run_async_current_thread;
+static gint                       gimp_parallel_run_async_next_thread = 0;
+
+static gint                       gimp_parallel_run_async_n_queued = 0;
+static gint                       gimp_parallel_run_async_n_steals = 0;
 
 
 /*  public functions  */
@@ -156,28 +195,111 @@ gimp_parallel_run_async_full (gint             priority,
   task->user_data              = user_data;
   task->user_data_destroy_func = user_data_destroy_func;
 
-  if (gimp_parallel_run_async_n_threads > 0)
-    {
-      g_signal_connect_after (async, "cancel",
-                              G_CALLBACK (gimp_parallel_run_async_cancel),
-                              NULL);
-      g_signal_connect_after (async, "waiting",
-                              G_CALLBACK (gimp_parallel_run_async_waiting),
-                              NULL);
+  gimp_parallel_run_async_submit_task (task);
+
+  return async;
+}
+
+GimpAsync *
+gimp_parallel_run_async_after (GimpAsync        **predecessors,
+                               gint               n_predecessors,
+                               GimpRunAsyncFunc   func,
+                               gpointer           user_data)
+{
+  return gimp_parallel_run_async_after_full (0,
+                                             predecessors, n_predecessors,
+                                             func, user_data, NULL);
+}
+
+/* same as 'gimp_parallel_run_async_full()', except that 'func' is only
+ * executed once all of 'predecessors' have stopped.  the task is submitted
+ * directly from the thread finishing the last predecessor, without going
+ * through the main loop, so that multi-stage pipelines don't stall between
+ * stages.
+ *
+ * if any of 'predecessors' is aborted, or if the returned GimpAsync is
+ * canceled before 'func' starts running, the task is aborted instead, and
+ * 'user_data_destroy_func' is called.  canceling any of 'predecessors'
+ * cancels the returned GimpAsync as well, and thus all of its own dependents.
+ * the cascade stops at asyncs which are already canceled, so callers may
+ * also forward the cancellation of the returned GimpAsync to 'predecessors'.
+ *
+ * 'func' may use 'gimp_async_get_result()' on any of 'predecessors'.  the
+ * returned GimpAsync keeps 'predecessors' alive for as long as it's alive.
+ *
+ * may only be called on the main thread.
+ */
+GimpAsync *
+gimp_parallel_run_async_after_full (gint               priority,
+                                    GimpAsync        **predecessors,
+                                    gint               n_predecessors,
+                                    GimpRunAsyncFunc   func,
+                                    gpointer           user_data,
+                                    GDestroyNotify     user_data_destroy_func)
+{
+  GimpAsync                        *async;
+  GimpParallelRunAsyncTask         *task;
+  GimpParallelRunAsyncDeferredTask *deferred_task;
+  GPtrArray                        *predecessors_array;
+  gint                              i;
+
+  g_return_val_if_fail (n_predecessors == 0 || predecessors != NULL, NULL);
+  g_return_val_if_fail (func != NULL, NULL);
 
-      g_mutex_lock (&gimp_parallel_run_async_mutex);
+  for (i = 0; i < n_predecessors; i++)
+    g_return_val_if_fail (GIMP_IS_ASYNC (predecessors[i]), NULL);
 
-      gimp_parallel_run_async_enqueue_task (task);
+  async = gimp_async_new ();
+
+  task = g_slice_new (GimpParallelRunAsyncTask);
 
-      g_cond_signal (&gimp_parallel_run_async_cond);
+  task->async                  = GIMP_ASYNC (g_object_ref (async));
+  task->priority               = priority;
+  task->func                   = func;
+  task->user_data              = user_data;
+  task->user_data_destroy_func = user_data_destroy_func;
 
-      g_mutex_unlock (&gimp_parallel_run_async_mutex);
+  deferred_task = g_slice_new (GimpParallelRunAsyncDeferredTask);
+
+  deferred_task->task      = task;
+  deferred_task->n_pending = n_predecessors + 1;
+  deferred_task->n_aborted = 0;
+
+  predecessors_array = g_ptr_array_new_full (n_predecessors,
+                                             g_object_unref);
+
+  for (i = 0; i < n_predecessors; i++)
+    {
+      g_ptr_array_add (predecessors_array, g_object_ref (predecessors[i]));
+
+      g_signal_connect_object (predecessors[i], "cancel",
+                               G_CALLBACK (gimp_parallel_run_async_dependent_cancel),
+                               async, G_CONNECT_SWAPPED);
     }
-  else
+
+  g_object_set_data_full (G_OBJECT (async),
+                          "gimp-parallel-run-async-predecessors",
+                          predecessors_array,
+                          (GDestroyNotify) g_ptr_array_unref);
+
+  /* forward waiting on the dependent to its predecessors, so that they get
+   * prioritized
+   */
+  g_signal_connect (async, "waiting",
+                    G_CALLBACK (gimp_parallel_run_async_dependent_waiting),
+                    NULL);
+
+  for (i = 0; i < n_predecessors; i++)
     {
-      while (gimp_parallel_run_async_execute_task (task));
+      gimp_async_add_stop_notify (
+        predecessors[i],
+        (GimpAsyncCallback) gimp_parallel_run_async_predecessor_stopped,
+        deferred_task);
     }
 
+  /* drop the registration guard */
+  gimp_parallel_run_async_predecessor_stopped (NULL, deferred_task);
+
   return async;
 }
 
@@ -249,6 +371,22 @@ gimp_parallel_run_async_independent_full (gint             priority,
 }
 
 
+/*  public functions (stats)  */
+
+
+gint
+gimp_parallel_run_async_get_n_queued (void)
+{
+  return g_atomic_int_get (&gimp_parallel_run_async_n_queued);
+}
+
+gint
+gimp_parallel_run_async_get_n_steals (void)
+{
+  return g_atomic_int_get (&gimp_parallel_run_async_n_steals);
+}
+
+
 /*  private functions  */
 
 
@@ -270,66 +408,97 @@ static void
 gimp_parallel_run_async_set_n_threads (gint     n_threads,
                                        gboolean finish_tasks)
 {
+  gint old_n_threads = gimp_parallel_run_async_n_threads;
   gint i;
 
   n_threads = CLAMP (n_threads, 0, GIMP_PARALLEL_RUN_ASYNC_MAX_THREADS);
 
-  if (n_threads > gimp_parallel_run_async_n_threads) /* need more threads */
+  if (n_threads > old_n_threads) /* need more threads */
     {
-      for (i = gimp_parallel_run_async_n_threads; i < n_threads; i++)
+      for (i = old_n_threads; i < n_threads; i++)
         {
           GimpParallelRunAsyncThread *thread =
             &gimp_parallel_run_async_threads[i];
 
-          thread->quit = FALSE;
+          thread->index  = i;
+          thread->quit   = FALSE;
+          thread->wakeup = FALSE;
+          thread->idle   = FALSE;
 
           thread->thread = g_thread_new (
             "async",
             (GThreadFunc) gimp_parallel_run_async_thread_func,
             thread);
         }
+
+      g_atomic_int_set (&gimp_parallel_run_async_n_threads, n_threads);
     }
-  else if (n_threads < gimp_parallel_run_async_n_threads) /* need less threads */
+  else if (n_threads < old_n_threads) /* need less threads */
     {
-      g_mutex_lock (&gimp_parallel_run_async_mutex);
+      /* stop routing new tasks to the threads we're about to stop */
+      g_atomic_int_set (&gimp_parallel_run_async_n_threads, n_threads);
 
-      for (i = n_threads; i < gimp_parallel_run_async_n_threads; i++)
+      for (i = n_threads; i < old_n_threads; i++)
         {
           GimpParallelRunAsyncThread *thread =
             &gimp_parallel_run_async_threads[i];
 
+          g_mutex_lock (&thread->mutex);
+
           thread->quit = TRUE;
 
           if (thread->current_async && ! finish_tasks)
             gimp_cancelable_cancel (GIMP_CANCELABLE (thread->current_async));
-        }
 
-      g_cond_broadcast (&gimp_parallel_run_async_cond);
+          g_cond_signal (&thread->cond);
 
-      g_mutex_unlock (&gimp_parallel_run_async_mutex);
+          g_mutex_unlock (&thread->mutex);
+        }
 
-      for (i = n_threads; i < gimp_parallel_run_async_n_threads; i++)
+      for (i = n_threads; i < old_n_threads; i++)
         {
           GimpParallelRunAsyncThread *thread =
             &gimp_parallel_run_async_threads[i];
 
           g_thread_join (thread->thread);
         }
-    }
-
-  gimp_parallel_run_async_n_threads = n_threads;
-
-  if (n_threads == 0)
-    {
-      GimpParallelRunAsyncTask *task;
 
-      /* finish remaining tasks */
-      while ((task = gimp_parallel_run_async_dequeue_task ()))
+      /* hand the stopped threads' remaining tasks over to the remaining
+       * threads, or finish them here if there are no threads left
+       */
+      for (i = n_threads; i < old_n_threads; i++)
         {
-          if (finish_tasks)
-            while (gimp_parallel_run_async_execute_task (task));
-          else
-            gimp_parallel_run_async_abort_task (task);
+          GimpParallelRunAsyncThread *thread =
+            &gimp_parallel_run_async_threads[i];
+
+          while (TRUE)
+            {
+              GimpParallelRunAsyncTask *task;
+
+              g_mutex_lock (&thread->mutex);
+
+              task = gimp_parallel_run_async_dequeue_task (thread);
+
+              g_mutex_unlock (&thread->mutex);
+
+              if (! task)
+                break;
+
+              if (n_threads > 0)
+                {
+                  gimp_parallel_run_async_push_task (
+                    &gimp_parallel_run_async_threads[i % n_threads], task,
+                    FALSE);
+                }
+              else if (finish_tasks)
+                {
+                  while (gimp_parallel_run_async_execute_task (task));
+                }
+              else
+                {
+                  gimp_parallel_run_async_abort_task (task);
+                }
+            }
         }
     }
 }
@@ -337,54 +506,264 @@ gimp_parallel_run_async_set_n_threads (gint     n_threads,
 static gpointer
 gimp_parallel_run_async_thread_func (GimpParallelRunAsyncThread *thread)
 {
-  g_mutex_lock (&gimp_parallel_run_async_mutex);
+  g_private_set (&gimp_parallel_run_async_current_thread, thread);
+
+  g_mutex_lock (&thread->mutex);
 
-  while (TRUE)
+  while (! thread->quit)
     {
       GimpParallelRunAsyncTask *task;
 
-      while (! thread->quit &&
-             (task = gimp_parallel_run_async_dequeue_task ()))
+      task = gimp_parallel_run_async_dequeue_task (thread);
+
+      if (! task)
         {
-          gboolean resume;
+          /* our own deque is empty.  mark ourselves as idle *before* looking
+           * for work in the other threads' deques, so that a task pushed
+           * while we're looking wakes us up, instead of being missed.
+           */
+          g_atomic_int_set (&thread->idle, TRUE);
 
-          thread->current_async = GIMP_ASYNC (g_object_ref (task->async));
+          g_mutex_unlock (&thread->mutex);
 
-          do
-            {
-              g_mutex_unlock (&gimp_parallel_run_async_mutex);
+          task = gimp_parallel_run_async_steal_task (thread);
 
-              resume = gimp_parallel_run_async_execute_task (task);
+          g_mutex_lock (&thread->mutex);
 
-              g_mutex_lock (&gimp_parallel_run_async_mutex);
+          if (! task                        &&
+              ! thread->quit                &&
+              ! thread->wakeup              &&
+              g_queue_is_empty (&thread->queue))
+            {
+              g_cond_wait (&thread->cond, &thread->mutex);
             }
-          while (resume &&
-                 (g_queue_is_empty (&gimp_parallel_run_async_queue) ||
-                  task->priority <
-                  ((GimpParallelRunAsyncTask *)
-                     g_queue_peek_head (
-                       &gimp_parallel_run_async_queue))->priority));
 
-          g_clear_object (&thread->current_async);
+          thread->wakeup = FALSE;
 
-          if (resume)
-            gimp_parallel_run_async_enqueue_task (task);
-        }
+          g_atomic_int_set (&thread->idle, FALSE);
 
-      if (thread->quit)
-        break;
+          if (! task)
+            continue;
 
-      g_cond_wait (&gimp_parallel_run_async_cond,
-                   &gimp_parallel_run_async_mutex);
+          if (thread->quit)
+            {
+              /* the task will be handed over to another thread by
+               * gimp_parallel_run_async_set_n_threads()
+               */
+              gimp_parallel_run_async_enqueue_task (thread, task);
+
+              break;
+            }
+        }
+
+      gimp_parallel_run_async_run_task (thread, task);
     }
 
-  g_mutex_unlock (&gimp_parallel_run_async_mutex);
+  g_mutex_unlock (&thread->mutex);
 
   return NULL;
 }
 
 static void
-gimp_parallel_run_async_enqueue_task (GimpParallelRunAsyncTask *task)
+gimp_parallel_run_async_run_task (GimpParallelRunAsyncThread *thread,
+                                  GimpParallelRunAsyncTask   *task)
+{
+  gboolean resume;
+
+  thread->current_async = GIMP_ASYNC (g_object_ref (task->async));
+
+  do
+    {
+      g_mutex_unlock (&thread->mutex);
+
+      resume = gimp_parallel_run_async_execute_task (task);
+
+      g_mutex_lock (&thread->mutex);
+    }
+  while (resume &&
+         (g_queue_is_empty (&thread->queue) ||
+          task->priority <
+          ((GimpParallelRunAsyncTask *)
+             g_queue_peek_head (&thread->queue))->priority));
+
+  g_clear_object (&thread->current_async);
+
+  if (resume)
+    gimp_parallel_run_async_enqueue_task (thread, task);
+}
+
+static void
+gimp_parallel_run_async_submit_task (GimpParallelRunAsyncTask *task)
+{
+  if (g_atomic_int_get (&gimp_parallel_run_async_n_threads) > 0)
+    {
+      GimpParallelRunAsyncThread *thread;
+      gboolean                    claimed;
+
+      g_signal_connect_after (task->async, "cancel",
+                              G_CALLBACK (gimp_parallel_run_async_cancel),
+                              NULL);
+      g_signal_connect_after (task->async, "waiting",
+                              G_CALLBACK (gimp_parallel_run_async_waiting),
+                              NULL);
+
+      thread = gimp_parallel_run_async_get_target_thread (&claimed);
+
+      gimp_parallel_run_async_push_task (thread, task, claimed);
+    }
+  else
+    {
+      while (gimp_parallel_run_async_execute_task (task));
+    }
+}
+
+/* called on the thread stopping 'predecessor', or with a NULL 'predecessor'
+ * to drop the registration guard.
+ */
+static void
+gimp_parallel_run_async_predecessor_stopped (GimpAsync                        *predecessor,
+                                             GimpParallelRunAsyncDeferredTask *deferred_task)
+{
+  GimpParallelRunAsyncTask *task = deferred_task->task;
+  gboolean                  abort_task;
+
+  if (predecessor && ! gimp_async_is_finished (predecessor))
+    g_atomic_int_inc (&deferred_task->n_aborted);
+
+  if (! g_atomic_int_dec_and_test (&deferred_task->n_pending))
+    return;
+
+  abort_task = g_atomic_int_get (&deferred_task->n_aborted) > 0 ||
+               gimp_async_is_canceled (task->async);
+
+  g_slice_free (GimpParallelRunAsyncDeferredTask, deferred_task);
+
+  if (abort_task)
+    gimp_parallel_run_async_abort_task (task);
+  else
+    gimp_parallel_run_async_submit_task (task);
+}
+
+static void
+gimp_parallel_run_async_dependent_cancel (GimpAsync *async)
+{
+  if (! gimp_async_is_canceled (async))
+    gimp_cancelable_cancel (GIMP_CANCELABLE (async));
+}
+
+static void
+gimp_parallel_run_async_dependent_waiting (GimpAsync *async)
+{
+  GPtrArray *predecessors;
+  guint      i;
+
+  predecessors = (GPtrArray *) g_object_get_data (
+    G_OBJECT (async), "gimp-parallel-run-async-predecessors");
+
+  for (i = 0; i < predecessors->len; i++)
+    g_signal_emit_by_name (g_ptr_array_index (predecessors, i), "waiting");
+}
+
+/* picks the thread whose deque a new task goes to.  an idle thread is
+ * claimed by clearing its 'idle' flag, so that the next task of a burst
+ * goes to another idle thread, instead of piling up in the same deque
+ * until the thread wakes up.  '*claimed' tells whether that's the case.
+ */
+static GimpParallelRunAsyncThread *
+gimp_parallel_run_async_get_target_thread (gboolean *claimed)
+{
+  GimpParallelRunAsyncThread *thread;
+  gint                        n_threads;
+  gint                        i;
+
+  *claimed = FALSE;
+
+  n_threads = g_atomic_int_get (&gimp_parallel_run_async_n_threads);
+
+  /* tasks spawned by a worker thread go to its own deque */
+  thread = (GimpParallelRunAsyncThread *) g_private_get (
+    &gimp_parallel_run_async_current_thread);
+
+  if (thread && thread->index < n_threads)
+    return thread;
+
+  /* otherwise, prefer an idle thread ... */
+  for (i = 0; i < n_threads; i++)
+    {
+      thread = &gimp_parallel_run_async_threads[i];
+
+      if (g_atomic_int_compare_and_exchange (&thread->idle, TRUE, FALSE))
+        {
+          *claimed = TRUE;
+
+          return thread;
+        }
+    }
+
+  /* ... and fall back to round-robin */
+  i = (guint) g_atomic_int_add (&gimp_parallel_run_async_next_thread, 1) %
+      (guint) n_threads;
+
+  return &gimp_parallel_run_async_threads[i];
+}
+
+static void
+gimp_parallel_run_async_push_task (GimpParallelRunAsyncThread *thread,
+                                   GimpParallelRunAsyncTask   *task,
+                                   gboolean                    claimed)
+{
+  gboolean was_empty;
+
+  g_mutex_lock (&thread->mutex);
+
+  was_empty = g_queue_is_empty (&thread->queue);
+
+  gimp_parallel_run_async_enqueue_task (thread, task);
+
+  thread->wakeup = TRUE;
+  g_cond_signal (&thread->cond);
+
+  g_mutex_unlock (&thread->mutex);
+
+  /* if the thread is busy, or already has another task to run first, let
+   * an idle thread steal the task
+   */
+  if (! claimed || ! was_empty)
+    gimp_parallel_run_async_wake_idle_thread (thread);
+}
+
+static void
+gimp_parallel_run_async_wake_idle_thread (GimpParallelRunAsyncThread *busy_thread)
+{
+  gint n_threads;
+  gint i;
+
+  n_threads = g_atomic_int_get (&gimp_parallel_run_async_n_threads);
+
+  for (i = 0; i < n_threads; i++)
+    {
+      GimpParallelRunAsyncThread *thread =
+        &gimp_parallel_run_async_threads[i];
+
+      /* claim the thread, so that it isn't woken up for another task */
+      if (thread != busy_thread &&
+          g_atomic_int_compare_and_exchange (&thread->idle, TRUE, FALSE))
+        {
+          g_mutex_lock (&thread->mutex);
+
+          thread->wakeup = TRUE;
+          g_cond_signal (&thread->cond);
+
+          g_mutex_unlock (&thread->mutex);
+
+          break;
+        }
+    }
+}
+
+static void
+gimp_parallel_run_async_enqueue_task (GimpParallelRunAsyncThread *thread,
+                                      GimpParallelRunAsyncTask   *task)
 {
   GList *link;
   GList *iter;
@@ -401,8 +780,10 @@ gimp_parallel_run_async_enqueue_task (GimpParallelRunAsyncTask *task)
 
   g_object_set_data (G_OBJECT (task->async),
                      "gimp-parallel-run-async-link", link);
+  g_object_set_data (G_OBJECT (task->async),
+                     "gimp-parallel-run-async-thread", thread);
 
-  for (iter = g_queue_peek_tail_link (&gimp_parallel_run_async_queue);
+  for (iter = g_queue_peek_tail_link (&thread->queue);
        iter;
        iter = g_list_previous (iter))
     {
@@ -423,33 +804,126 @@ gimp_parallel_run_async_enqueue_task (GimpParallelRunAsyncTask *task)
       if (link->next)
         link->next->prev = link;
       else
-        gimp_parallel_run_async_queue.tail = link;
+        thread->queue.tail = link;
 
-      gimp_parallel_run_async_queue.length++;
+      thread->queue.length++;
     }
   else
     {
-      g_queue_push_head_link (&gimp_parallel_run_async_queue, link);
+      g_queue_push_head_link (&thread->queue, link);
     }
+
+  g_atomic_int_inc (&thread->n_queued);
+  g_atomic_int_inc (&gimp_parallel_run_async_n_queued);
 }
 
 static GimpParallelRunAsyncTask *
-gimp_parallel_run_async_dequeue_task (void)
+gimp_parallel_run_async_dequeue_task (GimpParallelRunAsyncThread *thread)
 {
   GimpParallelRunAsyncTask *task;
 
-  task = (GimpParallelRunAsyncTask *) g_queue_pop_head (
-                                        &gimp_parallel_run_async_queue);
+  task = (GimpParallelRunAsyncTask *) g_queue_pop_head (&thread->queue);
 
   if (task)
     {
       g_object_set_data (G_OBJECT (task->async),
                          "gimp-parallel-run-async-link", NULL);
+      g_object_set_data (G_OBJECT (task->async),
+                         "gimp-parallel-run-async-thread", NULL);
+
+      g_atomic_int_add (&thread->n_queued, -1);
+      g_atomic_int_add (&gimp_parallel_run_async_n_queued, -1);
     }
 
   return task;
 }
 
+static GimpParallelRunAsyncTask *
+gimp_parallel_run_async_steal_task (GimpParallelRunAsyncThread *thief)
+{
+  GimpParallelRunAsyncThread *victim = NULL;
+  gint                        victim_priority = G_MAXINT;
+  gint                        n_threads;
+  gint                        i;
+
+  n_threads = g_atomic_int_get (&gimp_parallel_run_async_n_threads);
+
+  /* find the thread whose most urgent task has the highest priority, so that
+   * stealing doesn't violate the priority order across threads.  we never
+   * hold more than one thread's lock at a time.
+   */
+  for (i = 1; i < n_threads; i++)
+    {
+      GimpParallelRunAsyncThread *thread;
+
+      thread = &gimp_parallel_run_async_threads[(thief->index + i) %
+                                                n_threads];
+
+      if (! g_atomic_int_get (&thread->n_queued))
+        continue;
+
+      g_mutex_lock (&thread->mutex);
+
+      if (! g_queue_is_empty (&thread->queue))
+        {
+          GimpParallelRunAsyncTask *task =
+            (GimpParallelRunAsyncTask *) g_queue_peek_head (&thread->queue);
+
+          if (! victim || task->priority < victim_priority)
+            {
+              victim          = thread;
+              victim_priority = task->priority;
+            }
+        }
+
+      g_mutex_unlock (&thread->mutex);
+    }
+
+  if (victim)
+    {
+      GimpParallelRunAsyncTask *task;
+
+      g_mutex_lock (&victim->mutex);
+
+      task = gimp_parallel_run_async_dequeue_task (victim);
+
+      g_mutex_unlock (&victim->mutex);
+
+      if (task)
+        g_atomic_int_inc (&gimp_parallel_run_async_n_steals);
+
+      return task;
+    }
+
+  return NULL;
+}
+
+/* returns the thread whose deque holds 'async''s task, with its mutex locked,
+ * or NULL if the task is not queued.
+ */
+static GimpParallelRunAsyncThread *
+gimp_parallel_run_async_lock_task_thread (GimpAsync *async)
+{
+  GimpParallelRunAsyncThread *thread;
+
+  while ((thread = (GimpParallelRunAsyncThread *) g_object_get_data (
+                     G_OBJECT (async), "gimp-parallel-run-async-thread")))
+    {
+      g_mutex_lock (&thread->mutex);
+
+      if (g_object_get_data (G_OBJECT (async),
+                             "gimp-parallel-run-async-thread") == thread)
+        {
+          return thread;
+        }
+
+      /* the task was stolen, or moved, while we were waiting for the lock */
+      g_mutex_unlock (&thread->mutex);
+    }
+
+  return NULL;
+}
+
 static gboolean
 gimp_parallel_run_async_execute_task (GimpParallelRunAsyncTask *task)
 {
@@ -490,63 +964,63 @@ gimp_parallel_run_async_abort_task (GimpParallelRunAsyncTask *task)
 static void
 gimp_parallel_run_async_cancel (GimpAsync *async)
 {
-  GList                    *link;
-  GimpParallelRunAsyncTask *task = NULL;
+  GimpParallelRunAsyncThread *thread;
+  GList                      *link;
+  GimpParallelRunAsyncTask   *task;
 
-  link = (GList *) g_object_get_data (G_OBJECT (async),
-                                      "gimp-parallel-run-async-link");
+  thread = gimp_parallel_run_async_lock_task_thread (async);
 
-  if (! link)
+  if (! thread)
     return;
 
-  g_mutex_lock (&gimp_parallel_run_async_mutex);
-
   link = (GList *) g_object_get_data (G_OBJECT (async),
                                       "gimp-parallel-run-async-link");
 
-  if (link)
-    {
-      g_object_set_data (G_OBJECT (async),
-                         "gimp-parallel-run-async-link", NULL);
+  g_object_set_data (G_OBJECT (async),
+                     "gimp-parallel-run-async-link", NULL);
+  g_object_set_data (G_OBJECT (async),
+                     "gimp-parallel-run-async-thread", NULL);
 
-      task = (GimpParallelRunAsyncTask *) link->data;
+  task = (GimpParallelRunAsyncTask *) link->data;
 
-      g_queue_delete_link (&gimp_parallel_run_async_queue, link);
-    }
+  g_queue_delete_link (&thread->queue, link);
 
-  g_mutex_unlock (&gimp_parallel_run_async_mutex);
+  g_atomic_int_add (&thread->n_queued, -1);
+  g_atomic_int_add (&gimp_parallel_run_async_n_queued, -1);
 
-  if (task)
-    gimp_parallel_run_async_abort_task (task);
+  g_mutex_unlock (&thread->mutex);
+
+  gimp_parallel_run_async_abort_task (task);
 }
 
 static void
 gimp_parallel_run_async_waiting (GimpAsync *async)
 {
-  GList *link;
+  GimpParallelRunAsyncThread *thread;
+  GList                      *link;
+  GimpParallelRunAsyncTask   *task;
 
-  link = (GList *) g_object_get_data (G_OBJECT (async),
-                                      "gimp-parallel-run-async-link");
+  thread = gimp_parallel_run_async_lock_task_thread (async);
 
-  if (! link)
+  if (! thread)
     return;
 
-  g_mutex_lock (&gimp_parallel_run_async_mutex);
-
   link = (GList *) g_object_get_data (G_OBJECT (async),
                                       "gimp-parallel-run-async-link");
 
-  if (link)
-    {
-      GimpParallelRunAsyncTask *task = (GimpParallelRunAsyncTask *) link->data;
+  task = (GimpParallelRunAsyncTask *) link->data;
 
-      task->priority = G_MININT;
+  task->priority = G_MININT;
 
-      g_queue_unlink         (&gimp_parallel_run_async_queue, link);
-      g_queue_push_head_link (&gimp_parallel_run_async_queue, link);
-    }
+  g_queue_unlink         (&thread->queue, link);
+  g_queue_push_head_link (&thread->queue, link);
+
+  g_mutex_unlock (&thread->mutex);
 
-  g_mutex_unlock (&gimp_parallel_run_async_mutex);
+  /* the owning thread may be busy, possibly with the very task that is
+   * waiting for us -- let an idle thread pick it up.
+   */
+  gimp_parallel_run_async_wake_idle_thread (thread);
 }
 
 } /* extern "C" */
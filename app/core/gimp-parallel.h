@@ -30,12 +30,25 @@ GimpAsync * gimp_parallel_run_async_full             (gint              priority
                                                       GimpRunAsyncFunc  func,
                                                       gpointer          user_data,
                                                       GDestroyNotify    user_data_destroy_func);
+GimpAsync * gimp_parallel_run_async_after            (GimpAsync       **predecessors,
+                                                      gint              n_predecessors,
+                                                      GimpRunAsyncFunc  func,
+                                                      gpointer          user_data);
+GimpAsync * gimp_parallel_run_async_after_full       (gint              priority,
+                                                      GimpAsync       **predecessors,
+                                                      gint              n_predecessors,
+                                                      GimpRunAsyncFunc  func,
+                                                      gpointer          user_data,
+                                                      GDestroyNotify    user_data_destroy_func);
 GimpAsync * gimp_parallel_run_async_independent      (GimpRunAsyncFunc  func,
                                                       gpointer          user_data);
 GimpAsync * gimp_parallel_run_async_independent_full (gint              priority,
                                                       GimpRunAsyncFunc  func,
                                                       gpointer          user_data);
 
+gint        gimp_parallel_run_async_get_n_queued     (void);
+gint        gimp_parallel_run_async_get_n_steals     (void);
+
 
 #ifdef __cplusplus
 
@@ -117,6 +130,51 @@ gimp_parallel_run_async_full (gint         priority,
                                        });
 }
 
+template <class RunAsyncFunc>
+inline GimpAsync *
+gimp_parallel_run_async_after_full (gint          priority,
+                                    GimpAsync   **predecessors,
+                                    gint          n_predecessors,
+                                    RunAsyncFunc  func)
+{
+  RunAsyncFunc *func_copy = g_new (RunAsyncFunc, 1);
+
+  new (func_copy) RunAsyncFunc (func);
+
+  return gimp_parallel_run_async_after_full (priority,
+                                             predecessors, n_predecessors,
+                                             [] (GimpAsync *async,
+                                                 gpointer   user_data)
+                                             {
+                                               RunAsyncFunc *func_copy =
+                                                 (RunAsyncFunc *) user_data;
+
+                                               (*func_copy) (async);
+
+                                               func_copy->~RunAsyncFunc ();
+                                               g_free (func_copy);
+                                             },
+                                             func_copy,
+                                             [] (gpointer user_data)
+                                             {
+                                               RunAsyncFunc *func_copy =
+                                                 (RunAsyncFunc *) user_data;
+
+                                               func_copy->~RunAsyncFunc ();
+                                               g_free (func_copy);
+                                             });
+}
+
+template <class RunAsyncFunc>
+inline GimpAsync *
+gimp_parallel_run_async_after (GimpAsync   **predecessors,
+                               gint          n_predecessors,
+                               RunAsyncFunc  func)
+{
+  return gimp_parallel_run_async_after_full (0, predecessors, n_predecessors,
+                                             func);
+}
+
 template <class RunAsyncFunc>
 inline GimpAsync *
 gimp_parallel_run_async_independent_full (gint         priority,
@@ -84,6 +84,7 @@ struct _GimpAsyncPrivate
   GCond          cond;
 
   GQueue         callbacks;
+  GQueue         stop_notifies;
 
   gpointer       result;
   GDestroyNotify result_destroy_func;
@@ -122,6 +123,8 @@ static void       gimp_async_callback_weak_notify  (GimpAsyncCallbackInfo   *cal
                                                     GObject                 *gobject);
 
 static void       gimp_async_stop                  (GimpAsync               *async);
+static void       gimp_async_run_stop_notifies     (GimpAsync               *async,
+                                                    GQueue                  *stop_notifies);
 static void       gimp_async_run_callbacks         (GimpAsync               *async);
 
 
@@ -184,6 +187,7 @@ gimp_async_init (GimpAsync *async)
   g_cond_init  (&async->priv->cond);
 
   g_queue_init (&async->priv->callbacks);
+  g_queue_init (&async->priv->stop_notifies);
 
   g_atomic_int_inc (&gimp_async_n_running);
 
@@ -200,6 +204,7 @@ gimp_async_finalize (GObject *object)
   g_warn_if_fail (async->priv->stopped);
   g_warn_if_fail (async->priv->idle_id == 0);
   g_warn_if_fail (g_queue_is_empty (&async->priv->callbacks));
+  g_warn_if_fail (g_queue_is_empty (&async->priv->stop_notifies));
 
   if (async->priv->finished &&
       async->priv->result   &&
@@ -389,6 +394,20 @@ gimp_async_stop (GimpAsync *async)
   g_cond_broadcast (&async->priv->cond);
 }
 
+static void
+gimp_async_run_stop_notifies (GimpAsync *async,
+                              GQueue    *stop_notifies)
+{
+  GimpAsyncCallbackInfo *callback_info;
+
+  while ((callback_info = g_queue_pop_head (stop_notifies)))
+    {
+      callback_info->callback (async, callback_info->data);
+
+      g_slice_free (GimpAsyncCallbackInfo, callback_info);
+    }
+}
+
 static void
 gimp_async_run_callbacks (GimpAsync *async)
 {
@@ -609,6 +628,48 @@ gimp_async_remove_callback (GimpAsync         *async,
     g_object_unref (async);
 }
 
+/* registers a function to be called as soon as 'async' transitions to the
+ * "stopped" state.  in contrast to 'gimp_async_add_callback()', the function
+ * is called directly on the async thread, without going through the main
+ * loop, and doesn't cause 'async' to become synced.  if 'async' is already
+ * stopped, the function is called immediately, on the calling thread.
+ *
+ * the function may use 'gimp_async_is_finished()' and
+ * 'gimp_async_get_result()', but shouldn't block.
+ *
+ * may be called on any thread.
+ */
+void
+gimp_async_add_stop_notify (GimpAsync         *async,
+                            GimpAsyncCallback  callback,
+                            gpointer           data)
+{
+  GimpAsyncCallbackInfo *callback_info;
+
+  g_return_if_fail (GIMP_IS_ASYNC (async));
+  g_return_if_fail (callback != NULL);
+
+  g_mutex_lock (&async->priv->mutex);
+
+  if (async->priv->stopped)
+    {
+      g_mutex_unlock (&async->priv->mutex);
+
+      callback (async, data);
+
+      return;
+    }
+
+  callback_info           = g_slice_new0 (GimpAsyncCallbackInfo);
+  callback_info->async    = async;
+  callback_info->callback = callback;
+  callback_info->data     = data;
+
+  g_queue_push_tail (&async->priv->stop_notifies, callback_info);
+
+  g_mutex_unlock (&async->priv->mutex);
+}
+
 /* checks if 'async' is in the "stopped" state.
  *
  * may only be called on the async thread.
@@ -643,6 +704,8 @@ gimp_async_finish_full (GimpAsync      *async,
                         gpointer        result,
                         GDestroyNotify  result_destroy_func)
 {
+  GQueue stop_notifies;
+
   g_return_if_fail (GIMP_IS_ASYNC (async));
   g_return_if_fail (! async->priv->stopped);
 
@@ -654,7 +717,12 @@ gimp_async_finish_full (GimpAsync      *async,
 
   gimp_async_stop (async);
 
+  stop_notifies = async->priv->stop_notifies;
+  g_queue_init (&async->priv->stop_notifies);
+
   g_mutex_unlock (&async->priv->mutex);
+
+  gimp_async_run_stop_notifies (async, &stop_notifies);
 }
 
 /* checks if 'async' completed normally, using 'gimp_async_finish()' (in
@@ -702,6 +770,8 @@ gimp_async_get_result (GimpAsync *async)
 void
 gimp_async_abort (GimpAsync *async)
 {
+  GQueue stop_notifies;
+
   g_return_if_fail (GIMP_IS_ASYNC (async));
   g_return_if_fail (! async->priv->stopped);
 
@@ -709,7 +779,12 @@ gimp_async_abort (GimpAsync *async)
 
   gimp_async_stop (async);
 
+  stop_notifies = async->priv->stop_notifies;
+  g_queue_init (&async->priv->stop_notifies);
+
   g_mutex_unlock (&async->priv->mutex);
+
+  gimp_async_run_stop_notifies (async, &stop_notifies);
 }
 
 /* checks if cancellation of 'async' has been requested.
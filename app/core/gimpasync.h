@@ -69,6 +69,10 @@ void        gimp_async_remove_callback         (GimpAsync         *async,
                                                 GimpAsyncCallback  callback,
                                                 gpointer           data);
 
+void        gimp_async_add_stop_notify         (GimpAsync         *async,
+                                                GimpAsyncCallback  callback,
+                                                gpointer           data);
+
 gboolean    gimp_async_is_stopped              (GimpAsync         *async);
 
 void        gimp_async_finish                  (GimpAsync         *async,
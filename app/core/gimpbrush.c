@@ -58,6 +58,12 @@ enum
 };
 
 
+/*  transforms are snapped to a grid at which the resulting masks
+ *  differ by at most 1/TRANSFORM_PRECISION of a pixel
+ */
+#define TRANSFORM_PRECISION 4.0
+
+
 static void          gimp_brush_tagged_iface_init     (GimpTaggedInterface  *iface);
 
 static void          gimp_brush_finalize              (GObject              *object);
@@ -100,6 +106,17 @@ static gboolean      gimp_brush_real_want_null_motion (GimpBrush            *bru
 
 static gchar       * gimp_brush_get_checksum          (GimpTagged           *tagged);
 
+static void          gimp_brush_quantize_transform    (GimpBrush            *brush,
+                                                       gdouble              *scale,
+                                                       gdouble              *aspect_ratio,
+                                                       gdouble              *angle,
+                                                       gdouble              *hardness);
+
+static gint64        gimp_brush_temp_buf_get_memsize  (gpointer              data,
+                                                       gint64               *gui_size);
+static gint64        gimp_brush_boundary_get_memsize  (gpointer              data,
+                                                       gint64               *gui_size);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpBrush, gimp_brush, GIMP_TYPE_DATA,
                          G_ADD_PRIVATE (GimpBrush)
@@ -253,6 +270,18 @@ gimp_brush_get_memsize (GimpObject *object,
 
   memsize += gimp_brush_mipmap_get_memsize (brush);
 
+  if (brush->priv->mask_cache)
+    memsize += gimp_object_get_memsize (GIMP_OBJECT (brush->priv->mask_cache),
+                                        gui_size);
+
+  if (brush->priv->pixmap_cache)
+    memsize += gimp_object_get_memsize (GIMP_OBJECT (brush->priv->pixmap_cache),
+                                        gui_size);
+
+  if (brush->priv->boundary_cache)
+    memsize += gimp_object_get_memsize (GIMP_OBJECT (brush->priv->boundary_cache),
+                                        gui_size);
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -466,13 +495,19 @@ static void
 gimp_brush_real_begin_use (GimpBrush *brush)
 {
   brush->priv->mask_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref, 'M', 'm');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref,
+                          gimp_brush_temp_buf_get_memsize,
+                          'M', 'm');
 
   brush->priv->pixmap_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref, 'P', 'p');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref,
+                          gimp_brush_temp_buf_get_memsize,
+                          'P', 'p');
 
   brush->priv->boundary_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_bezier_desc_free, 'B', 'b');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_bezier_desc_free,
+                          gimp_brush_boundary_get_memsize,
+                          'B', 'b');
 }
 
 static void
@@ -537,6 +572,67 @@ gimp_brush_get_checksum (GimpTagged *tagged)
   return checksum_string;
 }
 
+/*  snaps the transform parameters to a grid which is just fine enough
+ *  to not make a visible difference, so that dabs whose dynamics
+ *  differ only slightly share the same cached transform.  the grid
+ *  spacing depends on the size of the brush, since the larger the
+ *  brush, the more a small change in scale or angle moves its edges.
+ */
+static void
+gimp_brush_quantize_transform (GimpBrush *brush,
+                               gdouble   *scale,
+                               gdouble   *aspect_ratio,
+                               gdouble   *angle,
+                               gdouble   *hardness)
+{
+  gdouble size;
+  gdouble n;
+
+  size = MAX (gimp_temp_buf_get_width  (brush->priv->mask),
+              gimp_temp_buf_get_height (brush->priv->mask)) *
+         TRANSFORM_PRECISION;
+
+  /*  keeps 1.0 exact  */
+  n      = size;
+  *scale = MAX (RINT (*scale * n), 1.0) / n;
+
+  size *= *scale;
+
+  /*  see gimp_brush_transform_get_scale()  */
+  n             = ceil (size / 20.0);
+  *aspect_ratio = RINT (*aspect_ratio * n) / n;
+
+  /*  keeps quarter turns exact, gimp_brush_transform_size() relies on
+   *  them
+   */
+  n      = 4.0 * ceil (G_PI * size / 4.0);
+  *angle = RINT (*angle * n) / n;
+
+  if (hardness)
+    {
+      n         = MAX (ceil (size), 256.0);
+      *hardness = RINT (*hardness * n) / n;
+    }
+}
+
+static gint64
+gimp_brush_temp_buf_get_memsize (gpointer  data,
+                                 gint64   *gui_size)
+{
+  return gimp_temp_buf_get_memsize (data);
+}
+
+static gint64
+gimp_brush_boundary_get_memsize (gpointer  data,
+                                 gint64   *gui_size)
+{
+  GimpBezierDesc *boundary = data;
+
+  return sizeof (GimpBezierDesc) +
+         boundary->num_data * sizeof (cairo_path_data_t);
+}
+
+
 /*  public functions  */
 
 GimpData *
@@ -632,6 +728,9 @@ gimp_brush_transform_size (GimpBrush     *brush,
   g_return_if_fail (width != NULL);
   g_return_if_fail (height != NULL);
 
+  gimp_brush_quantize_transform (brush,
+                                 &scale, &aspect_ratio, &angle, NULL);
+
   if (scale             == 1.0 &&
       aspect_ratio      == 0.0 &&
       fmod (angle, 0.5) == 0.0)
@@ -658,11 +757,16 @@ gimp_brush_transform_mask (GimpBrush *brush,
   const GimpTempBuf *mask;
   gint               width;
   gint               height;
-  gdouble            effective_hardness = hardness;
+  gdouble            effective_hardness;
 
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), NULL);
   g_return_val_if_fail (scale > 0.0, NULL);
 
+  gimp_brush_quantize_transform (brush,
+                                 &scale, &aspect_ratio, &angle, &hardness);
+
+  effective_hardness = hardness;
+
   gimp_brush_transform_size (brush,
                              scale, aspect_ratio, angle, reflect,
                              &width, &height);
@@ -725,12 +829,17 @@ gimp_brush_transform_pixmap (GimpBrush *brush,
   const GimpTempBuf *pixmap;
   gint               width;
   gint               height;
-  gdouble            effective_hardness = hardness;
+  gdouble            effective_hardness;
 
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), NULL);
   g_return_val_if_fail (brush->priv->pixmap != NULL, NULL);
   g_return_val_if_fail (scale > 0.0, NULL);
 
+  gimp_brush_quantize_transform (brush,
+                                 &scale, &aspect_ratio, &angle, &hardness);
+
+  effective_hardness = hardness;
+
   gimp_brush_transform_size (brush,
                              scale, aspect_ratio, angle, reflect,
                              &width, &height);
@@ -794,6 +903,9 @@ gimp_brush_transform_boundary (GimpBrush *brush,
   g_return_val_if_fail (width != NULL, NULL);
   g_return_val_if_fail (height != NULL, NULL);
 
+  gimp_brush_quantize_transform (brush,
+                                 &scale, &aspect_ratio, &angle, &hardness);
+
   gimp_brush_transform_size (brush,
                              scale, aspect_ratio, angle, reflect,
                              width, height);
@@ -27,13 +27,15 @@
 
 #include "core-types.h"
 
+#include "gimp-memsize.h"
 #include "gimpbrushcache.h"
 
 #include "gimp-log.h"
 #include "gimp-intl.h"
 
 
-#define MAX_CACHED_DATA 20
+/* the default of the "brush-cache-size" gimprc option */
+#define DEFAULT_MAX_MEMSIZE (64 << 20)
 
 
 enum
@@ -48,6 +50,8 @@ typedef struct _GimpBrushCacheUnit GimpBrushCacheUnit;
 struct _GimpBrushCacheUnit
 {
   gpointer data;
+  gint64   memsize;
+  GList    link;
 
   gint     width;
   gint     height;
@@ -59,16 +63,33 @@ struct _GimpBrushCacheUnit
 };
 
 
-static void   gimp_brush_cache_constructed  (GObject      *object);
-static void   gimp_brush_cache_finalize     (GObject      *object);
-static void   gimp_brush_cache_set_property (GObject      *object,
-                                             guint         property_id,
-                                             const GValue *value,
-                                             GParamSpec   *pspec);
-static void   gimp_brush_cache_get_property (GObject      *object,
-                                             guint         property_id,
-                                             GValue       *value,
-                                             GParamSpec   *pspec);
+static void       gimp_brush_cache_constructed  (GObject            *object);
+static void       gimp_brush_cache_finalize     (GObject            *object);
+static void       gimp_brush_cache_set_property (GObject            *object,
+                                                 guint               property_id,
+                                                 const GValue       *value,
+                                                 GParamSpec         *pspec);
+static void       gimp_brush_cache_get_property (GObject            *object,
+                                                 guint               property_id,
+                                                 GValue             *value,
+                                                 GParamSpec         *pspec);
+
+static gint64     gimp_brush_cache_get_memsize  (GimpObject         *object,
+                                                 gint64             *gui_size);
+
+static guint      gimp_brush_cache_unit_hash    (gconstpointer       ptr);
+static gboolean   gimp_brush_cache_unit_equal   (gconstpointer       ptr1,
+                                                 gconstpointer       ptr2);
+static void       gimp_brush_cache_unit_init    (GimpBrushCacheUnit *unit,
+                                                 gint                width,
+                                                 gint                height,
+                                                 gdouble             scale,
+                                                 gdouble             aspect_ratio,
+                                                 gdouble             angle,
+                                                 gboolean            reflect,
+                                                 gdouble             hardness);
+static void       gimp_brush_cache_remove_unit  (GimpBrushCache     *cache,
+                                                 GimpBrushCacheUnit *unit);
 
 
 G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
@@ -76,15 +97,24 @@ G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
 #define parent_class gimp_brush_cache_parent_class
 
 
+static guint64  gimp_brush_cache_max_memsize   = DEFAULT_MAX_MEMSIZE;
+static guintptr gimp_brush_cache_total_memsize = 0;
+static gint     gimp_brush_cache_n_hits        = 0;
+static gint     gimp_brush_cache_n_misses      = 0;
+
+
 static void
 gimp_brush_cache_class_init (GimpBrushCacheClass *klass)
 {
-  GObjectClass  *object_class = G_OBJECT_CLASS (klass);
+  GObjectClass    *object_class      = G_OBJECT_CLASS (klass);
+  GimpObjectClass *gimp_object_class = GIMP_OBJECT_CLASS (klass);
 
-  object_class->constructed  = gimp_brush_cache_constructed;
-  object_class->finalize     = gimp_brush_cache_finalize;
-  object_class->set_property = gimp_brush_cache_set_property;
-  object_class->get_property = gimp_brush_cache_get_property;
+  object_class->constructed     = gimp_brush_cache_constructed;
+  object_class->finalize        = gimp_brush_cache_finalize;
+  object_class->set_property    = gimp_brush_cache_set_property;
+  object_class->get_property    = gimp_brush_cache_get_property;
+
+  gimp_object_class->get_memsize = gimp_brush_cache_get_memsize;
 
   g_object_class_install_property (object_class, PROP_DATA_DESTROY,
                                    g_param_spec_pointer ("data-destroy",
@@ -94,8 +124,12 @@ gimp_brush_cache_class_init (GimpBrushCacheClass *klass)
 }
 
 static void
-gimp_brush_cache_init (GimpBrushCache *brush)
+gimp_brush_cache_init (GimpBrushCache *cache)
 {
+  cache->units = g_hash_table_new (gimp_brush_cache_unit_hash,
+                                   gimp_brush_cache_unit_equal);
+
+  g_queue_init (&cache->cached_units);
 }
 
 static void
@@ -115,6 +149,8 @@ gimp_brush_cache_finalize (GObject *object)
 
   gimp_brush_cache_clear (cache);
 
+  g_clear_pointer (&cache->units, g_hash_table_unref);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -158,24 +194,42 @@ gimp_brush_cache_get_property (GObject    *object,
     }
 }
 
+static gint64
+gimp_brush_cache_get_memsize (GimpObject *object,
+                              gint64     *gui_size)
+{
+  GimpBrushCache *cache   = GIMP_BRUSH_CACHE (object);
+  gint64          memsize = 0;
+
+  memsize += gimp_g_hash_table_get_memsize (cache->units,
+                                            sizeof (GimpBrushCacheUnit));
+  memsize += cache->memsize;
+
+  return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
+                                                                  gui_size);
+}
+
 
 /*  public functions  */
 
 GimpBrushCache *
-gimp_brush_cache_new (GDestroyNotify  data_destroy,
-                      gchar           debug_hit,
-                      gchar           debug_miss)
+gimp_brush_cache_new (GDestroyNotify   data_destroy,
+                      GimpMemsizeFunc  data_get_memsize,
+                      gchar            debug_hit,
+                      gchar            debug_miss)
 {
   GimpBrushCache *cache;
 
   g_return_val_if_fail (data_destroy != NULL, NULL);
+  g_return_val_if_fail (data_get_memsize != NULL, NULL);
 
   cache =  g_object_new (GIMP_TYPE_BRUSH_CACHE,
                          "data-destroy", data_destroy,
                          NULL);
 
-  cache->debug_hit  = debug_hit;
-  cache->debug_miss = debug_miss;
+  cache->data_get_memsize = data_get_memsize;
+  cache->debug_hit        = debug_hit;
+  cache->debug_miss       = debug_miss;
 
   return cache;
 }
@@ -185,19 +239,10 @@ gimp_brush_cache_clear (GimpBrushCache *cache)
 {
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
 
-  if (cache->cached_units)
+  while (! g_queue_is_empty (&cache->cached_units))
     {
-      GList *iter;
-
-      for (iter = cache->cached_units; iter; iter = g_list_next (iter))
-        {
-          GimpBrushCacheUnit *unit = iter->data;
-
-          cache->data_destroy (unit->data);
-        }
-
-      g_list_free_full (cache->cached_units, g_free);
-      cache->cached_units = NULL;
+      gimp_brush_cache_remove_unit (cache,
+                                    g_queue_peek_head (&cache->cached_units));
     }
 }
 
@@ -211,40 +256,36 @@ gimp_brush_cache_get (GimpBrushCache *cache,
                       gboolean        reflect,
                       gdouble         hardness)
 {
-  GList *iter;
+  GimpBrushCacheUnit  key;
+  GimpBrushCacheUnit *unit;
 
   g_return_val_if_fail (GIMP_IS_BRUSH_CACHE (cache), NULL);
 
-  for (iter = cache->cached_units; iter; iter = g_list_next (iter))
+  gimp_brush_cache_unit_init (&key,
+                              width, height,
+                              scale, aspect_ratio, angle, reflect, hardness);
+
+  unit = g_hash_table_lookup (cache->units, &key);
+
+  if (unit)
     {
-      GimpBrushCacheUnit *unit = iter->data;
-
-      if (unit->data                         &&
-          unit->width        == width        &&
-          unit->height       == height       &&
-          unit->scale        == scale        &&
-          unit->aspect_ratio == aspect_ratio &&
-          unit->angle        == angle        &&
-          unit->reflect      == reflect      &&
-          unit->hardness     == hardness)
-        {
-          if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
-            g_printerr ("%c", cache->debug_hit);
-
-          /* Make the returned cached brush first in the list. */
-          cache->cached_units = g_list_remove_link (cache->cached_units, iter);
-          iter->next = cache->cached_units;
-          if (cache->cached_units)
-            cache->cached_units->prev = iter;
-          cache->cached_units = iter;
-
-          return (gconstpointer) unit->data;
-        }
+      if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
+        g_printerr ("%c", cache->debug_hit);
+
+      g_atomic_int_inc (&gimp_brush_cache_n_hits);
+
+      /* Make the returned cached brush first in the list. */
+      g_queue_unlink (&cache->cached_units, &unit->link);
+      g_queue_push_head_link (&cache->cached_units, &unit->link);
+
+      return (gconstpointer) unit->data;
     }
 
   if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
     g_printerr ("%c", cache->debug_miss);
 
+  g_atomic_int_inc (&gimp_brush_cache_n_misses);
+
   return NULL;
 }
 
@@ -259,44 +300,152 @@ gimp_brush_cache_add (GimpBrushCache *cache,
                       gboolean        reflect,
                       gdouble         hardness)
 {
-  GList              *iter;
+  GimpBrushCacheUnit  key;
   GimpBrushCacheUnit *unit;
-  GList              *last   = NULL;
-  gint                length = 0;
 
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
   g_return_if_fail (data != NULL);
 
-  for (iter = cache->cached_units; iter; iter = g_list_next (iter))
-    {
-      unit = iter->data;
+  gimp_brush_cache_unit_init (&key,
+                              width, height,
+                              scale, aspect_ratio, angle, reflect, hardness);
 
-      if (data == unit->data)
+  /*  replace an existing entry for the same transform, unless it
+   *  already holds this very data
+   */
+  unit = g_hash_table_lookup (cache->units, &key);
+
+  if (unit)
+    {
+      if (unit->data == data)
         return;
 
-      length++;
-      last = iter;
+      gimp_brush_cache_remove_unit (cache, unit);
     }
 
-  if (length > MAX_CACHED_DATA)
-    {
-      unit = last->data;
+  unit = g_slice_dup (GimpBrushCacheUnit, &key);
+
+  unit->data      = data;
+  unit->memsize   = cache->data_get_memsize (data, NULL);
+  unit->link.data = unit;
+  unit->link.prev = NULL;
+  unit->link.next = NULL;
+
+  g_hash_table_add (cache->units, unit);
+  g_queue_push_head_link (&cache->cached_units, &unit->link);
+
+  cache->memsize += unit->memsize;
 
-      cache->data_destroy (unit->data);
-      cache->cached_units = g_list_delete_link (cache->cached_units, last);
-      g_free (unit);
+  g_atomic_pointer_add (&gimp_brush_cache_total_memsize, unit->memsize);
+
+  /*  the budget is shared by all caches, i.e. the mask, pixmap and
+   *  boundary caches of all brushes in use.  evict our own least
+   *  recently used entries, but always keep the one we just added,
+   *  however big it is
+   */
+  while (g_atomic_pointer_get (&gimp_brush_cache_total_memsize) >
+         gimp_brush_cache_max_memsize &&
+         cache->cached_units.length > 1)
+    {
+      gimp_brush_cache_remove_unit (cache,
+                                    g_queue_peek_tail (&cache->cached_units));
     }
+}
 
-  unit = g_new0 (GimpBrushCacheUnit, 1);
+void
+gimp_brush_cache_set_max_memsize (guint64 max_memsize)
+{
+  gimp_brush_cache_max_memsize = max_memsize;
+}
+
+guint64
+gimp_brush_cache_get_total_memsize (void)
+{
+  return gimp_brush_cache_total_memsize;
+}
 
-  unit->data         = data;
+gint
+gimp_brush_cache_get_n_hits (void)
+{
+  return gimp_brush_cache_n_hits;
+}
+
+gint
+gimp_brush_cache_get_n_misses (void)
+{
+  return gimp_brush_cache_n_misses;
+}
+
+
+/*  private functions  */
+
+static guint
+gimp_brush_cache_unit_hash (gconstpointer ptr)
+{
+  const GimpBrushCacheUnit *unit = ptr;
+  guint                     hash;
+
+  hash = unit->width;
+  hash = hash * 31 + unit->height;
+  hash = hash * 31 + g_double_hash (&unit->scale);
+  hash = hash * 31 + g_double_hash (&unit->aspect_ratio);
+  hash = hash * 31 + g_double_hash (&unit->angle);
+  hash = hash * 31 + (unit->reflect ? 1 : 0);
+  hash = hash * 31 + g_double_hash (&unit->hardness);
+
+  return hash;
+}
+
+static gboolean
+gimp_brush_cache_unit_equal (gconstpointer ptr1,
+                             gconstpointer ptr2)
+{
+  const GimpBrushCacheUnit *unit1 = ptr1;
+  const GimpBrushCacheUnit *unit2 = ptr2;
+
+  return unit1->width        == unit2->width        &&
+         unit1->height       == unit2->height       &&
+         unit1->scale        == unit2->scale        &&
+         unit1->aspect_ratio == unit2->aspect_ratio &&
+         unit1->angle        == unit2->angle        &&
+         unit1->reflect      == unit2->reflect      &&
+         unit1->hardness     == unit2->hardness;
+}
+
+static void
+gimp_brush_cache_unit_init (GimpBrushCacheUnit *unit,
+                            gint                width,
+                            gint                height,
+                            gdouble             scale,
+                            gdouble             aspect_ratio,
+                            gdouble             angle,
+                            gboolean            reflect,
+                            gdouble             hardness)
+{
+  /*  adding 0.0 turns -0.0 into 0.0, which compares equal to it, so
+   *  that both hash to the same value
+   */
   unit->width        = width;
   unit->height       = height;
-  unit->scale        = scale;
-  unit->aspect_ratio = aspect_ratio;
-  unit->angle        = angle;
-  unit->reflect      = reflect;
-  unit->hardness     = hardness;
+  unit->scale        = scale        + 0.0;
+  unit->aspect_ratio = aspect_ratio + 0.0;
+  unit->angle        = angle        + 0.0;
+  unit->reflect      = reflect ? TRUE : FALSE;
+  unit->hardness     = hardness     + 0.0;
+}
+
+static void
+gimp_brush_cache_remove_unit (GimpBrushCache     *cache,
+                              GimpBrushCacheUnit *unit)
+{
+  g_hash_table_remove (cache->units, unit);
+  g_queue_unlink (&cache->cached_units, &unit->link);
+
+  cache->memsize -= unit->memsize;
+
+  g_atomic_pointer_add (&gimp_brush_cache_total_memsize, -unit->memsize);
+
+  cache->data_destroy (unit->data);
 
-  cache->cached_units = g_list_prepend (cache->cached_units, unit);
+  g_slice_free (GimpBrushCacheUnit, unit);
 }
@@ -37,12 +37,15 @@ struct _GimpBrushCache
 {
   GimpObject      parent_instance;
 
-  GDestroyNotify  data_destroy;
+  GDestroyNotify   data_destroy;
+  GimpMemsizeFunc  data_get_memsize;
 
-  GList          *cached_units;
+  GHashTable      *units;
+  GQueue           cached_units;  /* most recently used first */
+  gint64           memsize;
 
-  gchar           debug_hit;
-  gchar           debug_miss;
+  gchar            debug_hit;
+  gchar            debug_miss;
 };
 
 struct _GimpBrushCacheClass
@@ -51,28 +54,35 @@ struct _GimpBrushCacheClass
 };
 
 
-GType            gimp_brush_cache_get_type (void) G_GNUC_CONST;
-
-GimpBrushCache * gimp_brush_cache_new      (GDestroyNotify  data_destory,
-                                            gchar           debug_hit,
-                                            gchar           debug_miss);
-
-void             gimp_brush_cache_clear    (GimpBrushCache *cache);
-
-gconstpointer    gimp_brush_cache_get      (GimpBrushCache *cache,
-                                            gint            width,
-                                            gint            height,
-                                            gdouble         scale,
-                                            gdouble         aspect_ratio,
-                                            gdouble         angle,
-                                            gboolean        reflect,
-                                            gdouble         hardness);
-void             gimp_brush_cache_add      (GimpBrushCache *cache,
-                                            gpointer        data,
-                                            gint            width,
-                                            gint            height,
-                                            gdouble         scale,
-                                            gdouble         aspect_ratio,
-                                            gdouble         angle,
-                                            gboolean        reflect,
-                                            gdouble         hardness);
+GType            gimp_brush_cache_get_type          (void) G_GNUC_CONST;
+
+GimpBrushCache * gimp_brush_cache_new               (GDestroyNotify   data_destory,
+                                                     GimpMemsizeFunc  data_get_memsize,
+                                                     gchar            debug_hit,
+                                                     gchar            debug_miss);
+
+void             gimp_brush_cache_clear             (GimpBrushCache  *cache);
+
+gconstpointer    gimp_brush_cache_get               (GimpBrushCache  *cache,
+                                                     gint             width,
+                                                     gint             height,
+                                                     gdouble          scale,
+                                                     gdouble          aspect_ratio,
+                                                     gdouble          angle,
+                                                     gboolean         reflect,
+                                                     gdouble          hardness);
+void             gimp_brush_cache_add               (GimpBrushCache  *cache,
+                                                     gpointer         data,
+                                                     gint             width,
+                                                     gint             height,
+                                                     gdouble          scale,
+                                                     gdouble          aspect_ratio,
+                                                     gdouble          angle,
+                                                     gboolean         reflect,
+                                                     gdouble          hardness);
+
+void             gimp_brush_cache_set_max_memsize   (guint64          max_memsize);
+
+guint64          gimp_brush_cache_get_total_memsize (void);
+gint             gimp_brush_cache_get_n_hits        (void);
+gint             gimp_brush_cache_get_n_misses      (void);
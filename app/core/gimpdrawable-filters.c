@@ -474,22 +474,8 @@ gimp_drawable_merge_filter (GimpDrawable *drawable,
 
   if (! buffer)
     {
-      gegl_rectangle_align_to_buffer (
-        &undo_rect,
-        &rect,
-        gimp_drawable_get_buffer (drawable),
-        GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
-
-      undo_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
-                                                     undo_rect.width,
-                                                     undo_rect.height),
-                                     gimp_drawable_get_format (drawable));
-
-      gimp_gegl_buffer_copy (gimp_drawable_get_buffer (drawable),
-                             &undo_rect,
-                             GEGL_ABYSS_NONE,
-                             undo_buffer,
-                             GEGL_RECTANGLE (0, 0, 0, 0));
+      undo_buffer = gimp_gegl_buffer_snapshot (gimp_drawable_get_buffer (drawable),
+                                               &rect, &undo_rect);
     }
 
   gimp_projection_stop_rendering (gimp_image_get_projection (image));
@@ -218,6 +218,9 @@ static GeglNode * gimp_drawable_real_get_source_node (GimpDrawable    *drawable)
 static void       gimp_drawable_format_changed     (GimpDrawable      *drawable);
 static void       gimp_drawable_alpha_changed      (GimpDrawable      *drawable);
 
+static void       gimp_drawable_set_cached_backdrop (GimpDrawable     *drawable,
+                                                     gboolean          cached);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpDrawable, gimp_drawable, GIMP_TYPE_ITEM,
                          G_ADD_PRIVATE (GimpDrawable)
@@ -230,6 +233,11 @@ G_DEFINE_TYPE_WITH_CODE (GimpDrawable, gimp_drawable, GIMP_TYPE_ITEM,
 
 static guint gimp_drawable_signals[LAST_SIGNAL] = { 0 };
 
+/* disable caching the backdrop of drawables while they're being painted.
+ * see gimp_drawable_set_cached_backdrop().
+ */
+static gboolean no_paint_backdrop_cache = FALSE;
+
 
 static void
 gimp_drawable_class_init (GimpDrawableClass *klass)
@@ -330,6 +338,9 @@ gimp_drawable_class_init (GimpDrawableClass *klass)
   klass->get_source_node          = gimp_drawable_real_get_source_node;
 
   g_object_class_override_property (object_class, PROP_BUFFER, "buffer");
+
+  if (g_getenv ("GIMP_NO_PAINT_BACKDROP_CACHE"))
+    no_paint_backdrop_cache = TRUE;
 }
 
 static void
@@ -1044,28 +1055,14 @@ gimp_drawable_real_push_undo (GimpDrawable *drawable,
 
   if (! buffer)
     {
-      GeglBuffer    *drawable_buffer = gimp_drawable_get_buffer (drawable);
-      GeglRectangle  drawable_rect;
-
-      gegl_rectangle_align_to_buffer (
-        &drawable_rect,
-        GEGL_RECTANGLE (x, y, width, height),
-        drawable_buffer,
-        GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
-
-      x      = drawable_rect.x;
-      y      = drawable_rect.y;
-      width  = drawable_rect.width;
-      height = drawable_rect.height;
+      GeglRectangle drawable_rect;
 
-      buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
-                                gimp_drawable_get_format (drawable));
+      buffer = gimp_gegl_buffer_snapshot (gimp_drawable_get_buffer (drawable),
+                                          GEGL_RECTANGLE (x, y, width, height),
+                                          &drawable_rect);
 
-      gimp_gegl_buffer_copy (
-        drawable_buffer,
-        &drawable_rect, GEGL_ABYSS_NONE,
-        buffer,
-        GEGL_RECTANGLE (0, 0, 0, 0));
+      x = drawable_rect.x;
+      y = drawable_rect.y;
     }
   else
     {
@@ -1091,6 +1088,9 @@ gimp_drawable_real_swap_pixels (GimpDrawable *drawable,
   gint        width  = gegl_buffer_get_width (buffer);
   gint        height = gegl_buffer_get_height (buffer);
 
+  /*  all of these copies share tiles instead of copying pixels, as long
+   *  as 'buffer' was created by gimp_gegl_buffer_snapshot()
+   */
   tmp = gimp_gegl_buffer_dup (buffer);
 
   gimp_gegl_buffer_copy (gimp_drawable_get_buffer (drawable),
@@ -1133,6 +1133,33 @@ gimp_drawable_alpha_changed (GimpDrawable *drawable)
   g_signal_emit (drawable, gimp_drawable_signals[ALPHA_CHANGED], 0);
 }
 
+/*  while a drawable is being painted, nothing but the drawable itself
+ *  normally changes, so the composite of the items below it, as well as
+ *  below each of its ancestors, can be cached, and only the drawable's
+ *  own contribution has to be blended again for each update.
+ */
+static void
+gimp_drawable_set_cached_backdrop (GimpDrawable *drawable,
+                                   gboolean      cached)
+{
+  GimpItem *item;
+
+  if (no_paint_backdrop_cache)
+    return;
+
+  for (item = GIMP_ITEM (drawable); item; item = gimp_item_get_parent (item))
+    {
+      GimpContainer *container = gimp_item_get_container (item);
+
+      if (! GIMP_IS_FILTER_STACK (container))
+        break;
+
+      gimp_filter_stack_set_cached_backdrop (GIMP_FILTER_STACK (container),
+                                             cached ? GIMP_FILTER (item) :
+                                                      NULL);
+    }
+}
+
 
 /*  public functions  */
 
@@ -2082,6 +2109,8 @@ gimp_drawable_start_paint (GimpDrawable *drawable)
       g_return_if_fail (drawable->private->paint_update_region == NULL);
 
       drawable->private->paint_buffer = gimp_gegl_buffer_dup (buffer);
+
+      gimp_drawable_set_cached_backdrop (drawable, TRUE);
     }
 
   drawable->private->paint_count++;
@@ -2100,6 +2129,8 @@ gimp_drawable_end_paint (GimpDrawable *drawable)
       result = gimp_drawable_flush_paint (drawable);
 
       g_clear_object (&drawable->private->paint_buffer);
+
+      gimp_drawable_set_cached_backdrop (drawable, FALSE);
     }
 
   drawable->private->paint_count--;
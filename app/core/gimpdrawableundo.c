@@ -17,18 +17,38 @@
 
 #include "config.h"
 
+#include <zlib.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
 #include "libgimpbase/gimpbase.h"
+#include "libgimpconfig/gimpconfig.h"
 
 #include "core-types.h"
 
+#include "config/gimpgeglconfig.h"
+
+#include "gimp.h"
 #include "gimp-memsize.h"
+#include "gimp-parallel.h"
+#include "gimp-utils.h"
+#include "gimpasync.h"
+#include "gimpcancelable.h"
 #include "gimpimage.h"
+#include "gimpimage-undo.h"
 #include "gimpdrawable.h"
 #include "gimpdrawable-filters.h"
 #include "gimpdrawableundo.h"
+#include "gimpwaitable.h"
+
+#include "gimp-intl.h"
+
+
+/* compressed data is only kept if it is at most this fraction of the
+ * raw pixel data, otherwise decompressing on undo isn't worth it
+ */
+#define MAX_COMPRESSION_RATIO 0.9
 
 
 enum
@@ -40,30 +60,100 @@ enum
 };
 
 
-static void     gimp_drawable_undo_constructed  (GObject             *object);
-static void     gimp_drawable_undo_set_property (GObject             *object,
-                                                 guint                property_id,
-                                                 const GValue        *value,
-                                                 GParamSpec          *pspec);
-static void     gimp_drawable_undo_get_property (GObject             *object,
-                                                 guint                property_id,
-                                                 GValue              *value,
-                                                 GParamSpec          *pspec);
+struct _GimpDrawableUndoCompressed
+{
+  const Babl  *format;
+  gint         width;
+  gint         height;
+  gint         tile_width;
+  gint         tile_height;
 
-static gint64   gimp_drawable_undo_get_memsize  (GimpObject          *object,
-                                                 gint64              *gui_size);
+  gint         n_tiles;
+  GBytes     **tiles;
 
-static void     gimp_drawable_undo_pop          (GimpUndo            *undo,
-                                                 GimpUndoMode         undo_mode,
-                                                 GimpUndoAccumulator *accum);
-static void     gimp_drawable_undo_free         (GimpUndo            *undo,
-                                                 GimpUndoMode         undo_mode);
+  gint64       raw_size;
+  gint64       compressed_size;
+
+  /*  set while the tiles are swapped out to disk  */
+  GFile       *swap_file;
+  gsize       *tile_sizes;
+};
+
+typedef struct
+{
+  GimpDrawableUndo           *drawable_undo;
+  GeglBuffer                 *buffer;     /* NULL if already compressed */
+  GimpDrawableUndoCompressed *compressed;
+  GFile                      *swap_dir;   /* set when spilling          */
+  GError                     *error;
+} CompressData;
+
+
+static void         gimp_drawable_undo_constructed             (GObject                    *object);
+static void         gimp_drawable_undo_finalize                (GObject                    *object);
+static void         gimp_drawable_undo_set_property            (GObject                    *object,
+                                                                guint                       property_id,
+                                                                const GValue               *value,
+                                                                GParamSpec                 *pspec);
+static void         gimp_drawable_undo_get_property            (GObject                    *object,
+                                                                guint                       property_id,
+                                                                GValue                     *value,
+                                                                GParamSpec                 *pspec);
+
+static gint64       gimp_drawable_undo_get_memsize             (GimpObject                 *object,
+                                                                gint64                     *gui_size);
+
+static void         gimp_drawable_undo_pop                     (GimpUndo                   *undo,
+                                                                GimpUndoMode                undo_mode,
+                                                                GimpUndoAccumulator        *accum);
+static void         gimp_drawable_undo_free                    (GimpUndo                   *undo,
+                                                                GimpUndoMode                undo_mode);
+static void         gimp_drawable_undo_compress                (GimpUndo                   *undo);
+static gboolean     gimp_drawable_undo_get_compression         (GimpUndo                   *undo,
+                                                                gint64                     *raw_size,
+                                                                gint64                     *compressed_size);
+static gboolean     gimp_drawable_undo_spill                   (GimpUndo                   *undo);
+static gint64       gimp_drawable_undo_get_swap_size           (GimpUndo                   *undo);
+static gboolean     gimp_drawable_undo_reload                  (GimpUndo                   *undo,
+                                                                GError                    **error);
+
+static void         gimp_drawable_undo_compress_async          (GimpAsync                  *async,
+                                                                CompressData               *data);
+static void         gimp_drawable_undo_compress_async_callback (GimpAsync                  *async,
+                                                                CompressData               *data);
+static void         gimp_drawable_undo_compress_abort          (GimpDrawableUndo           *drawable_undo);
+static GeglBuffer * gimp_drawable_undo_decompress              (GimpDrawableUndo           *drawable_undo,
+                                                                GError                    **error);
+static void         gimp_drawable_undo_clear_compressed        (GimpDrawableUndo           *drawable_undo);
+
+static GimpDrawableUndoCompressed *
+                    compressed_new                             (GeglBuffer                 *buffer);
+static GimpDrawableUndoCompressed *
+                    compressed_copy                            (GimpDrawableUndoCompressed *compressed);
+static void         compressed_free                            (GimpDrawableUndoCompressed *compressed);
+static void         compressed_account                         (GimpDrawableUndoCompressed *compressed,
+                                                                gint                        sign);
+static gboolean     compressed_fill                            (GimpDrawableUndoCompressed *compressed,
+                                                                GeglBuffer                 *buffer,
+                                                                GimpAsync                  *async);
+static gboolean     compressed_swap_out                        (GimpDrawableUndoCompressed *compressed,
+                                                                GFile                      *swap_dir,
+                                                                GError                    **error);
+static gboolean     compressed_swap_in                         (GimpDrawableUndoCompressed *compressed,
+                                                                GError                    **error);
+static void         compressed_get_tile                        (GimpDrawableUndoCompressed *compressed,
+                                                                gint                        tile,
+                                                                GeglRectangle              *rect);
 
 
 G_DEFINE_TYPE (GimpDrawableUndo, gimp_drawable_undo, GIMP_TYPE_ITEM_UNDO)
 
 #define parent_class gimp_drawable_undo_parent_class
 
+static guintptr gimp_drawable_undo_total_raw_size        = 0;
+static guintptr gimp_drawable_undo_total_compressed_size = 0;
+static guintptr gimp_drawable_undo_total_swap_size       = 0;
+
 
 static void
 gimp_drawable_undo_class_init (GimpDrawableUndoClass *klass)
@@ -73,6 +163,7 @@ gimp_drawable_undo_class_init (GimpDrawableUndoClass *klass)
   GimpUndoClass   *undo_class        = GIMP_UNDO_CLASS (klass);
 
   object_class->constructed      = gimp_drawable_undo_constructed;
+  object_class->finalize         = gimp_drawable_undo_finalize;
   object_class->set_property     = gimp_drawable_undo_set_property;
   object_class->get_property     = gimp_drawable_undo_get_property;
 
@@ -80,6 +171,11 @@ gimp_drawable_undo_class_init (GimpDrawableUndoClass *klass)
 
   undo_class->pop                = gimp_drawable_undo_pop;
   undo_class->free               = gimp_drawable_undo_free;
+  undo_class->compress           = gimp_drawable_undo_compress;
+  undo_class->get_compression    = gimp_drawable_undo_get_compression;
+  undo_class->spill              = gimp_drawable_undo_spill;
+  undo_class->get_swap_size      = gimp_drawable_undo_get_swap_size;
+  undo_class->reload             = gimp_drawable_undo_reload;
 
   g_object_class_install_property (object_class, PROP_BUFFER,
                                    g_param_spec_object ("buffer", NULL, NULL,
@@ -116,6 +212,19 @@ gimp_drawable_undo_constructed (GObject *object)
   gimp_assert (GEGL_IS_BUFFER (drawable_undo->buffer));
 }
 
+static void
+gimp_drawable_undo_finalize (GObject *object)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (object);
+
+  gimp_drawable_undo_compress_abort (drawable_undo);
+
+  g_clear_object (&drawable_undo->buffer);
+  gimp_drawable_undo_clear_compressed (drawable_undo);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gimp_drawable_undo_set_property (GObject      *object,
                                  guint         property_id,
@@ -175,7 +284,22 @@ gimp_drawable_undo_get_memsize (GimpObject *object,
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (object);
   gint64            memsize       = 0;
 
-  memsize += gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+  /*  while spilling, the payload already counts as swapped out, so
+   *  that freeing undo space doesn't free steps because of memory which
+   *  is about to be released
+   */
+  if (! drawable_undo->spilling)
+    memsize += gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+
+  if (drawable_undo->compressed)
+    {
+      GimpDrawableUndoCompressed *compressed = drawable_undo->compressed;
+
+      if (compressed->swap_file || drawable_undo->spilling)
+        memsize += compressed->n_tiles * sizeof (gsize);
+      else
+        memsize += compressed->compressed_size;
+    }
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -191,10 +315,16 @@ gimp_drawable_undo_pop (GimpUndo            *undo,
 
   GIMP_UNDO_CLASS (parent_class)->pop (undo, undo_mode, accum);
 
-  gimp_drawable_swap_pixels (drawable,
-                             drawable_undo->buffer,
-                             drawable_undo->x,
-                             drawable_undo->y);
+  /*  gimp_drawable_undo_reload() brought back the compressed pixels  */
+  g_return_if_fail (drawable_undo->compressed == NULL);
+
+  if (drawable_undo->buffer)
+    {
+      gimp_drawable_swap_pixels (drawable,
+                                 drawable_undo->buffer,
+                                 drawable_undo->x,
+                                 drawable_undo->y);
+    }
 
   if (gimp_drawable_has_visible_filters (drawable))
     gimp_drawable_update (drawable, 0, 0, -1, -1);
@@ -206,7 +336,626 @@ gimp_drawable_undo_free (GimpUndo     *undo,
 {
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
 
+  gimp_drawable_undo_compress_abort (drawable_undo);
+
   g_clear_object (&drawable_undo->buffer);
+  gimp_drawable_undo_clear_compressed (drawable_undo);
 
   GIMP_UNDO_CLASS (parent_class)->free (undo, undo_mode);
 }
+
+static void
+gimp_drawable_undo_compress (GimpUndo *undo)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+  CompressData     *data;
+
+  if (! drawable_undo->buffer || drawable_undo->compress_async)
+    return;
+
+  data = g_slice_new0 (CompressData);
+
+  data->drawable_undo = drawable_undo;
+  data->buffer        = g_object_ref (drawable_undo->buffer);
+  data->compressed    = compressed_new (data->buffer);
+
+  /*  compressing is never urgent, let it yield to everything else  */
+  drawable_undo->compress_async = gimp_parallel_run_async_full (
+    +10,
+    (GimpRunAsyncFunc) gimp_drawable_undo_compress_async,
+    data,
+    NULL);
+
+  gimp_async_add_callback (
+    drawable_undo->compress_async,
+    (GimpAsyncCallback) gimp_drawable_undo_compress_async_callback,
+    data);
+}
+
+static gboolean
+gimp_drawable_undo_get_compression (GimpUndo *undo,
+                                    gint64   *raw_size,
+                                    gint64   *compressed_size)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+
+  if (drawable_undo->compressed)
+    {
+      *raw_size        = drawable_undo->compressed->raw_size;
+      *compressed_size = drawable_undo->compressed->compressed_size;
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*  compresses the buffer, unless it already is, and writes it to the
+ *  swap in the background, like gimp_drawable_undo_compress()
+ */
+static gboolean
+gimp_drawable_undo_spill (GimpUndo *undo)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+  CompressData     *data;
+  GFile            *swap_dir;
+  GError           *error         = NULL;
+
+  if (drawable_undo->spilling)
+    return FALSE;
+
+  if (drawable_undo->compressed && drawable_undo->compressed->swap_file)
+    return FALSE;
+
+  gimp_drawable_undo_compress_abort (drawable_undo);
+
+  if (! drawable_undo->compressed && ! drawable_undo->buffer)
+    return FALSE;
+
+  swap_dir = gimp_file_new_for_config_path (
+    GIMP_GEGL_CONFIG (undo->image->gimp->config)->swap_path, &error);
+
+  if (! swap_dir)
+    {
+      gimp_image_undo_spill_failed (undo->image, error);
+      g_clear_error (&error);
+
+      return FALSE;
+    }
+
+  data = g_slice_new0 (CompressData);
+
+  data->drawable_undo = drawable_undo;
+  data->swap_dir      = swap_dir;
+
+  if (drawable_undo->compressed)
+    {
+      data->compressed = compressed_copy (drawable_undo->compressed);
+    }
+  else
+    {
+      data->buffer     = g_object_ref (drawable_undo->buffer);
+      data->compressed = compressed_new (data->buffer);
+    }
+
+  drawable_undo->spilling       = TRUE;
+  drawable_undo->compress_async = gimp_parallel_run_async_full (
+    +10,
+    (GimpRunAsyncFunc) gimp_drawable_undo_compress_async,
+    data,
+    NULL);
+
+  gimp_async_add_callback (
+    drawable_undo->compress_async,
+    (GimpAsyncCallback) gimp_drawable_undo_compress_async_callback,
+    data);
+
+  gimp_undo_memsize_changed (undo);
+
+  return TRUE;
+}
+
+static gint64
+gimp_drawable_undo_get_swap_size (GimpUndo *undo)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+
+  if (drawable_undo->compressed &&
+      (drawable_undo->compressed->swap_file || drawable_undo->spilling))
+    {
+      return drawable_undo->compressed->compressed_size;
+    }
+
+  /*  the compressed size isn't known yet, assume the worst  */
+  if (drawable_undo->spilling)
+    return gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+
+  return 0;
+}
+
+/*  reads swapped out tiles back and decompresses them.  if that fails,
+ *  the compressed tiles and the swap file are kept, and the undo step
+ *  is not popped
+ */
+static gboolean
+gimp_drawable_undo_reload (GimpUndo  *undo,
+                           GError   **error)
+{
+  GimpDrawableUndo           *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+  GimpDrawableUndoCompressed *compressed;
+  GeglBuffer                 *buffer;
+
+  /*  waits for a running spill to land  */
+  gimp_drawable_undo_compress_abort (drawable_undo);
+
+  compressed = drawable_undo->compressed;
+
+  if (! compressed)
+    return TRUE;
+
+  if (compressed->swap_file)
+    {
+      gboolean success;
+
+      compressed_account (compressed, -1);
+
+      success = compressed_swap_in (compressed, error);
+
+      compressed_account (compressed, +1);
+
+      if (! success)
+        {
+          g_prefix_error (error,
+                          _("Could not read undo data from the swap: "));
+
+          return FALSE;
+        }
+    }
+
+  buffer = gimp_drawable_undo_decompress (drawable_undo, error);
+
+  if (! buffer)
+    {
+      g_prefix_error (error, _("Could not decompress undo data: "));
+
+      gimp_undo_memsize_changed (undo);
+
+      return FALSE;
+    }
+
+  drawable_undo->buffer = buffer;
+
+  gimp_drawable_undo_clear_compressed (drawable_undo);
+
+  gimp_undo_memsize_changed (undo);
+
+  return TRUE;
+}
+
+static void
+gimp_drawable_undo_compress_async (GimpAsync    *async,
+                                   CompressData *data)
+{
+  if (data->buffer &&
+      ! compressed_fill (data->compressed, data->buffer, async))
+    {
+      gimp_async_abort (async);
+      return;
+    }
+
+  if (data->swap_dir &&
+      ! compressed_swap_out (data->compressed, data->swap_dir, &data->error))
+    {
+      gimp_async_abort (async);
+      return;
+    }
+
+  gimp_async_finish (async, NULL);
+}
+
+static void
+gimp_drawable_undo_compress_async_callback (GimpAsync    *async,
+                                            CompressData *data)
+{
+  GimpDrawableUndo           *drawable_undo = data->drawable_undo;
+  GimpDrawableUndoCompressed *compressed    = data->compressed;
+
+  drawable_undo->compress_async = NULL;
+  drawable_undo->spilling       = FALSE;
+
+  /*  swapped out data is kept no matter how well it compressed  */
+  if (gimp_async_is_finished (async) &&
+      (data->swap_dir ||
+       compressed->compressed_size <
+       compressed->raw_size * MAX_COMPRESSION_RATIO))
+    {
+      g_clear_object (&drawable_undo->buffer);
+      gimp_drawable_undo_clear_compressed (drawable_undo);
+
+      drawable_undo->compressed = g_steal_pointer (&data->compressed);
+
+      compressed_account (compressed, +1);
+    }
+  else if (data->error)
+    {
+      gimp_image_undo_spill_failed (GIMP_UNDO (drawable_undo)->image,
+                                    data->error);
+    }
+
+  /*  also when a spill failed, the payload counted as gone meanwhile  */
+  gimp_undo_memsize_changed (GIMP_UNDO (drawable_undo));
+
+  g_clear_object (&data->buffer);
+  g_clear_pointer (&data->compressed, compressed_free);
+  g_clear_object (&data->swap_dir);
+  g_clear_error (&data->error);
+
+  g_slice_free (CompressData, data);
+}
+
+static void
+gimp_drawable_undo_compress_abort (GimpDrawableUndo *drawable_undo)
+{
+  if (drawable_undo->compress_async)
+    {
+      /*  waiting runs the callback, which clears compress_async  */
+      gimp_cancelable_cancel (GIMP_CANCELABLE (drawable_undo->compress_async));
+      gimp_waitable_wait (GIMP_WAITABLE (drawable_undo->compress_async));
+    }
+}
+
+static GeglBuffer *
+gimp_drawable_undo_decompress (GimpDrawableUndo  *drawable_undo,
+                               GError           **error)
+{
+  GimpDrawableUndoCompressed *compressed = drawable_undo->compressed;
+  GeglBuffer                 *buffer;
+  gint                        bpp;
+  guchar                     *dest;
+  gint                        i;
+
+  bpp  = babl_format_get_bytes_per_pixel (compressed->format);
+  dest = g_malloc ((gsize) compressed->tile_width *
+                   compressed->tile_height * bpp);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                            compressed->width,
+                                            compressed->height),
+                            compressed->format);
+
+  for (i = 0; i < compressed->n_tiles; i++)
+    {
+      GeglRectangle  rect;
+      const guchar  *src;
+      gsize          src_size;
+      uLongf         dest_size;
+
+      compressed_get_tile (compressed, i, &rect);
+
+      src       = g_bytes_get_data (compressed->tiles[i], &src_size);
+      dest_size = (uLongf) rect.width * rect.height * bpp;
+
+      if (uncompress (dest, &dest_size, src, src_size) != Z_OK ||
+          dest_size != (uLongf) rect.width * rect.height * bpp)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                       _("Tile %d is corrupt."), i);
+          g_object_unref (buffer);
+          g_free (dest);
+
+          return NULL;
+        }
+
+      gegl_buffer_set (buffer, &rect, 0,
+                       compressed->format, dest,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (dest);
+
+  return buffer;
+}
+
+static void
+gimp_drawable_undo_clear_compressed (GimpDrawableUndo *drawable_undo)
+{
+  GimpDrawableUndoCompressed *compressed = drawable_undo->compressed;
+
+  if (compressed)
+    {
+      compressed_account (compressed, -1);
+
+      compressed_free (compressed);
+
+      drawable_undo->compressed = NULL;
+    }
+}
+
+static GimpDrawableUndoCompressed *
+compressed_new (GeglBuffer *buffer)
+{
+  GimpDrawableUndoCompressed *compressed;
+  gint                        n_columns;
+  gint                        n_rows;
+
+  compressed = g_slice_new0 (GimpDrawableUndoCompressed);
+
+  compressed->format = gegl_buffer_get_format (buffer);
+  compressed->width  = gegl_buffer_get_width  (buffer);
+  compressed->height = gegl_buffer_get_height (buffer);
+
+  g_object_get (buffer,
+                "tile-width",  &compressed->tile_width,
+                "tile-height", &compressed->tile_height,
+                NULL);
+
+  n_columns = (compressed->width  + compressed->tile_width  - 1) /
+              compressed->tile_width;
+  n_rows    = (compressed->height + compressed->tile_height - 1) /
+              compressed->tile_height;
+
+  compressed->n_tiles  = n_columns * n_rows;
+  compressed->tiles    = g_new0 (GBytes *, compressed->n_tiles);
+  compressed->raw_size = (gint64) compressed->width * compressed->height *
+                         babl_format_get_bytes_per_pixel (compressed->format);
+
+  return compressed;
+}
+
+/*  returns a copy of the in-memory 'compressed', sharing its tiles  */
+static GimpDrawableUndoCompressed *
+compressed_copy (GimpDrawableUndoCompressed *compressed)
+{
+  GimpDrawableUndoCompressed *copy;
+  gint                        i;
+
+  copy = g_slice_dup (GimpDrawableUndoCompressed, compressed);
+
+  copy->tiles = g_new (GBytes *, compressed->n_tiles);
+
+  for (i = 0; i < compressed->n_tiles; i++)
+    copy->tiles[i] = g_bytes_ref (compressed->tiles[i]);
+
+  return copy;
+}
+
+static void
+compressed_free (GimpDrawableUndoCompressed *compressed)
+{
+  gint i;
+
+  for (i = 0; i < compressed->n_tiles; i++)
+    {
+      if (compressed->tiles[i])
+        g_bytes_unref (compressed->tiles[i]);
+    }
+
+  g_free (compressed->tiles);
+
+  if (compressed->swap_file)
+    {
+      g_file_delete (compressed->swap_file, NULL, NULL);
+      g_object_unref (compressed->swap_file);
+    }
+
+  g_free (compressed->tile_sizes);
+
+  g_slice_free (GimpDrawableUndoCompressed, compressed);
+}
+
+/*  adds (sign = +1) or removes (sign = -1) 'compressed' to/from the
+ *  totals shown in the dashboard
+ */
+static void
+compressed_account (GimpDrawableUndoCompressed *compressed,
+                    gint                        sign)
+{
+  if (compressed->swap_file)
+    {
+      g_atomic_pointer_add (&gimp_drawable_undo_total_swap_size,
+                            sign * (gssize) compressed->compressed_size);
+    }
+  else
+    {
+      g_atomic_pointer_add (&gimp_drawable_undo_total_raw_size,
+                            sign * (gssize) compressed->raw_size);
+      g_atomic_pointer_add (&gimp_drawable_undo_total_compressed_size,
+                            sign * (gssize) compressed->compressed_size);
+    }
+}
+
+/*  compresses 'buffer' into 'compressed', returns FALSE if compression
+ *  failed or 'async' was canceled
+ */
+static gboolean
+compressed_fill (GimpDrawableUndoCompressed *compressed,
+                 GeglBuffer                 *buffer,
+                 GimpAsync                  *async)
+{
+  gint    bpp;
+  gsize   tile_size;
+  uLong   bound;
+  guchar *src;
+  guchar *dest;
+  gint    i;
+
+  bpp       = babl_format_get_bytes_per_pixel (compressed->format);
+  tile_size = (gsize) compressed->tile_width * compressed->tile_height * bpp;
+  bound     = compressBound (tile_size);
+
+  src  = g_malloc (tile_size);
+  dest = g_malloc (bound);
+
+  for (i = 0; i < compressed->n_tiles; i++)
+    {
+      GeglRectangle rect;
+      uLongf        dest_size = bound;
+
+      if (async && gimp_async_is_canceled (async))
+        break;
+
+      compressed_get_tile (compressed, i, &rect);
+
+      gegl_buffer_get (buffer, &rect, 1.0,
+                       compressed->format, src,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      if (compress2 (dest, &dest_size,
+                     src, (uLong) rect.width * rect.height * bpp,
+                     Z_BEST_SPEED) != Z_OK)
+        break;
+
+      compressed->tiles[i]         = g_bytes_new (dest, dest_size);
+      compressed->compressed_size += dest_size;
+    }
+
+  g_free (src);
+  g_free (dest);
+
+  return i == compressed->n_tiles;
+}
+
+/*  writes the tiles of 'compressed' to a new file in 'swap_dir'.  runs
+ *  in the background, see gimp_drawable_undo_spill()
+ */
+static gboolean
+compressed_swap_out (GimpDrawableUndoCompressed  *compressed,
+                     GFile                       *swap_dir,
+                     GError                     **error)
+{
+  static gint    id = 0;
+  GFile         *file;
+  GOutputStream *output;
+  gchar         *basename;
+  gboolean       success = TRUE;
+  gint           i;
+
+  basename = g_strdup_printf ("gimp-undo-%d-%d.swap", gimp_get_pid (),
+                              g_atomic_int_add (&id, 1));
+  file     = g_file_get_child (swap_dir, basename);
+
+  g_free (basename);
+
+  output = G_OUTPUT_STREAM (g_file_replace (file,
+                                            NULL, FALSE,
+                                            G_FILE_CREATE_PRIVATE,
+                                            NULL, error));
+  if (! output)
+    {
+      g_object_unref (file);
+
+      return FALSE;
+    }
+
+  for (i = 0; success && i < compressed->n_tiles; i++)
+    {
+      gsize         size;
+      gconstpointer data = g_bytes_get_data (compressed->tiles[i], &size);
+
+      success = g_output_stream_write_all (output, data, size,
+                                           NULL, NULL, error);
+    }
+
+  if (success)
+    success = g_output_stream_close (output, NULL, error);
+
+  g_object_unref (output);
+
+  if (! success)
+    {
+      g_file_delete (file, NULL, NULL);
+      g_object_unref (file);
+
+      return FALSE;
+    }
+
+  compressed->tile_sizes = g_new (gsize, compressed->n_tiles);
+
+  for (i = 0; i < compressed->n_tiles; i++)
+    {
+      compressed->tile_sizes[i] = g_bytes_get_size (compressed->tiles[i]);
+
+      g_clear_pointer (&compressed->tiles[i], g_bytes_unref);
+    }
+
+  compressed->swap_file = file;
+
+  return TRUE;
+}
+
+static gboolean
+compressed_swap_in (GimpDrawableUndoCompressed  *compressed,
+                    GError                     **error)
+{
+  gchar  *contents;
+  gsize   length;
+  GBytes *bytes;
+  gsize   offset = 0;
+  gint    i;
+
+  if (! g_file_load_contents (compressed->swap_file, NULL,
+                              &contents, &length, NULL, error))
+    return FALSE;
+
+  if (length != compressed->compressed_size)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                           _("The swap file is truncated."));
+      g_free (contents);
+
+      return FALSE;
+    }
+
+  bytes = g_bytes_new_take (contents, length);
+
+  for (i = 0; i < compressed->n_tiles; i++)
+    {
+      compressed->tiles[i] = g_bytes_new_from_bytes (bytes, offset,
+                                                     compressed->tile_sizes[i]);
+
+      offset += compressed->tile_sizes[i];
+    }
+
+  g_bytes_unref (bytes);
+
+  g_file_delete (compressed->swap_file, NULL, NULL);
+  g_clear_object (&compressed->swap_file);
+  g_clear_pointer (&compressed->tile_sizes, g_free);
+
+  return TRUE;
+}
+
+static void
+compressed_get_tile (GimpDrawableUndoCompressed *compressed,
+                     gint                        tile,
+                     GeglRectangle              *rect)
+{
+  gint n_columns = (compressed->width + compressed->tile_width - 1) /
+                   compressed->tile_width;
+
+  rect->x      = (tile % n_columns) * compressed->tile_width;
+  rect->y      = (tile / n_columns) * compressed->tile_height;
+  rect->width  = MIN (compressed->tile_width,  compressed->width  - rect->x);
+  rect->height = MIN (compressed->tile_height, compressed->height - rect->y);
+}
+
+
+/*  public functions  */
+
+guint64
+gimp_drawable_undo_get_total_raw_size (void)
+{
+  return gimp_drawable_undo_total_raw_size;
+}
+
+guint64
+gimp_drawable_undo_get_total_compressed_size (void)
+{
+  return gimp_drawable_undo_total_compressed_size;
+}
+
+guint64
+gimp_drawable_undo_get_total_swap_size (void)
+{
+  return gimp_drawable_undo_total_swap_size;
+}
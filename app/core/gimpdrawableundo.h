@@ -28,16 +28,22 @@
 #define GIMP_DRAWABLE_UNDO_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GIMP_TYPE_DRAWABLE_UNDO, GimpDrawableUndoClass))
 
 
-typedef struct _GimpDrawableUndo      GimpDrawableUndo;
-typedef struct _GimpDrawableUndoClass GimpDrawableUndoClass;
+typedef struct _GimpDrawableUndo           GimpDrawableUndo;
+typedef struct _GimpDrawableUndoClass      GimpDrawableUndoClass;
+typedef struct _GimpDrawableUndoCompressed GimpDrawableUndoCompressed;
 
 struct _GimpDrawableUndo
 {
-  GimpItemUndo  parent_instance;
+  GimpItemUndo                parent_instance;
 
-  GeglBuffer   *buffer;
-  gint          x;
-  gint          y;
+  GeglBuffer                 *buffer;
+  gint                        x;
+  gint                        y;
+
+  /*  replaces buffer once compression has finished  */
+  GimpDrawableUndoCompressed *compressed;
+  GimpAsync                  *compress_async;
+  gboolean                    spilling;  /* compress_async also swaps out */
 };
 
 struct _GimpDrawableUndoClass
@@ -46,4 +52,8 @@ struct _GimpDrawableUndoClass
 };
 
 
-GType   gimp_drawable_undo_get_type (void) G_GNUC_CONST;
+GType     gimp_drawable_undo_get_type                  (void) G_GNUC_CONST;
+
+guint64   gimp_drawable_undo_get_total_raw_size        (void);
+guint64   gimp_drawable_undo_get_total_compressed_size (void);
+guint64   gimp_drawable_undo_get_total_swap_size       (void);
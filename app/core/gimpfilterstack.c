@@ -48,6 +48,8 @@ static void   gimp_filter_stack_add_node         (GimpFilterStack *stack,
 static void   gimp_filter_stack_remove_node      (GimpFilterStack *stack,
                                                   GimpFilter      *filter);
 static void   gimp_filter_stack_update_last_node (GimpFilterStack *stack);
+static void   gimp_filter_stack_add_cache        (GimpFilterStack *stack);
+static void   gimp_filter_stack_remove_cache     (GimpFilterStack *stack);
 
 static void   gimp_filter_stack_filter_active    (GimpFilter      *filter,
                                                   GimpFilterStack *stack);
@@ -109,6 +111,8 @@ gimp_filter_stack_add (GimpContainer *container,
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
 
+  gimp_filter_stack_remove_cache (stack);
+
   GIMP_CONTAINER_CLASS (parent_class)->add (container, object);
 
   if (gimp_filter_get_active (filter))
@@ -121,6 +125,8 @@ gimp_filter_stack_add (GimpContainer *container,
 
       gimp_filter_stack_update_last_node (stack);
     }
+
+  gimp_filter_stack_add_cache (stack);
 }
 
 static void
@@ -130,6 +136,11 @@ gimp_filter_stack_remove (GimpContainer *container,
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
 
+  gimp_filter_stack_remove_cache (stack);
+
+  if (filter == stack->cached_filter)
+    stack->cached_filter = NULL;
+
   if (stack->graph && gimp_filter_get_active (filter))
     {
       gimp_filter_stack_remove_node (stack, filter);
@@ -143,6 +154,8 @@ gimp_filter_stack_remove (GimpContainer *container,
       gimp_filter_set_is_last_node (filter, FALSE);
       gimp_filter_stack_update_last_node (stack);
     }
+
+  gimp_filter_stack_add_cache (stack);
 }
 
 static void
@@ -154,6 +167,8 @@ gimp_filter_stack_reorder (GimpContainer *container,
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
 
+  gimp_filter_stack_remove_cache (stack);
+
   if (stack->graph && gimp_filter_get_active (filter))
     gimp_filter_stack_remove_node (stack, filter);
 
@@ -167,6 +182,8 @@ gimp_filter_stack_reorder (GimpContainer *container,
       if (stack->graph)
         gimp_filter_stack_add_node (stack, filter);
     }
+
+  gimp_filter_stack_add_cache (stack);
 }
 
 
@@ -223,9 +240,43 @@ gimp_filter_stack_get_graph (GimpFilterStack *stack)
 
   gegl_node_link (previous, output);
 
+  gimp_filter_stack_add_cache (stack);
+
   return stack->graph;
 }
 
+/**
+ * gimp_filter_stack_set_cached_backdrop:
+ * @stack:  a #GimpFilterStack
+ * @filter: a filter in @stack, or %NULL
+ *
+ * Caches the composite of the filters below @filter, which is used as
+ * its input, so that when only @filter itself changes, such as while
+ * a drawable is being painted on, the filters below it don't have to
+ * be processed again.  The cache is kept up to date with changes below
+ * @filter, but it takes memory, so it should only be kept for as long
+ * as it's useful.  Pass %NULL to drop the cache.
+ **/
+void
+gimp_filter_stack_set_cached_backdrop (GimpFilterStack *stack,
+                                       GimpFilter      *filter)
+{
+  g_return_if_fail (GIMP_IS_FILTER_STACK (stack));
+  g_return_if_fail (filter == NULL || GIMP_IS_FILTER (filter));
+  g_return_if_fail (filter == NULL ||
+                    gimp_container_have (GIMP_CONTAINER (stack),
+                                         GIMP_OBJECT (filter)));
+
+  if (filter != stack->cached_filter)
+    {
+      gimp_filter_stack_remove_cache (stack);
+
+      stack->cached_filter = filter;
+
+      gimp_filter_stack_add_cache (stack);
+    }
+}
+
 
 /*  private functions  */
 
@@ -323,10 +374,63 @@ gimp_filter_stack_update_last_node (GimpFilterStack *stack)
     }
 }
 
+static void
+gimp_filter_stack_add_cache (GimpFilterStack *stack)
+{
+  GeglNode *node;
+  GeglNode *node_below;
+
+  if (! stack->graph         ||
+      ! stack->cached_filter ||
+      stack->cache_node      ||
+      ! gimp_filter_get_active (stack->cached_filter))
+    {
+      return;
+    }
+
+  node       = gimp_filter_get_node (stack->cached_filter);
+  node_below = gegl_node_get_producer (node, "input", NULL);
+
+  if (! node_below)
+    return;
+
+  stack->cache_node = gegl_node_new_child (stack->graph,
+                                           "operation", "gegl:cache",
+                                           NULL);
+
+  gegl_node_link (node_below, stack->cache_node);
+  gegl_node_link (stack->cache_node, node);
+}
+
+static void
+gimp_filter_stack_remove_cache (GimpFilterStack *stack)
+{
+  GeglNode *node;
+  GeglNode *node_below;
+
+  if (! stack->cache_node)
+    return;
+
+  node       = gimp_filter_get_node (stack->cached_filter);
+  node_below = gegl_node_get_producer (stack->cache_node, "input", NULL);
+
+  gegl_node_disconnect (stack->cache_node, "input");
+
+  if (node_below)
+    gegl_node_link (node_below, node);
+  else
+    gegl_node_disconnect (node, "input");
+
+  gegl_node_remove_child (stack->graph, stack->cache_node);
+  stack->cache_node = NULL;
+}
+
 static void
 gimp_filter_stack_filter_active (GimpFilter      *filter,
                                  GimpFilterStack *stack)
 {
+  gimp_filter_stack_remove_cache (stack);
+
   if (stack->graph)
     {
       if (gimp_filter_get_active (filter))
@@ -345,4 +449,6 @@ gimp_filter_stack_filter_active (GimpFilter      *filter,
 
   if (! gimp_filter_get_active (filter))
     gimp_filter_set_is_last_node (filter, FALSE);
+
+  gimp_filter_stack_add_cache (stack);
 }
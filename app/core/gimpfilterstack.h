@@ -36,7 +36,10 @@ struct _GimpFilterStack
 {
   GimpList  parent_instance;
 
-  GeglNode *graph;
+  GeglNode   *graph;
+
+  GimpFilter *cached_filter;
+  GeglNode   *cache_node;
 };
 
 struct _GimpFilterStackClass
@@ -49,3 +52,7 @@ GType           gimp_filter_stack_get_type  (void) G_GNUC_CONST;
 GimpContainer * gimp_filter_stack_new       (GType            filter_type);
 
 GeglNode *      gimp_filter_stack_get_graph (GimpFilterStack *stack);
+
+void            gimp_filter_stack_set_cached_backdrop
+                                            (GimpFilterStack *stack,
+                                             GimpFilter      *filter);
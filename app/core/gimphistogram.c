@@ -37,6 +37,7 @@
 #include "gimp-atomic.h"
 #include "gimp-parallel.h"
 #include "gimpasync.h"
+#include "gimpcancelable.h"
 #include "gimpdrawable.h"
 #include "gimphistogram.h"
 #include "gimpwaitable.h"
@@ -74,6 +75,11 @@ typedef struct
   GeglRectangle  buffer_rect;
   GeglBuffer    *mask;
   GeglRectangle  mask_rect;
+  const Babl    *format;
+
+  /*  the asyncs calculating the areas, when calculating asynchronously  */
+  GimpAsync    **area_asyncs;
+  gint           n_areas;
 
   /*  output  */
   gint           n_components;
@@ -88,6 +94,9 @@ typedef struct
 
   const Babl       *format;
   GSList           *values_list;
+
+  /*  the area of an area async  */
+  GeglRectangle     area;
 } CalculateData;
 
 
@@ -114,10 +123,17 @@ static void       gimp_histogram_set_values               (GimpHistogram
                                                            gint                  n_bins,
                                                            gdouble              *values);
 
-static void       gimp_histogram_calculate_internal       (GimpAsync            *async,
-                                                           CalculateContext     *context);
+static const Babl * gimp_histogram_calculate_prepare      (CalculateContext     *context);
+static gdouble  * gimp_histogram_calculate_sum            (CalculateContext     *context,
+                                                           GSList               *values_list);
+static void       gimp_histogram_calculate_internal       (CalculateContext     *context);
 static void       gimp_histogram_calculate_area           (const GeglRectangle  *area,
                                                            CalculateData        *data);
+static void       gimp_histogram_calculate_area_async     (GimpAsync            *async,
+                                                           CalculateData        *data);
+static void       gimp_histogram_calculate_area_free      (CalculateData        *data);
+static void       gimp_histogram_calculate_sum_async      (GimpAsync            *async,
+                                                           CalculateContext     *context);
 static void       gimp_histogram_calculate_async_callback (GimpAsync            *async,
                                                            CalculateContext     *context);
 static guint      hash_color_bytes                        (gpointer             *key);
@@ -349,7 +365,7 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
         context.mask_rect = *gegl_buffer_get_extent (mask);
     }
 
-  gimp_histogram_calculate_internal (NULL, &context);
+  gimp_histogram_calculate_internal (&context);
 
   gimp_histogram_set_values (histogram,
                              context.n_components, context.n_bins,
@@ -365,6 +381,9 @@ gimp_histogram_calculate_async (GimpHistogram       *histogram,
 {
   CalculateContext *context;
   GeglRectangle     rect;
+  GimpAsync        *async;
+  gint              n_threads;
+  gint              i;
 
   g_return_val_if_fail (GIMP_IS_HISTOGRAM (histogram), NULL);
   g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
@@ -402,10 +421,59 @@ gimp_histogram_calculate_async (GimpHistogram       *histogram,
                              context->mask, NULL);
     }
 
-  histogram->priv->calculate_async = gimp_parallel_run_async (
-    (GimpRunAsyncFunc) gimp_histogram_calculate_internal,
+  context->format = gimp_histogram_calculate_prepare (context);
+
+  /*  calculate horizontal strips of the buffer in parallel, and sum
+   *  them up once all of them are done, without going through the main
+   *  loop in between
+   */
+  g_object_get (gegl_config (), "threads", &n_threads, NULL);
+
+  context->n_areas = (gdouble) context->buffer_rect.width *
+                     context->buffer_rect.height / PIXELS_PER_THREAD;
+  context->n_areas = CLAMP (context->n_areas,
+                            1, MIN (n_threads, context->buffer_rect.height));
+
+  context->area_asyncs = g_new0 (GimpAsync *, context->n_areas);
+
+  for (i = 0; i < context->n_areas && context->format; i++)
+    {
+      CalculateData *data = g_slice_new0 (CalculateData);
+      gint           y1;
+      gint           y2;
+
+      y1 = context->buffer_rect.height * i       / context->n_areas;
+      y2 = context->buffer_rect.height * (i + 1) / context->n_areas;
+
+      data->context     = context;
+      data->format      = context->format;
+      data->area.x      = context->buffer_rect.x;
+      data->area.y      = context->buffer_rect.y + y1;
+      data->area.width  = context->buffer_rect.width;
+      data->area.height = y2 - y1;
+
+      context->area_asyncs[i] = gimp_parallel_run_async_full (
+        0,
+        (GimpRunAsyncFunc) gimp_histogram_calculate_area_async,
+        data,
+        (GDestroyNotify) gimp_histogram_calculate_area_free);
+    }
+
+  async = gimp_parallel_run_async_after (
+    context->area_asyncs, context->format ? context->n_areas : 0,
+    (GimpRunAsyncFunc) gimp_histogram_calculate_sum_async,
     context);
 
+  /*  canceling the calculation stops the areas which are still running  */
+  for (i = 0; i < context->n_areas && context->area_asyncs[i]; i++)
+    {
+      g_signal_connect_object (async, "cancel",
+                               G_CALLBACK (gimp_cancelable_cancel),
+                               context->area_asyncs[i], G_CONNECT_SWAPPED);
+    }
+
+  histogram->priv->calculate_async = async;
+
   gimp_async_add_callback (
     histogram->priv->calculate_async,
     (GimpAsyncCallback) gimp_histogram_calculate_async_callback,
@@ -925,11 +993,10 @@ gimp_histogram_set_values (GimpHistogram *histogram,
   g_object_notify (G_OBJECT (histogram), "values");
 }
 
-static void
-gimp_histogram_calculate_internal (GimpAsync        *async,
-                                   CalculateContext *context)
+/*  sets up @context's output, and returns the format to calculate in  */
+static const Babl *
+gimp_histogram_calculate_prepare (CalculateContext *context)
 {
-  CalculateData         data;
   GimpHistogramPrivate *priv;
   const Babl           *format;
   const Babl           *space;
@@ -964,64 +1031,65 @@ gimp_histogram_calculate_internal (GimpAsync        *async,
       break;
 
     default:
-      if (async)
-        gimp_async_abort (async);
-
-      g_return_if_reached ();
+      g_return_val_if_reached (NULL);
     }
 
   context->n_components = babl_format_get_n_components (format);
 
-  data.async       = async;
-  data.context     = context;
-  data.format      = format;
-  data.values_list = NULL;
+  return format;
+}
 
-  gegl_parallel_distribute_area (
-    &context->buffer_rect, PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
-    (GeglParallelDistributeAreaFunc) gimp_histogram_calculate_area,
-    &data);
+/*  adds up the values of @values_list, and frees it  */
+static gdouble *
+gimp_histogram_calculate_sum (CalculateContext *context,
+                              GSList           *values_list)
+{
+  gdouble *total_values = NULL;
+  gint     n_values     = (context->n_components + N_DERIVED_CHANNELS) *
+                          context->n_bins;
+  GSList  *iter;
 
-  if (! async || ! gimp_async_is_canceled (async))
+  for (iter = values_list; iter; iter = g_slist_next (iter))
     {
-      gdouble *total_values = NULL;
-      gint     n_values     = (context->n_components + N_DERIVED_CHANNELS) *
-                              context->n_bins;
-      GSList  *iter;
+      gdouble *values = iter->data;
 
-      for (iter = data.values_list; iter; iter = g_slist_next (iter))
+      if (! total_values)
         {
-          gdouble *values = iter->data;
-
-          if (! total_values)
-            {
-              total_values = values;
-            }
-          else
-            {
-              gint i;
+          total_values = values;
+        }
+      else
+        {
+          gint i;
 
-              for (i = 0; i < n_values; i++)
-                total_values[i] += values[i];
+          for (i = 0; i < n_values; i++)
+            total_values[i] += values[i];
 
-              g_free (values);
-            }
+          g_free (values);
         }
+    }
 
-      g_slist_free (data.values_list);
+  g_slist_free (values_list);
 
-      context->values = total_values;
+  return total_values;
+}
 
-      if (async)
-        gimp_async_finish (async, NULL);
-    }
-  else
-    {
-      g_slist_free_full (data.values_list, g_free);
+static void
+gimp_histogram_calculate_internal (CalculateContext *context)
+{
+  CalculateData data = {};
 
-      if (async)
-        gimp_async_abort (async);
-    }
+  data.context = context;
+  data.format  = gimp_histogram_calculate_prepare (context);
+
+  if (! data.format)
+    return;
+
+  gegl_parallel_distribute_area (
+    &context->buffer_rect, PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) gimp_histogram_calculate_area,
+    &data);
+
+  context->values = gimp_histogram_calculate_sum (context, data.values_list);
 }
 
 static void
@@ -1258,10 +1326,79 @@ gimp_histogram_calculate_area (const GeglRectangle *area,
 #undef CHECK_CANCELED
 }
 
+static void
+gimp_histogram_calculate_area_async (GimpAsync     *async,
+                                     CalculateData *data)
+{
+  data->async = async;
+
+  gimp_histogram_calculate_area (&data->area, data);
+
+  if (gimp_async_is_canceled (async))
+    {
+      gimp_async_abort (async);
+    }
+  else
+    {
+      gimp_async_finish_full (async,
+                              data->values_list->data,
+                              (GDestroyNotify) g_free);
+
+      g_clear_pointer (&data->values_list, g_slist_free);
+    }
+
+  gimp_histogram_calculate_area_free (data);
+}
+
+static void
+gimp_histogram_calculate_area_free (CalculateData *data)
+{
+  g_slist_free_full (data->values_list, g_free);
+
+  g_slice_free (CalculateData, data);
+}
+
+/*  runs once all the area asyncs are finished  */
+static void
+gimp_histogram_calculate_sum_async (GimpAsync        *async,
+                                    CalculateContext *context)
+{
+  gdouble *total_values;
+  gint     n_values;
+  gint     i;
+  gint     j;
+
+  if (! context->format)
+    {
+      gimp_async_abort (async);
+      return;
+    }
+
+  n_values = (context->n_components + N_DERIVED_CHANNELS) * context->n_bins;
+
+  /*  the areas' values are owned by their asyncs  */
+  total_values = g_memdup2 (gimp_async_get_result (context->area_asyncs[0]),
+                            n_values * sizeof (gdouble));
+
+  for (i = 1; i < context->n_areas; i++)
+    {
+      const gdouble *values = gimp_async_get_result (context->area_asyncs[i]);
+
+      for (j = 0; j < n_values; j++)
+        total_values[j] += values[j];
+    }
+
+  context->values = total_values;
+
+  gimp_async_finish (async, NULL);
+}
+
 static void
 gimp_histogram_calculate_async_callback (GimpAsync        *async,
                                          CalculateContext *context)
 {
+  gint i;
+
   context->histogram->priv->calculate_async = NULL;
 
   if (gimp_async_is_finished (async))
@@ -1271,6 +1408,11 @@ gimp_histogram_calculate_async_callback (GimpAsync        *async,
                                  context->values);
     }
 
+  for (i = 0; i < context->n_areas; i++)
+    g_clear_object (&context->area_asyncs[i]);
+
+  g_free (context->area_asyncs);
+
   g_object_unref (context->buffer);
   if (context->mask)
     g_object_unref (context->mask);
@@ -145,6 +145,7 @@ struct _GimpImagePrivate
   GimpUndoStack     *redo_stack;            /*  stack for redo operations    */
   gint               group_count;           /*  nested undo groups           */
   GimpUndoType       pushing_undo_group;    /*  undo group status flag       */
+  gboolean           undo_spill_failed;     /*  don't swap undo steps again  */
 
   /*  Signal emission accumulator  */
   GimpImageFlushAccumulator  flush_accum;
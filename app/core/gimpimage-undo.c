@@ -33,14 +33,19 @@
 #include "gimplist.h"
 #include "gimpundostack.h"
 
+#include "gimp-intl.h"
+
 
 /*  local function prototypes  */
 
-static void          gimp_image_undo_pop_stack       (GimpImage     *image,
+static gboolean      gimp_image_undo_pop_stack       (GimpImage     *image,
                                                       GimpUndoStack *undo_stack,
                                                       GimpUndoStack *redo_stack,
                                                       GimpUndoMode   undo_mode);
+static void          gimp_image_undo_update_top      (GimpImage     *image);
 static void          gimp_image_undo_free_space      (GimpImage     *image);
+static gboolean      gimp_image_undo_spill           (GimpImage     *image);
+static void          gimp_image_undo_compress        (GimpImage     *image);
 static void          gimp_image_undo_free_redo       (GimpImage     *image);
 
 static GimpDirtyMask gimp_image_undo_dirty_from_type (GimpUndoType   undo_type);
@@ -123,12 +128,10 @@ gimp_image_undo (GimpImage *image)
   g_return_val_if_fail (private->pushing_undo_group == GIMP_UNDO_GROUP_NONE,
                         FALSE);
 
-  gimp_image_undo_pop_stack (image,
-                             private->undo_stack,
-                             private->redo_stack,
-                             GIMP_UNDO_MODE_UNDO);
-
-  return TRUE;
+  return gimp_image_undo_pop_stack (image,
+                                    private->undo_stack,
+                                    private->redo_stack,
+                                    GIMP_UNDO_MODE_UNDO);
 }
 
 gboolean
@@ -143,12 +146,10 @@ gimp_image_redo (GimpImage *image)
   g_return_val_if_fail (private->pushing_undo_group == GIMP_UNDO_GROUP_NONE,
                         FALSE);
 
-  gimp_image_undo_pop_stack (image,
-                             private->redo_stack,
-                             private->undo_stack,
-                             GIMP_UNDO_MODE_REDO);
-
-  return TRUE;
+  return gimp_image_undo_pop_stack (image,
+                                    private->redo_stack,
+                                    private->undo_stack,
+                                    GIMP_UNDO_MODE_REDO);
 }
 
 /*
@@ -170,13 +171,14 @@ gimp_image_strong_undo (GimpImage *image)
 
   undo = gimp_undo_stack_peek (private->undo_stack);
 
-  gimp_image_undo (image);
+  if (! gimp_image_undo (image))
+    return FALSE;
 
   while (gimp_undo_is_weak (undo))
     {
       undo = gimp_undo_stack_peek (private->undo_stack);
-      if (gimp_undo_is_weak (undo))
-        gimp_image_undo (image);
+      if (gimp_undo_is_weak (undo) && ! gimp_image_undo (image))
+        break;
     }
 
   return TRUE;
@@ -203,13 +205,14 @@ gimp_image_strong_redo (GimpImage *image)
 
   undo = gimp_undo_stack_peek (private->redo_stack);
 
-  gimp_image_redo (image);
+  if (! gimp_image_redo (image))
+    return FALSE;
 
   while (gimp_undo_is_weak (undo))
     {
       undo = gimp_undo_stack_peek (private->redo_stack);
-      if (gimp_undo_is_weak (undo))
-        gimp_image_redo (image);
+      if (gimp_undo_is_weak (undo) && ! gimp_image_redo (image))
+        break;
     }
 
   return TRUE;
@@ -306,6 +309,8 @@ gimp_image_undo_group_start (GimpImage    *image,
   /*  nuke the redo stack  */
   gimp_image_undo_free_redo (image);
 
+  gimp_image_undo_update_top (image);
+
   undo_group = gimp_undo_stack_new (image);
 
   gimp_object_set_name (GIMP_OBJECT (undo_group), name);
@@ -345,7 +350,9 @@ gimp_image_undo_group_end (GimpImage *image)
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_UNDO_PUSHED,
                              gimp_undo_stack_peek (private->undo_stack));
 
+      gimp_image_undo_update_top (image);
       gimp_image_undo_free_space (image);
+      gimp_image_undo_compress (image);
     }
 
   return TRUE;
@@ -410,11 +417,14 @@ gimp_image_undo_push (GimpImage     *image,
 
   if (private->pushing_undo_group == GIMP_UNDO_GROUP_NONE)
     {
+      gimp_image_undo_update_top (image);
+
       gimp_undo_stack_push_undo (private->undo_stack, undo);
 
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_UNDO_PUSHED, undo);
 
       gimp_image_undo_free_space (image);
+      gimp_image_undo_compress (image);
 
       /*  freeing undo space may have freed the newly pushed undo  */
       if (gimp_undo_stack_peek (private->undo_stack) == undo)
@@ -460,10 +470,37 @@ gimp_image_undo_can_compress (GimpImage    *image,
   return NULL;
 }
 
+/*  called when an undo step couldn't be swapped out to disk.  the
+ *  image's steps aren't spilled anymore then, so that free_space()
+ *  discards the oldest steps instead of starting the same failing
+ *  write over and over, without ever enforcing "undo-size"
+ */
+void
+gimp_image_undo_spill_failed (GimpImage    *image,
+                              const GError *error)
+{
+  GimpImagePrivate *private;
+
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+  g_return_if_fail (error != NULL);
+
+  private = GIMP_IMAGE_GET_PRIVATE (image);
+
+  if (private->undo_spill_failed)
+    return;
+
+  private->undo_spill_failed = TRUE;
+
+  gimp_message (image->gimp, NULL, GIMP_MESSAGE_WARNING,
+                _("Could not swap undo data to disk: %s\n\n"
+                  "The oldest undo steps will be discarded instead."),
+                error->message);
+}
+
 
 /*  private functions  */
 
-static void
+static gboolean
 gimp_image_undo_pop_stack (GimpImage     *image,
                            GimpUndoStack *undo_stack,
                            GimpUndoStack *redo_stack,
@@ -471,6 +508,21 @@ gimp_image_undo_pop_stack (GimpImage     *image,
 {
   GimpUndo            *undo;
   GimpUndoAccumulator  accum = { 0, };
+  GError              *error = NULL;
+
+  undo = gimp_undo_stack_peek (undo_stack);
+
+  /*  a step whose data can't be brought back stays where it is  */
+  if (undo && ! gimp_undo_reload (undo, &error))
+    {
+      gimp_message (image->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    (undo_mode == GIMP_UNDO_MODE_UNDO) ?
+                    _("Undo failed: %s") : _("Redo failed: %s"),
+                    error->message);
+      g_clear_error (&error);
+
+      return FALSE;
+    }
 
   g_object_freeze_notify (G_OBJECT (image));
 
@@ -510,6 +562,33 @@ gimp_image_undo_pop_stack (GimpImage     *image,
     }
 
   g_object_thaw_notify (G_OBJECT (image));
+
+  return TRUE;
+}
+
+/*  re-measures the top undo step, and all of its undos if it is a
+ *  group.  undos are measured when they are pushed, but some of them
+ *  grow once the operation which pushed them is done, e.g. item undos
+ *  count their item as soon as it is removed from the image, without
+ *  emitting "memsize-changed".  this is called whenever a step is
+ *  done, before free_space() relies on the undo stack's size.
+ */
+static void
+gimp_image_undo_update_top (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GimpUndo         *undo;
+
+  undo = gimp_undo_stack_peek (private->undo_stack);
+
+  if (! undo)
+    return;
+
+  if (GIMP_IS_UNDO_STACK (undo))
+    gimp_container_foreach (GIMP_UNDO_STACK (undo)->undos,
+                            (GFunc) gimp_undo_memsize_changed, NULL);
+  else
+    gimp_undo_memsize_changed (undo);
 }
 
 static void
@@ -537,11 +616,20 @@ gimp_image_undo_free_space (GimpImage *image)
   if (gimp_container_get_n_children (container) <= min_undo_levels)
     return;
 
-  while ((gimp_object_get_memsize (GIMP_OBJECT (container), NULL) > undo_size) ||
+  while ((gimp_undo_stack_get_size (private->undo_stack) > undo_size) ||
          (gimp_container_get_n_children (container) > max_undo_levels))
     {
-      GimpUndo *freed = gimp_undo_stack_free_bottom (private->undo_stack,
-                                                     GIMP_UNDO_MODE_UNDO);
+      GimpUndo *freed;
+
+      /*  rather than discarding the oldest step, try moving a step out
+       *  of memory into the swap first
+       */
+      if (gimp_container_get_n_children (container) <= max_undo_levels &&
+          gimp_image_undo_spill (image))
+        continue;
+
+      freed = gimp_undo_stack_free_bottom (private->undo_stack,
+                                           GIMP_UNDO_MODE_UNDO);
 
 #ifdef DEBUG_IMAGE_UNDO
       g_printerr ("freed one step: undo_steps: %d    undo_bytes: %ld\n",
@@ -559,6 +647,49 @@ gimp_image_undo_free_space (GimpImage *image)
     }
 }
 
+static gboolean
+gimp_image_undo_spill (GimpImage *image)
+{
+  GimpImagePrivate *private   = GIMP_IMAGE_GET_PRIVATE (image);
+  GimpUndo         *undo      = GIMP_UNDO (private->undo_stack);
+  guint64           swap_size = image->gimp->config->undo_swap_size;
+  GList            *list;
+
+  if (swap_size == 0                 ||
+      private->undo_spill_failed     ||
+      gimp_undo_get_swap_size (undo) >= swap_size)
+    return FALSE;
+
+  /*  spill the oldest steps first, and never the newest one  */
+  for (list = GIMP_LIST (private->undo_stack->undos)->queue->tail;
+       list && list->prev;
+       list = g_list_previous (list))
+    {
+      if (gimp_undo_spill (list->data))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+gimp_image_undo_compress (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GimpObject       *undo;
+
+  if (! image->gimp->config->undo_compression)
+    return;
+
+  /*  leave the newest step alone, it's the one most likely to be undone
+   *  right away, and compress the step it was pushed on top of
+   */
+  undo = gimp_container_get_child_by_index (private->undo_stack->undos, 1);
+
+  if (undo)
+    gimp_undo_compress (GIMP_UNDO (undo));
+}
+
 static void
 gimp_image_undo_free_redo (GimpImage *image)
 {
@@ -51,3 +51,6 @@ GimpUndo      * gimp_image_undo_push            (GimpImage     *image,
 GimpUndo      * gimp_image_undo_can_compress    (GimpImage     *image,
                                                  GType          object_type,
                                                  GimpUndoType   undo_type);
+
+void            gimp_image_undo_spill_failed    (GimpImage     *image,
+                                                 const GError  *error);
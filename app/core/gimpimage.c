@@ -3099,12 +3099,25 @@ gimp_image_get_xcf_version (GimpImage    *image,
       version = MAX (12, version);
     }
 
-  /* need version 8 for zlib compression */
+  /* need version 8 for zlib compression, and version 26 if the
+   * compressed XCF is going to use zstd instead, see xcf_save_stream()
+   */
   if (zlib_compression)
     {
-      ADD_REASON (g_strdup_printf (_("Internal zlib compression was "
-                                     "added in %s"), "GIMP 2.10"));
-      version = MAX (8, version);
+#ifdef HAVE_ZSTD
+      if (image->gimp->config->xcf_zstd_level > 0)
+        {
+          ADD_REASON (g_strdup_printf (_("Internal zstd compression was "
+                                         "added in %s"), "GIMP 3.2"));
+          version = MAX (26, version);
+        }
+      else
+#endif
+        {
+          ADD_REASON (g_strdup_printf (_("Internal zlib compression was "
+                                         "added in %s"), "GIMP 2.10"));
+          version = MAX (8, version);
+        }
     }
 
   /* if version is 10 (lots of new layer modes), go to version 11 with
@@ -3215,6 +3228,7 @@ gimp_image_get_xcf_version (GimpImage    *image,
       break;
     case 24:
     case 25:
+    case 26:
       if (gimp_version)   *gimp_version   = 320;
       if (version_string) *version_string = "GIMP 3.2";
       break;
@@ -94,6 +94,7 @@ struct _GimpLineArtPrivate
 typedef struct
 {
   GeglBuffer  *buffer;
+  GimpAsync   *transparent_async;
 
   gboolean     select_transparent;
   gdouble      threshold;
@@ -166,6 +167,8 @@ static void            gimp_line_art_compute_cb                (GimpAsync
 
 static GimpAsync     * gimp_line_art_prepare_async             (GimpLineArt            *line_art,
                                                                 gint                    priority);
+static void            gimp_line_art_find_transparent_async    (GimpAsync              *async,
+                                                                GeglBuffer             *buffer);
 static void            gimp_line_art_prepare_async_func        (GimpAsync              *async,
                                                                 LineArtData            *data);
 static LineArtData   * line_art_data_new                       (GeglBuffer             *buffer,
@@ -591,6 +594,38 @@ gimp_line_art_get (GimpLineArt  *line_art,
   return line_art->priv->closed;
 }
 
+/* Returns the async computing the line art, starting the computation
+ * if needed, so that work depending on it can be scheduled to run as
+ * soon as it's done.  Returns NULL if the line art is computed already,
+ * or if it can't be computed right now.
+ */
+GimpAsync *
+gimp_line_art_get_async (GimpLineArt *line_art)
+{
+  g_return_val_if_fail (line_art->priv->input, NULL);
+
+  if (! line_art->priv->async && ! line_art->priv->closed)
+    gimp_line_art_compute (line_art);
+
+  return line_art->priv->async;
+}
+
+/* Returns the closed line art computed by @async, as returned by
+ * gimp_line_art_get_async().  May be called on any thread, once @async
+ * is finished.
+ */
+GeglBuffer *
+gimp_line_art_async_get_closed (GimpAsync *async)
+{
+  LineArtResult *result;
+
+  g_return_val_if_fail (gimp_async_is_finished (async), NULL);
+
+  result = gimp_async_get_result (async);
+
+  return result->closed;
+}
+
 /* Functions for asynchronous computation. */
 
 static void
@@ -686,71 +721,97 @@ gimp_line_art_prepare_async (GimpLineArt *line_art,
 
   g_object_unref (buffer);
 
-  async = gimp_parallel_run_async_full (
+  /*  don't select transparent regions if there are no fully
+   *  transparent pixels.  the closing needs to know that, so it runs
+   *  as soon as the search is done.
+   */
+  if (data->select_transparent &&
+      babl_format_has_alpha (gegl_buffer_get_format (data->buffer)))
+    {
+      data->transparent_async = gimp_parallel_run_async_full (
+        priority,
+        (GimpRunAsyncFunc) gimp_line_art_find_transparent_async,
+        g_object_ref (data->buffer), (GDestroyNotify) g_object_unref);
+    }
+
+  async = gimp_parallel_run_async_after_full (
     priority,
+    &data->transparent_async, data->transparent_async ? 1 : 0,
     (GimpRunAsyncFunc) gimp_line_art_prepare_async_func,
     data, (GDestroyNotify) line_art_data_free);
 
+  /*  canceling the computation stops the search as well  */
+  if (data->transparent_async)
+    {
+      g_signal_connect_object (async, "cancel",
+                               G_CALLBACK (gimp_cancelable_cancel),
+                               data->transparent_async, G_CONNECT_SWAPPED);
+    }
+
   return async;
 }
 
 static void
-gimp_line_art_prepare_async_func (GimpAsync   *async,
-                                  LineArtData *data)
+gimp_line_art_find_transparent_async (GimpAsync  *async,
+                                      GeglBuffer *buffer)
 {
-  GeglBuffer *buffer;
-  GeglBuffer *closed  = NULL;
-  gfloat     *distmap = NULL;
-  gint        buffer_x;
-  gint        buffer_y;
-  gboolean    has_alpha;
-  gboolean    select_transparent = FALSE;
+  GeglBufferIterator *gi;
+  gboolean            transparent = FALSE;
 
-  has_alpha = babl_format_has_alpha (gegl_buffer_get_format (data->buffer));
+  gi = gegl_buffer_iterator_new (buffer, NULL, 0,
+                                 babl_format ("A u8"),
+                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
 
-  if (has_alpha)
+  while (! transparent && gegl_buffer_iterator_next (gi))
     {
-      if (data->select_transparent)
+      guint8 *p = (guint8*) gi->items[0].data;
+      gint    k;
+
+      if (gimp_async_is_canceled (async))
         {
-          /*  don't select transparent regions if there are no fully
-           *  transparent pixels.
-           */
-          GeglBufferIterator *gi;
+          gegl_buffer_iterator_stop (gi);
+
+          gimp_async_abort (async);
 
-          gi = gegl_buffer_iterator_new (data->buffer, NULL, 0,
-                                         babl_format ("A u8"),
-                                         GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 3);
-          while (gegl_buffer_iterator_next (gi))
+          g_object_unref (buffer);
+
+          return;
+        }
+
+      for (k = 0; k < gi->length; k++)
+        {
+          if (! *p)
             {
-              guint8 *p = (guint8*) gi->items[0].data;
-              gint    k;
+              transparent = TRUE;
+              break;
+            }
+          p++;
+        }
+    }
 
-              if (gimp_async_is_canceled (async))
-                {
-                  gegl_buffer_iterator_stop (gi);
+  if (transparent)
+    gegl_buffer_iterator_stop (gi);
 
-                  gimp_async_abort (async);
+  gimp_async_finish (async, GINT_TO_POINTER (transparent));
 
-                  line_art_data_free (data);
+  g_object_unref (buffer);
+}
 
-                  return;
-                }
+static void
+gimp_line_art_prepare_async_func (GimpAsync   *async,
+                                  LineArtData *data)
+{
+  GeglBuffer *buffer;
+  GeglBuffer *closed  = NULL;
+  gfloat     *distmap = NULL;
+  gint        buffer_x;
+  gint        buffer_y;
+  gboolean    select_transparent = FALSE;
 
-              for (k = 0; k < gi->length; k++)
-                {
-                  if (! *p)
-                    {
-                      select_transparent = TRUE;
-                      break;
-                    }
-                  p++;
-                }
-              if (select_transparent)
-                break;
-            }
-          if (select_transparent)
-            gegl_buffer_iterator_stop (gi);
-        }
+  if (data->transparent_async)
+    {
+      select_transparent =
+        GPOINTER_TO_INT (gimp_async_get_result (data->transparent_async));
     }
 
   buffer   = data->buffer;
@@ -836,6 +897,7 @@ line_art_data_new (GeglBuffer  *buffer,
   LineArtData *data = g_slice_new (LineArtData);
 
   data->buffer             = g_object_ref (buffer);
+  data->transparent_async  = NULL;
   data->select_transparent = line_art->priv->select_transparent;
   data->threshold          = line_art->priv->threshold;
   data->automatic_closure  = line_art->priv->automatic_closure;
@@ -849,6 +911,7 @@ static void
 line_art_data_free (LineArtData *data)
 {
   g_object_unref (data->buffer);
+  g_clear_object (&data->transparent_async);
 
   g_slice_free (LineArtData, data);
 }
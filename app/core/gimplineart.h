@@ -68,3 +68,5 @@ gboolean             gimp_line_art_is_frozen        (GimpLineArt  *line_art);
 
 GeglBuffer         * gimp_line_art_get              (GimpLineArt  *line_art,
                                                      gfloat      **distmap);
+GimpAsync          * gimp_line_art_get_async        (GimpLineArt  *line_art);
+GeglBuffer         * gimp_line_art_async_get_closed (GimpAsync    *async);
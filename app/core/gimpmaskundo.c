@@ -25,6 +25,7 @@
 #include "core-types.h"
 
 #include "gegl/gimp-gegl-loops.h"
+#include "gegl/gimp-gegl-utils.h"
 
 #include "gimp-memsize.h"
 #include "gimpchannel.h"
@@ -114,19 +115,11 @@ gimp_mask_undo_constructed (GObject *object)
                         &mask_undo->bounds.width,
                         &mask_undo->bounds.height))
     {
-      GeglBuffer    *buffer = gimp_drawable_get_buffer (drawable);
-      GeglRectangle  rect;
+      GeglRectangle rect;
 
-      gegl_rectangle_align_to_buffer (&rect, &mask_undo->bounds, buffer,
-                                      GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
-
-      mask_undo->buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
-                                                           rect.width,
-                                                           rect.height),
-                                           mask_undo->format);
-
-      gimp_gegl_buffer_copy (buffer, &rect, GEGL_ABYSS_NONE,
-                             mask_undo->buffer, GEGL_RECTANGLE (0, 0, 0, 0));
+      mask_undo->buffer =
+        gimp_gegl_buffer_snapshot (gimp_drawable_get_buffer (drawable),
+                                   &mask_undo->bounds, &rect);
 
       mask_undo->x = rect.x;
       mask_undo->y = rect.y;
@@ -212,15 +205,7 @@ gimp_mask_undo_pop (GimpUndo            *undo,
     {
       GeglBuffer *buffer = gimp_drawable_get_buffer (drawable);
 
-      gegl_rectangle_align_to_buffer (&rect, &bounds, buffer,
-                                      GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
-
-      new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
-                                                    rect.width, rect.height),
-                                    format);
-
-      gimp_gegl_buffer_copy (buffer, &rect, GEGL_ABYSS_NONE,
-                             new_buffer, GEGL_RECTANGLE (0, 0, 0, 0));
+      new_buffer = gimp_gegl_buffer_snapshot (buffer, &bounds, &rect);
 
       gegl_buffer_clear (buffer, &rect);
     }
@@ -40,6 +40,7 @@ extern "C"
 #include "gimplineart.h"
 #include "gimppickable.h"
 #include "gimppickable-contiguous-region.h"
+#include "gimpwaitable.h"
 
 
 #define EPSILON 1e-6
@@ -115,6 +116,12 @@ static void     find_contiguous_region    (GeglBuffer          *src_buffer,
                                            gint                 y,
                                            const gfloat        *col);
 
+static GeglBuffer    * line_art_add_fill    (GimpLineArt         *line_art,
+                                             GeglBuffer          *fill_buffer,
+                                             GeglColor           *fill_color,
+                                             gfloat               fill_threshold,
+                                             gint                 fill_offset_x,
+                                             gint                 fill_offset_y);
 static void            line_art_queue_pixel (GQueue              *queue,
                                              gint                 x,
                                              gint                 y,
@@ -298,7 +305,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                              gint           x,
                                              gint           y)
 {
-  GeglBuffer    *src_buffer;
+  GeglBuffer    *src_buffer = NULL;
   GeglBuffer    *mask_buffer;
   const Babl    *format  = babl_format ("Y float");
   gfloat        *distmap = NULL;
@@ -321,69 +328,22 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
       free_line_art = TRUE;
     }
 
-  src_buffer = gimp_line_art_get (line_art, &distmap);
-  g_return_val_if_fail (src_buffer && distmap, NULL);
-
   if (fill_buffer != NULL)
     {
-      GeglBufferIterator  *gi;
-      const Babl          *fill_format;
-      const GeglRectangle *fill_extent;
-      gfloat               fill_col[MAX_CHANNELS];
-      gboolean             has_alpha;
-      gint                 n_components;
-
-      fill_extent = gegl_buffer_get_extent (fill_buffer);
-      fill_format = choose_format (fill_buffer,
-                                   GIMP_SELECT_CRITERION_COMPOSITE,
-                                   &n_components, &has_alpha);
-      fill_format = babl_format_with_space (babl_format_get_encoding (fill_format),
-                                            gegl_buffer_get_format (fill_buffer));
-      gegl_color_get_pixel (fill_color, fill_format, fill_col);
-
-      src_buffer = gimp_gegl_buffer_dup (src_buffer);
-      gi = gegl_buffer_iterator_new (src_buffer, NULL, 0, NULL,
-                                     GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE, 2);
-      gegl_buffer_iterator_add (gi, fill_buffer,
-                                GEGL_RECTANGLE (-fill_offset_x, -fill_offset_y,
-                                                fill_extent->width + fill_offset_x,
-                                                fill_extent->height + fill_offset_y),
-                                0, fill_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-      while (gegl_buffer_iterator_next (gi))
-        {
-          guchar       *data = (guchar*) gi->items[0].data;
-          const gfloat *fill = (const gfloat *) gi->items[1].data;
-          gint          k;
-
-          for (k = 0; k < gi->length; k++)
-            {
-              /* Only consider if the line art source hasn't filled yet,
-               * and also if this the fill target has full opacity.
-               */
-              if (! *data &&
-                  ( ! has_alpha ||
-                   fill[n_components - 1] == 1.0))
-                {
-                  gfloat diff;
+      src_buffer = line_art_add_fill (line_art, fill_buffer,
+                                      fill_color, fill_threshold,
+                                      fill_offset_x, fill_offset_y);
 
-                  diff = pixel_difference (fill, fill_col,
-                                           FALSE,
-                                           fill_threshold,
-                                           n_components, has_alpha, FALSE,
-                                           GIMP_SELECT_CRITERION_COMPOSITE);
-
-                  /* Make the additional fill pixel a closure pixel. */
-                  if (diff == 1.0)
-                    *data = 2;
-                }
+      free_src_buffer = (src_buffer != NULL);
+    }
 
-              data++;
-              fill += n_components;
-            }
-        }
+  /* also syncs the line art, if it was computed by line_art_add_fill() */
+  if (! src_buffer)
+    src_buffer = gimp_line_art_get (line_art, &distmap);
+  else
+    gimp_line_art_get (line_art, &distmap);
 
-      free_src_buffer = TRUE;
-    }
+  g_return_val_if_fail (src_buffer && distmap, NULL);
 
   gegl_buffer_sample (src_buffer, x, y, NULL, &start_col, NULL,
                       GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
@@ -1187,6 +1147,158 @@ find_contiguous_region (GeglBuffer          *src_buffer,
 #endif
 }
 
+/* Returns a copy of the closed line art, in which the pixels which are
+ * filled with @fill_color in @fill_buffer are closure pixels.  The
+ * pixels matching @fill_color are searched for while the line art is
+ * being computed, and merged into it right after.
+ */
+static GeglBuffer *
+line_art_add_fill (GimpLineArt *line_art,
+                   GeglBuffer  *fill_buffer,
+                   GeglColor   *fill_color,
+                   gfloat       fill_threshold,
+                   gint         fill_offset_x,
+                   gint         fill_offset_y)
+{
+  GimpAsync     *line_art_async;
+  GeglBuffer    *closed = NULL;
+  GimpAsync     *predecessors[2];
+  GimpAsync     *fill_async;
+  GimpAsync     *async;
+  GeglBuffer    *buffer = NULL;
+  const Babl    *fill_format;
+  GeglRectangle  fill_rect;
+  gboolean       has_alpha;
+  gint           n_components;
+  gfloat         fill_col[MAX_CHANNELS];
+
+  fill_format = choose_format (fill_buffer,
+                               GIMP_SELECT_CRITERION_COMPOSITE,
+                               &n_components, &has_alpha);
+  fill_format = babl_format_with_space (babl_format_get_encoding (fill_format),
+                                        gegl_buffer_get_format (fill_buffer));
+  gegl_color_get_pixel (fill_color, fill_format, fill_col);
+
+  /* @fill_buffer's extent, in line art coordinates */
+  fill_rect    = *gegl_buffer_get_extent (fill_buffer);
+  fill_rect.x += fill_offset_x;
+  fill_rect.y += fill_offset_y;
+
+  line_art_async = gimp_line_art_get_async (line_art);
+
+  if (! line_art_async)
+    {
+      closed = gimp_line_art_get (line_art, NULL);
+      g_return_val_if_fail (closed, NULL);
+    }
+
+  g_object_ref (fill_buffer);
+
+  fill_async = gimp_parallel_run_async_full (
+    0,
+    [=] (GimpAsync *async)
+    {
+      GeglBuffer         *fill_mask;
+      GeglBufferIterator *gi;
+
+      fill_mask = gegl_buffer_new (&fill_rect, babl_format ("Y u8"));
+
+      gi = gegl_buffer_iterator_new (fill_mask, &fill_rect, 0, NULL,
+                                     GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
+      gegl_buffer_iterator_add (gi, fill_buffer,
+                                gegl_buffer_get_extent (fill_buffer),
+                                0, fill_format, GEGL_ACCESS_READ,
+                                GEGL_ABYSS_NONE);
+
+      while (gegl_buffer_iterator_next (gi))
+        {
+          guchar       *data = (guchar *) gi->items[0].data;
+          const gfloat *fill = (const gfloat *) gi->items[1].data;
+          gint          k;
+
+          for (k = 0; k < gi->length; k++)
+            {
+              /* Only consider if the fill target has full opacity. */
+              *data = (! has_alpha || fill[n_components - 1] == 1.0) &&
+                      pixel_difference (fill, fill_col,
+                                        FALSE,
+                                        fill_threshold,
+                                        n_components, has_alpha, FALSE,
+                                        GIMP_SELECT_CRITERION_COMPOSITE) == 1.0;
+
+              data++;
+              fill += n_components;
+            }
+        }
+
+      g_object_unref (fill_buffer);
+
+      gimp_async_finish_full (async, fill_mask, g_object_unref);
+    },
+    [=] ()
+    {
+      g_object_unref (fill_buffer);
+    });
+
+  predecessors[0] = fill_async;
+  predecessors[1] = line_art_async;
+
+  async = gimp_parallel_run_async_after (
+    predecessors, line_art_async ? 2 : 1,
+    [=] (GimpAsync *async)
+    {
+      GeglBuffer         *fill_mask;
+      GeglBuffer         *buffer;
+      GeglBufferIterator *gi;
+
+      fill_mask = (GeglBuffer *) gimp_async_get_result (fill_async);
+
+      if (closed)
+        buffer = gimp_gegl_buffer_dup (closed);
+      else
+        buffer = gimp_gegl_buffer_dup (
+          gimp_line_art_async_get_closed (line_art_async));
+
+      gi = gegl_buffer_iterator_new (buffer, NULL, 0, NULL,
+                                     GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE, 2);
+      gegl_buffer_iterator_add (gi, fill_mask,
+                                gegl_buffer_get_extent (buffer), 0, NULL,
+                                GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+      while (gegl_buffer_iterator_next (gi))
+        {
+          guchar       *data = (guchar *) gi->items[0].data;
+          const guchar *fill = (const guchar *) gi->items[1].data;
+          gint          k;
+
+          /* Make the additional fill pixels closure pixels, where the
+           * line art source hasn't filled yet.
+           */
+          for (k = 0; k < gi->length; k++)
+            {
+              if (! *data && *fill)
+                *data = 2;
+
+              data++;
+              fill++;
+            }
+        }
+
+      gimp_async_finish_full (async, buffer, g_object_unref);
+    });
+
+  g_object_unref (fill_async);
+
+  gimp_waitable_wait (GIMP_WAITABLE (async));
+
+  if (gimp_async_is_finished (async))
+    buffer = GEGL_BUFFER (g_object_ref (gimp_async_get_result (async)));
+
+  g_object_unref (async);
+
+  return buffer;
+}
+
 static void
 line_art_queue_pixel (GQueue *queue,
                       gint    x,
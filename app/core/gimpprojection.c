@@ -29,6 +29,8 @@
 
 #include "core-types.h"
 
+#include "config/gimpgeglconfig.h"
+
 #include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-loops.h"
 #include "gegl/gimp-gegl-utils.h"
@@ -80,6 +82,14 @@ struct _GimpProjectionPrivate
   guint                      idle_id;
 
   gboolean                   invalidate_preview;
+
+  gint                       level;
+
+  GeglRectangle              prefetch_rect;
+  gdouble                    prefetch_scale;
+  cairo_region_t            *prefetched_region;
+  GimpChunkIterator         *prefetch_iter;
+  guint                      prefetch_idle_id;
 };
 
 
@@ -136,6 +146,18 @@ static void        gimp_projection_paint_area            (GimpProjection  *proj,
                                                           gint             y,
                                                           gint             w,
                                                           gint             h);
+static void        gimp_projection_read_scaled           (GimpProjection  *proj,
+                                                          const GeglRectangle *rect,
+                                                          gdouble          scale);
+static gboolean    gimp_projection_use_threaded_render   (GimpProjection  *proj);
+static void        gimp_projection_prefetch_start        (GimpProjection  *proj);
+static void        gimp_projection_prefetch_stop         (GimpProjection  *proj);
+static gboolean    gimp_projection_prefetch_callback     (GimpProjection  *proj);
+static void        gimp_projection_prefetch_area         (GimpProjection  *proj,
+                                                          const GeglRectangle *rect);
+static void        gimp_projection_count_prefetch_hits   (GimpProjection  *proj,
+                                                          const GeglRectangle *old_rect,
+                                                          const GeglRectangle *new_rect);
 
 static void        gimp_projection_projectable_invalidate(GimpProjectable *projectable,
                                                           gint             x,
@@ -164,6 +186,12 @@ G_DEFINE_TYPE_WITH_CODE (GimpProjection, gimp_projection, GIMP_TYPE_OBJECT,
 
 static guint projection_signals[LAST_SIGNAL] = { 0 };
 
+/*  number of chunks scrolled into view that were, and weren't, already
+ *  prerendered by the prefetch pass
+ */
+static gint gimp_projection_prefetch_hits   = 0;
+static gint gimp_projection_prefetch_misses = 0;
+
 
 static void
 gimp_projection_class_init (GimpProjectionClass *klass)
@@ -475,13 +503,128 @@ gimp_projection_set_priority_rect (GimpProjection *proj,
                                    gint            w,
                                    gint            h)
 {
+  GeglRectangle old_rect;
+
   g_return_if_fail (GIMP_IS_PROJECTION (proj));
 
+  old_rect = proj->priv->priority_rect;
+
   proj->priv->priority_rect = *GEGL_RECTANGLE (x, y, w, h);
 
+  gimp_projection_count_prefetch_hits (proj,
+                                       &old_rect, &proj->priv->priority_rect);
+
   gimp_projection_update_priority_rect (proj);
 }
 
+/**
+ * gimp_projection_set_prefetch_rect:
+ * @proj:
+ * @x:
+ * @y:
+ * @w:
+ * @h:
+ * @scale: the scale at which the area is going to be displayed
+ *
+ * Sets the area, in image coordinates, that is likely to be displayed
+ * next.  While the projection is otherwise idle, the area is rendered,
+ * and its mipmap levels for @scale are built, in a low-priority idle,
+ * so that it is ready by the time it is scrolled into view.  The
+ * speculative rendering is interrupted as soon as the projection has
+ * real updates to render.
+ *
+ * Pass an empty rectangle to stop prefetching.
+ */
+void
+gimp_projection_set_prefetch_rect (GimpProjection *proj,
+                                   gint            x,
+                                   gint            y,
+                                   gint            w,
+                                   gint            h,
+                                   gdouble         scale)
+{
+  g_return_if_fail (GIMP_IS_PROJECTION (proj));
+
+  if (scale != proj->priv->prefetch_scale)
+    {
+      /*  the mipmap levels we built are of no use at a different scale  */
+      g_clear_pointer (&proj->priv->prefetched_region, cairo_region_destroy);
+
+      proj->priv->prefetch_scale = scale;
+    }
+
+  proj->priv->prefetch_rect = *GEGL_RECTANGLE (x, y, w, h);
+
+  gimp_projection_prefetch_stop (proj);
+  gimp_projection_prefetch_start (proj);
+}
+
+/**
+ * gimp_projection_set_render_scale:
+ * @proj:
+ * @scale: the scale at which the projection is displayed
+ *
+ * When @scale is low enough for the display to sample one of the
+ * buffer's mipmap levels, dirty areas are rendered directly at that
+ * level, instead of at full resolution.  Level 0 is only rendered on
+ * demand, or in full once the scale increases again.
+ */
+void
+gimp_projection_set_render_scale (GimpProjection *proj,
+                                  gdouble         scale)
+{
+  gint level = 0;
+
+  g_return_if_fail (GIMP_IS_PROJECTION (proj));
+  g_return_if_fail (scale > 0.0);
+
+  /*  same level selection as gegl_buffer_get()  */
+  while (scale <= 0.5 && level < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL)
+    {
+      scale *= 2.0;
+      level++;
+    }
+
+  if (level == proj->priv->level)
+    return;
+
+  if (level < proj->priv->level && proj->priv->validate_handler)
+    {
+      cairo_region_t *dirty_region;
+      gint            n_rects;
+      gint            i;
+
+      /*  the finer levels are needed now, queue whatever we skipped for
+       *  rendering
+       */
+      dirty_region = proj->priv->validate_handler->dirty_region;
+      n_rects      = cairo_region_num_rectangles (dirty_region);
+
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t rect;
+
+          cairo_region_get_rectangle (dirty_region, i, &rect);
+
+          gimp_projection_add_update_area (proj,
+                                           rect.x,     rect.y,
+                                           rect.width, rect.height);
+        }
+
+      if (n_rects > 0)
+        gimp_projection_flush (proj);
+    }
+
+  proj->priv->level = level;
+
+  if (proj->priv->validate_handler)
+    {
+      g_object_set (proj->priv->validate_handler,
+                    "max-level", level,
+                    NULL);
+    }
+}
+
 void
 gimp_projection_stop_rendering (GimpProjection *proj)
 {
@@ -576,6 +719,21 @@ gimp_projection_finish_draw (GimpProjection *proj)
 }
 
 
+/*  public functions (stats)  */
+
+gint
+gimp_projection_get_prefetch_hits (void)
+{
+  return gimp_projection_prefetch_hits;
+}
+
+gint
+gimp_projection_get_prefetch_misses (void)
+{
+  return gimp_projection_prefetch_misses;
+}
+
+
 /*  private functions  */
 
 static void
@@ -597,6 +755,10 @@ gimp_projection_allocate_buffer (GimpProjection *proj)
     GIMP_TILE_HANDLER_VALIDATE (
       gimp_tile_handler_projectable_new (proj->priv->projectable));
 
+  g_object_set (proj->priv->validate_handler,
+                "max-level", proj->priv->level,
+                NULL);
+
   gimp_tile_handler_validate_assign (proj->priv->validate_handler,
                                      proj->priv->buffer);
 
@@ -607,6 +769,9 @@ static void
 gimp_projection_free_buffer (GimpProjection  *proj)
 {
   gimp_projection_chunk_render_stop (proj, FALSE);
+  gimp_projection_prefetch_stop (proj);
+
+  g_clear_pointer (&proj->priv->prefetched_region, cairo_region_destroy);
 
   g_clear_pointer (&proj->priv->update_region, cairo_region_destroy);
 
@@ -699,6 +864,9 @@ gimp_projection_chunk_render_start (GWeakRef *proj_ref)
       cairo_region_t *region             = proj->priv->update_region;
       gboolean        invalidate_preview = FALSE;
 
+      /* Real updates take precedence over speculative rendering */
+      gimp_projection_prefetch_stop (proj);
+
       /* Make sure we have a buffer */
       gimp_projection_allocate_buffer (proj);
 
@@ -745,6 +913,8 @@ gimp_projection_chunk_render_start (GWeakRef *proj_ref)
               proj->priv->idle_id = 0;
             }
 
+          gimp_projection_prefetch_start (proj);
+
           if (invalidate_preview)
             {
               /* invalidate the preview here since it is constructed from
@@ -830,8 +1000,13 @@ gimp_projection_chunk_render_iteration (GimpProjection *proj)
   if (gimp_chunk_iterator_next (proj->priv->iter))
     {
       GeglRectangle rect;
+      gint          level = proj->priv->level;
 
-      gimp_tile_handler_validate_begin_validate (proj->priv->validate_handler);
+      /*  when rendering at a mipmap level, the tiles are rendered on
+       *  demand, so validation must not be suspended
+       */
+      if (level == 0)
+        gimp_tile_handler_validate_begin_validate (proj->priv->validate_handler);
 
       while (gimp_chunk_iterator_get_rect (proj->priv->iter, &rect))
         {
@@ -839,7 +1014,8 @@ gimp_projection_chunk_render_iteration (GimpProjection *proj)
                                       rect.x, rect.y, rect.width, rect.height);
         }
 
-      gimp_tile_handler_validate_end_validate (proj->priv->validate_handler);
+      if (level == 0)
+        gimp_tile_handler_validate_end_validate (proj->priv->validate_handler);
 
       /* Still work to do. */
       return TRUE;
@@ -858,11 +1034,26 @@ gimp_projection_chunk_render_iteration (GimpProjection *proj)
           gimp_projectable_invalidate_preview (proj->priv->projectable);
         }
 
+      /* Use the idle time to render ahead of the viewport */
+      gimp_projection_prefetch_start (proj);
+
       /* FINISHED */
       return FALSE;
     }
 }
 
+/*  whether to render the chunks of the update queue concurrently, using
+ *  the GEGL thread pool, instead of one tile after the other on the main
+ *  thread.  see the "threaded-projection" blurb for why this is opt-in
+ */
+static gboolean
+gimp_projection_use_threaded_render (GimpProjection *proj)
+{
+  GimpImage *image = gimp_projectable_get_image (proj->priv->projectable);
+
+  return GIMP_GEGL_CONFIG (image->gimp->config)->threaded_projection;
+}
+
 static void
 gimp_projection_paint_area (GimpProjection *proj,
                             gboolean        now,
@@ -881,7 +1072,29 @@ gimp_projection_paint_area (GimpProjection *proj,
   if (gegl_rectangle_intersect (&rect,
                                 GEGL_RECTANGLE (x, y, w, h), &bounding_box))
     {
-      if (now)
+      if (now && proj->priv->level > 0 &&
+          ! proj->priv->validate_handler->validating)
+        {
+          /*  when zoomed out, only render the mipmap level the display
+           *  is going to sample.  level 0 stays invalid, and is rendered
+           *  on demand, or in full once the display zooms back in.
+           */
+          gimp_projection_read_scaled (proj, &rect,
+                                       1.0 / (1 << proj->priv->level));
+        }
+      else if (now && gimp_projection_use_threaded_render (proj))
+        {
+          /*  the chunk is split along the tile grid, and its tiles are
+           *  rendered in parallel.  the update is only emitted once all of
+           *  them are done, so chunks still reach the display in the order
+           *  handed out by the chunk iterator, i.e., priority-rect first.
+           */
+          gimp_tile_handler_validate_validate_parallel (
+            proj->priv->validate_handler,
+            proj->priv->buffer,
+            &rect);
+        }
+      else if (now)
         {
           gimp_tile_handler_validate_validate (
             proj->priv->validate_handler,
@@ -909,6 +1122,244 @@ gimp_projection_paint_area (GimpProjection *proj,
     }
 }
 
+/*  reads back an area of the buffer at a given scale, and throws the
+ *  result away.  this builds the corresponding mipmap tiles, rendering
+ *  them directly at their level if their area is still invalid.
+ */
+static void
+gimp_projection_read_scaled (GimpProjection      *proj,
+                             const GeglRectangle *rect,
+                             gdouble              scale)
+{
+  const Babl    *format = gegl_buffer_get_format (proj->priv->buffer);
+  GeglRectangle  scaled_rect;
+  gpointer       data;
+
+  scaled_rect.x      = floor (rect->x * scale);
+  scaled_rect.y      = floor (rect->y * scale);
+  scaled_rect.width  = ceil ((rect->x + rect->width)  * scale) -
+                       scaled_rect.x;
+  scaled_rect.height = ceil ((rect->y + rect->height) * scale) -
+                       scaled_rect.y;
+
+  data = gegl_scratch_alloc (scaled_rect.width * scaled_rect.height *
+                             babl_format_get_bytes_per_pixel (format));
+
+  gegl_buffer_get (proj->priv->buffer,
+                   &scaled_rect, scale, format, data,
+                   GEGL_AUTO_ROWSTRIDE,
+                   GEGL_ABYSS_NONE | GEGL_BUFFER_FILTER_NEAREST);
+
+  gegl_scratch_free (data);
+}
+
+static void
+gimp_projection_prefetch_start (GimpProjection *proj)
+{
+  cairo_region_t *region;
+  GeglRectangle   rect;
+  GeglRectangle   bounding_box;
+  gint            off_x, off_y;
+
+  if (proj->priv->prefetch_iter     ||
+      ! proj->priv->buffer          ||
+      proj->priv->iter              ||
+      proj->priv->update_region     ||
+      gegl_rectangle_is_empty (&proj->priv->prefetch_rect))
+    {
+      return;
+    }
+
+  rect = proj->priv->prefetch_rect;
+
+  gimp_projectable_get_offset (proj->priv->projectable, &off_x, &off_y);
+  bounding_box = gimp_projectable_get_bounding_box (proj->priv->projectable);
+
+  /*  subtract the projectable's offsets because the list of update
+   *  areas is in tile-pyramid coordinates, but our external API is
+   *  always in terms of image coordinates.
+   */
+  rect.x -= off_x;
+  rect.y -= off_y;
+
+  if (! gegl_rectangle_intersect (&rect, &rect, &bounding_box))
+    return;
+
+  region = cairo_region_create_rectangle ((const cairo_rectangle_int_t *) &rect);
+
+  if (proj->priv->prefetched_region)
+    cairo_region_subtract (region, proj->priv->prefetched_region);
+
+  if (cairo_region_is_empty (region))
+    {
+      cairo_region_destroy (region);
+
+      return;
+    }
+
+  proj->priv->prefetch_iter = gimp_chunk_iterator_new (region);
+
+  proj->priv->prefetch_idle_id = g_idle_add_full (
+    GIMP_PRIORITY_PROJECTION_PREFETCH_IDLE + proj->priv->priority,
+    (GSourceFunc) gimp_projection_prefetch_callback,
+    proj, NULL);
+}
+
+static void
+gimp_projection_prefetch_stop (GimpProjection *proj)
+{
+  if (proj->priv->prefetch_idle_id)
+    {
+      g_source_remove (proj->priv->prefetch_idle_id);
+      proj->priv->prefetch_idle_id = 0;
+    }
+
+  if (proj->priv->prefetch_iter)
+    {
+      gimp_chunk_iterator_stop (proj->priv->prefetch_iter, TRUE);
+
+      proj->priv->prefetch_iter = NULL;
+    }
+}
+
+static gboolean
+gimp_projection_prefetch_callback (GimpProjection *proj)
+{
+  /*  bail as soon as there are real updates pending  */
+  if (proj->priv->update_region)
+    {
+      gimp_chunk_iterator_stop (proj->priv->prefetch_iter, TRUE);
+
+      proj->priv->prefetch_iter    = NULL;
+      proj->priv->prefetch_idle_id = 0;
+
+      return G_SOURCE_REMOVE;
+    }
+
+  if (gimp_chunk_iterator_next (proj->priv->prefetch_iter))
+    {
+      GeglRectangle rect;
+      gint          level = proj->priv->level;
+
+      if (level == 0)
+        gimp_tile_handler_validate_begin_validate (proj->priv->validate_handler);
+
+      while (gimp_chunk_iterator_get_rect (proj->priv->prefetch_iter, &rect))
+        gimp_projection_prefetch_area (proj, &rect);
+
+      if (level == 0)
+        gimp_tile_handler_validate_end_validate (proj->priv->validate_handler);
+
+      return G_SOURCE_CONTINUE;
+    }
+  else
+    {
+      proj->priv->prefetch_iter    = NULL;
+      proj->priv->prefetch_idle_id = 0;
+
+      return G_SOURCE_REMOVE;
+    }
+}
+
+static void
+gimp_projection_prefetch_area (GimpProjection      *proj,
+                               const GeglRectangle *rect)
+{
+  gdouble scale = proj->priv->prefetch_scale;
+
+  /*  render whatever is still invalid...  */
+  if (proj->priv->level == 0)
+    {
+      gimp_tile_handler_validate_validate (proj->priv->validate_handler,
+                                           proj->priv->buffer,
+                                           rect,
+                                           TRUE, FALSE);
+    }
+
+  /*  ...and, when zoomed out, read the area back at the display scale,
+   *  so that the buffer's mipmap levels are built ahead of time as well.
+   */
+  if (scale > 0.0 && scale < 1.0)
+    gimp_projection_read_scaled (proj, rect, scale);
+
+  if (proj->priv->prefetched_region)
+    {
+      cairo_region_union_rectangle (proj->priv->prefetched_region,
+                                    (const cairo_rectangle_int_t *) rect);
+    }
+  else
+    {
+      proj->priv->prefetched_region =
+        cairo_region_create_rectangle ((const cairo_rectangle_int_t *) rect);
+    }
+}
+
+static void
+gimp_projection_count_prefetch_hits (GimpProjection      *proj,
+                                     const GeglRectangle *old_rect,
+                                     const GeglRectangle *new_rect)
+{
+  cairo_region_t *region;
+  gint64          area;
+  gint64          hit_area;
+  gint            off_x, off_y;
+  gint            n_rects;
+  gint            i;
+
+  /*  only count while prefetching is in effect  */
+  if (! proj->priv->prefetched_region ||
+      gegl_rectangle_is_empty (old_rect))
+    {
+      return;
+    }
+
+  gimp_projectable_get_offset (proj->priv->projectable, &off_x, &off_y);
+
+  /*  the newly exposed area, in tile-pyramid coordinates  */
+  region = cairo_region_create_rectangle (
+    (const cairo_rectangle_int_t *) new_rect);
+  cairo_region_subtract_rectangle (region,
+                                   (const cairo_rectangle_int_t *) old_rect);
+  cairo_region_translate (region, -off_x, -off_y);
+
+  area    = 0;
+  n_rects = cairo_region_num_rectangles (region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (region, i, &rect);
+
+      area += (gint64) rect.width * rect.height;
+    }
+
+  cairo_region_intersect (region, proj->priv->prefetched_region);
+
+  hit_area = 0;
+  n_rects  = cairo_region_num_rectangles (region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (region, i, &rect);
+
+      hit_area += (gint64) rect.width * rect.height;
+    }
+
+  cairo_region_destroy (region);
+
+  /*  count in units of update chunks  */
+  area     /= GIMP_PROJECTION_UPDATE_CHUNK_WIDTH *
+              GIMP_PROJECTION_UPDATE_CHUNK_HEIGHT;
+  hit_area /= GIMP_PROJECTION_UPDATE_CHUNK_WIDTH *
+              GIMP_PROJECTION_UPDATE_CHUNK_HEIGHT;
+
+  gimp_projection_prefetch_hits   += hit_area;
+  gimp_projection_prefetch_misses += area - hit_area;
+}
+
 
 /*  image callbacks  */
 
@@ -931,6 +1382,13 @@ gimp_projection_projectable_invalidate (GimpProjectable *projectable,
   x -= off_x;
   y -= off_y;
 
+  if (proj->priv->prefetched_region)
+    {
+      cairo_region_subtract_rectangle (
+        proj->priv->prefetched_region,
+        (const cairo_rectangle_int_t *) GEGL_RECTANGLE (x, y, w, h));
+    }
+
   gimp_projection_add_update_area (proj, x, y, w, h);
 }
 
@@ -1036,6 +1494,9 @@ gimp_projection_projectable_bounds_changed (GimpProjectable *projectable,
    */
 
   gimp_projection_chunk_render_stop (proj, TRUE);
+  gimp_projection_prefetch_stop (proj);
+
+  g_clear_pointer (&proj->priv->prefetched_region, cairo_region_destroy);
 
   if (dx == 0 && dy == 0)
     {
@@ -65,6 +65,16 @@ void             gimp_projection_set_priority_rect (GimpProjection    *proj,
                                                     gint               width,
                                                     gint               height);
 
+void             gimp_projection_set_render_scale  (GimpProjection    *proj,
+                                                    gdouble            scale);
+
+void             gimp_projection_set_prefetch_rect (GimpProjection    *proj,
+                                                    gint               x,
+                                                    gint               y,
+                                                    gint               width,
+                                                    gint               height,
+                                                    gdouble            scale);
+
 void             gimp_projection_stop_rendering    (GimpProjection    *proj);
 
 void             gimp_projection_flush             (GimpProjection    *proj);
@@ -76,3 +86,9 @@ gint64           gimp_projection_estimate_memsize  (GimpImageBaseType  type,
                                                     GimpComponentType  component_type,
                                                     gint               width,
                                                     gint               height);
+
+
+/*  stats  */
+
+gint             gimp_projection_get_prefetch_hits   (void);
+gint             gimp_projection_get_prefetch_misses (void);
@@ -34,6 +34,18 @@
 
 #define LOCK_DATA_ALIGNMENT 16
 
+/* temp-buf data is allocated in size classes, four per power of two, between
+ * 2^POOL_MIN_SHIFT and 2^POOL_MAX_SHIFT bytes.  freed blocks are kept in a
+ * per-thread pool, and reused by subsequent allocations of the same class on
+ * the same thread, so that per-dab mask buffers don't hit the allocator.
+ * all the pools are kept in a list, so that gimp_temp_buf_pool_reset() can
+ * empty them from any thread.
+ */
+#define POOL_MIN_SHIFT      8
+#define POOL_MAX_SHIFT      24
+#define POOL_N_SIZE_CLASSES (4 * (POOL_MAX_SHIFT - POOL_MIN_SHIFT) + 1)
+#define POOL_MAX_SIZE       (16 << 20) /* per thread */
+
 
 struct _GimpTempBuf
 {
@@ -42,8 +54,16 @@ struct _GimpTempBuf
   gint        height;
   const Babl *format;
   guchar     *data;
+  gint        size_class;
 };
 
+typedef struct
+{
+  GMutex   mutex; /* only contended by gimp_temp_buf_pool_reset() */
+  gsize    size;
+  gpointer blocks[POOL_N_SIZE_CLASSES];
+} GimpTempBufPool;
+
 typedef struct
 {
   const Babl     *format;
@@ -53,9 +73,30 @@ typedef struct
 G_STATIC_ASSERT (sizeof (LockData) <= LOCK_DATA_ALIGNMENT);
 
 
+/*  local function prototypes  */
+
+static gint              gimp_temp_buf_get_size_class (gsize            size,
+                                                       gsize           *class_size);
+
+static GimpTempBufPool * gimp_temp_buf_pool_get       (void);
+static void              gimp_temp_buf_pool_clear     (GimpTempBufPool *pool);
+static void              gimp_temp_buf_pool_free      (GimpTempBufPool *pool);
+
+static guchar          * gimp_temp_buf_data_alloc     (gsize            size,
+                                                       gint            *size_class);
+static void              gimp_temp_buf_data_free      (guchar          *data,
+                                                       gint             size_class);
+
+
 /*  local variables  */
 
 static guintptr gimp_temp_buf_total_memsize = 0;
+static guintptr gimp_temp_buf_pool_memsize  = 0;
+
+static GMutex   gimp_temp_buf_pools_mutex;
+static GSList  *gimp_temp_buf_pools        = NULL;
+static GPrivate gimp_temp_buf_pool_private =
+  G_PRIVATE_INIT ((GDestroyNotify) gimp_temp_buf_pool_free);
 
 
 /*  public functions  */
@@ -81,7 +122,8 @@ gimp_temp_buf_new (gint        width,
   temp->width     = width;
   temp->height    = height;
   temp->format    = format;
-  temp->data      = gegl_malloc ((gsize) width * height * bpp);
+  temp->data      = gimp_temp_buf_data_alloc ((gsize) width * height * bpp,
+                                              &temp->size_class);
 
   g_atomic_pointer_add (&gimp_temp_buf_total_memsize,
                         +gimp_temp_buf_get_memsize (temp));
@@ -175,7 +217,7 @@ gimp_temp_buf_unref (const GimpTempBuf *buf)
 
 
       if (buf->data)
-        gegl_free (buf->data);
+        gimp_temp_buf_data_free (buf->data, buf->size_class);
 
       g_slice_free (GimpTempBuf, (GimpTempBuf *) buf);
     }
@@ -441,6 +483,33 @@ gimp_gegl_buffer_get_temp_buf (GeglBuffer *buffer)
 }
 
 
+/* releases the memory held by the temp-buf pools of all threads.
+ *
+ * should be called at the end of operations allocating many temp bufs, such
+ * as paint strokes.
+ */
+void
+gimp_temp_buf_pool_reset (void)
+{
+  GSList *list;
+
+  g_mutex_lock (&gimp_temp_buf_pools_mutex);
+
+  for (list = gimp_temp_buf_pools; list; list = g_slist_next (list))
+    {
+      GimpTempBufPool *pool = list->data;
+
+      g_mutex_lock (&pool->mutex);
+
+      gimp_temp_buf_pool_clear (pool);
+
+      g_mutex_unlock (&pool->mutex);
+    }
+
+  g_mutex_unlock (&gimp_temp_buf_pools_mutex);
+}
+
+
 /*  public functions (stats)  */
 
 guint64
@@ -448,3 +517,189 @@ gimp_temp_buf_get_total_memsize (void)
 {
   return gimp_temp_buf_total_memsize;
 }
+
+guint64
+gimp_temp_buf_get_pool_memsize (void)
+{
+  return gimp_temp_buf_pool_memsize;
+}
+
+
+/*  private functions  */
+
+static gint
+gimp_temp_buf_get_size_class (gsize  size,
+                              gsize *class_size)
+{
+  gint  shift;
+  gsize step;
+
+  if (size <= (1 << POOL_MIN_SHIFT))
+    {
+      *class_size = 1 << POOL_MIN_SHIFT;
+
+      return 0;
+    }
+  else if (size > (1 << POOL_MAX_SHIFT))
+    {
+      *class_size = size;
+
+      return -1;
+    }
+
+  /* 2^shift < size <= 2^(shift + 1) */
+  shift = g_bit_storage (size - 1) - 1;
+  step  = (gsize) 1 << (shift - 2);
+
+  *class_size = ((size - 1) / step + 1) * step;
+
+  return 1                                +
+         4 * (shift - POOL_MIN_SHIFT)     +
+         (gint) (*class_size / step - 5);
+}
+
+/* returns the calling thread's pool, locked */
+static GimpTempBufPool *
+gimp_temp_buf_pool_get (void)
+{
+  GimpTempBufPool *pool;
+
+  pool = g_private_get (&gimp_temp_buf_pool_private);
+
+  if (! pool)
+    {
+      pool = g_slice_new0 (GimpTempBufPool);
+
+      g_mutex_init (&pool->mutex);
+
+      g_private_set (&gimp_temp_buf_pool_private, pool);
+
+      g_mutex_lock (&gimp_temp_buf_pools_mutex);
+
+      gimp_temp_buf_pools = g_slist_prepend (gimp_temp_buf_pools, pool);
+
+      g_mutex_unlock (&gimp_temp_buf_pools_mutex);
+    }
+
+  g_mutex_lock (&pool->mutex);
+
+  return pool;
+}
+
+static void
+gimp_temp_buf_pool_clear (GimpTempBufPool *pool)
+{
+  gint i;
+
+  for (i = 0; i < POOL_N_SIZE_CLASSES; i++)
+    {
+      while (pool->blocks[i])
+        {
+          gpointer block = pool->blocks[i];
+
+          pool->blocks[i] = *(gpointer *) block;
+
+          gegl_free (block);
+        }
+    }
+
+  g_atomic_pointer_add (&gimp_temp_buf_pool_memsize, -(gssize) pool->size);
+
+  pool->size = 0;
+}
+
+static void
+gimp_temp_buf_pool_free (GimpTempBufPool *pool)
+{
+  g_mutex_lock (&gimp_temp_buf_pools_mutex);
+
+  gimp_temp_buf_pools = g_slist_remove (gimp_temp_buf_pools, pool);
+
+  g_mutex_unlock (&gimp_temp_buf_pools_mutex);
+
+  gimp_temp_buf_pool_clear (pool);
+
+  g_mutex_clear (&pool->mutex);
+
+  g_slice_free (GimpTempBufPool, pool);
+}
+
+static guchar *
+gimp_temp_buf_data_alloc (gsize  size,
+                          gint  *size_class)
+{
+  GimpTempBufPool *pool;
+  gsize            class_size;
+  gpointer         block;
+
+  *size_class = gimp_temp_buf_get_size_class (size, &class_size);
+
+  if (*size_class < 0)
+    return gegl_malloc (size);
+
+  pool  = gimp_temp_buf_pool_get ();
+  block = pool->blocks[*size_class];
+
+  if (block)
+    {
+      pool->blocks[*size_class] = *(gpointer *) block;
+      pool->size               -= class_size;
+
+      g_atomic_pointer_add (&gimp_temp_buf_pool_memsize, -(gssize) class_size);
+    }
+
+  g_mutex_unlock (&pool->mutex);
+
+  if (! block)
+    block = gegl_malloc (class_size);
+
+  return block;
+}
+
+/* blocks are returned to the pool of the freeing thread, which is not
+ * necessarily the allocating thread.
+ */
+static void
+gimp_temp_buf_data_free (guchar *data,
+                         gint    size_class)
+{
+  GimpTempBufPool *pool;
+  gsize            class_size;
+
+  if (size_class < 0)
+    {
+      gegl_free (data);
+
+      return;
+    }
+
+  if (size_class == 0)
+    {
+      class_size = 1 << POOL_MIN_SHIFT;
+    }
+  else
+    {
+      gint shift = POOL_MIN_SHIFT + (size_class - 1) / 4;
+
+      class_size = ((gsize) 1 << (shift - 2)) * (5 + (size_class - 1) % 4);
+    }
+
+  pool = gimp_temp_buf_pool_get ();
+
+  if (pool->size + class_size > POOL_MAX_SIZE)
+    {
+      g_mutex_unlock (&pool->mutex);
+
+      gegl_free (data);
+
+      return;
+    }
+
+  *(gpointer *) data       = pool->blocks[size_class];
+  pool->blocks[size_class] = data;
+  pool->size              += class_size;
+
+  g_atomic_pointer_add (&gimp_temp_buf_pool_memsize, class_size);
+
+  g_mutex_unlock (&pool->mutex);
+}
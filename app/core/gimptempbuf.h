@@ -57,7 +57,10 @@ GdkPixbuf   * gimp_temp_buf_create_pixbuf     (const GimpTempBuf *temp_buf) G_GN
 
 GimpTempBuf * gimp_gegl_buffer_get_temp_buf   (GeglBuffer        *buffer);
 
+void          gimp_temp_buf_pool_reset        (void);
+
 
 /*  stats  */
 
 guint64       gimp_temp_buf_get_total_memsize (void);
+guint64       gimp_temp_buf_get_pool_memsize  (void);
@@ -46,6 +46,7 @@ enum
 {
   POP,
   FREE,
+  MEMSIZE_CHANGED,
   LAST_SIGNAL
 };
 
@@ -84,12 +85,22 @@ static GimpTempBuf * gimp_undo_get_new_preview     (GimpViewable        *viewabl
                                                     gint                 width,
                                                     gint                 height,
                                                     GeglColor           *fg_color);
+static gchar       * gimp_undo_get_description     (GimpViewable        *viewable,
+                                                    gchar              **tooltip);
 
 static void          gimp_undo_real_pop            (GimpUndo            *undo,
                                                     GimpUndoMode         undo_mode,
                                                     GimpUndoAccumulator *accum);
 static void          gimp_undo_real_free           (GimpUndo            *undo,
                                                     GimpUndoMode         undo_mode);
+static void          gimp_undo_real_compress       (GimpUndo            *undo);
+static gboolean     gimp_undo_real_get_compression (GimpUndo            *undo,
+                                                    gint64              *raw_size,
+                                                    gint64              *compressed_size);
+static gboolean      gimp_undo_real_spill          (GimpUndo            *undo);
+static gint64        gimp_undo_real_get_swap_size  (GimpUndo            *undo);
+static gboolean      gimp_undo_real_reload         (GimpUndo            *undo,
+                                                    GError             **error);
 
 static gboolean      gimp_undo_create_preview_idle (gpointer             data);
 static void       gimp_undo_create_preview_private (GimpUndo            *undo,
@@ -130,6 +141,15 @@ gimp_undo_class_init (GimpUndoClass *klass)
                   G_TYPE_NONE, 1,
                   GIMP_TYPE_UNDO_MODE);
 
+  undo_signals[MEMSIZE_CHANGED] =
+    g_signal_new ("memsize-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_FIRST,
+                  G_STRUCT_OFFSET (GimpUndoClass, memsize_changed),
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 1,
+                  G_TYPE_INT64);
+
   object_class->constructed         = gimp_undo_constructed;
   object_class->finalize            = gimp_undo_finalize;
   object_class->set_property        = gimp_undo_set_property;
@@ -140,9 +160,16 @@ gimp_undo_class_init (GimpUndoClass *klass)
   viewable_class->default_icon_name = "edit-undo";
   viewable_class->get_popup_size    = gimp_undo_get_popup_size;
   viewable_class->get_new_preview   = gimp_undo_get_new_preview;
+  viewable_class->get_description   = gimp_undo_get_description;
 
   klass->pop                        = gimp_undo_real_pop;
   klass->free                       = gimp_undo_real_free;
+  klass->compress                   = gimp_undo_real_compress;
+  klass->get_compression            = gimp_undo_real_get_compression;
+  klass->spill                      = gimp_undo_real_spill;
+  klass->get_swap_size              = gimp_undo_real_get_swap_size;
+  klass->reload                     = gimp_undo_real_reload;
+  klass->memsize_changed            = NULL;
 
   g_object_class_install_property (object_class, PROP_IMAGE,
                                    g_param_spec_object ("image", NULL, NULL,
@@ -334,6 +361,62 @@ gimp_undo_get_new_preview (GimpViewable *viewable,
   return NULL;
 }
 
+static gchar *
+gimp_undo_get_description (GimpViewable  *viewable,
+                           gchar        **tooltip)
+{
+  GimpUndo *undo = GIMP_UNDO (viewable);
+  gint64    raw_size;
+  gint64    compressed_size;
+  gint64    swap_size;
+
+  if (! tooltip)
+    return GIMP_VIEWABLE_CLASS (parent_class)->get_description (viewable,
+                                                                NULL);
+
+  swap_size = gimp_undo_get_swap_size (undo);
+
+  if (gimp_undo_get_compression (undo, &raw_size, &compressed_size))
+    {
+      gchar *raw_str        = g_format_size (raw_size);
+      gchar *compressed_str = g_format_size (compressed_size);
+
+      /* TRANSLATORS: the first %s is the compressed size of an undo
+       * step, the second one its uncompressed size, e.g. "4.2 MB of 16.8 MB"
+       */
+      *tooltip = g_strdup_printf (_("Compressed: %s of %s"),
+                                  compressed_str, raw_str);
+
+      g_free (raw_str);
+      g_free (compressed_str);
+    }
+
+  if (swap_size > 0)
+    {
+      gchar *swap_str = g_format_size (swap_size);
+      gchar *swapped  = g_strdup_printf (_("Swapped to disk: %s"), swap_str);
+
+      if (*tooltip)
+        {
+          gchar *tmp = *tooltip;
+
+          *tooltip = g_strconcat (tmp, "\n", swapped, NULL);
+
+          g_free (tmp);
+          g_free (swapped);
+        }
+      else
+        {
+          *tooltip = swapped;
+        }
+
+      g_free (swap_str);
+    }
+
+  return GIMP_VIEWABLE_CLASS (parent_class)->get_description (viewable,
+                                                              NULL);
+}
+
 static void
 gimp_undo_real_pop (GimpUndo            *undo,
                     GimpUndoMode         undo_mode,
@@ -347,6 +430,38 @@ gimp_undo_real_free (GimpUndo     *undo,
 {
 }
 
+static void
+gimp_undo_real_compress (GimpUndo *undo)
+{
+}
+
+static gboolean
+gimp_undo_real_get_compression (GimpUndo *undo,
+                                gint64   *raw_size,
+                                gint64   *compressed_size)
+{
+  return FALSE;
+}
+
+static gboolean
+gimp_undo_real_spill (GimpUndo *undo)
+{
+  return FALSE;
+}
+
+static gint64
+gimp_undo_real_get_swap_size (GimpUndo *undo)
+{
+  return 0;
+}
+
+static gboolean
+gimp_undo_real_reload (GimpUndo  *undo,
+                       GError   **error)
+{
+  return TRUE;
+}
+
 void
 gimp_undo_pop (GimpUndo            *undo,
                GimpUndoMode         undo_mode,
@@ -381,6 +496,160 @@ gimp_undo_free (GimpUndo     *undo,
   g_signal_emit (undo, undo_signals[FREE], 0, undo_mode);
 }
 
+/**
+ * gimp_undo_compress:
+ * @undo: a #GimpUndo
+ *
+ * Asks @undo to compress its payload in the background. Undo steps
+ * which don't keep any pixel data ignore this.
+ */
+void
+gimp_undo_compress (GimpUndo *undo)
+{
+  g_return_if_fail (GIMP_IS_UNDO (undo));
+
+  GIMP_UNDO_GET_CLASS (undo)->compress (undo);
+}
+
+/**
+ * gimp_undo_get_compression:
+ * @undo:            a #GimpUndo
+ * @raw_size:        (out) (optional): the uncompressed size of the payload
+ * @compressed_size: (out) (optional): the compressed size of the payload
+ *
+ * Returns: %TRUE if (part of) @undo's payload is currently compressed.
+ */
+gboolean
+gimp_undo_get_compression (GimpUndo *undo,
+                           gint64   *raw_size,
+                           gint64   *compressed_size)
+{
+  gint64   raw        = 0;
+  gint64   compressed = 0;
+  gboolean success;
+
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), FALSE);
+
+  success = GIMP_UNDO_GET_CLASS (undo)->get_compression (undo,
+                                                         &raw, &compressed);
+
+  if (raw_size)        *raw_size        = raw;
+  if (compressed_size) *compressed_size = compressed;
+
+  return success;
+}
+
+/**
+ * gimp_undo_spill:
+ * @undo: a #GimpUndo
+ *
+ * Moves @undo's payload out of memory into a swap file, from where it
+ * is reloaded when @undo is popped.
+ *
+ * Returns: %TRUE if @undo's memory size was reduced.
+ */
+gboolean
+gimp_undo_spill (GimpUndo *undo)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), FALSE);
+
+  return GIMP_UNDO_GET_CLASS (undo)->spill (undo);
+}
+
+/**
+ * gimp_undo_get_swap_size:
+ * @undo: a #GimpUndo
+ *
+ * Returns: the number of bytes of @undo's payload which are currently
+ *          swapped out to disk.
+ */
+gint64
+gimp_undo_get_swap_size (GimpUndo *undo)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), 0);
+
+  return GIMP_UNDO_GET_CLASS (undo)->get_swap_size (undo);
+}
+
+/**
+ * gimp_undo_reload:
+ * @undo:  a #GimpUndo
+ * @error: return location for an error
+ *
+ * Brings @undo's payload back into memory, if gimp_undo_spill() moved
+ * it out, so that popping @undo can't fail. If this fails, @undo is
+ * left as it was and must not be popped.
+ *
+ * Returns: %TRUE if @undo can be popped.
+ */
+gboolean
+gimp_undo_reload (GimpUndo  *undo,
+                  GError   **error)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  return GIMP_UNDO_GET_CLASS (undo)->reload (undo, error);
+}
+
+/**
+ * gimp_undo_memsize_changed:
+ * @undo: a #GimpUndo
+ *
+ * Re-measures @undo and updates its cached memory size. Subclasses
+ * call this whenever their payload changes while @undo sits on an
+ * undo stack, e.g. after it got compressed or swapped out, so the
+ * stack's running total stays accurate.
+ */
+void
+gimp_undo_memsize_changed (GimpUndo *undo)
+{
+  g_return_if_fail (GIMP_IS_UNDO (undo));
+
+  gimp_undo_set_cached_memsize (undo,
+                                gimp_object_get_memsize (GIMP_OBJECT (undo),
+                                                         NULL));
+}
+
+/**
+ * gimp_undo_set_cached_memsize:
+ * @undo:    a #GimpUndo
+ * @memsize: the new memory size of @undo
+ *
+ * Sets @undo's cached memory size, and emits "memsize-changed" with
+ * the difference to the previous value if it changed.
+ */
+void
+gimp_undo_set_cached_memsize (GimpUndo *undo,
+                              gint64    memsize)
+{
+  g_return_if_fail (GIMP_IS_UNDO (undo));
+
+  if (memsize != undo->memsize)
+    {
+      gint64 delta = memsize - undo->memsize;
+
+      undo->memsize = memsize;
+
+      g_signal_emit (undo, undo_signals[MEMSIZE_CHANGED], 0, delta);
+    }
+}
+
+/**
+ * gimp_undo_get_cached_memsize:
+ * @undo: a #GimpUndo
+ *
+ * Returns: @undo's memory size, as of the last time it was measured,
+ *          without walking its payload. Excludes the GUI size.
+ */
+gint64
+gimp_undo_get_cached_memsize (GimpUndo *undo)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), 0);
+
+  return undo->memsize;
+}
+
 typedef struct _GimpUndoIdle GimpUndoIdle;
 
 struct _GimpUndoIdle
@@ -59,36 +59,67 @@ struct _GimpUndo
 
   GimpTempBuf      *preview;
   guint             preview_idle_id;
+
+  gint64            memsize;        /* cached memory size                 */
 };
 
 struct _GimpUndoClass
 {
   GimpViewableClass  parent_class;
 
-  void (* pop)  (GimpUndo            *undo,
-                 GimpUndoMode         undo_mode,
-                 GimpUndoAccumulator *accum);
-  void (* free) (GimpUndo            *undo,
-                 GimpUndoMode         undo_mode);
+  void     (* pop)             (GimpUndo            *undo,
+                                GimpUndoMode         undo_mode,
+                                GimpUndoAccumulator *accum);
+  void     (* free)            (GimpUndo            *undo,
+                                GimpUndoMode         undo_mode);
+
+  void     (* compress)        (GimpUndo            *undo);
+  gboolean (* get_compression) (GimpUndo            *undo,
+                                gint64              *raw_size,
+                                gint64              *compressed_size);
+
+  gboolean (* spill)           (GimpUndo            *undo);
+  gint64   (* get_swap_size)   (GimpUndo            *undo);
+  gboolean (* reload)          (GimpUndo            *undo,
+                                GError             **error);
+
+  /*  signals  */
+  void     (* memsize_changed) (GimpUndo            *undo,
+                                gint64               delta);
 };
 
 
-GType         gimp_undo_get_type        (void) G_GNUC_CONST;
+GType         gimp_undo_get_type           (void) G_GNUC_CONST;
+
+void          gimp_undo_pop                (GimpUndo            *undo,
+                                            GimpUndoMode         undo_mode,
+                                            GimpUndoAccumulator *accum);
+void          gimp_undo_free               (GimpUndo            *undo,
+                                            GimpUndoMode         undo_mode);
+
+void          gimp_undo_compress           (GimpUndo            *undo);
+gboolean      gimp_undo_get_compression    (GimpUndo            *undo,
+                                            gint64              *raw_size,
+                                            gint64              *compressed_size);
+
+gboolean      gimp_undo_spill              (GimpUndo            *undo);
+gint64        gimp_undo_get_swap_size      (GimpUndo            *undo);
+gboolean      gimp_undo_reload             (GimpUndo            *undo,
+                                            GError             **error);
 
-void          gimp_undo_pop             (GimpUndo            *undo,
-                                         GimpUndoMode         undo_mode,
-                                         GimpUndoAccumulator *accum);
-void          gimp_undo_free            (GimpUndo            *undo,
-                                         GimpUndoMode         undo_mode);
+void          gimp_undo_memsize_changed    (GimpUndo            *undo);
+void          gimp_undo_set_cached_memsize (GimpUndo            *undo,
+                                            gint64               memsize);
+gint64        gimp_undo_get_cached_memsize (GimpUndo            *undo);
 
-void          gimp_undo_create_preview  (GimpUndo            *undo,
-                                         GimpContext         *context,
-                                         gboolean             create_now);
-void          gimp_undo_refresh_preview (GimpUndo            *undo,
-                                         GimpContext         *context);
+void          gimp_undo_create_preview     (GimpUndo            *undo,
+                                            GimpContext         *context,
+                                            gboolean             create_now);
+void          gimp_undo_refresh_preview    (GimpUndo            *undo,
+                                            GimpContext         *context);
 
-const gchar * gimp_undo_type_to_name    (GimpUndoType         type);
+const gchar * gimp_undo_type_to_name       (GimpUndoType         type);
 
-gboolean      gimp_undo_is_weak         (GimpUndo            *undo);
-gint          gimp_undo_get_age         (GimpUndo            *undo);
-void          gimp_undo_reset_age       (GimpUndo            *undo);
+gboolean      gimp_undo_is_weak            (GimpUndo            *undo);
+gint          gimp_undo_get_age            (GimpUndo            *undo);
+void          gimp_undo_reset_age          (GimpUndo            *undo);
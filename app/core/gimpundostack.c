@@ -28,16 +28,29 @@
 #include "gimpundostack.h"
 
 
-static void    gimp_undo_stack_finalize    (GObject             *object);
-
-static gint64  gimp_undo_stack_get_memsize (GimpObject          *object,
-                                            gint64              *gui_size);
-
-static void    gimp_undo_stack_pop         (GimpUndo            *undo,
-                                            GimpUndoMode         undo_mode,
-                                            GimpUndoAccumulator *accum);
-static void    gimp_undo_stack_free        (GimpUndo            *undo,
-                                            GimpUndoMode         undo_mode);
+static void     gimp_undo_stack_finalize        (GObject             *object);
+
+static gint64   gimp_undo_stack_get_memsize     (GimpObject          *object,
+                                                 gint64              *gui_size);
+
+static void     gimp_undo_stack_pop             (GimpUndo            *undo,
+                                                 GimpUndoMode         undo_mode,
+                                                 GimpUndoAccumulator *accum);
+static void     gimp_undo_stack_free            (GimpUndo            *undo,
+                                                 GimpUndoMode         undo_mode);
+static void     gimp_undo_stack_compress        (GimpUndo            *undo);
+static gboolean gimp_undo_stack_get_compression (GimpUndo            *undo,
+                                                 gint64              *raw_size,
+                                                 gint64              *compressed_size);
+static gboolean gimp_undo_stack_spill           (GimpUndo            *undo);
+static gint64   gimp_undo_stack_get_swap_size   (GimpUndo            *undo);
+static gboolean gimp_undo_stack_reload          (GimpUndo            *undo,
+                                                 GError             **error);
+
+static void     gimp_undo_stack_undo_memsize_changed
+                                                (GimpUndo            *undo,
+                                                 gint64               delta,
+                                                 GimpUndoStack       *stack);
 
 
 G_DEFINE_TYPE (GimpUndoStack, gimp_undo_stack, GIMP_TYPE_UNDO)
@@ -58,12 +71,21 @@ gimp_undo_stack_class_init (GimpUndoStackClass *klass)
 
   undo_class->pop                = gimp_undo_stack_pop;
   undo_class->free               = gimp_undo_stack_free;
+  undo_class->compress           = gimp_undo_stack_compress;
+  undo_class->get_compression    = gimp_undo_stack_get_compression;
+  undo_class->spill              = gimp_undo_stack_spill;
+  undo_class->get_swap_size      = gimp_undo_stack_get_swap_size;
+  undo_class->reload             = gimp_undo_stack_reload;
 }
 
 static void
 gimp_undo_stack_init (GimpUndoStack *stack)
 {
   stack->undos = gimp_list_new (GIMP_TYPE_UNDO, FALSE);
+
+  gimp_container_add_handler (stack->undos, "memsize-changed",
+                              G_CALLBACK (gimp_undo_stack_undo_memsize_changed),
+                              stack);
 }
 
 static void
@@ -125,6 +147,126 @@ gimp_undo_stack_free (GimpUndo     *undo,
     }
 
   gimp_container_clear (stack->undos);
+
+  gimp_undo_memsize_changed (undo);
+}
+
+static void
+gimp_undo_stack_compress (GimpUndo *undo)
+{
+  GimpUndoStack *stack = GIMP_UNDO_STACK (undo);
+  GList         *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *child = list->data;
+
+      gimp_undo_compress (child);
+    }
+}
+
+static gboolean
+gimp_undo_stack_get_compression (GimpUndo *undo,
+                                 gint64   *raw_size,
+                                 gint64   *compressed_size)
+{
+  GimpUndoStack *stack   = GIMP_UNDO_STACK (undo);
+  gboolean       success = FALSE;
+  GList         *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *child = list->data;
+      gint64    child_raw_size;
+      gint64    child_compressed_size;
+
+      if (gimp_undo_get_compression (child,
+                                     &child_raw_size,
+                                     &child_compressed_size))
+        {
+          *raw_size        += child_raw_size;
+          *compressed_size += child_compressed_size;
+
+          success = TRUE;
+        }
+    }
+
+  return success;
+}
+
+static gboolean
+gimp_undo_stack_spill (GimpUndo *undo)
+{
+  GimpUndoStack *stack   = GIMP_UNDO_STACK (undo);
+  gboolean       success = FALSE;
+  GList         *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *child = list->data;
+
+      if (gimp_undo_spill (child))
+        success = TRUE;
+    }
+
+  return success;
+}
+
+static gint64
+gimp_undo_stack_get_swap_size (GimpUndo *undo)
+{
+  GimpUndoStack *stack     = GIMP_UNDO_STACK (undo);
+  gint64         swap_size = 0;
+  GList         *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *child = list->data;
+
+      swap_size += gimp_undo_get_swap_size (child);
+    }
+
+  return swap_size;
+}
+
+static gboolean
+gimp_undo_stack_reload (GimpUndo  *undo,
+                        GError   **error)
+{
+  GimpUndoStack *stack = GIMP_UNDO_STACK (undo);
+  GList         *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *child = list->data;
+
+      if (! gimp_undo_reload (child, error))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gimp_undo_stack_undo_memsize_changed (GimpUndo      *undo,
+                                      gint64         delta,
+                                      GimpUndoStack *stack)
+{
+  /*  keeps the running total up to date, and passes the change on to
+   *  the stack this one is a group in, if any
+   */
+  gimp_undo_set_cached_memsize (GIMP_UNDO (stack),
+                                GIMP_UNDO (stack)->memsize + delta);
 }
 
 GimpUndoStack *
@@ -144,7 +286,15 @@ gimp_undo_stack_push_undo (GimpUndoStack *stack,
   g_return_if_fail (GIMP_IS_UNDO_STACK (stack));
   g_return_if_fail (GIMP_IS_UNDO (undo));
 
+  /*  measure @undo once, from here on changes to its payload are
+   *  reported by "memsize-changed"
+   */
+  gimp_undo_memsize_changed (undo);
+
   gimp_container_add (stack->undos, GIMP_OBJECT (undo));
+
+  gimp_undo_set_cached_memsize (GIMP_UNDO (stack),
+                                GIMP_UNDO (stack)->memsize + undo->memsize);
 }
 
 GimpUndo *
@@ -162,6 +312,11 @@ gimp_undo_stack_pop_undo (GimpUndoStack       *stack,
   if (undo)
     {
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+
+      gimp_undo_set_cached_memsize (GIMP_UNDO (stack),
+                                    GIMP_UNDO (stack)->memsize -
+                                    undo->memsize);
+
       gimp_undo_pop (undo, undo_mode, accum);
 
       return undo;
@@ -183,6 +338,11 @@ gimp_undo_stack_free_bottom (GimpUndoStack *stack,
   if (undo)
     {
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+
+      gimp_undo_set_cached_memsize (GIMP_UNDO (stack),
+                                    GIMP_UNDO (stack)->memsize -
+                                    undo->memsize);
+
       gimp_undo_free (undo, undo_mode);
 
       return undo;
@@ -206,3 +366,22 @@ gimp_undo_stack_get_depth (GimpUndoStack *stack)
 
   return gimp_container_get_n_children (stack->undos);
 }
+
+/**
+ * gimp_undo_stack_get_size:
+ * @stack: a #GimpUndoStack
+ *
+ * Returns the memory size of all undo steps on @stack. Unlike
+ * gimp_object_get_memsize(), this doesn't walk the steps but returns
+ * a total which is updated as steps are pushed, popped and freed, or
+ * change their payload, so it is cheap enough to be called in a loop.
+ *
+ * Returns: the memory size of @stack's undo steps.
+ */
+gint64
+gimp_undo_stack_get_size (GimpUndoStack *stack)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO_STACK (stack), 0);
+
+  return GIMP_UNDO (stack)->memsize;
+}
@@ -1233,23 +1233,34 @@ prefs_dialog_new (Gimp       *gimp,
   prefs_memsize_entry_add (object, "undo-size",
                            _("Maximum undo _memory:"),
                            GTK_GRID (grid), 1, size_group);
+  prefs_memsize_entry_add (object, "undo-swap-size",
+                           _("Undo _disk space:"),
+                           GTK_GRID (grid), 2, size_group);
   prefs_memsize_entry_add (object, "tile-cache-size",
                            _("Tile cache _size:"),
-                           GTK_GRID (grid), 2, size_group);
+                           GTK_GRID (grid), 3, size_group);
+  prefs_memsize_entry_add (object, "brush-cache-size",
+                           _("_Brush cache size:"),
+                           GTK_GRID (grid), 4, size_group);
   prefs_memsize_entry_add (object, "max-new-image-size",
                            _("Maximum _new image size:"),
-                           GTK_GRID (grid), 3, size_group);
+                           GTK_GRID (grid), 5, size_group);
 
   prefs_compression_combo_box_add (object, "swap-compression",
                                    _("S_wap compression:"),
-                                   GTK_GRID (grid), 4, size_group);
+                                   GTK_GRID (grid), 6, size_group);
 
 #ifdef ENABLE_MP
   prefs_spin_button_add (object, "num-processors", 1.0, 4.0, 0,
                          _("Number of _threads to use:"),
-                         GTK_GRID (grid), 5, size_group);
+                         GTK_GRID (grid), 7, size_group);
 #endif /* ENABLE_MP */
 
+  prefs_switch_add (object, "undo-compression",
+                    _("Compress the undo _history in the background"),
+                    GTK_BOX (vbox2),
+                    size_group, NULL);
+
   /*  Internet access  */
 #ifdef CHECK_UPDATE
   if (gimp_version_check_update ())
@@ -1701,6 +1712,9 @@ prefs_dialog_new (Gimp       *gimp,
       button = prefs_check_button_add (object, "playground-use-list-box",
                                        _("Use GtkListBox in simple lists"),
                                        GTK_BOX (vbox2));
+      button = prefs_check_button_add (object, "threaded-projection",
+                                       _("_Threaded image rendering"),
+                                       GTK_BOX (vbox2));
     }
 
 
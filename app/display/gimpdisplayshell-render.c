@@ -58,6 +58,9 @@ gimp_display_shell_render_set_scale (GimpDisplayShell *shell,
       shell->render_scale = scale;
 
       gimp_display_shell_render_invalidate_full (shell);
+
+      /*  let the projection render at the matching mipmap level  */
+      gimp_display_shell_update_priority_rect (shell);
     }
 #endif
 }
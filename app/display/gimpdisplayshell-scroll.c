@@ -47,6 +47,20 @@
 
 #define OVERPAN_FACTOR 0.5
 
+/*  weight of the previous velocity estimate, and the time after which
+ *  the display is no longer considered to be moving
+ */
+#define VELOCITY_SMOOTHING 0.6
+#define VELOCITY_TIMEOUT   (250 * G_TIME_SPAN_MILLISECOND)
+
+
+/*  local function prototypes  */
+
+static void   gimp_display_shell_scroll_update_velocity (GimpDisplayShell *shell,
+                                                         gint              x_offset,
+                                                         gint              y_offset);
+
+
 
 /**
  * gimp_display_shell_scroll:
@@ -90,6 +104,8 @@ gimp_display_shell_scroll (GimpDisplayShell *shell,
 
   if (x_offset || y_offset)
     {
+      gimp_display_shell_scroll_update_velocity (shell, x_offset, y_offset);
+
       gimp_display_shell_scrolled (shell);
 
       gimp_overlay_box_scroll (GIMP_OVERLAY_BOX (shell->canvas),
@@ -571,3 +587,66 @@ gimp_display_shell_scroll_get_viewport (GimpDisplayShell *shell,
   *w = shell->disp_width  / shell->scale_x;
   *h = shell->disp_height / shell->scale_y;
 }
+
+/**
+ * gimp_display_shell_scroll_get_velocity:
+ * @shell:
+ * @velocity_x:
+ * @velocity_y:
+ *
+ * Gets the current panning velocity of the display, in display pixels
+ * per second, or 0 if the display hasn't been scrolled recently.
+ **/
+void
+gimp_display_shell_scroll_get_velocity (GimpDisplayShell *shell,
+                                        gdouble          *velocity_x,
+                                        gdouble          *velocity_y)
+{
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+  g_return_if_fail (velocity_x != NULL);
+  g_return_if_fail (velocity_y != NULL);
+
+  if (g_get_monotonic_time () - shell->scroll_time < VELOCITY_TIMEOUT)
+    {
+      *velocity_x = shell->scroll_velocity_x;
+      *velocity_y = shell->scroll_velocity_y;
+    }
+  else
+    {
+      *velocity_x = 0.0;
+      *velocity_y = 0.0;
+    }
+}
+
+
+/*  private functions  */
+
+static void
+gimp_display_shell_scroll_update_velocity (GimpDisplayShell *shell,
+                                           gint              x_offset,
+                                           gint              y_offset)
+{
+  gint64 time = g_get_monotonic_time ();
+  gint64 dt   = time - shell->scroll_time;
+
+  if (dt >= VELOCITY_TIMEOUT)
+    {
+      /*  the first step of a new motion doesn't tell us its speed  */
+      shell->scroll_velocity_x = 0.0;
+      shell->scroll_velocity_y = 0.0;
+    }
+  else if (dt > 0)
+    {
+      gdouble velocity_x = (gdouble) x_offset * G_TIME_SPAN_SECOND / dt;
+      gdouble velocity_y = (gdouble) y_offset * G_TIME_SPAN_SECOND / dt;
+
+      shell->scroll_velocity_x =
+        VELOCITY_SMOOTHING         * shell->scroll_velocity_x +
+        (1.0 - VELOCITY_SMOOTHING) * velocity_x;
+      shell->scroll_velocity_y =
+        VELOCITY_SMOOTHING         * shell->scroll_velocity_y +
+        (1.0 - VELOCITY_SMOOTHING) * velocity_y;
+    }
+
+  shell->scroll_time = time;
+}
@@ -53,3 +53,7 @@ void   gimp_display_shell_scroll_get_viewport        (GimpDisplayShell *shell,
                                                       gdouble          *y,
                                                       gdouble          *w,
                                                       gdouble          *h);
+
+void   gimp_display_shell_scroll_get_velocity        (GimpDisplayShell *shell,
+                                                      gdouble          *velocity_x,
+                                                      gdouble          *velocity_y);
@@ -96,6 +96,10 @@
 #include "gimp-intl.h"
 
 
+/*  how far ahead of the panning motion to prerender, in seconds  */
+#define PREFETCH_LOOKAHEAD 0.5
+
+
 enum
 {
   PROP_0,
@@ -2235,10 +2239,59 @@ gimp_display_shell_update_priority_rect (GimpDisplayShell *shell)
       GimpProjection *projection = gimp_image_get_projection (image);
       gint            x, y;
       gint            width, height;
+      gdouble         render_scale;
+      gdouble         velocity_x, velocity_y;
 
       gimp_display_shell_untransform_viewport (shell, ! shell->show_all,
                                                &x, &y, &width, &height);
       gimp_projection_set_priority_rect (projection, x, y, width, height);
+
+      /*  the scale gimp_display_shell_draw() renders the image at  */
+      render_scale = shell->render_scale *
+                     MAX (shell->scale_x, shell->scale_y);
+
+      gimp_projection_set_render_scale (projection, render_scale);
+
+      gimp_display_shell_scroll_get_velocity (shell, &velocity_x, &velocity_y);
+
+      if (velocity_x || velocity_y)
+        {
+          gdouble cx, cy;
+          gdouble dx, dy;
+          gdouble x1, y1;
+          gdouble x2, y2;
+
+          /*  prerender the area the viewport is about to move into,
+           *  PREFETCH_LOOKAHEAD seconds ahead, but no further than one
+           *  viewport away.
+           */
+          dx = CLAMP (velocity_x * PREFETCH_LOOKAHEAD,
+                      -shell->disp_width, shell->disp_width);
+          dy = CLAMP (velocity_y * PREFETCH_LOOKAHEAD,
+                      -shell->disp_height, shell->disp_height);
+
+          cx = shell->disp_width  / 2.0;
+          cy = shell->disp_height / 2.0;
+
+          /*  map the displacement to image space, taking the display
+           *  rotation and flipping into account
+           */
+          gimp_display_shell_untransform_xy_f (shell, cx,      cy,
+                                               &x1, &y1);
+          gimp_display_shell_untransform_xy_f (shell, cx + dx, cy + dy,
+                                               &x2, &y2);
+
+          gimp_projection_set_prefetch_rect (projection,
+                                             x + SIGNED_ROUND (x2 - x1),
+                                             y + SIGNED_ROUND (y2 - y1),
+                                             width, height,
+                                             render_scale);
+        }
+      else
+        {
+          gimp_projection_set_prefetch_rect (projection, 0, 0, 0, 0,
+                                             render_scale);
+        }
     }
 }
 
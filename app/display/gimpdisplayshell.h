@@ -222,6 +222,9 @@ struct _GimpDisplayShell
   gint               scroll_start_y;
   gint               scroll_last_x;
   gint               scroll_last_y;
+  gdouble            scroll_velocity_x; /*  panning speed, in display pixels  */
+  gdouble            scroll_velocity_y; /*  per second                        */
+  gint64             scroll_time;       /*  time of the last scroll           */
   gdouble            rotate_drag_angle;
   gpointer           scroll_info;
   GimpLayer         *picked_layer;
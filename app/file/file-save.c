@@ -42,6 +42,8 @@
 
 #include "plug-in/gimppluginprocedure.h"
 
+#include "xcf/xcf.h"
+
 #include "file-remote.h"
 #include "file-save.h"
 #include "gimp-file.h"
@@ -191,6 +193,11 @@ file_save (Gimp                *gimp,
       g_free (my_path);
     }
 
+  /*  images lazily loaded from the file still need it, whichever
+   *  procedure is going to overwrite it
+   */
+  xcf_release_file (orig_file);
+
   return_vals =
     gimp_pdb_execute_procedure_by_name (image->gimp->pdb,
                                         gimp_get_user_context (gimp),
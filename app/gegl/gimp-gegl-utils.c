@@ -337,6 +337,53 @@ gimp_gegl_buffer_dup (GeglBuffer *buffer)
   return new_buffer;
 }
 
+/* returns a copy of 'rect' of 'buffer', placed at (0, 0).  'rect' is
+ * grown to the buffer's tile grid, and the copy uses the buffer's tile
+ * size, so that the tiles are shared copy-on-write instead of copied:
+ * taking a snapshot is cheap, and memory is only paid for tiles which
+ * are modified in 'buffer' afterwards.  the area actually copied is
+ * returned in 'snapshot_rect'.
+ */
+GeglBuffer *
+gimp_gegl_buffer_snapshot (GeglBuffer          *buffer,
+                           const GeglRectangle *rect,
+                           GeglRectangle       *snapshot_rect)
+{
+  GeglBuffer    *new_buffer;
+  GeglRectangle  aligned_rect;
+  gint           tile_width;
+  gint           tile_height;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (rect != NULL, NULL);
+
+  gegl_rectangle_align_to_buffer (&aligned_rect, rect, buffer,
+                                  GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+
+  g_object_get (buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  new_buffer = g_object_new (GEGL_TYPE_BUFFER,
+                             "format",      gegl_buffer_get_format (buffer),
+                             "x",           0,
+                             "y",           0,
+                             "width",       aligned_rect.width,
+                             "height",      aligned_rect.height,
+                             "tile-width",  tile_width,
+                             "tile-height", tile_height,
+                             NULL);
+
+  gimp_gegl_buffer_copy (buffer, &aligned_rect, GEGL_ABYSS_NONE,
+                         new_buffer, GEGL_RECTANGLE (0, 0, 0, 0));
+
+  if (snapshot_rect)
+    *snapshot_rect = aligned_rect;
+
+  return new_buffer;
+}
+
 GeglBuffer *
 gimp_gegl_buffer_resize (GeglBuffer   *buffer,
                          gint          new_width,
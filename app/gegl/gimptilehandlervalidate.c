@@ -44,10 +44,19 @@ enum
   PROP_FORMAT,
   PROP_TILE_WIDTH,
   PROP_TILE_HEIGHT,
-  PROP_WHOLE_TILE
+  PROP_WHOLE_TILE,
+  PROP_MAX_LEVEL
 };
 
 
+typedef struct
+{
+  GimpTileHandlerValidate *validate;
+  GeglBuffer              *buffer;
+  GArray                  *rects;
+} ValidateParallelData;
+
+
 static void     gimp_tile_handler_validate_finalize             (GObject         *object);
 static void     gimp_tile_handler_validate_set_property         (GObject         *object,
                                                                  guint            property_id,
@@ -69,6 +78,11 @@ static void     gimp_tile_handler_validate_real_validate_buffer (GimpTileHandler
                                                                  const GeglRectangle     *rect,
                                                                  GeglBuffer              *buffer);
 
+static void     gimp_tile_handler_validate_validate_parallel_func
+                                                                (gint                  i,
+                                                                 gint                  n,
+                                                                 ValidateParallelData *data);
+
 static gpointer gimp_tile_handler_validate_command              (GeglTileSource  *source,
                                                                  GeglTileCommand  command,
                                                                  gint             x,
@@ -130,6 +144,12 @@ gimp_tile_handler_validate_class_init (GimpTileHandlerValidateClass *klass)
                                                          FALSE,
                                                          GIMP_PARAM_READWRITE |
                                                          G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (object_class, PROP_MAX_LEVEL,
+                                   g_param_spec_int ("max-level", NULL, NULL,
+                                                     0, GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL, 0,
+                                                     GIMP_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT));
 }
 
 static void
@@ -175,6 +195,9 @@ gimp_tile_handler_validate_set_property (GObject      *object,
     case PROP_WHOLE_TILE:
       validate->whole_tile = g_value_get_boolean (value);
       break;
+    case PROP_MAX_LEVEL:
+      validate->max_level = g_value_get_int (value);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -204,6 +227,9 @@ gimp_tile_handler_validate_get_property (GObject    *object,
     case PROP_WHOLE_TILE:
       g_value_set_boolean (value, validate->whole_tile);
       break;
+    case PROP_MAX_LEVEL:
+      g_value_set_int (value, validate->max_level);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -271,6 +297,71 @@ gimp_tile_handler_validate_real_validate_buffer (GimpTileHandlerValidate *valida
     }
 }
 
+/*  renders a mipmap tile directly from the graph, at the tile's scale,
+ *  when the part of level 0 it's built from is dirty, instead of rendering
+ *  all of that part at full resolution, and scaling it down.  level 0
+ *  remains dirty, and is only rendered once it's actually needed.
+ */
+static GeglTile *
+gimp_tile_handler_validate_validate_level_tile (GeglTileSource *source,
+                                                gint            x,
+                                                gint            y,
+                                                gint            z)
+{
+  GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (source);
+  GeglTile                *tile;
+  cairo_rectangle_int_t    tile_rect;
+  cairo_region_overlap_t   overlap;
+
+  if (validate->suspend_validate ||
+      cairo_region_is_empty (validate->dirty_region) ||
+      GIMP_TILE_HANDLER_VALIDATE_GET_CLASS (validate)->validate !=
+      gimp_tile_handler_validate_real_validate)
+    {
+      return gegl_tile_handler_source_command (source,
+                                               GEGL_TILE_GET, x, y, z, NULL);
+    }
+
+  /*  the tile's footprint on level 0  */
+  tile_rect.x      = (x * validate->tile_width)  << z;
+  tile_rect.y      = (y * validate->tile_height) << z;
+  tile_rect.width  = validate->tile_width        << z;
+  tile_rect.height = validate->tile_height       << z;
+
+  overlap = cairo_region_contains_rectangle (validate->dirty_region,
+                                             &tile_rect);
+
+  if (overlap == CAIRO_REGION_OVERLAP_OUT)
+    {
+      return gegl_tile_handler_source_command (source,
+                                               GEGL_TILE_GET, x, y, z, NULL);
+    }
+
+  tile = gegl_tile_handler_create_tile (GEGL_TILE_HANDLER (source), x, y, z);
+
+  gimp_tile_handler_validate_begin_validate (validate);
+
+  gegl_tile_lock (tile);
+
+  gegl_node_blit (validate->graph,
+                  1.0 / (1 << z),
+                  GEGL_RECTANGLE (x * validate->tile_width,
+                                  y * validate->tile_height,
+                                  validate->tile_width,
+                                  validate->tile_height),
+                  validate->format,
+                  gegl_tile_get_data (tile),
+                  babl_format_get_bytes_per_pixel (validate->format) *
+                  validate->tile_width,
+                  GEGL_BLIT_DEFAULT);
+
+  gegl_tile_unlock (tile);
+
+  gimp_tile_handler_validate_end_validate (validate);
+
+  return tile;
+}
+
 static GeglTile *
 gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
                                           gint            x,
@@ -408,6 +499,28 @@ gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
   return tile;
 }
 
+static void
+gimp_tile_handler_validate_validate_parallel_func (gint                  i,
+                                                   gint                  n,
+                                                   ValidateParallelData *data)
+{
+  GimpTileHandlerValidateClass *klass;
+  guint                         j;
+
+  klass = GIMP_TILE_HANDLER_VALIDATE_GET_CLASS (data->validate);
+
+  /* interleave the chunks between the threads, so that the chunks at the
+   * front of the list, which are closer to the start of the rect, are
+   * rendered first.
+   */
+  for (j = i; j < data->rects->len; j += n)
+    {
+      klass->validate_buffer (data->validate,
+                              &g_array_index (data->rects, GeglRectangle, j),
+                              data->buffer);
+    }
+}
+
 static gpointer
 gimp_tile_handler_validate_command (GeglTileSource  *source,
                                     GeglTileCommand  command,
@@ -416,8 +529,12 @@ gimp_tile_handler_validate_command (GeglTileSource  *source,
                                     gint             z,
                                     gpointer         data)
 {
+  GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (source);
+
   if (command == GEGL_TILE_GET && z == 0)
     return gimp_tile_handler_validate_validate_tile (source, x, y);
+  else if (command == GEGL_TILE_GET && z <= validate->max_level)
+    return gimp_tile_handler_validate_validate_level_tile (source, x, y, z);
 
   return gegl_tile_handler_source_command (source, command, x, y, z, data);
 }
@@ -623,6 +740,80 @@ gimp_tile_handler_validate_validate (GimpTileHandlerValidate *validate,
     }
 }
 
+/* same as 'gimp_tile_handler_validate_validate()' with 'intersect' and
+ * 'chunked' set to FALSE, except that 'rect' is split along the buffer's tile
+ * grid, and the resulting chunks are rendered concurrently, using the GEGL
+ * thread pool.  the chunks are disjoint, and each covers a single tile, so
+ * that no two threads write to the same tile.  the graph itself is shared,
+ * so every operation in it must support processing different areas at the
+ * same time; this is why the projection only uses this function when
+ * "threaded-projection" is enabled.
+ */
+void
+gimp_tile_handler_validate_validate_parallel (GimpTileHandlerValidate *validate,
+                                              GeglBuffer              *buffer,
+                                              const GeglRectangle     *rect)
+{
+  ValidateParallelData data;
+  GeglRectangle        chunk;
+  gint                 x;
+  gint                 y;
+
+  g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
+  g_return_if_fail (gimp_tile_handler_validate_get_assigned (buffer) ==
+                    validate);
+
+  if (! rect)
+    rect = gegl_buffer_get_extent (buffer);
+
+  data.validate = validate;
+  data.buffer   = buffer;
+  data.rects    = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+
+  for (y = rect->y - ((rect->y % validate->tile_height) +
+                      validate->tile_height) % validate->tile_height;
+       y < rect->y + rect->height;
+       y += validate->tile_height)
+    {
+      for (x = rect->x - ((rect->x % validate->tile_width) +
+                          validate->tile_width) % validate->tile_width;
+           x < rect->x + rect->width;
+           x += validate->tile_width)
+        {
+          if (gegl_rectangle_intersect (&chunk,
+                                        GEGL_RECTANGLE (x, y,
+                                                        validate->tile_width,
+                                                        validate->tile_height),
+                                        rect))
+            {
+              g_array_append_val (data.rects, chunk);
+            }
+        }
+    }
+
+  gimp_tile_handler_validate_begin_validate (validate);
+
+  if (data.rects->len > 1)
+    {
+      gegl_parallel_distribute (
+        data.rects->len,
+        (GeglParallelDistributeFunc)
+          gimp_tile_handler_validate_validate_parallel_func,
+        &data);
+    }
+  else if (data.rects->len == 1)
+    {
+      gimp_tile_handler_validate_validate_parallel_func (0, 1, &data);
+    }
+
+  gimp_tile_handler_validate_end_validate (validate);
+
+  cairo_region_subtract_rectangle (validate->dirty_region,
+                                   (const cairo_rectangle_int_t *) rect);
+
+  g_array_free (data.rects, TRUE);
+}
+
 gboolean
 gimp_tile_handler_validate_buffer_set_extent (GeglBuffer          *buffer,
                                               const GeglRectangle *extent)
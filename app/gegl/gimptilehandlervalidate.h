@@ -25,6 +25,10 @@
  * projection.
  */
 
+/*  the highest mipmap level that can be rendered directly  */
+#define GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL 8
+
+
 #define GIMP_TYPE_TILE_HANDLER_VALIDATE            (gimp_tile_handler_validate_get_type ())
 #define GIMP_TILE_HANDLER_VALIDATE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_TILE_HANDLER_VALIDATE, GimpTileHandlerValidate))
 #define GIMP_TILE_HANDLER_VALIDATE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_TILE_HANDLER_VALIDATE, GimpTileHandlerValidateClass))
@@ -48,6 +52,7 @@ struct _GimpTileHandlerValidate
   gboolean         whole_tile;
   gint             validating;
   gint             suspend_validate;
+  gint             max_level;
 };
 
 struct _GimpTileHandlerValidateClass
@@ -95,6 +100,9 @@ void                      gimp_tile_handler_validate_validate          (GimpTile
                                                                         const GeglRectangle     *rect,
                                                                         gboolean                 intersect,
                                                                         gboolean                 chunked);
+void                      gimp_tile_handler_validate_validate_parallel (GimpTileHandlerValidate *validate,
+                                                                        GeglBuffer              *buffer,
+                                                                        const GeglRectangle     *rect);
 
 gboolean                  gimp_tile_handler_validate_buffer_set_extent (GeglBuffer              *buffer,
                                                                         const GeglRectangle     *extent);
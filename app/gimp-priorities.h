@@ -35,6 +35,9 @@
 
 /* #define G_PRIORITY_DEFAULT_IDLE 200 */
 
+/*  speculative rendering, only when nothing else is going on  */
+#define GIMP_PRIORITY_PROJECTION_PREFETCH_IDLE (G_PRIORITY_DEFAULT_IDLE + 1)
+
 #define GIMP_PRIORITY_VIEWABLE_IDLE (G_PRIORITY_LOW)
 
 /* #define G_PRIORITY_LOW 300 */
@@ -343,6 +343,11 @@ gimp_mybrush_core_motion (GimpPaintCore    *paint_core,
       x2 = coords.x + radius;
       y2 = coords.y + radius;
 
+      /* expanding the drawable replaces its buffer, render the dabs of
+       * the previous strokes into the old one first
+       */
+      gimp_mypaint_surface_flush (mybrush->private->surface);
+
       expanded = gimp_paint_core_expand_drawable (paint_core, drawable, paint_options,
                                                   x1, x2, y1, y2,
                                                   &offset_change_x, &offset_change_y);
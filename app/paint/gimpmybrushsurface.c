@@ -32,6 +32,38 @@
 #include "gimpmybrushsurface.h"
 
 
+typedef struct
+{
+  GeglRectangle rect;
+  gfloat        x;
+  gfloat        y;
+  gfloat        radius;
+  gfloat        color_r;
+  gfloat        color_g;
+  gfloat        color_b;
+  gfloat        color_a;
+  gfloat        hardness;
+  gfloat        aspect_ratio;
+  gfloat        sn;
+  gfloat        cs;
+  gfloat        one_over_radius2;
+  gfloat        segment1_slope;
+  gfloat        segment2_slope;
+  gfloat        r_aa_start;
+  gfloat        normal_mode;
+  gfloat        colorize;
+  gfloat        posterize;
+  gfloat        posterize_num;
+} GimpMybrushDab;
+
+/* the part of a single tile touched by the queued dabs */
+typedef struct
+{
+  GeglRectangle rect;
+  guint         first_dab;
+  guint         n_dabs;
+} DabChunk;
+
 struct _GimpMybrushSurface
 {
   MyPaintSurface2     surface;
@@ -44,8 +76,20 @@ struct _GimpMybrushSurface
   GeglRectangle       dirty;
   GimpComponentMask   component_mask;
   GimpMybrushOptions *options;
+  /* XXX What spaces should we be working from and to? */
+  const Babl         *rgb_to_hsl_fish;
+  const Babl         *hsl_to_rgb_fish;
+  gint                atomic;
+  GArray             *dabs;
 };
 
+typedef struct
+{
+  GimpMybrushSurface *surface;
+  GArray             *chunks;
+  GArray             *dab_indices;
+} FlushData;
+
 /* --- Taken from mypaint-tiled-surface.c --- */
 static inline float
 calculate_rr (int   xp,
@@ -245,6 +289,11 @@ gimp_mypaint_surface_get_color_2 (MyPaintSurface2 *base_surface,
   GimpMybrushSurface *surface = (GimpMybrushSurface *)base_surface;
   GeglRectangle       dabRect;
 
+  /* the color is sampled from the buffer, so the queued dabs have to be
+   * rendered first
+   */
+  gimp_mypaint_surface_flush (surface);
+
   if (radius < 1.0f)
     radius = 1.0f;
 
@@ -352,76 +401,21 @@ gimp_mypaint_surface_get_color_wrapper (MyPaintSurface *surface,
                                            -1.0);
 }
 
-static gint
-gimp_mypaint_surface_draw_dab_2 (MyPaintSurface2 *base_surface,
-                                 gfloat           x,
-                                 gfloat           y,
-                                 gfloat           radius,
-                                 gfloat           color_r,
-                                 gfloat           color_g,
-                                 gfloat           color_b,
-                                 gfloat           opaque,
-                                 gfloat           hardness,
-                                 gfloat           color_a,
-                                 gfloat           aspect_ratio,
-                                 gfloat           angle,
-                                 gfloat           lock_alpha,
-                                 gfloat           colorize,
-                                 gfloat           posterize,
-                                 gfloat           posterize_num,
-                                 gfloat           paint)
+static void
+gimp_mypaint_surface_render_dab (GimpMybrushSurface   *surface,
+                                 const GimpMybrushDab *dab,
+                                 const GeglRectangle  *roi)
 {
-  GimpMybrushSurface *surface = (GimpMybrushSurface *)base_surface;
   GeglBufferIterator *iter;
-  GeglRectangle       dabRect;
-  GimpComponentMask   component_mask  = surface->component_mask;
-  /* XXX What spaces should we be working from and to? */
-  const Babl         *rgb_to_hsl_fish = babl_fish (babl_format ("R'G'B' float"), babl_format ("HSL float"));
-  const Babl         *hsl_to_rgb_fish = babl_fish (babl_format ("HSL float"), babl_format ("R'G'B' float"));
-
-  const float one_over_radius2 = 1.0f / (radius * radius);
-  const double angle_rad = angle / 360 * 2 * M_PI;
-  const float cs = cos(angle_rad);
-  const float sn = sin(angle_rad);
-  float normal_mode;
-  float segment1_slope;
-  float segment2_slope;
-  float r_aa_start;
-
-  posterize     = CLAMP (posterize, 0.0f, 1.0f);
-  posterize_num = CLAMP (ROUND (posterize_num * 100.0), 1, 128);
-  paint         = CLAMP (paint, 0.0f, 1.0f);
+  GimpComponentMask   component_mask = surface->component_mask;
 
-  hardness = CLAMP (hardness, 0.0f, 1.0f);
-  segment1_slope = -(1.0f / hardness - 1.0f);
-  segment2_slope = -hardness / (1.0f - hardness);
-  aspect_ratio = MAX (1.0f, aspect_ratio);
-
-  r_aa_start = radius - 1.0f;
-  r_aa_start = MAX (r_aa_start, 0);
-  r_aa_start = (r_aa_start * r_aa_start) / aspect_ratio;
-
-  normal_mode = opaque * (1.0f - colorize) * (1.0f - posterize);
-  colorize = opaque * colorize;
-
-  /* FIXME: This should use the real matrix values to trim aspect_ratio dabs */
-  x += surface->off_x;
-  y += surface->off_y;
-  dabRect = calculate_dab_roi (x, y, radius);
-  gegl_rectangle_intersect (&dabRect, &dabRect, gegl_buffer_get_extent (surface->buffer));
-
-  if (dabRect.width <= 0 || dabRect.height <= 0)
-    return 0;
-
-  gegl_rectangle_bounding_box (&surface->dirty, &surface->dirty, &dabRect);
-
-  iter = gegl_buffer_iterator_new (surface->buffer, &dabRect, 0,
+  iter = gegl_buffer_iterator_new (surface->buffer, roi, 0,
                                    babl_format ("R'G'B'A float"),
                                    GEGL_BUFFER_READWRITE,
                                    GEGL_ABYSS_NONE, 2);
   if (surface->paint_mask)
     {
-      GeglRectangle mask_roi = dabRect;
+      GeglRectangle mask_roi = *roi;
       mask_roi.x -= surface->paint_mask_x;
       mask_roi.y -= surface->paint_mask_y;
       gegl_buffer_iterator_add (iter, surface->paint_mask, &mask_roi, 0,
@@ -445,18 +439,18 @@ gimp_mypaint_surface_draw_dab_2 (MyPaintSurface2 *base_surface,
           for (ix = iter->items[0].roi.x; ix < iter->items[0].roi.x +  iter->items[0].roi.width; ix++)
             {
               float rr, base_alpha, alpha, dst_alpha, r, g, b, a;
-              if (radius < 3.0f)
-                rr = calculate_rr_antialiased (ix, iy, x, y, aspect_ratio, sn, cs, one_over_radius2, r_aa_start);
+              if (dab->radius < 3.0f)
+                rr = calculate_rr_antialiased (ix, iy, dab->x, dab->y, dab->aspect_ratio, dab->sn, dab->cs, dab->one_over_radius2, dab->r_aa_start);
               else
-                rr = calculate_rr (ix, iy, x, y, aspect_ratio, sn, cs, one_over_radius2);
-              base_alpha = calculate_alpha_for_rr (rr, hardness, segment1_slope, segment2_slope);
-              alpha = base_alpha * normal_mode;
+                rr = calculate_rr (ix, iy, dab->x, dab->y, dab->aspect_ratio, dab->sn, dab->cs, dab->one_over_radius2);
+              base_alpha = calculate_alpha_for_rr (rr, dab->hardness, dab->segment1_slope, dab->segment2_slope);
+              alpha = base_alpha * dab->normal_mode;
               if (mask)
                 alpha *= *mask;
               dst_alpha = pixel[ALPHA];
               /* a = alpha * color_a + dst_alpha * (1.0f - alpha);
                * which converts to: */
-              a = alpha * (color_a - dst_alpha) + dst_alpha;
+              a = alpha * (dab->color_a - dst_alpha) + dst_alpha;
               r = pixel[RED];
               g = pixel[GREEN];
               b = pixel[BLUE];
@@ -466,21 +460,21 @@ gimp_mypaint_surface_draw_dab_2 (MyPaintSurface2 *base_surface,
                   /* By definition the ratio between each color[] and pixel[] component in a non-pre-multipled blend always sums to 1.0f.
                    * Originally this would have been "(color[n] * alpha * color_a + pixel[n] * dst_alpha * (1.0f - alpha)) / a",
                    * instead we only calculate the cheaper term. */
-                  float src_term = (alpha * color_a) / a;
+                  float src_term = (alpha * dab->color_a) / a;
                   float dst_term = 1.0f - src_term;
-                  r = color_r * src_term + r * dst_term;
-                  g = color_g * src_term + g * dst_term;
-                  b = color_b * src_term + b * dst_term;
+                  r = dab->color_r * src_term + r * dst_term;
+                  g = dab->color_g * src_term + g * dst_term;
+                  b = dab->color_b * src_term + b * dst_term;
                 }
 
-              if (colorize > 0.0f && base_alpha > 0.0f)
+              if (dab->colorize > 0.0f && base_alpha > 0.0f)
                 {
-                  alpha = base_alpha * colorize;
+                  alpha = base_alpha * dab->colorize;
                   a = alpha + dst_alpha - alpha * dst_alpha;
                   if (a > 0.0f)
                     {
                       float pixel_hsl[3], out_hsl[3];
-                      float pixel_rgb[3] = {color_r, color_g, color_b};
+                      float pixel_rgb[3] = {dab->color_r, dab->color_g, dab->color_b};
                       float out_rgb[3]   = {r, g, b};
                       float src_term     = alpha / a;
                       float dst_term     = 1.0f - src_term;
@@ -490,12 +484,12 @@ gimp_mypaint_surface_draw_dab_2 (MyPaintSurface2 *base_surface,
                        * of color_r/g/b arguments?
                        * TODO: this code should be double-checked.
                        */
-                      babl_process (rgb_to_hsl_fish, pixel_rgb, pixel_hsl, 1);
-                      babl_process (rgb_to_hsl_fish, out_rgb, out_hsl, 1);
+                      babl_process (surface->rgb_to_hsl_fish, pixel_rgb, pixel_hsl, 1);
+                      babl_process (surface->rgb_to_hsl_fish, out_rgb, out_hsl, 1);
 
                       out_hsl[0] = pixel_hsl[0];
                       out_hsl[1] = pixel_hsl[1];
-                      babl_process (hsl_to_rgb_fish, out_hsl, out_rgb, 1);
+                      babl_process (surface->hsl_to_rgb_fish, out_hsl, out_rgb, 1);
 
                       r = (float)out_rgb[0] * src_term + r * dst_term;
                       g = (float)out_rgb[1] * src_term + g * dst_term;
@@ -503,9 +497,9 @@ gimp_mypaint_surface_draw_dab_2 (MyPaintSurface2 *base_surface,
                     }
                 }
 
-              if (posterize > 0.0f && base_alpha > 0.0f)
+              if (dab->posterize > 0.0f && base_alpha > 0.0f)
                 {
-                  alpha = base_alpha * posterize;
+                  alpha = base_alpha * dab->posterize;
                   a     = alpha + dst_alpha - alpha * dst_alpha;
                   if (a > 0.0f)
                     {
@@ -513,9 +507,9 @@ gimp_mypaint_surface_draw_dab_2 (MyPaintSurface2 *base_surface,
                       gfloat src_term = alpha / a;
                       gfloat dst_term = 1.0f - src_term;
 
-                      post_pixel[0] = ROUND (r * posterize_num) / posterize_num;
-                      post_pixel[1] = ROUND (g * posterize_num) / posterize_num;
-                      post_pixel[2] = ROUND (b * posterize_num) / posterize_num;
+                      post_pixel[0] = ROUND (r * dab->posterize_num) / dab->posterize_num;
+                      post_pixel[1] = ROUND (g * dab->posterize_num) / dab->posterize_num;
+                      post_pixel[2] = ROUND (b * dab->posterize_num) / dab->posterize_num;
 
                       r = post_pixel[0] * src_term + r * dst_term;
                       g = post_pixel[1] * src_term + g * dst_term;
@@ -552,6 +546,141 @@ gimp_mypaint_surface_draw_dab_2 (MyPaintSurface2 *base_surface,
         }
     }
 
+}
+
+static void
+gimp_mypaint_surface_render_chunk (GimpMybrushSurface *surface,
+                                   const DabChunk     *chunk,
+                                   const guint        *dab_indices)
+{
+  guint i;
+
+  /* the dabs are applied in the order in which they were drawn, so
+   * that each pixel goes through exactly the same sequence of
+   * operations as when the dabs are rendered right away
+   */
+  for (i = 0; i < chunk->n_dabs; i++)
+    {
+      const GimpMybrushDab *dab;
+      GeglRectangle         roi;
+
+      dab = &g_array_index (surface->dabs, GimpMybrushDab,
+                            dab_indices[chunk->first_dab + i]);
+
+      gegl_rectangle_intersect (&roi, &dab->rect, &chunk->rect);
+
+      gimp_mypaint_surface_render_dab (surface, dab, &roi);
+    }
+}
+
+static void
+gimp_mypaint_surface_flush_parallel_func (gint       i,
+                                          gint       n,
+                                          FlushData *data)
+{
+  guint j;
+
+  /* interleave the chunks between the threads, so that neighboring
+   * tiles, which tend to be touched by similar numbers of dabs, are
+   * spread across them
+   */
+  for (j = i; j < data->chunks->len; j += n)
+    {
+      gimp_mypaint_surface_render_chunk (data->surface,
+                                         &g_array_index (data->chunks,
+                                                         DabChunk, j),
+                                         (const guint *) data->dab_indices->data);
+    }
+}
+
+static gint
+gimp_mypaint_surface_draw_dab_2 (MyPaintSurface2 *base_surface,
+                                 gfloat           x,
+                                 gfloat           y,
+                                 gfloat           radius,
+                                 gfloat           color_r,
+                                 gfloat           color_g,
+                                 gfloat           color_b,
+                                 gfloat           opaque,
+                                 gfloat           hardness,
+                                 gfloat           color_a,
+                                 gfloat           aspect_ratio,
+                                 gfloat           angle,
+                                 gfloat           lock_alpha,
+                                 gfloat           colorize,
+                                 gfloat           posterize,
+                                 gfloat           posterize_num,
+                                 gfloat           paint)
+{
+  GimpMybrushSurface *surface = (GimpMybrushSurface *)base_surface;
+  GimpMybrushDab      dab;
+  GeglRectangle       dabRect;
+
+  const float one_over_radius2 = 1.0f / (radius * radius);
+  const double angle_rad = angle / 360 * 2 * M_PI;
+  const float cs = cos(angle_rad);
+  const float sn = sin(angle_rad);
+  float normal_mode;
+  float segment1_slope;
+  float segment2_slope;
+  float r_aa_start;
+
+  posterize     = CLAMP (posterize, 0.0f, 1.0f);
+  posterize_num = CLAMP (ROUND (posterize_num * 100.0), 1, 128);
+  paint         = CLAMP (paint, 0.0f, 1.0f);
+
+  hardness = CLAMP (hardness, 0.0f, 1.0f);
+  segment1_slope = -(1.0f / hardness - 1.0f);
+  segment2_slope = -hardness / (1.0f - hardness);
+  aspect_ratio = MAX (1.0f, aspect_ratio);
+
+  r_aa_start = radius - 1.0f;
+  r_aa_start = MAX (r_aa_start, 0);
+  r_aa_start = (r_aa_start * r_aa_start) / aspect_ratio;
+
+  normal_mode = opaque * (1.0f - colorize) * (1.0f - posterize);
+  colorize = opaque * colorize;
+
+  /* FIXME: This should use the real matrix values to trim aspect_ratio dabs */
+  x += surface->off_x;
+  y += surface->off_y;
+  dabRect = calculate_dab_roi (x, y, radius);
+  gegl_rectangle_intersect (&dabRect, &dabRect, gegl_buffer_get_extent (surface->buffer));
+
+  if (dabRect.width <= 0 || dabRect.height <= 0)
+    return 0;
+
+  gegl_rectangle_bounding_box (&surface->dirty, &surface->dirty, &dabRect);
+
+  dab.rect             = dabRect;
+  dab.x                = x;
+  dab.y                = y;
+  dab.radius           = radius;
+  dab.color_r          = color_r;
+  dab.color_g          = color_g;
+  dab.color_b          = color_b;
+  dab.color_a          = color_a;
+  dab.hardness         = hardness;
+  dab.aspect_ratio     = aspect_ratio;
+  dab.sn               = sn;
+  dab.cs               = cs;
+  dab.one_over_radius2 = one_over_radius2;
+  dab.segment1_slope   = segment1_slope;
+  dab.segment2_slope   = segment2_slope;
+  dab.r_aa_start       = r_aa_start;
+  dab.normal_mode      = normal_mode;
+  dab.colorize         = colorize;
+  dab.posterize        = posterize;
+  dab.posterize_num    = posterize_num;
+
+  /* inside an atomic section, only queue the dab, the queued dabs are
+   * rendered tile by tile, in parallel, by gimp_mypaint_surface_flush()
+   */
+  if (surface->atomic > 0)
+    g_array_append_val (surface->dabs, dab);
+  else
+    gimp_mypaint_surface_render_dab (surface, &dab, &dab.rect);
+
   return 1;
 }
 
@@ -585,7 +714,9 @@ gimp_mypaint_surface_draw_dab_wrapper (MyPaintSurface *surface,
 static void
 gimp_mypaint_surface_begin_atomic (MyPaintSurface *base_surface)
 {
+  GimpMybrushSurface *surface = (GimpMybrushSurface *)base_surface;
 
+  surface->atomic++;
 }
 
 static void
@@ -594,6 +725,11 @@ gimp_mypaint_surface_end_atomic_2 (MyPaintSurface2   *base_surface,
 {
   GimpMybrushSurface *surface = (GimpMybrushSurface *)base_surface;
 
+  gimp_mypaint_surface_flush (surface);
+
+  if (surface->atomic > 0)
+    surface->atomic--;
+
   if (rois)
     {
       const gint roi_rects = rois->num_rectangles;
@@ -623,8 +759,11 @@ gimp_mypaint_surface_destroy (MyPaintSurface *base_surface)
 {
   GimpMybrushSurface *surface = (GimpMybrushSurface *) base_surface;
 
+  gimp_mypaint_surface_flush (surface);
+
   g_clear_object (&surface->buffer);
   g_clear_object (&surface->paint_mask);
+  g_array_free (surface->dabs, TRUE);
   g_free (surface);
 }
 
@@ -666,6 +805,14 @@ gimp_mypaint_surface_new (GeglBuffer         *buffer,
   surface->off_x          = 0;
   surface->off_y          = 0;
 
+  surface->rgb_to_hsl_fish = babl_fish (babl_format ("R'G'B' float"),
+                                        babl_format ("HSL float"));
+  surface->hsl_to_rgb_fish = babl_fish (babl_format ("HSL float"),
+                                        babl_format ("R'G'B' float"));
+
+  surface->atomic         = 0;
+  surface->dabs           = g_array_new (FALSE, FALSE, sizeof (GimpMybrushDab));
+
   return surface;
 }
 
@@ -675,6 +822,8 @@ gimp_mypaint_surface_set_buffer (GimpMybrushSurface *surface,
                                  gint                paint_mask_x,
                                  gint                paint_mask_y)
 {
+  gimp_mypaint_surface_flush (surface);
+
   g_object_unref (surface->buffer);
 
   surface->buffer = g_object_ref (buffer);
@@ -700,3 +849,108 @@ gimp_mypaint_surface_get_offset (GimpMybrushSurface *surface,
   *off_x = surface->off_x;
   *off_y = surface->off_y;
 }
+
+/* renders the dabs queued since the start of the current atomic
+ * section.  the area they cover is split along the buffer's tile grid,
+ * and the resulting chunks, each covering a single tile, are rendered
+ * concurrently, using the GEGL thread pool.
+ */
+void
+gimp_mypaint_surface_flush (GimpMybrushSurface *surface)
+{
+  FlushData     data;
+  GeglRectangle bounds = { 0, };
+  GeglRectangle chunk_rect;
+  gint          tile_width;
+  gint          tile_height;
+  gint          x;
+  gint          y;
+  guint         i;
+
+  if (surface->dabs->len == 0)
+    return;
+
+  if (surface->dabs->len == 1)
+    {
+      GimpMybrushDab *dab = &g_array_index (surface->dabs, GimpMybrushDab, 0);
+
+      gimp_mypaint_surface_render_dab (surface, dab, &dab->rect);
+
+      g_array_set_size (surface->dabs, 0);
+
+      return;
+    }
+
+  for (i = 0; i < surface->dabs->len; i++)
+    {
+      const GimpMybrushDab *dab = &g_array_index (surface->dabs,
+                                                  GimpMybrushDab, i);
+
+      gegl_rectangle_bounding_box (&bounds, &bounds, &dab->rect);
+    }
+
+  g_object_get (surface->buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  data.surface     = surface;
+  data.chunks      = g_array_new (FALSE, FALSE, sizeof (DabChunk));
+  data.dab_indices = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  for (y = bounds.y - ((bounds.y % tile_height) + tile_height) % tile_height;
+       y < bounds.y + bounds.height;
+       y += tile_height)
+    {
+      for (x = bounds.x - ((bounds.x % tile_width) + tile_width) % tile_width;
+           x < bounds.x + bounds.width;
+           x += tile_width)
+        {
+          DabChunk chunk;
+
+          if (! gegl_rectangle_intersect (&chunk_rect,
+                                          GEGL_RECTANGLE (x, y,
+                                                          tile_width,
+                                                          tile_height),
+                                          &bounds))
+            {
+              continue;
+            }
+
+          chunk.rect      = chunk_rect;
+          chunk.first_dab = data.dab_indices->len;
+
+          for (i = 0; i < surface->dabs->len; i++)
+            {
+              const GimpMybrushDab *dab = &g_array_index (surface->dabs,
+                                                          GimpMybrushDab, i);
+
+              if (gegl_rectangle_intersect (NULL, &dab->rect, &chunk.rect))
+                g_array_append_val (data.dab_indices, i);
+            }
+
+          chunk.n_dabs = data.dab_indices->len - chunk.first_dab;
+
+          if (chunk.n_dabs > 0)
+            g_array_append_val (data.chunks, chunk);
+        }
+    }
+
+  if (data.chunks->len > 1)
+    {
+      gegl_parallel_distribute (
+        data.chunks->len,
+        (GeglParallelDistributeFunc)
+          gimp_mypaint_surface_flush_parallel_func,
+        &data);
+    }
+  else if (data.chunks->len == 1)
+    {
+      gimp_mypaint_surface_flush_parallel_func (0, 1, &data);
+    }
+
+  g_array_free (data.chunks, TRUE);
+  g_array_free (data.dab_indices, TRUE);
+
+  g_array_set_size (surface->dabs, 0);
+}
@@ -42,5 +42,7 @@ void
 gimp_mypaint_surface_get_offset (GimpMybrushSurface *surface,
                                  gint               *off_x,
                                  gint               *off_y);
+void
+gimp_mypaint_surface_flush      (GimpMybrushSurface *surface);
 
 #endif  /*  __GIMP_MYBRUSH_SURFACE_H__  */
@@ -0,0 +1,234 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppaintcore-loops-avx2.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "paint-types.h"
+
+#include "gimppaintcore-loops.h"
+
+
+#if COMPILE_AVX2_INTRINISICS
+
+/* AVX2 */
+#include <immintrin.h>
+
+
+/* The kernels below process the longest prefix of a row which is a
+ * multiple of 8 pixels, and return its length; the caller handles the
+ * remaining pixels using the scalar code in gimppaintcore-loops.cc.
+ *
+ * Each kernel performs exactly the same operations, in the same order
+ * and at the same precision, as the corresponding scalar loop.  In
+ * particular, wherever the scalar code multiplies by the gdouble
+ * opacity, the arithmetic is done in double precision, four pixels at
+ * a time, so the results are bit-exact.
+ */
+
+
+static inline __m256
+load_mask (const gfloat *mask)
+{
+  return _mm256_loadu_ps (mask);
+}
+
+static inline __m256
+load_mask_u8 (const guint8 *mask)
+{
+  __m256i v = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) mask));
+
+  /* same as value_to_float() */
+  return _mm256_div_ps (_mm256_cvtepi32_ps (v), _mm256_set1_ps (255.0f));
+}
+
+static inline __m128
+combine_paint_mask4 (__m128   canvas,
+                     __m128   mask,
+                     __m256d  opacity,
+                     gboolean stipple)
+{
+  __m256d c = _mm256_cvtps_pd (canvas);
+  __m256d m = _mm256_cvtps_pd (mask);
+  __m256d d;
+
+  if (stipple)
+    {
+      d = _mm256_sub_pd (_mm256_set1_pd (1.0), c);
+      d = _mm256_mul_pd (_mm256_mul_pd (d, m), opacity);
+      c = _mm256_add_pd (c, d);
+    }
+  else
+    {
+      __m256d below = _mm256_cmp_pd (opacity, c, _CMP_GT_OQ);
+
+      d = _mm256_sub_pd (opacity, c);
+      d = _mm256_mul_pd (_mm256_mul_pd (d, m), opacity);
+      c = _mm256_blendv_pd (c, _mm256_add_pd (c, d), below);
+    }
+
+  return _mm256_cvtpd_ps (c);
+}
+
+static inline __m256
+combine_paint_mask8 (__m256   canvas,
+                     __m256   mask,
+                     __m256d  opacity,
+                     gboolean stipple)
+{
+  __m128 lo = combine_paint_mask4 (_mm256_castps256_ps128 (canvas),
+                                   _mm256_castps256_ps128 (mask),
+                                   opacity, stipple);
+  __m128 hi = combine_paint_mask4 (_mm256_extractf128_ps (canvas, 1),
+                                   _mm256_extractf128_ps (mask, 1),
+                                   opacity, stipple);
+
+  return _mm256_insertf128_ps (_mm256_castps128_ps256 (lo), hi, 1);
+}
+
+static inline __m256
+scale_by_opacity8 (__m256  value,
+                   __m256d opacity)
+{
+  __m128 lo;
+  __m128 hi;
+
+  lo = _mm256_cvtpd_ps (
+    _mm256_mul_pd (_mm256_cvtps_pd (_mm256_castps256_ps128 (value)),
+                   opacity));
+  hi = _mm256_cvtpd_ps (
+    _mm256_mul_pd (_mm256_cvtps_pd (_mm256_extractf128_ps (value, 1)),
+                   opacity));
+
+  return _mm256_insertf128_ps (_mm256_castps128_ps256 (lo), hi, 1);
+}
+
+gint
+gimp_paint_core_loops_combine_paint_mask_avx2 (gfloat       *canvas,
+                                               const gfloat *mask,
+                                               gint          width,
+                                               gdouble       opacity,
+                                               gboolean      stipple)
+{
+  const __m256d v_opacity = _mm256_set1_pd (opacity);
+  gint          x;
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      __m256 v_canvas = _mm256_loadu_ps (canvas + x);
+
+      v_canvas = combine_paint_mask8 (v_canvas, load_mask (mask + x),
+                                      v_opacity, stipple);
+
+      _mm256_storeu_ps (canvas + x, v_canvas);
+    }
+
+  return x;
+}
+
+gint
+gimp_paint_core_loops_combine_paint_mask_u8_avx2 (gfloat       *canvas,
+                                                  const guint8 *mask,
+                                                  gint          width,
+                                                  gdouble       opacity,
+                                                  gboolean      stipple)
+{
+  const __m256d v_opacity = _mm256_set1_pd (opacity);
+  gint          x;
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      __m256 v_canvas = _mm256_loadu_ps (canvas + x);
+
+      v_canvas = combine_paint_mask8 (v_canvas, load_mask_u8 (mask + x),
+                                      v_opacity, stipple);
+
+      _mm256_storeu_ps (canvas + x, v_canvas);
+    }
+
+  return x;
+}
+
+gint
+gimp_paint_core_loops_paint_mask_to_comp_mask_avx2 (gfloat       *comp_mask,
+                                                    const gfloat *mask,
+                                                    const gfloat *mask_buffer,
+                                                    gint          width,
+                                                    gdouble       opacity)
+{
+  const __m256d v_opacity = _mm256_set1_pd (opacity);
+  gint          x;
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      __m256 v_mask = load_mask (mask + x);
+
+      if (mask_buffer)
+        v_mask = _mm256_mul_ps (v_mask, _mm256_loadu_ps (mask_buffer + x));
+
+      _mm256_storeu_ps (comp_mask + x, scale_by_opacity8 (v_mask, v_opacity));
+    }
+
+  return x;
+}
+
+gint
+gimp_paint_core_loops_paint_mask_to_comp_mask_u8_avx2 (gfloat       *comp_mask,
+                                                       const guint8 *mask,
+                                                       const gfloat *mask_buffer,
+                                                       gint          width,
+                                                       gdouble       opacity)
+{
+  const __m256d v_opacity = _mm256_set1_pd (opacity);
+  gint          x;
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      __m256 v_mask = load_mask_u8 (mask + x);
+
+      if (mask_buffer)
+        v_mask = _mm256_mul_ps (v_mask, _mm256_loadu_ps (mask_buffer + x));
+
+      _mm256_storeu_ps (comp_mask + x, scale_by_opacity8 (v_mask, v_opacity));
+    }
+
+  return x;
+}
+
+gint
+gimp_paint_core_loops_canvas_buffer_to_comp_mask_avx2 (gfloat       *comp_mask,
+                                                       const gfloat *canvas,
+                                                       const gfloat *mask_buffer,
+                                                       gint          width)
+{
+  gint x;
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      _mm256_storeu_ps (comp_mask + x,
+                        _mm256_mul_ps (_mm256_loadu_ps (canvas      + x),
+                                       _mm256_loadu_ps (mask_buffer + x)));
+    }
+
+  return x;
+}
+
+#endif /* COMPILE_AVX2_INTRINISICS */
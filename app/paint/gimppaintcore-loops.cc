@@ -22,6 +22,8 @@
 extern "C"
 {
 
+#include "libgimpbase/gimpbase.h"
+
 #include "paint-types.h"
 
 #include "gegl/gimp-babl.h"
@@ -229,6 +231,121 @@ static inline gfloat
 value_to_float (T value) = delete;
 
 
+/* SIMD kernels:
+ *
+ * Some of the algorithms hand the bulk of each row to a wide-vector kernel,
+ * selected at runtime according to the CPU's capabilities.  A kernel
+ * processes a prefix of the row and returns its length, and the algorithm's
+ * scalar loop takes care of the rest.  The kernels are bit-exact with the
+ * scalar loops; see gimppaintcore-loops-avx2.c.
+ *
+ * When no kernel is available, the functions below return 0, and the scalar
+ * loop processes the entire row.
+ */
+
+static inline gboolean
+use_avx2 ()
+{
+#if COMPILE_AVX2_INTRINISICS
+  static const gboolean avx2 =
+    (gimp_cpu_accel_get_support () & GIMP_CPU_ACCEL_X86_AVX2) != 0;
+
+  return avx2;
+#else
+  return FALSE;
+#endif
+}
+
+static inline gint
+combine_paint_mask_simd (gfloat       *canvas,
+                         const gfloat *mask,
+                         gint          width,
+                         gdouble       opacity,
+                         gboolean      stipple)
+{
+#if COMPILE_AVX2_INTRINISICS
+  if (use_avx2 ())
+    {
+      return gimp_paint_core_loops_combine_paint_mask_avx2 (
+        canvas, mask, width, opacity, stipple);
+    }
+#endif
+
+  return 0;
+}
+
+static inline gint
+combine_paint_mask_simd (gfloat       *canvas,
+                         const guint8 *mask,
+                         gint          width,
+                         gdouble       opacity,
+                         gboolean      stipple)
+{
+#if COMPILE_AVX2_INTRINISICS
+  if (use_avx2 ())
+    {
+      return gimp_paint_core_loops_combine_paint_mask_u8_avx2 (
+        canvas, mask, width, opacity, stipple);
+    }
+#endif
+
+  return 0;
+}
+
+static inline gint
+paint_mask_to_comp_mask_simd (gfloat       *comp_mask,
+                              const gfloat *mask,
+                              const gfloat *mask_buffer,
+                              gint          width,
+                              gdouble       opacity)
+{
+#if COMPILE_AVX2_INTRINISICS
+  if (use_avx2 ())
+    {
+      return gimp_paint_core_loops_paint_mask_to_comp_mask_avx2 (
+        comp_mask, mask, mask_buffer, width, opacity);
+    }
+#endif
+
+  return 0;
+}
+
+static inline gint
+paint_mask_to_comp_mask_simd (gfloat       *comp_mask,
+                              const guint8 *mask,
+                              const gfloat *mask_buffer,
+                              gint          width,
+                              gdouble       opacity)
+{
+#if COMPILE_AVX2_INTRINISICS
+  if (use_avx2 ())
+    {
+      return gimp_paint_core_loops_paint_mask_to_comp_mask_u8_avx2 (
+        comp_mask, mask, mask_buffer, width, opacity);
+    }
+#endif
+
+  return 0;
+}
+
+static inline gint
+canvas_buffer_to_comp_mask_simd (gfloat       *comp_mask,
+                                 const gfloat *canvas,
+                                 const gfloat *mask_buffer,
+                                 gint          width)
+{
+#if COMPILE_AVX2_INTRINISICS
+  if (use_avx2 ())
+    {
+      return gimp_paint_core_loops_canvas_buffer_to_comp_mask_avx2 (
+        comp_mask, canvas, mask_buffer, width);
+    }
+#endif
+
+  return 0;
+}
+
+
 /* AlgorithmBase:
  *
  * The base class of the algorithm hierarchy.
@@ -1203,9 +1320,22 @@ struct CombinePaintMaskToCanvasBufferToPaintBufAlpha : Base
     gint             paint_offset = (y       - roi->y) * this->paint_stride +
                                     (rect->x - roi->x) * 4;
     gfloat          *paint_pixel  = &this->paint_data[paint_offset];
+    gint             n;
     gint             x;
 
-    for (x = 0; x < rect->width; x++)
+    n = combine_paint_mask_simd (state->canvas_pixel, mask_pixel, rect->width,
+                                 params->paint_opacity, Base::stipple);
+
+    for (x = 0; x < n; x++)
+      {
+        paint_pixel[3] *= state->canvas_pixel[0];
+
+        mask_pixel          += 1;
+        state->canvas_pixel += 1;
+        paint_pixel         += 4;
+      }
+
+    for (; x < rect->width; x++)
       {
         if (Base::stipple)
           {
@@ -1303,7 +1433,13 @@ struct CombinePaintMaskToCanvasBuffer : Base
     const mask_type *mask_pixel  = &this->mask_data[mask_offset];
     gint             x;
 
-    for (x = 0; x < rect->width; x++)
+    x = combine_paint_mask_simd (state->canvas_pixel, mask_pixel, rect->width,
+                                 params->paint_opacity, Base::stipple);
+
+    mask_pixel          += x;
+    state->canvas_pixel += x;
+
+    for (; x < rect->width; x++)
       {
         if (Base::stipple)
           {
@@ -1543,7 +1679,16 @@ struct CanvasBufferToCompMask : Base
     comp_mask_type *comp_mask_pixel = state->comp_mask_data;
     gint            x;
 
-    for (x = 0; x < rect->width; x++)
+    x = canvas_buffer_to_comp_mask_simd (comp_mask_pixel,
+                                         state->canvas_pixel,
+                                         state->mask_pixel,
+                                         rect->width);
+
+    comp_mask_pixel     += x;
+    state->canvas_pixel += x;
+    state->mask_pixel   += x;
+
+    for (; x < rect->width; x++)
       {
         comp_mask_pixel[0] = state->canvas_pixel[0] * state->mask_pixel[0];
 
@@ -1722,7 +1867,17 @@ struct PaintMaskToCompMask : Base
 
     if (has_mask_buffer_iterator (this))
       {
-        for (x = 0; x < rect->width; x++)
+        x = paint_mask_to_comp_mask_simd (comp_mask_pixel,
+                                          mask_pixel,
+                                          state->mask_pixel,
+                                          rect->width,
+                                          params->paint_opacity);
+
+        comp_mask_pixel   += x;
+        mask_pixel        += x;
+        state->mask_pixel += x;
+
+        for (; x < rect->width; x++)
           {
             comp_mask_pixel[0] = value_to_float (mask_pixel[0]) *
                                  state->mask_pixel[0]           *
@@ -1735,7 +1890,16 @@ struct PaintMaskToCompMask : Base
       }
     else
       {
-        for (x = 0; x < rect->width; x++)
+        x = paint_mask_to_comp_mask_simd (comp_mask_pixel,
+                                          mask_pixel,
+                                          NULL,
+                                          rect->width,
+                                          params->paint_opacity);
+
+        comp_mask_pixel += x;
+        mask_pixel      += x;
+
+        for (; x < rect->width; x++)
           {
             comp_mask_pixel[0] = value_to_float (mask_pixel[0]) *
                                  params->paint_opacity;
@@ -64,3 +64,31 @@ typedef struct
 
 void   gimp_paint_core_loops_process (const GimpPaintCoreLoopsParams *params,
                                       GimpPaintCoreLoopsAlgorithm     algorithms);
+
+
+/*  AVX2 row kernels, used by gimp_paint_core_loops_process()  */
+
+gint   gimp_paint_core_loops_combine_paint_mask_avx2         (gfloat       *canvas,
+                                                              const gfloat *mask,
+                                                              gint          width,
+                                                              gdouble       opacity,
+                                                              gboolean      stipple);
+gint   gimp_paint_core_loops_combine_paint_mask_u8_avx2      (gfloat       *canvas,
+                                                              const guint8 *mask,
+                                                              gint          width,
+                                                              gdouble       opacity,
+                                                              gboolean      stipple);
+gint   gimp_paint_core_loops_paint_mask_to_comp_mask_avx2    (gfloat       *comp_mask,
+                                                              const gfloat *mask,
+                                                              const gfloat *mask_buffer,
+                                                              gint          width,
+                                                              gdouble       opacity);
+gint   gimp_paint_core_loops_paint_mask_to_comp_mask_u8_avx2 (gfloat       *comp_mask,
+                                                              const guint8 *mask,
+                                                              const gfloat *mask_buffer,
+                                                              gint          width,
+                                                              gdouble       opacity);
+gint   gimp_paint_core_loops_canvas_buffer_to_comp_mask_avx2 (gfloat       *comp_mask,
+                                                              const gfloat *canvas,
+                                                              const gfloat *mask_buffer,
+                                                              gint          width);
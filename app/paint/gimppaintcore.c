@@ -531,6 +531,9 @@ gimp_paint_core_finish (GimpPaintCore *core,
 
   g_clear_object (&core->mask_buffer);
 
+  /*  release the dab buffers retained by the temp-buf pools  */
+  gimp_temp_buf_pool_reset ();
+
   image = gimp_item_get_image (GIMP_ITEM (drawables->data));
 
   for (GList *iter = drawables; iter; iter = iter->next)
@@ -586,19 +589,9 @@ gimp_paint_core_finish (GimpPaintCore *core,
                                         gimp_item_get_height (GIMP_ITEM (iter->data)),
                                         &rect.x, &rect.y, &rect.width, &rect.height);
 
-              gegl_rectangle_align_to_buffer (&rect, &rect, undo_buffer,
-                                              GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
-
               GIMP_PAINT_CORE_GET_CLASS (core)->push_undo (core, image, NULL);
 
-              buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, rect.width, rect.height),
-                                        gimp_drawable_get_format (iter->data));
-
-              gimp_gegl_buffer_copy (undo_buffer,
-                                     &rect,
-                                     GEGL_ABYSS_NONE,
-                                     buffer,
-                                     GEGL_RECTANGLE (0, 0, 0, 0));
+              buffer = gimp_gegl_buffer_snapshot (undo_buffer, &rect, &rect);
 
               gimp_drawable_push_undo (iter->data, NULL,
                                        buffer, rect.x, rect.y, rect.width, rect.height);
@@ -47,6 +47,7 @@
 #include "gimpplugin-cleanup.h"
 #include "gimpplugin-message.h"
 #include "gimppluginmanager.h"
+#include "gimppluginmanager-worker.h"
 #include "gimpplugindef.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
@@ -63,6 +64,23 @@ static void gimp_plug_in_handle_tile_put         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
 static void gimp_plug_in_handle_tile_get         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
+static void gimp_plug_in_handle_tile_batch_request (GimpPlugIn    *plug_in,
+                                                    GPTileBatchReq *request);
+static void gimp_plug_in_handle_tile_batch_get   (GimpPlugIn      *plug_in,
+                                                  GPTileBatchReq  *request);
+static void gimp_plug_in_handle_tile_batch_put   (GimpPlugIn      *plug_in,
+                                                  GPTileBatchReq  *request);
+static void gimp_plug_in_handle_drawable_store   (GimpPlugIn      *plug_in,
+                                                  GPDrawableStoreReq *request);
+static void gimp_plug_in_handle_invalid_message (GimpPlugIn      *plug_in);
+static GeglBuffer *
+            gimp_plug_in_get_read_buffer         (GimpPlugIn      *plug_in,
+                                                  gint32           drawable_id,
+                                                  gboolean         shadow);
+static GeglBuffer *
+            gimp_plug_in_get_write_buffer        (GimpPlugIn      *plug_in,
+                                                  gint32           drawable_id,
+                                                  gboolean         shadow);
 static void gimp_plug_in_handle_proc_run         (GimpPlugIn      *plug_in,
                                                   GPProcRun       *proc_run);
 static void gimp_plug_in_handle_proc_return      (GimpPlugIn      *plug_in,
@@ -75,6 +93,7 @@ static void gimp_plug_in_handle_proc_uninstall   (GimpPlugIn      *plug_in,
                                                   GPProcUninstall *proc_uninstall);
 static void gimp_plug_in_handle_extension_ack    (GimpPlugIn      *plug_in);
 static void gimp_plug_in_handle_has_init         (GimpPlugIn      *plug_in);
+static void gimp_plug_in_handle_reusable         (GimpPlugIn      *plug_in);
 
 
 /*  public functions  */
@@ -160,6 +179,36 @@ gimp_plug_in_handle_message (GimpPlugIn      *plug_in,
     case GP_HAS_INIT:
       gimp_plug_in_handle_has_init (plug_in);
       break;
+
+    case GP_REUSABLE:
+      gimp_plug_in_handle_reusable (plug_in);
+      break;
+
+    case GP_TILE_BATCH_REQ:
+      gimp_plug_in_handle_tile_batch_request (plug_in, msg->data);
+      break;
+
+    case GP_TILE_BATCH_DATA:
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent a TILE_BATCH_DATA message.  This should not happen.",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      break;
+
+    case GP_DRAWABLE_STORE_REQ:
+      gimp_plug_in_handle_drawable_store (plug_in, msg->data);
+      break;
+
+    case GP_DRAWABLE_STORE:
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent a DRAWABLE_STORE message.  This should not happen.",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      break;
     }
 }
 
@@ -184,6 +233,22 @@ gimp_plug_in_handle_tile_request (GimpPlugIn *plug_in,
     gimp_plug_in_handle_tile_get (plug_in, request);
 }
 
+static void
+gimp_plug_in_handle_tile_batch_request (GimpPlugIn     *plug_in,
+                                        GPTileBatchReq *request)
+{
+  if (! request)
+    {
+      gimp_plug_in_handle_invalid_message (plug_in);
+      return;
+    }
+
+  if (request->drawable_id == -1)
+    gimp_plug_in_handle_tile_batch_put (plug_in, request);
+  else
+    gimp_plug_in_handle_tile_batch_get (plug_in, request);
+}
+
 static void
 gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
                               GPTileReq  *request)
@@ -191,7 +256,6 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
   GPTileData       tile_data;
   GPTileData      *tile_info;
   GimpWireMessage  msg;
-  GimpDrawable    *drawable;
   GeglBuffer      *buffer;
   const Babl      *format;
   GeglRectangle    tile_rect;
@@ -231,73 +295,15 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
 
   tile_info = msg.data;
 
-  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
-                                                   tile_info->drawable_id);
+  buffer = gimp_plug_in_get_write_buffer (plug_in, tile_info->drawable_id,
+                                          tile_info->shadow);
 
-  if (! GIMP_IS_DRAWABLE (drawable))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried writing to invalid drawable %d (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    tile_info->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
-  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
+  if (! buffer)
     {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried writing to drawable %d which was removed "
-                    "from the image (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    tile_info->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
+      gimp_wire_destroy (&msg);
       return;
     }
 
-  if (tile_info->shadow)
-    {
-
-      /*  don't check whether the drawable is a group or locked here,
-       *  the plugin will get a proper error message when it tries to
-       *  merge the shadow tiles, which is much better than just
-       *  killing it.
-       */
-      buffer = gimp_drawable_get_shadow_buffer (drawable);
-
-      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
-    }
-  else
-    {
-      if (gimp_item_is_content_locked (GIMP_ITEM (drawable), NULL))
-        {
-          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                        "Plug-in \"%s\"\n(%s)\n\n"
-                        "tried writing to a locked drawable %d (killing)",
-                        gimp_object_get_name (plug_in),
-                        gimp_file_get_utf8_name (plug_in->file),
-                        tile_info->drawable_id);
-          gimp_plug_in_close (plug_in, TRUE);
-          return;
-        }
-      else if (gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
-        {
-          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                        "Plug-in \"%s\"\n(%s)\n\n"
-                        "tried writing to a group layer %d (killing)",
-                        gimp_object_get_name (plug_in),
-                        gimp_file_get_utf8_name (plug_in->file),
-                        tile_info->drawable_id);
-          gimp_plug_in_close (plug_in, TRUE);
-          return;
-        }
-
-      buffer = gimp_drawable_get_buffer (drawable);
-    }
-
   if (! gimp_gegl_buffer_get_tile_rect (buffer,
                                         GIMP_PLUG_IN_TILE_WIDTH,
                                         GIMP_PLUG_IN_TILE_HEIGHT,
@@ -346,49 +352,16 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
 {
   GPTileData       tile_data;
   GimpWireMessage  msg;
-  GimpDrawable    *drawable;
   GeglBuffer      *buffer;
   const Babl      *format;
   GeglRectangle    tile_rect;
   gint             tile_size;
 
-  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
-                                                   request->drawable_id);
-
-  if (! GIMP_IS_DRAWABLE (drawable))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried reading from invalid drawable %d (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    request->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
-  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried reading from drawable %d which was removed "
-                    "from the image (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    request->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
-
-  if (request->shadow)
-    {
-      buffer = gimp_drawable_get_shadow_buffer (drawable);
+  buffer = gimp_plug_in_get_read_buffer (plug_in, request->drawable_id,
+                                         request->shadow);
 
-      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
-    }
-  else
-    {
-      buffer = gimp_drawable_get_buffer (drawable);
-    }
+  if (! buffer)
+    return;
 
   if (! gimp_gegl_buffer_get_tile_rect (buffer,
                                         GIMP_PLUG_IN_TILE_WIDTH,
@@ -461,6 +434,506 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
   gimp_wire_destroy (&msg);
 }
 
+/*  like gimp_plug_in_handle_tile_get(), but sends all the requested
+ *  tiles in a single message, which is acknowledged once
+ */
+static void
+gimp_plug_in_handle_tile_batch_get (GimpPlugIn     *plug_in,
+                                    GPTileBatchReq *request)
+{
+  GPTileBatchData  batch_data;
+  GimpWireMessage  msg;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  guchar          *shm_data = NULL;
+  gint             bpp;
+  gint             i;
+
+  buffer = gimp_plug_in_get_read_buffer (plug_in, request->drawable_id,
+                                         request->shadow);
+
+  if (! buffer)
+    return;
+
+  format = gegl_buffer_get_format (buffer);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  batch_data.drawable_id = request->drawable_id;
+  batch_data.shadow      = request->shadow;
+  batch_data.bpp         = bpp;
+  batch_data.use_shm     = (plug_in->manager->shm != NULL);
+  batch_data.n_tiles     = request->n_tiles;
+  batch_data.tiles       = g_new0 (GPTileBatchTile, request->n_tiles);
+
+  if (batch_data.use_shm)
+    shm_data = gimp_plug_in_shm_get_addr (plug_in->manager->shm);
+
+  for (i = 0; i < request->n_tiles; i++)
+    {
+      GPTileBatchTile *tile = &batch_data.tiles[i];
+      GeglRectangle    tile_rect;
+      guchar          *data;
+
+      if (! gimp_gegl_buffer_get_tile_rect (buffer,
+                                            GIMP_PLUG_IN_TILE_WIDTH,
+                                            GIMP_PLUG_IN_TILE_HEIGHT,
+                                            request->tile_nums[i],
+                                            &tile_rect))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "requested invalid tile #%d for reading (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        request->tile_nums[i]);
+          gimp_plug_in_close (plug_in, TRUE);
+          goto cleanup;
+        }
+
+      tile->tile_num = request->tile_nums[i];
+      tile->width    = tile_rect.width;
+      tile->height   = tile_rect.height;
+
+      if (batch_data.use_shm)
+        {
+          /*  the tiles are stored one after the other  */
+          data      = shm_data;
+          shm_data += bpp * tile_rect.width * tile_rect.height;
+        }
+      else
+        {
+          tile->data = g_malloc (bpp * tile_rect.width * tile_rect.height);
+
+          data = tile->data;
+        }
+
+      gegl_buffer_get (buffer, &tile_rect, 1.0, format,
+                       data,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  if (! gp_tile_batch_data_write (plug_in->my_write, &batch_data, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      goto cleanup;
+    }
+
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      goto cleanup;
+    }
+
+  if (msg.type != GP_TILE_ACK)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "expected tile ack and received: %d", msg.type);
+      gimp_plug_in_close (plug_in, TRUE);
+    }
+
+  gimp_wire_destroy (&msg);
+
+ cleanup:
+  for (i = 0; i < request->n_tiles; i++)
+    g_free (batch_data.tiles[i].data);
+
+  g_free (batch_data.tiles);
+}
+
+/*  like gimp_plug_in_handle_tile_put(), but receives all the tiles the
+ *  plug-in changed since its last commit in a single GP_TILE_BATCH_DATA.
+ *  the plug-in only writes to the shared memory segment after it got
+ *  our permission, while we wait for its data.
+ */
+static void
+gimp_plug_in_handle_tile_batch_put (GimpPlugIn     *plug_in,
+                                    GPTileBatchReq *request)
+{
+  GPTileBatchData  batch_grant;
+  GPTileBatchData *batch_data;
+  GimpWireMessage  msg;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  const guchar    *shm_data = NULL;
+  gint             bpp;
+  gint             i;
+
+  batch_grant.drawable_id = -1;
+  batch_grant.shadow      = 0;
+  batch_grant.bpp         = 0;
+  batch_grant.use_shm     = (plug_in->manager->shm != NULL);
+  batch_grant.n_tiles     = 0;
+  batch_grant.tiles       = NULL;
+
+  if (! gp_tile_batch_data_write (plug_in->my_write, &batch_grant, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (msg.type != GP_TILE_BATCH_DATA)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "expected tile batch data and received: %d", msg.type);
+      gimp_plug_in_close (plug_in, TRUE);
+      gimp_wire_destroy (&msg);
+      return;
+    }
+
+  batch_data = msg.data;
+
+  if (! batch_data)
+    {
+      gimp_plug_in_handle_invalid_message (plug_in);
+      return;
+    }
+
+  buffer = gimp_plug_in_get_write_buffer (plug_in, batch_data->drawable_id,
+                                          batch_data->shadow);
+
+  if (! buffer)
+    {
+      gimp_wire_destroy (&msg);
+      return;
+    }
+
+  format = gegl_buffer_get_format (buffer);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  if (batch_data->bpp != bpp ||
+      (batch_data->use_shm && ! plug_in->manager->shm))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent invalid tile data for drawable %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    batch_data->drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      gimp_wire_destroy (&msg);
+      return;
+    }
+
+  if (batch_data->use_shm)
+    shm_data = gimp_plug_in_shm_get_addr (plug_in->manager->shm);
+
+  for (i = 0; i < batch_data->n_tiles; i++)
+    {
+      GPTileBatchTile *tile = &batch_data->tiles[i];
+      GeglRectangle    tile_rect;
+      const guchar    *data;
+
+      if (! gimp_gegl_buffer_get_tile_rect (buffer,
+                                            GIMP_PLUG_IN_TILE_WIDTH,
+                                            GIMP_PLUG_IN_TILE_HEIGHT,
+                                            tile->tile_num,
+                                            &tile_rect) ||
+          tile->width  != tile_rect.width ||
+          tile->height != tile_rect.height)
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "requested invalid tile #%d for writing (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        tile->tile_num);
+          gimp_plug_in_close (plug_in, TRUE);
+          gimp_wire_destroy (&msg);
+          return;
+        }
+
+      if (batch_data->use_shm)
+        {
+          data      = shm_data;
+          shm_data += bpp * tile_rect.width * tile_rect.height;
+        }
+      else
+        {
+          data = tile->data;
+        }
+
+      gegl_buffer_set (buffer, &tile_rect, 0, format,
+                       data,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  gimp_wire_destroy (&msg);
+
+  if (! gp_tile_ack_write (plug_in->my_write, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+}
+
+/*  copies all the tiles of a drawable into a new shared memory segment
+ *  which the plug-in maps, and then reads without further requests.
+ *  the segment belongs to the plug-in once it acknowledged mapping it.
+ */
+static void
+gimp_plug_in_handle_drawable_store (GimpPlugIn         *plug_in,
+                                    GPDrawableStoreReq *request)
+{
+  GPDrawableStore  drawable_store;
+  GimpWireMessage  msg;
+  GimpPlugInShm   *store = NULL;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  gint             bpp;
+  gint             width;
+  gint             height;
+
+  if (! request)
+    {
+      gimp_plug_in_handle_invalid_message (plug_in);
+      return;
+    }
+
+  buffer = gimp_plug_in_get_read_buffer (plug_in, request->drawable_id,
+                                         request->shadow);
+
+  if (! buffer)
+    return;
+
+  format = gegl_buffer_get_format (buffer);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+  width  = gegl_buffer_get_width  (buffer);
+  height = gegl_buffer_get_height (buffer);
+
+  if (plug_in->manager->shm)
+    {
+      gint  n_cols    = (width  + GIMP_PLUG_IN_TILE_WIDTH  - 1) /
+                        GIMP_PLUG_IN_TILE_WIDTH;
+      gint  n_rows    = (height + GIMP_PLUG_IN_TILE_HEIGHT - 1) /
+                        GIMP_PLUG_IN_TILE_HEIGHT;
+      gsize tile_size = (gsize) GIMP_PLUG_IN_TILE_WIDTH *
+                        GIMP_PLUG_IN_TILE_HEIGHT * bpp;
+
+      store = gimp_plug_in_shm_new_store (plug_in->manager->shm,
+                                          tile_size * n_cols * n_rows);
+
+      if (store)
+        {
+          guchar *data = gimp_plug_in_shm_get_addr (store);
+          gint    tile_num;
+
+          /*  the segment is zero-filled, the edge tiles just don't
+           *  use all of their space
+           */
+          for (tile_num = 0; tile_num < n_cols * n_rows; tile_num++)
+            {
+              GeglRectangle tile_rect;
+
+              gimp_gegl_buffer_get_tile_rect (buffer,
+                                              GIMP_PLUG_IN_TILE_WIDTH,
+                                              GIMP_PLUG_IN_TILE_HEIGHT,
+                                              tile_num,
+                                              &tile_rect);
+
+              gegl_buffer_get (buffer, &tile_rect, 1.0, format,
+                               data + tile_num * tile_size,
+                               GIMP_PLUG_IN_TILE_WIDTH * bpp,
+                               GEGL_ABYSS_NONE);
+            }
+        }
+    }
+
+  drawable_store.drawable_id = request->drawable_id;
+  drawable_store.shadow      = request->shadow;
+  drawable_store.bpp         = bpp;
+  drawable_store.width       = width;
+  drawable_store.height      = height;
+  drawable_store.store_id    = store ? gimp_plug_in_shm_get_id (store) : -1;
+
+  if (! gp_drawable_store_write (plug_in->my_write, &drawable_store, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      goto cleanup;
+    }
+
+  if (! store)
+    return;
+
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      goto cleanup;
+    }
+
+  if (msg.type != GP_TILE_ACK)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "expected tile ack and received: %d", msg.type);
+      gimp_plug_in_close (plug_in, TRUE);
+    }
+
+  gimp_wire_destroy (&msg);
+
+ cleanup:
+  if (store)
+    gimp_plug_in_shm_free (store);
+}
+
+/*  closes a plug-in which sent a message that couldn't be read  */
+static void
+gimp_plug_in_handle_invalid_message (GimpPlugIn *plug_in)
+{
+  gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                "Plug-in \"%s\"\n(%s)\n\n"
+                "sent an invalid message (killing)",
+                gimp_object_get_name (plug_in),
+                gimp_file_get_utf8_name (plug_in->file));
+  gimp_plug_in_close (plug_in, TRUE);
+}
+
+/*  returns the buffer which a plug-in reads tiles from, or closes the
+ *  plug-in and returns NULL if the drawable is invalid
+ */
+static GeglBuffer *
+gimp_plug_in_get_read_buffer (GimpPlugIn *plug_in,
+                              gint32      drawable_id,
+                              gboolean    shadow)
+{
+  GimpDrawable *drawable;
+
+  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
+                                                   drawable_id);
+
+  if (! GIMP_IS_DRAWABLE (drawable))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried reading from invalid drawable %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried reading from drawable %d which was removed "
+                    "from the image (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+
+  if (shadow)
+    {
+      GeglBuffer *buffer = gimp_drawable_get_shadow_buffer (drawable);
+
+      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
+
+      return buffer;
+    }
+
+  return gimp_drawable_get_buffer (drawable);
+}
+
+/*  returns the buffer which a plug-in writes tiles to, or closes the
+ *  plug-in and returns NULL if it may not write to the drawable
+ */
+static GeglBuffer *
+gimp_plug_in_get_write_buffer (GimpPlugIn *plug_in,
+                               gint32      drawable_id,
+                               gboolean    shadow)
+{
+  GimpDrawable *drawable;
+
+  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
+                                                   drawable_id);
+
+  if (! GIMP_IS_DRAWABLE (drawable))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried writing to invalid drawable %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried writing to drawable %d which was removed "
+                    "from the image (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+
+  if (shadow)
+    {
+      GeglBuffer *buffer;
+
+      /*  don't check whether the drawable is a group or locked here,
+       *  the plugin will get a proper error message when it tries to
+       *  merge the shadow tiles, which is much better than just
+       *  killing it.
+       */
+      buffer = gimp_drawable_get_shadow_buffer (drawable);
+
+      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
+
+      return buffer;
+    }
+
+  if (gimp_item_is_content_locked (GIMP_ITEM (drawable), NULL))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried writing to a locked drawable %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+  else if (gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried writing to a group layer %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+
+  return gimp_drawable_get_buffer (drawable);
+}
+
 static void
 gimp_plug_in_handle_proc_error (GimpPlugIn          *plug_in,
                                 GimpPlugInProcFrame *proc_frame,
@@ -659,9 +1132,19 @@ gimp_plug_in_handle_proc_return (GimpPlugIn   *plug_in,
                                                    plug_in->manager->gimp,
                                                    proc_frame->progress,
                                                    proc_frame->return_vals);
+
+      if (plug_in->reusable)
+        {
+          gimp_plug_in_manager_release_worker (plug_in->manager, plug_in);
+          return;
+        }
     }
 
-  gimp_plug_in_close (plug_in, FALSE);
+  /*  a reusable plug-in run synchronously is released in
+   *  gimp_plug_in_manager_call_run() once the return values are taken
+   */
+  if (! plug_in->reusable)
+    gimp_plug_in_close (plug_in, FALSE);
 }
 
 static void
@@ -902,3 +1385,22 @@ gimp_plug_in_handle_has_init (GimpPlugIn *plug_in)
       gimp_plug_in_close (plug_in, TRUE);
     }
 }
+
+static void
+gimp_plug_in_handle_reusable (GimpPlugIn *plug_in)
+{
+  if (plug_in->call_mode == GIMP_PLUG_IN_CALL_QUERY)
+    {
+      gimp_plug_in_def_set_reusable (plug_in->plug_in_def, TRUE);
+    }
+  else
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent a REUSABLE message while not in query().  "
+                    "This should not happen.",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+    }
+}
@@ -94,6 +94,7 @@
 #include "gimpplugindef.h"
 #include "gimppluginmanager.h"
 #include "gimppluginmanager-help-domain.h"
+#include "gimppluginmanager-worker.h"
 #include "gimptemporaryprocedure.h"
 
 #include "gimp-intl.h"
@@ -164,7 +165,7 @@ gimp_plug_in_init (GimpPlugIn *plug_in)
   plug_in->his_write          = NULL;
 
   plug_in->input_id           = 0;
-  plug_in->write_buffer_index = 0;
+  plug_in->write_buffer       = gimp_wire_buffer_new ();
 
   plug_in->temp_procedures    = NULL;
 
@@ -182,6 +183,7 @@ gimp_plug_in_finalize (GObject *object)
 
   g_clear_object (&plug_in->file);
   g_clear_weak_pointer (&plug_in->display);
+  g_clear_pointer (&plug_in->write_buffer, gimp_wire_buffer_free);
 
   gimp_plug_in_proc_frame_dispose (&plug_in->main_proc_frame, plug_in);
 
@@ -279,32 +281,8 @@ gimp_plug_in_write (GIOChannel   *channel,
                     gpointer      data)
 {
   GimpPlugIn *plug_in = data;
-  gulong      bytes;
 
-  while (count > 0)
-    {
-      if ((plug_in->write_buffer_index + count) >= WRITE_BUFFER_SIZE)
-        {
-          bytes = WRITE_BUFFER_SIZE - plug_in->write_buffer_index;
-          memcpy (&plug_in->write_buffer[plug_in->write_buffer_index],
-                  buf, bytes);
-          plug_in->write_buffer_index += bytes;
-          if (! gimp_wire_flush (channel, plug_in))
-            return FALSE;
-        }
-      else
-        {
-          bytes = count;
-          memcpy (&plug_in->write_buffer[plug_in->write_buffer_index],
-                  buf, bytes);
-          plug_in->write_buffer_index += bytes;
-        }
-
-      buf += bytes;
-      count -= bytes;
-    }
-
-  return TRUE;
+  return gimp_wire_buffer_write (plug_in->write_buffer, channel, buf, count);
 }
 
 static gboolean
@@ -313,52 +291,7 @@ gimp_plug_in_flush (GIOChannel *channel,
 {
   GimpPlugIn *plug_in = data;
 
-  if (plug_in->write_buffer_index > 0)
-    {
-      GIOStatus  status;
-      GError    *error = NULL;
-      gint       count;
-      gsize      bytes;
-
-      count = 0;
-      while (count != plug_in->write_buffer_index)
-        {
-          do
-            {
-              bytes = 0;
-              status = g_io_channel_write_chars (channel,
-                                                 &plug_in->write_buffer[count],
-                                                 (plug_in->write_buffer_index - count),
-                                                 &bytes,
-                                                 &error);
-            }
-          while (status == G_IO_STATUS_AGAIN);
-
-          if (status != G_IO_STATUS_NORMAL)
-            {
-              if (error)
-                {
-                  g_warning ("%s: plug_in_flush(): error: %s",
-                             gimp_filename_to_utf8 (g_get_prgname ()),
-                             error->message);
-                  g_error_free (error);
-                }
-              else
-                {
-                  g_warning ("%s: plug_in_flush(): error",
-                             gimp_filename_to_utf8 (g_get_prgname ()));
-                }
-
-              return FALSE;
-            }
-
-          count += bytes;
-        }
-
-      plug_in->write_buffer_index = 0;
-    }
-
-  return TRUE;
+  return gimp_wire_buffer_flush (plug_in->write_buffer, channel);
 }
 
 #if defined G_OS_WIN32 && defined WIN32_32BIT_DLL_FOLDER
@@ -493,6 +426,31 @@ gimp_plug_in_new (GimpPlugInManager   *manager,
   return plug_in;
 }
 
+/*  prepares a worker which returned from its last procedure for
+ *  running @procedure, see gimp_plug_in_manager_take_worker()
+ */
+void
+gimp_plug_in_reuse (GimpPlugIn          *plug_in,
+                    GimpContext         *context,
+                    GimpProgress        *progress,
+                    GimpPlugInProcedure *procedure,
+                    GimpDisplay         *display)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+  g_return_if_fail (plug_in->open);
+  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
+  g_return_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress));
+  g_return_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure));
+  g_return_if_fail (display == NULL || GIMP_IS_DISPLAY (display));
+
+  gimp_plug_in_proc_frame_dispose (&plug_in->main_proc_frame, plug_in);
+
+  g_set_weak_pointer (&plug_in->display, display);
+
+  gimp_plug_in_proc_frame_init (&plug_in->main_proc_frame,
+                                context, progress, procedure);
+}
+
 gboolean
 gimp_plug_in_open (GimpPlugIn         *plug_in,
                    GimpPlugInCallMode  call_mode,
@@ -879,6 +837,7 @@ gimp_plug_in_close (GimpPlugIn *plug_in,
   while (plug_in->temp_procedures)
     gimp_plug_in_remove_temp_proc (plug_in, plug_in->temp_procedures->data);
 
+  gimp_plug_in_manager_remove_worker (plug_in->manager, plug_in);
   gimp_plug_in_manager_remove_open_plug_in (plug_in->manager, plug_in);
 }
 
@@ -19,13 +19,12 @@
 
 #pragma once
 
+#include "libgimpbase/gimpwire.h"
+
 #include "core/gimpobject.h"
 #include "gimppluginprocframe.h"
 
 
-#define WRITE_BUFFER_SIZE  512
-
-
 #define GIMP_TYPE_PLUG_IN            (gimp_plug_in_get_type ())
 #define GIMP_PLUG_IN(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_PLUG_IN, GimpPlugIn))
 #define GIMP_PLUG_IN_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GIMP_TYPE_PLUG_IN, GimpPlugInClass))
@@ -46,6 +45,7 @@ struct _GimpPlugIn
   GimpPlugInCallMode   call_mode;       /*  QUERY, INIT or RUN                */
   guint                open : 1;        /*  Is the plug-in open?              */
   guint                hup : 1;         /*  Did we receive a G_IO_HUP         */
+  guint                reusable : 1;    /*  Does it stay open after running?  */
   GPid                 pid;             /*  Plug-in's process id              */
 
   GIOChannel          *my_read;         /*  App's read and write channels     */
@@ -55,8 +55,7 @@ struct _GimpPlugIn
 
   guint                input_id;        /*  Id of input proc                  */
 
-  gchar                write_buffer[WRITE_BUFFER_SIZE]; /* Buffer for writing */
-  gint                 write_buffer_index;              /* Buffer index       */
+  GimpWireBuffer      *write_buffer;    /*  Buffer for writing                */
 
   GSList              *temp_procedures; /*  Temporary procedures              */
 
@@ -67,6 +66,8 @@ struct _GimpPlugIn
   GList               *temp_proc_frames;
 
   GimpPlugInDef       *plug_in_def;     /*  Valid during query() and init()   */
+
+  guint                worker_timeout_id; /*  Quits an idle worker            */
 };
 
 struct _GimpPlugInClass
@@ -84,6 +85,12 @@ GimpPlugIn  * gimp_plug_in_new               (GimpPlugInManager      *manager,
                                               GFile                  *file,
                                               GimpDisplay            *display);
 
+void          gimp_plug_in_reuse             (GimpPlugIn             *plug_in,
+                                              GimpContext            *context,
+                                              GimpProgress           *progress,
+                                              GimpPlugInProcedure    *procedure,
+                                              GimpDisplay            *display);
+
 gboolean      gimp_plug_in_open              (GimpPlugIn             *plug_in,
                                               GimpPlugInCallMode      call_mode,
                                               gboolean                synchronous);
@@ -201,3 +201,12 @@ gimp_plug_in_def_set_has_init (GimpPlugInDef *plug_in_def,
 
   plug_in_def->has_init = has_init ? TRUE : FALSE;
 }
+
+void
+gimp_plug_in_def_set_reusable (GimpPlugInDef *plug_in_def,
+                               gboolean       reusable)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+
+  plug_in_def->reusable = reusable ? TRUE : FALSE;
+}
@@ -42,6 +42,7 @@ struct _GimpPlugInDef
   gint64      mtime;
   gboolean    needs_query;  /* Does the plug-in need to be queried ?     */
   gboolean    has_init;     /* Does the plug-in need to be initialized ? */
+  gboolean    reusable;     /* Can the plug-in run several procedures ?  */
 };
 
 struct _GimpPlugInDefClass
@@ -69,3 +70,5 @@ void   gimp_plug_in_def_set_needs_query   (GimpPlugInDef       *plug_in_def,
                                            gboolean             needs_query);
 void   gimp_plug_in_def_set_has_init      (GimpPlugInDef       *plug_in_def,
                                            gboolean             has_init);
+void   gimp_plug_in_def_set_reusable      (GimpPlugInDef       *plug_in_def,
+                                           gboolean             reusable);
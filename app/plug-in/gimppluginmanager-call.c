@@ -56,12 +56,28 @@
 #include "gimppluginmanager.h"
 #define __YES_I_NEED_GIMP_PLUG_IN_MANAGER_CALL__
 #include "gimppluginmanager-call.h"
+#include "gimppluginmanager-worker.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
 
 #include "gimp-intl.h"
 
 
+/*  the most plug-ins queried or initialized at the same time  */
+#define MAX_CALL_JOBS 16
+
+
+typedef struct _GimpPlugInCallJob GimpPlugInCallJob;
+
+struct _GimpPlugInCallJob
+{
+  GimpPlugInDef *plug_in_def;
+  GimpPlugIn    *plug_in;
+  gint64         start_time;
+  gint64         duration;
+};
+
+
 static void
 gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 {
@@ -70,89 +86,211 @@ gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 #endif
 }
 
+static gboolean
+gimp_plug_in_manager_call_job_recv (GIOChannel        *channel,
+                                    GIOCondition       cond,
+                                    GimpPlugInCallJob *job)
+{
+  GimpPlugIn      *plug_in = job->plug_in;
+  GimpWireMessage  msg;
 
-/*  public functions  */
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_plug_in_close (plug_in, TRUE);
+    }
+  else
+    {
+      gimp_plug_in_handle_message (plug_in, &msg);
+      gimp_wire_destroy (&msg);
+    }
 
-void
-gimp_plug_in_manager_call_query (GimpPlugInManager *manager,
-                                 GimpContext       *context,
-                                 GimpPlugInDef     *plug_in_def)
+  return plug_in->open ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static gint
+gimp_plug_in_manager_call_job_compare (const GimpPlugInCallJob *a,
+                                       const GimpPlugInCallJob *b)
 {
-  GimpPlugIn *plug_in;
+  if (a->duration > b->duration)
+    return -1;
+  else if (a->duration < b->duration)
+    return 1;
 
-  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
-  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
-  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+  return 0;
+}
+
+/*  Runs the query() or init() function of all @plug_in_defs, with up
+ *  to "num-processors" plug-ins running at once. Each plug-in only
+ *  adds to its own GimpPlugInDef, and the messages of all plug-ins are
+ *  handled one at a time, so the result is the same as when running
+ *  them one after another.
+ */
+static void
+gimp_plug_in_manager_call_defs (GimpPlugInManager  *manager,
+                                GimpContext        *context,
+                                GimpPlugInCallMode  call_mode,
+                                GSList             *plug_in_defs,
+                                GimpInitStatusFunc  status_callback)
+{
+  GimpGeglConfig *gegl_config = GIMP_GEGL_CONFIG (manager->gimp->config);
+  GMainContext   *main_context;
+  GList          *running     = NULL;
+  GList          *done        = NULL;
+  GSList         *list;
+  gint            n_plug_ins;
+  gint            n_jobs;
+  gint            nth         = 0;
 
-  plug_in = gimp_plug_in_new (manager, context, NULL,
-                              NULL, plug_in_def->file, NULL);
+  n_plug_ins = g_slist_length (plug_in_defs);
 
-  if (plug_in)
+  if (n_plug_ins == 0)
+    return;
+
+  n_jobs = CLAMP (gegl_config->num_processors, 1, MAX_CALL_JOBS);
+
+  /*  a plug-in wrapped in a debugger may need the terminal  */
+  if (manager->debug)
+    n_jobs = 1;
+
+  main_context = g_main_context_new ();
+
+  list = plug_in_defs;
+
+  while (list || running)
     {
-      plug_in->plug_in_def = plug_in_def;
+      GList *iter;
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_QUERY, TRUE))
+      while (list && (gint) g_list_length (running) < n_jobs)
         {
-          while (plug_in->open)
+          GimpPlugInCallJob *job         = g_slice_new0 (GimpPlugInCallJob);
+          GimpPlugInDef     *plug_in_def = list->data;
+          gchar             *basename;
+
+          list = g_slist_next (list);
+
+          basename =
+            g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
+          status_callback (NULL, basename,
+                           (gdouble) nth++ / (gdouble) n_plug_ins);
+          g_free (basename);
+
+          if (manager->gimp->be_verbose)
+            g_print ("%s plug-in: '%s'\n",
+                     call_mode == GIMP_PLUG_IN_CALL_QUERY ?
+                     "Querying" : "Initializing",
+                     gimp_file_get_utf8_name (plug_in_def->file));
+
+          job->plug_in_def = plug_in_def;
+          job->plug_in     = gimp_plug_in_new (manager, context, NULL,
+                                               NULL, plug_in_def->file, NULL);
+          job->start_time  = g_get_monotonic_time ();
+
+          if (job->plug_in)
             {
-              GimpWireMessage msg;
+              job->plug_in->plug_in_def = plug_in_def;
 
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
-                {
-                  gimp_plug_in_close (plug_in, TRUE);
-                }
-              else
+              if (gimp_plug_in_open (job->plug_in, call_mode, TRUE))
                 {
-                  gimp_plug_in_handle_message (plug_in, &msg);
-                  gimp_wire_destroy (&msg);
+                  GSource *source;
+
+                  source = g_io_create_watch (job->plug_in->my_read,
+                                              G_IO_IN  | G_IO_PRI |
+                                              G_IO_ERR | G_IO_HUP);
+                  g_source_set_callback (source,
+                                         (GSourceFunc) gimp_plug_in_manager_call_job_recv,
+                                         job, NULL);
+                  g_source_attach (source, main_context);
+                  g_source_unref (source);
                 }
             }
+
+          running = g_list_append (running, job);
         }
 
-      g_object_unref (plug_in);
-    }
-}
+      iter = running;
 
-void
-gimp_plug_in_manager_call_init (GimpPlugInManager *manager,
-                                GimpContext       *context,
-                                GimpPlugInDef     *plug_in_def)
-{
-  GimpPlugIn *plug_in;
+      while (iter)
+        {
+          GimpPlugInCallJob *job  = iter->data;
+          GList             *next = g_list_next (iter);
 
-  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
-  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
-  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+          if (! job->plug_in || ! job->plug_in->open)
+            {
+              job->duration = g_get_monotonic_time () - job->start_time;
 
-  plug_in = gimp_plug_in_new (manager, context, NULL,
-                              NULL, plug_in_def->file, NULL);
+              g_clear_object (&job->plug_in);
 
-  if (plug_in)
+              running = g_list_delete_link (running, iter);
+              done    = g_list_prepend (done, job);
+            }
+
+          iter = next;
+        }
+
+      if (running)
+        g_main_context_iteration (main_context, TRUE);
+    }
+
+  g_main_context_unref (main_context);
+
+  if (manager->gimp->be_verbose)
     {
-      plug_in->plug_in_def = plug_in_def;
+      GList *iter;
+
+      done = g_list_sort (done, (GCompareFunc) gimp_plug_in_manager_call_job_compare);
+
+      g_print ("%s %d plug-ins, %d at a time:\n",
+               call_mode == GIMP_PLUG_IN_CALL_QUERY ? "Queried" : "Initialized",
+               n_plug_ins, n_jobs);
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_INIT, TRUE))
+      for (iter = done; iter; iter = g_list_next (iter))
         {
-          while (plug_in->open)
-            {
-              GimpWireMessage msg;
+          GimpPlugInCallJob *job = iter->data;
 
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
-                {
-                  gimp_plug_in_close (plug_in, TRUE);
-                }
-              else
-                {
-                  gimp_plug_in_handle_message (plug_in, &msg);
-                  gimp_wire_destroy (&msg);
-                }
-            }
+          g_print ("  %8.3f s  %s\n",
+                   (gdouble) job->duration / G_TIME_SPAN_SECOND,
+                   gimp_file_get_utf8_name (job->plug_in_def->file));
         }
+    }
 
-      g_object_unref (plug_in);
+  while (done)
+    {
+      g_slice_free (GimpPlugInCallJob, done->data);
+      done = g_list_delete_link (done, done);
     }
 }
 
+
+/*  public functions  */
+
+void
+gimp_plug_in_manager_call_query (GimpPlugInManager  *manager,
+                                 GimpContext        *context,
+                                 GSList             *plug_in_defs,
+                                 GimpInitStatusFunc  status_callback)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
+  g_return_if_fail (status_callback != NULL);
+
+  gimp_plug_in_manager_call_defs (manager, context, GIMP_PLUG_IN_CALL_QUERY,
+                                  plug_in_defs, status_callback);
+}
+
+void
+gimp_plug_in_manager_call_init (GimpPlugInManager  *manager,
+                                GimpContext        *context,
+                                GSList             *plug_in_defs,
+                                GimpInitStatusFunc  status_callback)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
+  g_return_if_fail (status_callback != NULL);
+
+  gimp_plug_in_manager_call_defs (manager, context, GIMP_PLUG_IN_CALL_INIT,
+                                  plug_in_defs, status_callback);
+}
+
 GimpValueArray *
 gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
                                GimpContext         *context,
@@ -175,7 +313,12 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
   if (! display)
     display = gimp_context_get_display (context);
 
-  plug_in = gimp_plug_in_new (manager, context, progress, procedure, NULL, display);
+  plug_in = gimp_plug_in_manager_take_worker (manager, procedure);
+
+  if (plug_in)
+    gimp_plug_in_reuse (plug_in, context, progress, procedure, display);
+  else
+    plug_in = gimp_plug_in_new (manager, context, progress, procedure, NULL, display);
 
   if (plug_in)
     {
@@ -192,7 +335,8 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       const guint8      *icc;
       gint               icc_length;
 
-      if (! gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_RUN, FALSE))
+      if (! plug_in->open &&
+          ! gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_RUN, FALSE))
         {
           const gchar *name  = gimp_object_get_name (plug_in);
           GError      *error = g_error_new (GIMP_PLUG_IN_ERROR,
@@ -209,6 +353,9 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
           return return_vals;
         }
 
+      plug_in->reusable = gimp_plug_in_manager_is_reusable (manager,
+                                                            procedure);
+
       display_id = display ? gimp_display_get_id (display) : -1;
 
       icon_theme_dir = gimp_get_icon_theme_dir (manager->gimp);
@@ -326,6 +473,9 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
           g_clear_pointer (&proc_frame->main_loop, g_main_loop_unref);
 
           return_vals = gimp_plug_in_proc_frame_get_return_values (proc_frame);
+
+          if (plug_in->reusable)
+            gimp_plug_in_manager_release_worker (manager, plug_in);
         }
 
       g_object_unref (plug_in);
@@ -47,6 +47,7 @@
 #include "gimppluginmanager-restore.h"
 #include "gimppluginprocedure.h"
 #include "plug-in-rc.h"
+#include "plug-in-rc-cache.h"
 
 #include "gimp-intl.h"
 
@@ -56,6 +57,12 @@ static void    gimp_plug_in_manager_search            (GimpPlugInManager    *man
 static void    gimp_plug_in_manager_search_directory  (GimpPlugInManager    *manager,
                                                        GFile                *directory);
 static GFile * gimp_plug_in_manager_get_pluginrc      (GimpPlugInManager    *manager);
+static GFile * gimp_plug_in_manager_get_pluginrc_cache
+                                                      (GFile                *pluginrc);
+static gboolean gimp_plug_in_manager_read_pluginrc_cache
+                                                      (GimpPlugInManager    *manager,
+                                                       GFile                *pluginrc,
+                                                       GFile                *cache_file);
 static void    gimp_plug_in_manager_read_pluginrc     (GimpPlugInManager    *manager,
                                                        GFile                *file,
                                                        GimpInitStatusFunc    status_callback);
@@ -88,10 +95,12 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
                               GimpContext        *context,
                               GimpInitStatusFunc  status_callback)
 {
-  Gimp   *gimp;
-  GFile  *pluginrc;
-  GSList *list;
-  GError *error = NULL;
+  Gimp     *gimp;
+  GFile    *pluginrc;
+  GFile    *cache_file;
+  GSList   *list;
+  gboolean  write_cache;
+  GError   *error = NULL;
 
   g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
   g_return_if_fail (GIMP_IS_CONTEXT (context));
@@ -106,9 +115,18 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
   gimp_plug_in_manager_search (manager, status_callback);
 
   /* read the pluginrc file for cached data */
-  pluginrc = gimp_plug_in_manager_get_pluginrc (manager);
+  pluginrc   = gimp_plug_in_manager_get_pluginrc (manager);
+  cache_file = gimp_plug_in_manager_get_pluginrc_cache (pluginrc);
+
+  status_callback (_("Resource configuration"),
+                   gimp_file_get_utf8_name (pluginrc), 0.0);
 
-  gimp_plug_in_manager_read_pluginrc (manager, pluginrc, status_callback);
+  /* prefer the binary cache, it is only valid for an unchanged pluginrc */
+  write_cache = ! gimp_plug_in_manager_read_pluginrc_cache (manager,
+                                                            pluginrc,
+                                                            cache_file);
+  if (write_cache)
+    gimp_plug_in_manager_read_pluginrc (manager, pluginrc, status_callback);
 
   /* query any plug-ins that changed since we last wrote out pluginrc */
   gimp_plug_in_manager_query_new (manager, context, status_callback);
@@ -134,16 +152,39 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
       if (gimp->be_verbose)
         g_print ("Writing '%s'\n", gimp_file_get_utf8_name (pluginrc));
 
-      if (! plug_in_rc_write (manager->plug_in_defs, pluginrc, &error))
+      if (plug_in_rc_write (manager->plug_in_defs, pluginrc, &error))
+        {
+          write_cache = TRUE;
+        }
+      else
         {
           gimp_message_literal (gimp,
                                 NULL, GIMP_MESSAGE_ERROR, error->message);
           g_clear_error (&error);
+
+          write_cache = FALSE;
         }
 
       manager->write_pluginrc = FALSE;
     }
 
+  /* the cache is stamped with the pluginrc it was written along with */
+  if (write_cache)
+    {
+      if (gimp->be_verbose)
+        g_print ("Writing '%s'\n", gimp_file_get_utf8_name (cache_file));
+
+      if (! plug_in_rc_cache_write (manager->plug_in_defs,
+                                    cache_file, pluginrc, &error))
+        {
+          if (gimp->be_verbose)
+            g_print ("%s\n", error->message);
+
+          g_clear_error (&error);
+        }
+    }
+
+  g_object_unref (cache_file);
   g_object_unref (pluginrc);
 
   /* create help domain lists */
@@ -400,6 +441,78 @@ gimp_plug_in_manager_get_pluginrc (GimpPlugInManager *manager)
   return pluginrc;
 }
 
+static GFile *
+gimp_plug_in_manager_get_pluginrc_cache (GFile *pluginrc)
+{
+  GFile *cache_file;
+  gchar *path;
+
+  path = g_strconcat (g_file_peek_path (pluginrc), ".cache", NULL);
+  cache_file = g_file_new_for_path (path);
+  g_free (path);
+
+  return cache_file;
+}
+
+/* read the binary pluginrc cache, returns FALSE if it can't be used */
+static gboolean
+gimp_plug_in_manager_read_pluginrc_cache (GimpPlugInManager *manager,
+                                          GFile             *pluginrc,
+                                          GFile             *cache_file)
+{
+  PlugInRcCache *cache;
+  GSList        *list;
+  GError        *error = NULL;
+
+  if (manager->gimp->be_verbose)
+    g_print ("Reading '%s'\n", gimp_file_get_utf8_name (cache_file));
+
+  cache = plug_in_rc_cache_open (cache_file, pluginrc, &error);
+
+  if (! cache)
+    {
+      if (manager->gimp->be_verbose)
+        g_print ("%s\n", error->message);
+
+      g_clear_error (&error);
+
+      return FALSE;
+    }
+
+  /*  Only plug-ins found on disk are looked up, so entries of changed
+   *  or removed plug-ins are never decoded.
+   */
+  for (list = manager->plug_in_defs; list; list = list->next)
+    {
+      GimpPlugInDef *ondisk_plug_in_def = list->data;
+      GimpPlugInDef *plug_in_def;
+
+      plug_in_def = plug_in_rc_cache_lookup (cache,
+                                             ondisk_plug_in_def->file,
+                                             ondisk_plug_in_def->mtime);
+
+      if (plug_in_def)
+        {
+          /* Use cached entry, deleting on-disk entry */
+          list->data = plug_in_def;
+          g_object_unref (ondisk_plug_in_def);
+        }
+    }
+
+  if (plug_in_rc_cache_get_n_unused (cache) > 0)
+    {
+      if (manager->gimp->be_verbose)
+        g_printerr ("pluginrc lists %d plug-ins which weren't found\n",
+                    plug_in_rc_cache_get_n_unused (cache));
+
+      manager->write_pluginrc = TRUE;
+    }
+
+  plug_in_rc_cache_free (cache);
+
+  return TRUE;
+}
+
 /* read the pluginrc file for cached data */
 static void
 gimp_plug_in_manager_read_pluginrc (GimpPlugInManager  *manager,
@@ -409,9 +522,6 @@ gimp_plug_in_manager_read_pluginrc (GimpPlugInManager  *manager,
   GSList *rc_defs;
   GError *error = NULL;
 
-  status_callback (_("Resource configuration"),
-                   gimp_file_get_utf8_name (pluginrc), 0.0);
-
   if (manager->gimp->be_verbose)
     g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (pluginrc));
 
@@ -443,11 +553,11 @@ gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
                                 GimpInitStatusFunc  status_callback)
 {
   GSList *list;
-  gint    n_plugins;
+  GSList *query_defs = NULL;
 
   status_callback (_("Querying new Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
@@ -455,36 +565,19 @@ gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
         gimp_plug_in_def_set_needs_query (plug_in_def, TRUE);
 
       if (plug_in_def->needs_query)
-        n_plugins++;
+        query_defs = g_slist_prepend (query_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (query_defs)
     {
-      gint nth;
-
       manager->write_pluginrc = TRUE;
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
+      query_defs = g_slist_reverse (query_defs);
 
-          if (plug_in_def->needs_query)
-            {
-              gchar *basename;
-
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+      gimp_plug_in_manager_call_query (manager, context, query_defs,
+                                       status_callback);
 
-              if (manager->gimp->be_verbose)
-                g_print ("Querying plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
-
-              gimp_plug_in_manager_call_query (manager, context, plug_in_def);
-            }
-        }
+      g_slist_free (query_defs);
     }
 
   status_callback (NULL, "", 1.0);
@@ -497,43 +590,26 @@ gimp_plug_in_manager_init_plug_ins (GimpPlugInManager  *manager,
                                     GimpInitStatusFunc  status_callback)
 {
   GSList *list;
-  gint    n_plugins;
+  GSList *init_defs = NULL;
 
   status_callback (_("Initializing Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
       if (plug_in_def->has_init)
-        n_plugins++;
+        init_defs = g_slist_prepend (init_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (init_defs)
     {
-      gint nth;
+      init_defs = g_slist_reverse (init_defs);
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
-
-          if (plug_in_def->has_init)
-            {
-              gchar *basename;
+      gimp_plug_in_manager_call_init (manager, context, init_defs,
+                                      status_callback);
 
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
-
-              if (manager->gimp->be_verbose)
-                g_print ("Initializing plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
-
-              gimp_plug_in_manager_call_init (manager, context, plug_in_def);
-            }
-        }
+      g_slist_free (init_defs);
     }
 
   status_callback (NULL, "", 1.0);
@@ -0,0 +1,202 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppluginmanager-worker.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpbase/gimpwire.h"
+
+#include "plug-in-types.h"
+
+#include "config/gimpcoreconfig.h"
+
+#include "core/gimp.h"
+
+#include "gimpplugin.h"
+#include "gimpplugindef.h"
+#include "gimppluginmanager.h"
+#include "gimppluginmanager-worker.h"
+#include "gimppluginprocedure.h"
+
+
+/*  A worker is a plug-in which declared itself reusable in query()
+ *  and stays running after returning from its procedure, so the next
+ *  call of a procedure from the same file doesn't pay for spawning the
+ *  interpreter or process and initializing libgimp again.
+ *
+ *  Only idle workers are kept in manager->workers, at most
+ *  "plug-in-workers" of them, each one quit after having been idle for
+ *  "plug-in-worker-timeout" seconds.
+ */
+
+
+static gboolean   gimp_plug_in_manager_worker_timeout (GimpPlugIn *plug_in);
+
+
+/*  public functions  */
+
+gboolean
+gimp_plug_in_manager_is_reusable (GimpPlugInManager   *manager,
+                                  GimpPlugInProcedure *procedure)
+{
+  GFile  *file;
+  GSList *list;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), FALSE);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), FALSE);
+
+  if (manager->gimp->config->plug_in_workers < 1)
+    return FALSE;
+
+  /*  extensions keep running anyway  */
+  if (GIMP_PROCEDURE (procedure)->proc_type != GIMP_PDB_PROC_TYPE_PLUGIN)
+    return FALSE;
+
+  file = gimp_plug_in_procedure_get_file (procedure);
+
+  for (list = manager->plug_in_defs; list; list = g_slist_next (list))
+    {
+      GimpPlugInDef *plug_in_def = list->data;
+
+      if (g_file_equal (file, plug_in_def->file))
+        return plug_in_def->reusable;
+    }
+
+  return FALSE;
+}
+
+GimpPlugIn *
+gimp_plug_in_manager_take_worker (GimpPlugInManager   *manager,
+                                  GimpPlugInProcedure *procedure)
+{
+  GFile  *file;
+  GSList *list;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), NULL);
+
+  file = gimp_plug_in_procedure_get_file (procedure);
+
+  for (list = manager->workers; list; list = g_slist_next (list))
+    {
+      GimpPlugIn *plug_in = list->data;
+
+      if (g_file_equal (file, plug_in->file))
+        {
+          /*  the list's reference is passed on to the caller  */
+          manager->workers = g_slist_remove (manager->workers, plug_in);
+
+          g_clear_handle_id (&plug_in->worker_timeout_id, g_source_remove);
+
+          if (manager->gimp->be_verbose)
+            g_print ("Reusing plug-in: '%s'\n",
+                     gimp_file_get_utf8_name (plug_in->file));
+
+          return plug_in;
+        }
+    }
+
+  return NULL;
+}
+
+void
+gimp_plug_in_manager_release_worker (GimpPlugInManager *manager,
+                                     GimpPlugIn        *plug_in)
+{
+  GimpCoreConfig *config;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  if (! plug_in->open)
+    return;
+
+  config = manager->gimp->config;
+
+  /*  run the cleanups of the procedure now, not when the worker
+   *  finally quits
+   */
+  gimp_plug_in_proc_frame_dispose (&plug_in->main_proc_frame, plug_in);
+
+  /*  a plug-in with temporary procedures still serves them and must
+   *  not be given another procedure to run
+   */
+  if (plug_in->temp_procedures ||
+      g_slist_length (manager->workers) >= config->plug_in_workers)
+    {
+      gimp_plug_in_close (plug_in, FALSE);
+      return;
+    }
+
+  manager->workers = g_slist_prepend (manager->workers,
+                                      g_object_ref (plug_in));
+
+  plug_in->worker_timeout_id =
+    g_timeout_add_seconds (config->plug_in_worker_timeout,
+                           (GSourceFunc) gimp_plug_in_manager_worker_timeout,
+                           plug_in);
+}
+
+void
+gimp_plug_in_manager_remove_worker (GimpPlugInManager *manager,
+                                    GimpPlugIn        *plug_in)
+{
+  GSList *list;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  g_clear_handle_id (&plug_in->worker_timeout_id, g_source_remove);
+
+  list = g_slist_find (manager->workers, plug_in);
+
+  if (list)
+    {
+      manager->workers = g_slist_delete_link (manager->workers, list);
+
+      g_object_unref (plug_in);
+    }
+}
+
+
+/*  private functions  */
+
+static gboolean
+gimp_plug_in_manager_worker_timeout (GimpPlugIn *plug_in)
+{
+  plug_in->worker_timeout_id = 0;
+
+  g_object_ref (plug_in);
+
+  /*  let the plug-in exit normally, gimp_plug_in_close() removes it
+   *  from the idle workers
+   */
+  gp_quit_write (plug_in->my_write, plug_in);
+  gimp_wire_flush (plug_in->my_write, plug_in);
+
+  gimp_plug_in_close (plug_in, FALSE);
+
+  g_object_unref (plug_in);
+
+  return G_SOURCE_REMOVE;
+}
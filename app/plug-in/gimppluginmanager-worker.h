@@ -0,0 +1,35 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppluginmanager-worker.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+
+/* Can the plug-in of the procedure be kept running between calls? */
+gboolean     gimp_plug_in_manager_is_reusable    (GimpPlugInManager   *manager,
+                                                  GimpPlugInProcedure *procedure);
+
+/* Take an idle worker which can run the procedure, or NULL */
+GimpPlugIn * gimp_plug_in_manager_take_worker    (GimpPlugInManager   *manager,
+                                                  GimpPlugInProcedure *procedure);
+
+/* Keep a plug-in which returned from its procedure, or close it */
+void         gimp_plug_in_manager_release_worker (GimpPlugInManager   *manager,
+                                                  GimpPlugIn          *plug_in);
+void         gimp_plug_in_manager_remove_worker  (GimpPlugInManager   *manager,
+                                                  GimpPlugIn          *plug_in);
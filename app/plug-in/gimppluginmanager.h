@@ -59,6 +59,7 @@ struct _GimpPlugInManager
   GimpPlugIn        *current_plug_in;
   GSList            *open_plug_ins;
   GSList            *plug_in_stack;
+  GSList            *workers;
 
   GimpPlugInShm     *shm;
   GimpInterpreterDB *interpreter_db;
@@ -62,6 +62,8 @@
 
 #endif /* G_OS_WIN32 || G_WITH_CYGWIN */
 
+#include "libgimpbase/gimpprotocol.h"
+
 #include "plug-in-types.h"
 
 #include "core/gimp-utils.h"
@@ -71,7 +73,14 @@
 #include "gimp-log.h"
 
 
-#define TILE_MAP_SIZE (GIMP_PLUG_IN_TILE_WIDTH * GIMP_PLUG_IN_TILE_HEIGHT * 32)
+/*  room for a full batch of tiles of the largest pixel size  */
+#define TILE_MAP_SIZE (GIMP_PLUG_IN_TILE_WIDTH * GIMP_PLUG_IN_TILE_HEIGHT * 32 * \
+                       GP_TILE_BATCH_MAX_TILES)
+
+/*  the largest drawable store, larger drawables are transferred in
+ *  batches of tiles instead
+ */
+#define MAX_STORE_SIZE ((gsize) 256 << 20)
 
 #define ERRMSG_SHM_DISABLE "Disabling shared memory tile transport"
 
@@ -80,9 +89,12 @@ struct _GimpPlugInShm
 {
   gint    shm_id;
   guchar *shm_addr;
+  gsize   shm_size;
 
 #if defined(USE_WIN32_SHM)
   HANDLE  shm_handle;
+#elif defined(USE_POSIX_SHM)
+  gchar   shm_handle[48];
 #endif
 };
 
@@ -97,7 +109,8 @@ gimp_plug_in_shm_new (void)
 
   GimpPlugInShm *shm = g_slice_new0 (GimpPlugInShm);
 
-  shm->shm_id = -1;
+  shm->shm_id   = -1;
+  shm->shm_size = TILE_MAP_SIZE;
 
 #if defined(USE_SYSV_SHM)
 
@@ -183,15 +196,15 @@ gimp_plug_in_shm_new (void)
 
   /* Use POSIX shared memory mechanisms for transferring tile data. */
   {
-    gint  pid;
-    gchar shm_handle[32];
-    gint  shm_fd;
+    gint   pid;
+    gchar *shm_handle = shm->shm_handle;
+    gint   shm_fd;
 
     /* Our shared memory id will be our process ID */
     pid = gimp_get_pid ();
 
     /* From the id, derive the file map name */
-    g_snprintf (shm_handle, sizeof (shm_handle), "/gimp-shm-%d", pid);
+    g_snprintf (shm_handle, sizeof (shm->shm_handle), "/gimp-shm-%d", pid);
 
     /* Create the file mapping into paging space */
     shm_fd = shm_open (shm_handle, O_RDWR | O_CREAT, 0600);
@@ -250,6 +263,115 @@ gimp_plug_in_shm_new (void)
   return shm;
 }
 
+/*  creates a separate segment of @size bytes which holds a copy of a
+ *  drawable for a single plug-in.  the plug-in attaches to it using
+ *  the returned segment's ID, and keeps it after the segment is freed
+ *  by the core.  returns NULL if no such segment can be created, or if
+ *  @size exceeds MAX_STORE_SIZE.
+ */
+GimpPlugInShm *
+gimp_plug_in_shm_new_store (GimpPlugInShm *shm,
+                            gsize          size)
+{
+  GimpPlugInShm *store;
+
+  g_return_val_if_fail (shm != NULL, NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  if (size > MAX_STORE_SIZE)
+    {
+      GIMP_LOG (SHM, "not creating a store of %" G_GSIZE_FORMAT " bytes, "
+                "the maximum is %" G_GSIZE_FORMAT, size, MAX_STORE_SIZE);
+
+      return NULL;
+    }
+
+  store = g_slice_new0 (GimpPlugInShm);
+
+  store->shm_id   = -1;
+  store->shm_size = size;
+
+#if defined(USE_SYSV_SHM)
+
+  store->shm_id = shmget (IPC_PRIVATE, size, IPC_CREAT | 0600);
+
+  if (store->shm_id != -1)
+    {
+      store->shm_addr = (guchar *) shmat (store->shm_id, NULL, 0);
+
+      if (store->shm_addr == (guchar *) -1)
+        {
+          shmctl (store->shm_id, IPC_RMID, NULL);
+          store->shm_id = -1;
+        }
+
+#ifdef IPC_RMID_DEFERRED_RELEASE
+      if (store->shm_addr != (guchar *) -1)
+        shmctl (store->shm_id, IPC_RMID, NULL);
+#endif
+    }
+
+#elif defined(USE_POSIX_SHM)
+
+  {
+    static gint  store_serial = 0;
+    gchar       *shm_handle   = store->shm_handle;
+    gint         shm_fd;
+
+    /*  the stores are named after the main segment, which is the one
+     *  the plug-in knows about
+     */
+    g_snprintf (shm_handle, sizeof (store->shm_handle), "/gimp-shm-%d-%d",
+                shm->shm_id, ++store_serial);
+
+    shm_fd = shm_open (shm_handle, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if (shm_fd != -1)
+      {
+        /*  tmpfs only allocates the pages when they are first
+         *  written, and a full /dev/shm then raises SIGBUS instead of
+         *  failing.  reserve all of the space now, so that we can
+         *  fall back to the tile transport instead
+         */
+#ifdef HAVE_POSIX_FALLOCATE
+        if (posix_fallocate (shm_fd, 0, size) == 0)
+#else
+        if (ftruncate (shm_fd, size) != -1)
+#endif
+          {
+            store->shm_addr = (guchar *) mmap (NULL, size,
+                                               PROT_READ | PROT_WRITE,
+                                               MAP_SHARED, shm_fd, 0);
+
+            if (store->shm_addr != MAP_FAILED)
+              store->shm_id = store_serial;
+          }
+
+        if (store->shm_id == -1)
+          shm_unlink (shm_handle);
+
+        close (shm_fd);
+      }
+  }
+
+#endif
+
+  if (store->shm_id == -1)
+    {
+      GIMP_LOG (SHM, "could not create a store of %" G_GSIZE_FORMAT " bytes",
+                size);
+
+      g_slice_free (GimpPlugInShm, store);
+      store = NULL;
+    }
+  else
+    {
+      GIMP_LOG (SHM, "created store segment ID = %d", store->shm_id);
+    }
+
+  return store;
+}
+
 void
 gimp_plug_in_shm_free (GimpPlugInShm *shm)
 {
@@ -273,14 +395,9 @@ gimp_plug_in_shm_free (GimpPlugInShm *shm)
 
 #elif defined(USE_POSIX_SHM)
 
-      gchar shm_handle[32];
-
-      munmap (shm->shm_addr, TILE_MAP_SIZE);
-
-      g_snprintf (shm_handle, sizeof (shm_handle), "/gimp-shm-%d",
-                  shm->shm_id);
+      munmap (shm->shm_addr, shm->shm_size);
 
-      shm_unlink (shm_handle);
+      shm_unlink (shm->shm_handle);
 
 #endif
 
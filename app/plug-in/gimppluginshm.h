@@ -20,8 +20,10 @@
 #pragma once
 
 
-GimpPlugInShm * gimp_plug_in_shm_new      (void);
-void            gimp_plug_in_shm_free     (GimpPlugInShm *shm);
+GimpPlugInShm * gimp_plug_in_shm_new       (void);
+GimpPlugInShm * gimp_plug_in_shm_new_store (GimpPlugInShm *shm,
+                                            gsize          size);
+void            gimp_plug_in_shm_free      (GimpPlugInShm *shm);
 
-gint            gimp_plug_in_shm_get_id   (GimpPlugInShm *shm);
-guchar        * gimp_plug_in_shm_get_addr (GimpPlugInShm *shm);
+gint            gimp_plug_in_shm_get_id    (GimpPlugInShm *shm);
+guchar        * gimp_plug_in_shm_get_addr  (GimpPlugInShm *shm);
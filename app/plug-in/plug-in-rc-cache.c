@@ -0,0 +1,1104 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * plug-in-rc-cache.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpconfig/gimpconfig.h"
+
+#include "libgimp/gimpgpparams.h"
+
+#include "plug-in-types.h"
+
+#include "gimpplugindef.h"
+#include "gimppluginprocedure.h"
+#include "plug-in-rc-cache.h"
+
+#include "gimp-intl.h"
+
+
+/*  The pluginrc cache holds the same information as the text pluginrc
+ *  in a single serialized GVariant, which is mapped into memory. Only
+ *  the index of plug-in paths is read when the cache is opened; a
+ *  plug-in's procedures and their arguments are deserialized when the
+ *  plug-in is looked up, so entries of plug-ins which changed or are
+ *  gone are never decoded.
+ *
+ *  The cache is only used together with the very pluginrc it was
+ *  written along with, the text file stays the reference.
+ */
+
+#define PLUG_IN_RC_CACHE_MAGIC   0x47505243  /* "GPRC" */
+#define PLUG_IN_RC_CACHE_VERSION 1
+
+#define PROC_ARG_TYPE    "(ussssmsuv)"
+#define PROC_DEF_TYPE    "(si"           /* name, proc type                  */ \
+                         "msmsmsmsmsms"  /* blurb ... date, menu label       */ \
+                         "as"            /* menu paths                       */ \
+                         "iiay"          /* icon                             */ \
+                         "msib"          /* image types, sensitivity, file   */ \
+                         "msmsmsayi"     /* extensions ... priority          */ \
+                         "msbbbms"       /* mime types ... thumb loader      */ \
+                         "ms"            /* batch interpreter                */ \
+                         "a" PROC_ARG_TYPE                                      \
+                         "a" PROC_ARG_TYPE ")"
+#define PLUG_IN_DEF_TYPE "(sxmsmsbba" PROC_DEF_TYPE ")"
+#define CACHE_TYPE       "(uuutta" PLUG_IN_DEF_TYPE ")"
+
+
+struct _PlugInRcCache
+{
+  GMappedFile *mapped_file;
+  GVariant    *cache;
+  GVariant    *plug_in_defs;
+  GHashTable  *index;     /*  config path -> index + 1  */
+  guint8      *used;
+  gint         n_unused;
+};
+
+
+static gboolean              plug_in_rc_cache_get_stamp       (GFile         *pluginrc,
+                                                               guint64       *mtime,
+                                                               guint64       *size,
+                                                               GError       **error);
+static const gchar         * plug_in_rc_cache_get_meta_type   (GPParamDefType  param_def_type);
+
+static GimpPlugInDef       * plug_in_rc_cache_deserialize_def (GVariant      *variant);
+static GimpPlugInProcedure * plug_in_rc_cache_deserialize_proc
+                                                              (GVariant      *variant,
+                                                               GFile         *file);
+static gboolean              plug_in_rc_cache_deserialize_args
+                                                              (GVariant      *variant,
+                                                               gsize          index,
+                                                               GimpProcedure *procedure,
+                                                               gboolean       return_values);
+static GParamSpec          * plug_in_rc_cache_deserialize_arg (GVariant      *variant);
+
+static GVariant            * plug_in_rc_cache_serialize_def   (GimpPlugInDef *plug_in_def,
+                                                               const gchar   *path);
+static GVariant            * plug_in_rc_cache_serialize_proc  (GimpPlugInProcedure *proc);
+static GVariant            * plug_in_rc_cache_serialize_arg   (GParamSpec    *pspec);
+
+
+/*  public functions  */
+
+PlugInRcCache *
+plug_in_rc_cache_open (GFile   *file,
+                       GFile   *pluginrc,
+                       GError **error)
+{
+  PlugInRcCache *cache;
+  GMappedFile   *mapped_file;
+  GBytes        *bytes;
+  GVariant      *variant;
+  gchar         *path;
+  guint32        magic;
+  guint32        protocol_version;
+  guint32        cache_version;
+  guint64        rc_mtime;
+  guint64        rc_size;
+  guint64        mtime;
+  guint64        size;
+  gsize          n_plug_in_defs;
+  gsize          i;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (G_IS_FILE (pluginrc), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (! plug_in_rc_cache_get_stamp (pluginrc, &rc_mtime, &rc_size, error))
+    return NULL;
+
+  path = g_file_get_path (file);
+  mapped_file = g_mapped_file_new (path, FALSE, error);
+  g_free (path);
+
+  if (! mapped_file)
+    return NULL;
+
+  /*  the data is not trusted, GVariant checks it lazily on access  */
+  bytes   = g_mapped_file_get_bytes (mapped_file);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE),
+                                                          bytes, FALSE));
+  g_bytes_unref (bytes);
+
+  g_variant_get_child (variant, 0, "u", &magic);
+  g_variant_get_child (variant, 1, "u", &protocol_version);
+  g_variant_get_child (variant, 2, "u", &cache_version);
+  g_variant_get_child (variant, 3, "t", &mtime);
+  g_variant_get_child (variant, 4, "t", &size);
+
+  if (magic            != PLUG_IN_RC_CACHE_MAGIC   ||
+      protocol_version != GIMP_PROTOCOL_VERSION    ||
+      cache_version    != PLUG_IN_RC_CACHE_VERSION ||
+      mtime            != rc_mtime                 ||
+      size             != rc_size)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_VERSION,
+                   _("Skipping '%s': out of date."),
+                   gimp_file_get_utf8_name (file));
+
+      g_variant_unref (variant);
+      g_mapped_file_unref (mapped_file);
+
+      return NULL;
+    }
+
+  cache = g_slice_new0 (PlugInRcCache);
+
+  cache->mapped_file  = mapped_file;
+  cache->cache        = variant;
+  cache->plug_in_defs = g_variant_get_child_value (variant, 5);
+  cache->index        = g_hash_table_new (g_str_hash, g_str_equal);
+
+  n_plug_in_defs = g_variant_n_children (cache->plug_in_defs);
+
+  cache->used     = g_new0 (guint8, n_plug_in_defs);
+  cache->n_unused = n_plug_in_defs;
+
+  for (i = 0; i < n_plug_in_defs; i++)
+    {
+      GVariant    *plug_in_def;
+      const gchar *def_path;
+
+      plug_in_def = g_variant_get_child_value (cache->plug_in_defs, i);
+
+      /*  the string points into the mapped file  */
+      g_variant_get_child (plug_in_def, 0, "&s", &def_path);
+      g_hash_table_insert (cache->index,
+                           (gpointer) def_path, GSIZE_TO_POINTER (i + 1));
+
+      g_variant_unref (plug_in_def);
+    }
+
+  return cache;
+}
+
+void
+plug_in_rc_cache_free (PlugInRcCache *cache)
+{
+  g_return_if_fail (cache != NULL);
+
+  g_hash_table_unref (cache->index);
+  g_free (cache->used);
+  g_variant_unref (cache->plug_in_defs);
+  g_variant_unref (cache->cache);
+  g_mapped_file_unref (cache->mapped_file);
+
+  g_slice_free (PlugInRcCache, cache);
+}
+
+/*  returns the cached plug-in def of @file, if it was cached for the
+ *  same @mtime
+ */
+GimpPlugInDef *
+plug_in_rc_cache_lookup (PlugInRcCache *cache,
+                         GFile         *file,
+                         gint64         mtime)
+{
+  GimpPlugInDef *plug_in_def = NULL;
+  GVariant      *variant;
+  gchar         *path;
+  gint64         def_mtime;
+  gsize          i;
+
+  g_return_val_if_fail (cache != NULL, NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  path = gimp_file_get_config_path (file, NULL);
+
+  if (! path)
+    return NULL;
+
+  i = GPOINTER_TO_SIZE (g_hash_table_lookup (cache->index, path));
+  g_free (path);
+
+  if (i == 0)
+    return NULL;
+
+  i--;
+
+  if (! cache->used[i])
+    {
+      cache->used[i] = TRUE;
+      cache->n_unused--;
+    }
+
+  variant = g_variant_get_child_value (cache->plug_in_defs, i);
+
+  g_variant_get_child (variant, 1, "x", &def_mtime);
+
+  if (def_mtime == mtime)
+    plug_in_def = plug_in_rc_cache_deserialize_def (variant);
+
+  g_variant_unref (variant);
+
+  return plug_in_def;
+}
+
+/*  returns the number of cached plug-ins which were never looked up  */
+gint
+plug_in_rc_cache_get_n_unused (PlugInRcCache *cache)
+{
+  g_return_val_if_fail (cache != NULL, 0);
+
+  return cache->n_unused;
+}
+
+gboolean
+plug_in_rc_cache_write (GSList  *plug_in_defs,
+                        GFile   *file,
+                        GFile   *pluginrc,
+                        GError **error)
+{
+  GVariantBuilder  builder;
+  GVariant        *variant;
+  GSList          *list;
+  guint64          rc_mtime;
+  guint64          rc_size;
+  gboolean         success;
+
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (G_IS_FILE (pluginrc), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (! plug_in_rc_cache_get_stamp (pluginrc, &rc_mtime, &rc_size, error))
+    return FALSE;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (CACHE_TYPE));
+
+  g_variant_builder_add (&builder, "u", PLUG_IN_RC_CACHE_MAGIC);
+  g_variant_builder_add (&builder, "u", GIMP_PROTOCOL_VERSION);
+  g_variant_builder_add (&builder, "u", PLUG_IN_RC_CACHE_VERSION);
+  g_variant_builder_add (&builder, "t", rc_mtime);
+  g_variant_builder_add (&builder, "t", rc_size);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a" PLUG_IN_DEF_TYPE));
+
+  for (list = plug_in_defs; list; list = list->next)
+    {
+      GimpPlugInDef *plug_in_def = list->data;
+      gchar         *path;
+
+      if (! plug_in_def->procedures)
+        continue;
+
+      path = gimp_file_get_config_path (plug_in_def->file, NULL);
+      if (! path)
+        continue;
+
+      g_variant_builder_add_value (&builder,
+                                   plug_in_rc_cache_serialize_def (plug_in_def,
+                                                                   path));
+      g_free (path);
+    }
+
+  g_variant_builder_close (&builder);
+
+  variant = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  success = g_file_replace_contents (file,
+                                     g_variant_get_data (variant),
+                                     g_variant_get_size (variant),
+                                     NULL, FALSE, G_FILE_CREATE_NONE,
+                                     NULL, NULL, error);
+
+  g_variant_unref (variant);
+
+  return success;
+}
+
+
+/*  private functions  */
+
+static gboolean
+plug_in_rc_cache_get_stamp (GFile    *pluginrc,
+                            guint64  *mtime,
+                            guint64  *size,
+                            GError  **error)
+{
+  GFileInfo *info;
+
+  info = g_file_query_info (pluginrc,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL, error);
+
+  if (! info)
+    return FALSE;
+
+  *mtime = (g_file_info_get_attribute_uint64 (info,
+                                              G_FILE_ATTRIBUTE_TIME_MODIFIED) *
+            G_USEC_PER_SEC +
+            g_file_info_get_attribute_uint32 (info,
+                                              G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC));
+  *size  = g_file_info_get_size (info);
+
+  g_object_unref (info);
+
+  return TRUE;
+}
+
+static const gchar *
+plug_in_rc_cache_get_meta_type (GPParamDefType param_def_type)
+{
+  switch (param_def_type)
+    {
+    case GP_PARAM_DEF_TYPE_DEFAULT:
+    case GP_PARAM_DEF_TYPE_EXPORT_OPTIONS:
+      return "()";
+
+    case GP_PARAM_DEF_TYPE_INT:
+      return "(xxx)";
+
+    case GP_PARAM_DEF_TYPE_UNIT:
+    case GP_PARAM_DEF_TYPE_RESOURCE:
+      return "(iii)";
+
+    case GP_PARAM_DEF_TYPE_ENUM:
+    case GP_PARAM_DEF_TYPE_BOOLEAN:
+    case GP_PARAM_DEF_TYPE_ID:
+      return "(i)";
+
+    case GP_PARAM_DEF_TYPE_CHOICE:
+      return "(msa(simsms))";
+
+    case GP_PARAM_DEF_TYPE_DOUBLE:
+      return "(ddd)";
+
+    case GP_PARAM_DEF_TYPE_STRING:
+    case GP_PARAM_DEF_TYPE_ID_ARRAY:
+      return "(ms)";
+
+    case GP_PARAM_DEF_TYPE_GEGL_COLOR:
+      return "(im(aysay))";
+
+    case GP_PARAM_DEF_TYPE_FILE:
+      return "(iims)";
+    }
+
+  return NULL;
+}
+
+
+/*  deserialize functions  */
+
+static gchar *
+plug_in_rc_cache_dup_string (GVariant *variant,
+                             gsize     index)
+{
+  const gchar *str;
+
+  g_variant_get_child (variant, index, "&ms", &str);
+
+  return g_strdup (str);
+}
+
+static GimpPlugInDef *
+plug_in_rc_cache_deserialize_def (GVariant *variant)
+{
+  GimpPlugInDef *plug_in_def;
+  GFile         *file;
+  GVariant      *procs;
+  const gchar   *path;
+  const gchar   *help_domain_name;
+  const gchar   *help_domain_uri;
+  gint64         mtime;
+  gboolean       has_init;
+  gboolean       reusable;
+  gsize          n_procs;
+  gsize          i;
+
+  g_variant_get (variant, "(&sx&ms&msbb@a" PROC_DEF_TYPE ")",
+                 &path, &mtime,
+                 &help_domain_name, &help_domain_uri,
+                 &has_init, &reusable,
+                 &procs);
+
+  file = gimp_file_new_for_config_path (path, NULL);
+
+  if (! file)
+    {
+      g_variant_unref (procs);
+      return NULL;
+    }
+
+  plug_in_def = gimp_plug_in_def_new (file);
+  g_object_unref (file);
+
+  plug_in_def->mtime = mtime;
+
+  n_procs = g_variant_n_children (procs);
+
+  for (i = 0; i < n_procs; i++)
+    {
+      GimpPlugInProcedure *proc;
+      GVariant            *proc_variant;
+
+      proc_variant = g_variant_get_child_value (procs, i);
+      proc = plug_in_rc_cache_deserialize_proc (proc_variant,
+                                                plug_in_def->file);
+      g_variant_unref (proc_variant);
+
+      if (! proc)
+        {
+          g_variant_unref (procs);
+          g_object_unref (plug_in_def);
+
+          return NULL;
+        }
+
+      gimp_plug_in_def_add_procedure (plug_in_def, proc);
+      g_object_unref (proc);
+    }
+
+  g_variant_unref (procs);
+
+  if (help_domain_name)
+    gimp_plug_in_def_set_help_domain (plug_in_def,
+                                      help_domain_name, help_domain_uri);
+
+  gimp_plug_in_def_set_has_init (plug_in_def, has_init);
+  gimp_plug_in_def_set_reusable (plug_in_def, reusable);
+
+  return plug_in_def;
+}
+
+static GimpPlugInProcedure *
+plug_in_rc_cache_deserialize_proc (GVariant *variant,
+                                   GFile    *file)
+{
+  GimpProcedure       *procedure;
+  GimpPlugInProcedure *proc;
+  GVariant            *child;
+  GVariantIter         iter;
+  const gchar         *name;
+  const gchar         *str;
+  gchar               *menu_path;
+  guint8              *icon_data;
+  gint32               proc_type;
+  gint32               icon_type;
+  gint32               icon_data_length;
+  gint32               sensitivity_mask;
+  gboolean             file_proc;
+
+  g_variant_get_child (variant, 0, "&s", &name);
+  g_variant_get_child (variant, 1, "i",  &proc_type);
+
+  if (! *name ||
+      (proc_type != GIMP_PDB_PROC_TYPE_PLUGIN &&
+       proc_type != GIMP_PDB_PROC_TYPE_PERSISTENT))
+    return NULL;
+
+  procedure = gimp_plug_in_procedure_new (proc_type, file);
+  proc      = GIMP_PLUG_IN_PROCEDURE (procedure);
+
+  gimp_object_set_name (GIMP_OBJECT (procedure), name);
+
+  procedure->blurb     = plug_in_rc_cache_dup_string (variant, 2);
+  procedure->help      = plug_in_rc_cache_dup_string (variant, 3);
+  procedure->authors   = plug_in_rc_cache_dup_string (variant, 4);
+  procedure->copyright = plug_in_rc_cache_dup_string (variant, 5);
+  procedure->date      = plug_in_rc_cache_dup_string (variant, 6);
+  proc->menu_label     = plug_in_rc_cache_dup_string (variant, 7);
+
+  child = g_variant_get_child_value (variant, 8);
+  g_variant_iter_init (&iter, child);
+  while (g_variant_iter_next (&iter, "s", &menu_path))
+    proc->menu_paths = g_list_append (proc->menu_paths, menu_path);
+  g_variant_unref (child);
+
+  g_variant_get_child (variant, 9,  "i", &icon_type);
+  g_variant_get_child (variant, 10, "i", &icon_data_length);
+
+  child = g_variant_get_child_value (variant, 11);
+
+  switch (icon_type)
+    {
+    case GIMP_ICON_TYPE_ICON_NAME:
+    case GIMP_ICON_TYPE_IMAGE_FILE:
+      icon_data_length = -1;
+      icon_data        = NULL;
+
+      if (g_variant_n_children (child) > 0)
+        icon_data = (guint8 *) g_variant_dup_bytestring (child, NULL);
+      break;
+
+    case GIMP_ICON_TYPE_PIXBUF:
+      {
+        gconstpointer data;
+        gsize         size;
+
+        data = g_variant_get_fixed_array (child, &size, 1);
+
+        icon_data_length = size;
+        icon_data        = g_memdup2 (data, size);
+      }
+      break;
+
+    default:
+      g_variant_unref (child);
+      g_object_unref (proc);
+      return NULL;
+    }
+
+  g_variant_unref (child);
+
+  gimp_plug_in_procedure_take_icon (proc, icon_type,
+                                    icon_data, icon_data_length,
+                                    NULL);
+
+  g_variant_get_child (variant, 12, "&ms", &str);
+  gimp_plug_in_procedure_set_image_types (proc, str);
+
+  g_variant_get_child (variant, 13, "i", &sensitivity_mask);
+  gimp_plug_in_procedure_set_sensitivity_mask (proc, sensitivity_mask);
+
+  g_variant_get_child (variant, 14, "b", &file_proc);
+
+  if (file_proc)
+    {
+      gint32   priority;
+      gboolean handles_remote;
+      gboolean handles_raw;
+      gboolean handles_vector;
+
+      proc->file_proc = TRUE;
+
+      proc->extensions      = plug_in_rc_cache_dup_string (variant, 15);
+      proc->meta_extensions = plug_in_rc_cache_dup_string (variant, 16);
+      proc->prefixes        = plug_in_rc_cache_dup_string (variant, 17);
+
+      g_variant_get_child (variant, 18, "^&ay", &str);
+      if (*str)
+        proc->magics = g_strdup (str);
+
+      g_variant_get_child (variant, 19, "i", &priority);
+      gimp_plug_in_procedure_set_priority (proc, priority);
+
+      g_variant_get_child (variant, 20, "&ms", &str);
+      if (str)
+        gimp_plug_in_procedure_set_mime_types (proc, str);
+
+      g_variant_get_child (variant, 21, "b", &handles_remote);
+      g_variant_get_child (variant, 22, "b", &handles_raw);
+      g_variant_get_child (variant, 23, "b", &handles_vector);
+
+      if (handles_remote)
+        gimp_plug_in_procedure_set_handles_remote (proc);
+      if (handles_raw)
+        gimp_plug_in_procedure_set_handles_raw (proc);
+      if (handles_vector)
+        gimp_plug_in_procedure_set_handles_vector (proc);
+
+      g_variant_get_child (variant, 24, "&ms", &str);
+      if (str)
+        gimp_plug_in_procedure_set_thumb_loader (proc, str);
+    }
+  else
+    {
+      g_variant_get_child (variant, 25, "&ms", &str);
+      if (str)
+        gimp_plug_in_procedure_set_batch_interpreter (proc, str);
+    }
+
+  if (! plug_in_rc_cache_deserialize_args (variant, 26, procedure, FALSE) ||
+      ! plug_in_rc_cache_deserialize_args (variant, 27, procedure, TRUE))
+    {
+      g_object_unref (proc);
+      return NULL;
+    }
+
+  return proc;
+}
+
+static gboolean
+plug_in_rc_cache_deserialize_args (GVariant      *variant,
+                                   gsize          index,
+                                   GimpProcedure *procedure,
+                                   gboolean       return_values)
+{
+  GVariant *args;
+  gsize     n_args;
+  gsize     i;
+
+  args   = g_variant_get_child_value (variant, index);
+  n_args = g_variant_n_children (args);
+
+  for (i = 0; i < n_args; i++)
+    {
+      GVariant   *arg;
+      GParamSpec *pspec;
+
+      arg   = g_variant_get_child_value (args, i);
+      pspec = plug_in_rc_cache_deserialize_arg (arg);
+      g_variant_unref (arg);
+
+      if (! pspec)
+        {
+          g_variant_unref (args);
+          return FALSE;
+        }
+
+      if (return_values)
+        gimp_procedure_add_return_value (procedure, pspec);
+      else
+        gimp_procedure_add_argument (procedure, pspec);
+    }
+
+  g_variant_unref (args);
+
+  return TRUE;
+}
+
+static GParamSpec *
+plug_in_rc_cache_deserialize_arg (GVariant *variant)
+{
+  GPParamDef    param_def     = { 0, };
+  GPParamColor  default_color = { 0, };
+  GParamSpec   *pspec         = NULL;
+  GVariant     *meta;
+  const gchar  *meta_type;
+  guint32       param_def_type;
+
+  g_variant_get (variant, "(u&s&s&s&s&msuv)",
+                 &param_def_type,
+                 &param_def.type_name,
+                 &param_def.value_type_name,
+                 &param_def.name,
+                 &param_def.nick,
+                 &param_def.blurb,
+                 &param_def.flags,
+                 &meta);
+
+  param_def.param_def_type = param_def_type;
+
+  meta_type = plug_in_rc_cache_get_meta_type (param_def.param_def_type);
+
+  if (! meta_type || ! g_variant_is_of_type (meta, G_VARIANT_TYPE (meta_type)))
+    {
+      g_variant_unref (meta);
+      return NULL;
+    }
+
+  switch (param_def.param_def_type)
+    {
+    case GP_PARAM_DEF_TYPE_DEFAULT:
+    case GP_PARAM_DEF_TYPE_EXPORT_OPTIONS:
+      break;
+
+    case GP_PARAM_DEF_TYPE_INT:
+      g_variant_get (meta, "(xxx)",
+                     &param_def.meta.m_int.min_val,
+                     &param_def.meta.m_int.max_val,
+                     &param_def.meta.m_int.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_UNIT:
+      g_variant_get (meta, "(iii)",
+                     &param_def.meta.m_unit.allow_pixels,
+                     &param_def.meta.m_unit.allow_percent,
+                     &param_def.meta.m_unit.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ENUM:
+      g_variant_get (meta, "(i)", &param_def.meta.m_enum.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_CHOICE:
+      {
+        GVariant     *choices;
+        GVariantIter  iter;
+        const gchar  *nick;
+        const gchar  *label;
+        const gchar  *help;
+        gint32        id;
+
+        g_variant_get (meta, "(&ms@a(simsms))",
+                       &param_def.meta.m_choice.default_val, &choices);
+
+        param_def.meta.m_choice.choice = gimp_choice_new ();
+
+        g_variant_iter_init (&iter, choices);
+        while (g_variant_iter_next (&iter, "(&si&ms&ms)",
+                                    &nick, &id, &label, &help))
+          gimp_choice_add (param_def.meta.m_choice.choice,
+                           nick, id, label, help);
+
+        g_variant_unref (choices);
+      }
+      break;
+
+    case GP_PARAM_DEF_TYPE_BOOLEAN:
+      g_variant_get (meta, "(i)", &param_def.meta.m_boolean.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_DOUBLE:
+      g_variant_get (meta, "(ddd)",
+                     &param_def.meta.m_double.min_val,
+                     &param_def.meta.m_double.max_val,
+                     &param_def.meta.m_double.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_STRING:
+      g_variant_get (meta, "(&ms)", &param_def.meta.m_string.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_GEGL_COLOR:
+      {
+        GVariant *maybe;
+        GVariant *color;
+
+        g_variant_get (meta, "(i@m(aysay))",
+                       &param_def.meta.m_gegl_color.has_alpha, &maybe);
+
+        color = g_variant_get_maybe (maybe);
+
+        if (color)
+          {
+            GVariant      *data;
+            GVariant      *profile;
+            gconstpointer  bytes;
+            gsize          size;
+
+            /*  all pointers point into the mapped file  */
+            g_variant_get (color, "(@ay&s@ay)",
+                           &data, &default_color.format.encoding, &profile);
+
+            bytes = g_variant_get_fixed_array (data, &size, 1);
+
+            if (size > 0 && size <= sizeof (default_color.data))
+              {
+                memcpy (default_color.data, bytes, size);
+                default_color.size = size;
+
+                default_color.format.profile_data =
+                  (guint8 *) g_variant_get_fixed_array (profile, &size, 1);
+                default_color.format.profile_size = size;
+
+                param_def.meta.m_gegl_color.default_val = &default_color;
+              }
+
+            g_variant_unref (data);
+            g_variant_unref (profile);
+            g_variant_unref (color);
+          }
+
+        g_variant_unref (maybe);
+      }
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID:
+      g_variant_get (meta, "(i)", &param_def.meta.m_id.none_ok);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID_ARRAY:
+      g_variant_get (meta, "(&ms)", &param_def.meta.m_id_array.type_name);
+      break;
+
+    case GP_PARAM_DEF_TYPE_RESOURCE:
+      g_variant_get (meta, "(iii)",
+                     &param_def.meta.m_resource.none_ok,
+                     &param_def.meta.m_resource.default_to_context,
+                     &param_def.meta.m_resource.default_resource_id);
+      break;
+
+    case GP_PARAM_DEF_TYPE_FILE:
+      g_variant_get (meta, "(ii&ms)",
+                     &param_def.meta.m_file.action,
+                     &param_def.meta.m_file.none_ok,
+                     &param_def.meta.m_file.default_uri);
+      break;
+    }
+
+  pspec = _gimp_gp_param_def_to_param_spec (&param_def);
+
+  if (param_def.param_def_type == GP_PARAM_DEF_TYPE_CHOICE)
+    g_clear_object (&param_def.meta.m_choice.choice);
+
+  g_variant_unref (meta);
+
+  return pspec;
+}
+
+
+/*  serialize functions  */
+
+static GVariant *
+plug_in_rc_cache_serialize_def (GimpPlugInDef *plug_in_def,
+                                const gchar   *path)
+{
+  GVariantBuilder  builder;
+  GSList          *list;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (PLUG_IN_DEF_TYPE));
+
+  g_variant_builder_add (&builder, "s",  path);
+  g_variant_builder_add (&builder, "x",  plug_in_def->mtime);
+  g_variant_builder_add (&builder, "ms", plug_in_def->help_domain_name);
+  g_variant_builder_add (&builder, "ms", plug_in_def->help_domain_uri);
+  g_variant_builder_add (&builder, "b",  plug_in_def->has_init);
+  g_variant_builder_add (&builder, "b",  plug_in_def->reusable);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a" PROC_DEF_TYPE));
+
+  for (list = plug_in_def->procedures; list; list = list->next)
+    {
+      GimpPlugInProcedure *proc = list->data;
+
+      if (proc->installed_during_init)
+        continue;
+
+      g_variant_builder_add_value (&builder,
+                                   plug_in_rc_cache_serialize_proc (proc));
+    }
+
+  g_variant_builder_close (&builder);
+
+  return g_variant_builder_end (&builder);
+}
+
+static const gchar *
+plug_in_rc_cache_non_empty (const gchar *str)
+{
+  return (str && *str) ? str : NULL;
+}
+
+static GVariant *
+plug_in_rc_cache_serialize_proc (GimpPlugInProcedure *proc)
+{
+  GimpProcedure   *procedure = GIMP_PROCEDURE (proc);
+  GVariantBuilder  builder;
+  GVariant        *icon_data;
+  GList           *list;
+  gint             i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (PROC_DEF_TYPE));
+
+  g_variant_builder_add (&builder, "s",  gimp_object_get_name (procedure));
+  g_variant_builder_add (&builder, "i",  procedure->proc_type);
+  g_variant_builder_add (&builder, "ms", procedure->blurb);
+  g_variant_builder_add (&builder, "ms", procedure->help);
+  g_variant_builder_add (&builder, "ms", procedure->authors);
+  g_variant_builder_add (&builder, "ms", procedure->copyright);
+  g_variant_builder_add (&builder, "ms", procedure->date);
+  g_variant_builder_add (&builder, "ms", proc->menu_label);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_STRING_ARRAY);
+  for (list = proc->menu_paths; list; list = list->next)
+    g_variant_builder_add (&builder, "s", list->data);
+  g_variant_builder_close (&builder);
+
+  if (proc->icon_type == GIMP_ICON_TYPE_PIXBUF)
+    icon_data = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+                                           proc->icon_data,
+                                           MAX (proc->icon_data_length, 0),
+                                           1);
+  else if (proc->icon_data)
+    icon_data = g_variant_new_bytestring ((const gchar *) proc->icon_data);
+  else
+    icon_data = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, NULL, 0, 1);
+
+  g_variant_builder_add (&builder, "i", proc->icon_type);
+  g_variant_builder_add (&builder, "i", proc->icon_data_length);
+  g_variant_builder_add_value (&builder, icon_data);
+
+  g_variant_builder_add (&builder, "ms", proc->image_types);
+  g_variant_builder_add (&builder, "i",  proc->sensitivity_mask);
+  g_variant_builder_add (&builder, "b",  proc->file_proc);
+
+  g_variant_builder_add (&builder, "ms",
+                         plug_in_rc_cache_non_empty (proc->extensions));
+  g_variant_builder_add (&builder, "ms",
+                         plug_in_rc_cache_non_empty (proc->meta_extensions));
+  g_variant_builder_add (&builder, "ms",
+                         plug_in_rc_cache_non_empty (proc->prefixes));
+  g_variant_builder_add (&builder, "^ay",
+                         proc->magics ? proc->magics : "");
+  g_variant_builder_add (&builder, "i", proc->priority);
+  g_variant_builder_add (&builder, "ms",
+                         plug_in_rc_cache_non_empty (proc->mime_types));
+  g_variant_builder_add (&builder, "b", proc->handles_remote);
+  g_variant_builder_add (&builder, "b",
+                         proc->handles_raw && ! proc->image_types);
+  g_variant_builder_add (&builder, "b", proc->handles_vector);
+  g_variant_builder_add (&builder, "ms", proc->thumb_loader);
+  g_variant_builder_add (&builder, "ms",
+                         proc->batch_interpreter ?
+                         proc->batch_interpreter_name : NULL);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a" PROC_ARG_TYPE));
+  for (i = 0; i < procedure->num_args; i++)
+    g_variant_builder_add_value (&builder,
+                                 plug_in_rc_cache_serialize_arg (procedure->args[i]));
+  g_variant_builder_close (&builder);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a" PROC_ARG_TYPE));
+  for (i = 0; i < procedure->num_values; i++)
+    g_variant_builder_add_value (&builder,
+                                 plug_in_rc_cache_serialize_arg (procedure->values[i]));
+  g_variant_builder_close (&builder);
+
+  return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+plug_in_rc_cache_serialize_arg (GParamSpec *pspec)
+{
+  GPParamDef  param_def = { 0, };
+  GVariant   *meta      = NULL;
+
+  _gimp_param_spec_to_gp_param_def (pspec, &param_def, FALSE);
+
+  switch (param_def.param_def_type)
+    {
+    case GP_PARAM_DEF_TYPE_DEFAULT:
+    case GP_PARAM_DEF_TYPE_EXPORT_OPTIONS:
+      meta = g_variant_new ("()");
+      break;
+
+    case GP_PARAM_DEF_TYPE_INT:
+      meta = g_variant_new ("(xxx)",
+                            param_def.meta.m_int.min_val,
+                            param_def.meta.m_int.max_val,
+                            param_def.meta.m_int.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_UNIT:
+      meta = g_variant_new ("(iii)",
+                            param_def.meta.m_unit.allow_pixels,
+                            param_def.meta.m_unit.allow_percent,
+                            param_def.meta.m_unit.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ENUM:
+      meta = g_variant_new ("(i)", param_def.meta.m_enum.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_CHOICE:
+      {
+        GVariantBuilder  choices;
+        GList           *list;
+
+        g_variant_builder_init (&choices, G_VARIANT_TYPE ("a(simsms)"));
+
+        for (list = gimp_choice_list_nicks (param_def.meta.m_choice.choice);
+             list;
+             list = list->next)
+          {
+            const gchar *nick = list->data;
+            const gchar *label;
+            const gchar *help;
+
+            gimp_choice_get_documentation (param_def.meta.m_choice.choice,
+                                           nick, &label, &help);
+
+            g_variant_builder_add (&choices, "(simsms)",
+                                   nick,
+                                   gimp_choice_get_id (param_def.meta.m_choice.choice,
+                                                       nick),
+                                   label, help);
+          }
+
+        meta = g_variant_new ("(msa(simsms))",
+                              param_def.meta.m_choice.default_val,
+                              &choices);
+      }
+      break;
+
+    case GP_PARAM_DEF_TYPE_BOOLEAN:
+      meta = g_variant_new ("(i)", param_def.meta.m_boolean.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_DOUBLE:
+      meta = g_variant_new ("(ddd)",
+                            param_def.meta.m_double.min_val,
+                            param_def.meta.m_double.max_val,
+                            param_def.meta.m_double.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_STRING:
+      meta = g_variant_new ("(ms)", param_def.meta.m_string.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_GEGL_COLOR:
+      {
+        GPParamColor *color = param_def.meta.m_gegl_color.default_val;
+        GVariant     *value = NULL;
+
+        if (color && color->size > 0)
+          value = g_variant_new ("(@ays@ay)",
+                                 g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+                                                            color->data,
+                                                            color->size, 1),
+                                 color->format.encoding ?
+                                 color->format.encoding : "",
+                                 g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+                                                            color->format.profile_data,
+                                                            color->format.profile_size,
+                                                            1));
+
+        meta = g_variant_new ("(i@m(aysay))",
+                              param_def.meta.m_gegl_color.has_alpha,
+                              g_variant_new_maybe (G_VARIANT_TYPE ("(aysay)"),
+                                                   value));
+      }
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID:
+      meta = g_variant_new ("(i)", param_def.meta.m_id.none_ok);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID_ARRAY:
+      meta = g_variant_new ("(ms)", param_def.meta.m_id_array.type_name);
+      break;
+
+    case GP_PARAM_DEF_TYPE_RESOURCE:
+      meta = g_variant_new ("(iii)",
+                            param_def.meta.m_resource.none_ok,
+                            param_def.meta.m_resource.default_to_context,
+                            param_def.meta.m_resource.default_resource_id);
+      break;
+
+    case GP_PARAM_DEF_TYPE_FILE:
+      meta = g_variant_new ("(iims)",
+                            param_def.meta.m_file.action,
+                            param_def.meta.m_file.none_ok,
+                            param_def.meta.m_file.default_uri);
+      break;
+    }
+
+  return g_variant_new ("(ussssmsuv)",
+                        param_def.param_def_type,
+                        param_def.type_name,
+                        param_def.value_type_name,
+                        g_param_spec_get_name (pspec),
+                        g_param_spec_get_nick (pspec),
+                        g_param_spec_get_blurb (pspec),
+                        pspec->flags,
+                        meta);
+}
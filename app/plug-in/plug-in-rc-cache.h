@@ -0,0 +1,39 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * plug-in-rc-cache.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+
+typedef struct _PlugInRcCache PlugInRcCache;
+
+
+PlugInRcCache * plug_in_rc_cache_open         (GFile          *file,
+                                               GFile          *pluginrc,
+                                               GError        **error);
+void            plug_in_rc_cache_free         (PlugInRcCache  *cache);
+
+GimpPlugInDef * plug_in_rc_cache_lookup       (PlugInRcCache  *cache,
+                                               GFile          *file,
+                                               gint64          mtime);
+gint            plug_in_rc_cache_get_n_unused (PlugInRcCache  *cache);
+
+gboolean        plug_in_rc_cache_write        (GSList         *plug_in_defs,
+                                               GFile          *file,
+                                               GFile          *pluginrc,
+                                               GError        **error);
@@ -40,7 +40,7 @@
 #include "gimp-intl.h"
 
 
-#define PLUG_IN_RC_FILE_VERSION 15
+#define PLUG_IN_RC_FILE_VERSION 16
 
 
 /*
@@ -70,6 +70,8 @@ static GTokenType plug_in_help_def_deserialize   (GScanner             *scanner,
                                                   GimpPlugInDef        *plug_in_def);
 static GTokenType plug_in_has_init_deserialize   (GScanner             *scanner,
                                                   GimpPlugInDef        *plug_in_def);
+static GTokenType plug_in_reusable_deserialize   (GScanner             *scanner,
+                                                  GimpPlugInDef        *plug_in_def);
 
 
 enum
@@ -80,6 +82,7 @@ enum
   PROC_DEF,
   HELP_DEF,
   HAS_INIT,
+  REUSABLE,
   PROC_ARG,
   MENU_PATH,
   ICON,
@@ -137,6 +140,8 @@ plug_in_rc_parse (Gimp    *gimp,
                               "help-def", GINT_TO_POINTER (HELP_DEF));
   g_scanner_scope_add_symbol (scanner, PLUG_IN_DEF,
                               "has-init", GINT_TO_POINTER (HAS_INIT));
+  g_scanner_scope_add_symbol (scanner, PLUG_IN_DEF,
+                              "reusable", GINT_TO_POINTER (REUSABLE));
   g_scanner_scope_add_symbol (scanner, PLUG_IN_DEF,
                               "proc-arg", GINT_TO_POINTER (PROC_ARG));
   g_scanner_scope_add_symbol (scanner, PLUG_IN_DEF,
@@ -348,6 +353,10 @@ plug_in_def_deserialize (Gimp      *gimp,
               token = plug_in_has_init_deserialize (scanner, plug_in_def);
               break;
 
+            case REUSABLE:
+              token = plug_in_reusable_deserialize (scanner, plug_in_def);
+              break;
+
             default:
               break;
             }
@@ -1160,6 +1169,18 @@ plug_in_has_init_deserialize (GScanner      *scanner,
   return G_TOKEN_LEFT_PAREN;
 }
 
+static GTokenType
+plug_in_reusable_deserialize (GScanner      *scanner,
+                              GimpPlugInDef *plug_in_def)
+{
+  gimp_plug_in_def_set_reusable (plug_in_def, TRUE);
+
+  if (! gimp_scanner_parse_token (scanner, G_TOKEN_RIGHT_PAREN))
+    return G_TOKEN_RIGHT_PAREN;
+
+  return G_TOKEN_LEFT_PAREN;
+}
+
 
 /* serialize functions */
 
@@ -1572,6 +1593,12 @@ plug_in_rc_write (GSList  *plug_in_defs,
               gimp_config_writer_close (writer);
             }
 
+          if (plug_in_def->reusable)
+            {
+              gimp_config_writer_open (writer, "reusable");
+              gimp_config_writer_close (writer);
+            }
+
           gimp_config_writer_close (writer);
         }
     }
@@ -22,11 +22,15 @@
 
 #include "widgets/gimpuimanager.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "core/gimp.h"
 #include "core/gimpcontext.h"
 #include "core/gimpimage.h"
+#include "core/gimpimage-undo.h"
 #include "core/gimplayer.h"
 #include "core/gimplayer-new.h"
+#include "core/gimpundostack.h"
 
 #include "operations/gimplevelsconfig.h"
 
@@ -36,6 +40,7 @@
 
 
 #define GIMP_TEST_IMAGE_SIZE 100
+#define GIMP_TEST_N_LAYERS   10
 
 #define ADD_IMAGE_TEST(function) \
   g_test_add ("/gimp-core/" #function, \
@@ -225,6 +230,79 @@ remove_layer (GimpTestFixture *fixture,
   g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
 }
 
+/**
+ * remove_layers_frees_undo:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure that removed layers count towards the undo size, even
+ * though they are still attached to the image when their undo step is
+ * pushed, so that old undo steps are freed.
+ **/
+static void
+remove_layers_frees_undo (GimpTestFixture *fixture,
+                          gconstpointer    data)
+{
+  Gimp           *gimp   = GIMP (data);
+  GimpImage      *image  = fixture->image;
+  GimpUndoStack  *undo_stack;
+  GimpLayer      *layers[GIMP_TEST_N_LAYERS];
+  gint            old_undo_levels;
+  guint64         old_undo_size;
+  guint64         old_undo_swap_size;
+  guint64         undo_size;
+  gint            i;
+
+  g_object_get (gimp->config,
+                "undo-levels",    &old_undo_levels,
+                "undo-size",      &old_undo_size,
+                "undo-swap-size", &old_undo_swap_size,
+                NULL);
+
+  for (i = 0; i < GIMP_TEST_N_LAYERS; i++)
+    {
+      layers[i] = gimp_layer_new (image,
+                                  GIMP_TEST_IMAGE_SIZE,
+                                  GIMP_TEST_IMAGE_SIZE,
+                                  babl_format ("R'G'B'A u8"),
+                                  "Test Layer",
+                                  GIMP_OPACITY_OPAQUE,
+                                  GIMP_LAYER_MODE_NORMAL);
+
+      gimp_image_add_layer (image,
+                            layers[i],
+                            GIMP_IMAGE_ACTIVE_PARENT,
+                            0,
+                            FALSE);
+    }
+
+  /*  room for the undo steps of about three removed layers  */
+  undo_size = 3 * gimp_object_get_memsize (GIMP_OBJECT (layers[0]), NULL);
+
+  g_object_set (gimp->config,
+                "undo-levels",    1,
+                "undo-size",      undo_size,
+                "undo-swap-size", (guint64) 0,
+                NULL);
+
+  for (i = 0; i < GIMP_TEST_N_LAYERS; i++)
+    gimp_image_remove_layer (image, layers[i], TRUE, NULL);
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  undo_stack = gimp_image_get_undo_stack (image);
+
+  g_assert_cmpint (gimp_undo_stack_get_depth (undo_stack),
+                   <, GIMP_TEST_N_LAYERS);
+  g_assert_cmpint (gimp_undo_stack_get_size (undo_stack), <=, undo_size);
+
+  g_object_set (gimp->config,
+                "undo-levels",    old_undo_levels,
+                "undo-size",      old_undo_size,
+                "undo-swap-size", old_undo_swap_size,
+                NULL);
+}
+
 /**
  * white_graypoint_in_red_levels:
  * @fixture:
@@ -282,6 +360,7 @@ main (int    argc,
   ADD_IMAGE_TEST (add_layer);
   ADD_IMAGE_TEST (remove_layer);
   ADD_IMAGE_TEST (rotate_non_overlapping);
+  ADD_IMAGE_TEST (remove_layers_frees_undo);
   ADD_TEST (white_graypoint_in_red_levels);
 
   /* Run the tests */
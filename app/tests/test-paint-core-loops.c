@@ -0,0 +1,280 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gegl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "paint/paint-types.h"
+
+#include "paint/gimppaintcore-loops.h"
+
+
+/* Checks the SIMD row kernels of gimppaintcore-loops.cc against the
+ * scalar code they replace.  The scalar loops below are copies of the
+ * ones in the algorithm classes, and the results must be bit-exact.
+ */
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/gimppaintcoreloops/" #function, \
+                   gimp_test_paint_core_loops_ ## function);
+
+
+/* odd, so the kernels leave a tail to the scalar code */
+#define WIDTH        1003
+#define N_ITERATIONS 200
+
+
+typedef struct
+{
+  gfloat  canvas[WIDTH];
+  gfloat  mask[WIDTH];
+  guint8  mask_u8[WIDTH];
+  gfloat  mask_buffer[WIDTH];
+  gdouble opacity;
+} RowData;
+
+
+#if COMPILE_AVX2_INTRINISICS
+
+static void
+row_data_init (RowData *row,
+               GRand   *rand,
+               gint     iteration)
+{
+  gint x;
+
+  row->opacity = iteration % 5 ? g_rand_double (rand) : 1.0;
+
+  for (x = 0; x < WIDTH; x++)
+    {
+      /* hit the opacity exactly now and then, and throw in some signed
+       * zeros, to exercise the comparison in the non-stipple path
+       */
+      if (x % 17 == 0)
+        row->canvas[x] = row->opacity;
+      else if (x % 29 == 0)
+        row->canvas[x] = -0.0f;
+      else
+        row->canvas[x] = g_rand_double (rand);
+
+      row->mask[x]        = g_rand_double (rand);
+      row->mask_u8[x]     = g_rand_int_range (rand, 0, 256);
+      row->mask_buffer[x] = g_rand_double (rand);
+    }
+}
+
+static gboolean
+skip_without_avx2 (void)
+{
+  if (! (gimp_cpu_accel_get_support () & GIMP_CPU_ACCEL_X86_AVX2))
+    {
+      g_test_skip ("AVX2 is not supported by this CPU");
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+gimp_test_paint_core_loops_combine_paint_mask (void)
+{
+  RowData *row  = g_new (RowData, 1);
+  GRand   *rand = g_rand_new_with_seed (1);
+  gint     i;
+
+  if (skip_without_avx2 ())
+    goto out;
+
+  for (i = 0; i < N_ITERATIONS; i++)
+    {
+      gboolean stipple = i % 2;
+      gint     u8;
+
+      row_data_init (row, rand, i);
+
+      for (u8 = 0; u8 <= 1; u8++)
+        {
+          gfloat expected[WIDTH];
+          gfloat result[WIDTH];
+          gint   n;
+          gint   x;
+
+          memcpy (expected, row->canvas, sizeof (expected));
+          memcpy (result,   row->canvas, sizeof (result));
+
+          if (u8)
+            {
+              n = gimp_paint_core_loops_combine_paint_mask_u8_avx2 (
+                result, row->mask_u8, WIDTH, row->opacity, stipple);
+            }
+          else
+            {
+              n = gimp_paint_core_loops_combine_paint_mask_avx2 (
+                result, row->mask, WIDTH, row->opacity, stipple);
+            }
+
+          g_assert_cmpint (n, >, 0);
+          g_assert_cmpint (n, <=, WIDTH);
+
+          for (x = 0; x < n; x++)
+            {
+              gfloat mask = u8 ? row->mask_u8[x] / 255.0f : row->mask[x];
+
+              if (stipple)
+                {
+                  expected[x] += (1.0 - expected[x]) *
+                                 mask                *
+                                 row->opacity;
+                }
+              else if (row->opacity > expected[x])
+                {
+                  expected[x] += (row->opacity - expected[x]) *
+                                 mask                         *
+                                 row->opacity;
+                }
+            }
+
+          g_assert_true (memcmp (expected, result, n * sizeof (gfloat)) == 0);
+        }
+    }
+
+out:
+  g_rand_free (rand);
+  g_free (row);
+}
+
+static void
+gimp_test_paint_core_loops_paint_mask_to_comp_mask (void)
+{
+  RowData *row  = g_new (RowData, 1);
+  GRand   *rand = g_rand_new_with_seed (2);
+  gint     i;
+
+  if (skip_without_avx2 ())
+    goto out;
+
+  for (i = 0; i < N_ITERATIONS; i++)
+    {
+      gint u8;
+
+      row_data_init (row, rand, i);
+
+      for (u8 = 0; u8 <= 1; u8++)
+        {
+          gint has_mask_buffer;
+
+          for (has_mask_buffer = 0; has_mask_buffer <= 1; has_mask_buffer++)
+            {
+              const gfloat *mask_buffer;
+              gfloat        expected[WIDTH];
+              gfloat        result[WIDTH];
+              gint          n;
+              gint          x;
+
+              mask_buffer = has_mask_buffer ? row->mask_buffer : NULL;
+
+              if (u8)
+                {
+                  n = gimp_paint_core_loops_paint_mask_to_comp_mask_u8_avx2 (
+                    result, row->mask_u8, mask_buffer, WIDTH, row->opacity);
+                }
+              else
+                {
+                  n = gimp_paint_core_loops_paint_mask_to_comp_mask_avx2 (
+                    result, row->mask, mask_buffer, WIDTH, row->opacity);
+                }
+
+              g_assert_cmpint (n, >, 0);
+
+              for (x = 0; x < n; x++)
+                {
+                  gfloat mask = u8 ? row->mask_u8[x] / 255.0f : row->mask[x];
+
+                  if (mask_buffer)
+                    expected[x] = mask * mask_buffer[x] * row->opacity;
+                  else
+                    expected[x] = mask * row->opacity;
+                }
+
+              g_assert_true (memcmp (expected, result,
+                                     n * sizeof (gfloat)) == 0);
+            }
+        }
+    }
+
+out:
+  g_rand_free (rand);
+  g_free (row);
+}
+
+static void
+gimp_test_paint_core_loops_canvas_buffer_to_comp_mask (void)
+{
+  RowData *row  = g_new (RowData, 1);
+  GRand   *rand = g_rand_new_with_seed (3);
+  gint     i;
+
+  if (skip_without_avx2 ())
+    goto out;
+
+  for (i = 0; i < N_ITERATIONS; i++)
+    {
+      gfloat expected[WIDTH];
+      gfloat result[WIDTH];
+      gint   n;
+      gint   x;
+
+      row_data_init (row, rand, i);
+
+      n = gimp_paint_core_loops_canvas_buffer_to_comp_mask_avx2 (
+        result, row->canvas, row->mask_buffer, WIDTH);
+
+      g_assert_cmpint (n, >, 0);
+
+      for (x = 0; x < n; x++)
+        expected[x] = row->canvas[x] * row->mask_buffer[x];
+
+      g_assert_true (memcmp (expected, result, n * sizeof (gfloat)) == 0);
+    }
+
+out:
+  g_rand_free (rand);
+  g_free (row);
+}
+
+#endif /* COMPILE_AVX2_INTRINISICS */
+
+int main(int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+#if COMPILE_AVX2_INTRINISICS
+  ADD_TEST (combine_paint_mask);
+  ADD_TEST (paint_mask_to_comp_mask);
+  ADD_TEST (canvas_buffer_to_comp_mask);
+#endif
+
+  return g_test_run ();
+}
@@ -0,0 +1,383 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "core/core-types.h"
+
+#include "core/gimp.h"
+#include "core/gimp-parallel.h"
+#include "core/gimpasync.h"
+#include "core/gimpcancelable.h"
+#include "core/gimpwaitable.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/gimp-parallel/" #function, \
+                   gimp_test_parallel_ ## function);
+
+
+typedef struct
+{
+  gint order[3];
+  gint n_ran;
+  gint n_destroyed;
+} Trace;
+
+typedef struct
+{
+  Trace     *trace;
+  gint       id;
+  GimpAsync *predecessor;
+} Task;
+
+
+static Task *
+task_new (Trace     *trace,
+          gint       id,
+          GimpAsync *predecessor)
+{
+  Task *task = g_new0 (Task, 1);
+
+  task->trace       = trace;
+  task->id          = id;
+  task->predecessor = predecessor;
+
+  return task;
+}
+
+static void
+task_destroy (Task *task)
+{
+  g_atomic_int_inc (&task->trace->n_destroyed);
+
+  g_free (task);
+}
+
+/*  records the order in which the tasks run, and finishes with the
+ *  predecessor's result plus one
+ */
+static void
+task_record (GimpAsync *async,
+             Task      *task)
+{
+  gint n = g_atomic_int_add (&task->trace->n_ran, 1);
+  gint result = 0;
+
+  /*  give a wrongly scheduled dependent a chance to overtake us  */
+  g_usleep (10000);
+
+  task->trace->order[n] = task->id;
+
+  if (task->predecessor)
+    result = GPOINTER_TO_INT (gimp_async_get_result (task->predecessor));
+
+  gimp_async_finish (async, GINT_TO_POINTER (result + 1));
+
+  g_free (task);
+}
+
+static void
+task_abort (GimpAsync *async,
+            Task      *task)
+{
+  g_atomic_int_inc (&task->trace->n_ran);
+
+  gimp_async_abort (async);
+
+  g_free (task);
+}
+
+/*  runs until canceled  */
+static void
+task_until_canceled (GimpAsync *async,
+                     Task      *task)
+{
+  g_atomic_int_inc (&task->trace->n_ran);
+
+  while (! gimp_async_is_canceled (async))
+    g_usleep (1000);
+
+  gimp_async_abort (async);
+
+  g_free (task);
+}
+
+static void
+stop_notify (GimpAsync *async,
+             gint      *n_notified)
+{
+  g_assert_true (gimp_async_is_stopped (async));
+
+  g_atomic_int_inc (n_notified);
+}
+
+/**
+ * gimp_test_parallel_run_async_after_order:
+ *
+ * Test that a task only runs once all of its predecessors have
+ * finished, and can use their results.
+ **/
+static void
+gimp_test_parallel_run_async_after_order (void)
+{
+  Trace      trace = {};
+  GimpAsync *a;
+  GimpAsync *b;
+  GimpAsync *c;
+  GimpAsync *predecessors[2];
+
+  a = gimp_parallel_run_async_full (0,
+                                    (GimpRunAsyncFunc) task_record,
+                                    task_new (&trace, 1, NULL),
+                                    (GDestroyNotify) task_destroy);
+
+  b = gimp_parallel_run_async_after_full (0, &a, 1,
+                                          (GimpRunAsyncFunc) task_record,
+                                          task_new (&trace, 2, a),
+                                          (GDestroyNotify) task_destroy);
+
+  predecessors[0] = a;
+  predecessors[1] = b;
+
+  c = gimp_parallel_run_async_after_full (0, predecessors, 2,
+                                          (GimpRunAsyncFunc) task_record,
+                                          task_new (&trace, 3, b),
+                                          (GDestroyNotify) task_destroy);
+
+  gimp_waitable_wait (GIMP_WAITABLE (c));
+
+  g_assert_true (gimp_async_is_finished (a));
+  g_assert_true (gimp_async_is_finished (b));
+  g_assert_true (gimp_async_is_finished (c));
+
+  g_assert_cmpint (trace.n_ran,       ==, 3);
+  g_assert_cmpint (trace.n_destroyed, ==, 0);
+  g_assert_cmpint (trace.order[0],    ==, 1);
+  g_assert_cmpint (trace.order[1],    ==, 2);
+  g_assert_cmpint (trace.order[2],    ==, 3);
+
+  g_assert_cmpint (GPOINTER_TO_INT (gimp_async_get_result (c)), ==, 3);
+
+  g_object_unref (c);
+  g_object_unref (b);
+  g_object_unref (a);
+}
+
+/**
+ * gimp_test_parallel_run_async_after_abort:
+ *
+ * Test that aborting a task aborts its dependents without running
+ * them.
+ **/
+static void
+gimp_test_parallel_run_async_after_abort (void)
+{
+  Trace      trace = {};
+  GimpAsync *a;
+  GimpAsync *b;
+  GimpAsync *c;
+
+  a = gimp_parallel_run_async_full (0,
+                                    (GimpRunAsyncFunc) task_abort,
+                                    task_new (&trace, 1, NULL),
+                                    (GDestroyNotify) task_destroy);
+
+  b = gimp_parallel_run_async_after_full (0, &a, 1,
+                                          (GimpRunAsyncFunc) task_record,
+                                          task_new (&trace, 2, a),
+                                          (GDestroyNotify) task_destroy);
+
+  c = gimp_parallel_run_async_after_full (0, &b, 1,
+                                          (GimpRunAsyncFunc) task_record,
+                                          task_new (&trace, 3, b),
+                                          (GDestroyNotify) task_destroy);
+
+  gimp_waitable_wait (GIMP_WAITABLE (c));
+
+  g_assert_true (gimp_async_is_stopped (b));
+  g_assert_false (gimp_async_is_finished (b));
+  g_assert_false (gimp_async_is_finished (c));
+
+  g_assert_cmpint (trace.n_ran,       ==, 1);
+  g_assert_cmpint (trace.n_destroyed, ==, 2);
+
+  g_object_unref (c);
+  g_object_unref (b);
+  g_object_unref (a);
+}
+
+/**
+ * gimp_test_parallel_run_async_after_cancel:
+ *
+ * Test that canceling a task cancels its pending dependents, which
+ * are then aborted.
+ **/
+static void
+gimp_test_parallel_run_async_after_cancel (void)
+{
+  Trace      trace = {};
+  GimpAsync *a;
+  GimpAsync *b;
+
+  a = gimp_parallel_run_async_full (0,
+                                    (GimpRunAsyncFunc) task_until_canceled,
+                                    task_new (&trace, 1, NULL),
+                                    (GDestroyNotify) task_destroy);
+
+  b = gimp_parallel_run_async_after_full (0, &a, 1,
+                                          (GimpRunAsyncFunc) task_record,
+                                          task_new (&trace, 2, a),
+                                          (GDestroyNotify) task_destroy);
+
+  /*  cancel a while it's running  */
+  while (! g_atomic_int_get (&trace.n_ran))
+    g_usleep (1000);
+
+  gimp_cancelable_cancel (GIMP_CANCELABLE (a));
+
+  g_assert_true (gimp_async_is_canceled (b));
+
+  gimp_waitable_wait (GIMP_WAITABLE (b));
+
+  g_assert_false (gimp_async_is_finished (a));
+  g_assert_false (gimp_async_is_finished (b));
+
+  g_assert_cmpint (trace.n_ran,       ==, 1);
+  g_assert_cmpint (trace.n_destroyed, ==, 1);
+
+  g_object_unref (b);
+  g_object_unref (a);
+}
+
+/**
+ * gimp_test_parallel_run_async_after_cancel_forward:
+ *
+ * Test that the cancellation of a dependent can be forwarded to its
+ * predecessor, without the two canceling each other forever.
+ **/
+static void
+gimp_test_parallel_run_async_after_cancel_forward (void)
+{
+  Trace      trace = {};
+  GimpAsync *a;
+  GimpAsync *b;
+
+  a = gimp_parallel_run_async_full (0,
+                                    (GimpRunAsyncFunc) task_until_canceled,
+                                    task_new (&trace, 1, NULL),
+                                    (GDestroyNotify) task_destroy);
+
+  b = gimp_parallel_run_async_after_full (0, &a, 1,
+                                          (GimpRunAsyncFunc) task_record,
+                                          task_new (&trace, 2, a),
+                                          (GDestroyNotify) task_destroy);
+
+  g_signal_connect_object (b, "cancel",
+                           G_CALLBACK (gimp_cancelable_cancel),
+                           a, G_CONNECT_SWAPPED);
+
+  while (! g_atomic_int_get (&trace.n_ran))
+    g_usleep (1000);
+
+  gimp_cancelable_cancel (GIMP_CANCELABLE (b));
+
+  g_assert_true (gimp_async_is_canceled (a));
+
+  gimp_waitable_wait (GIMP_WAITABLE (b));
+
+  g_assert_true (gimp_async_is_stopped (a));
+  g_assert_false (gimp_async_is_finished (b));
+
+  g_assert_cmpint (trace.n_destroyed, ==, 1);
+
+  g_object_unref (b);
+  g_object_unref (a);
+}
+
+/**
+ * gimp_test_parallel_stop_notify:
+ *
+ * Test that stop notifications are called once the async stops, or
+ * right away when it's stopped already.
+ **/
+static void
+gimp_test_parallel_stop_notify (void)
+{
+  GimpAsync *async;
+  gint       n_notified = 0;
+
+  async = gimp_async_new ();
+
+  gimp_async_add_stop_notify (async,
+                              (GimpAsyncCallback) stop_notify,
+                              &n_notified);
+
+  g_assert_cmpint (n_notified, ==, 0);
+
+  gimp_async_finish (async, NULL);
+
+  g_assert_cmpint (n_notified, ==, 1);
+
+  gimp_async_add_stop_notify (async,
+                              (GimpAsyncCallback) stop_notify,
+                              &n_notified);
+
+  g_assert_cmpint (n_notified, ==, 2);
+
+  g_object_unref (async);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* gimp_parallel_init() is called from gimp_gegl_init() */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (run_async_after_order);
+  ADD_TEST (run_async_after_abort);
+  ADD_TEST (run_async_after_cancel);
+  ADD_TEST (run_async_after_cancel_forward);
+  ADD_TEST (stop_notify);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
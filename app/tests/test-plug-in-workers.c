@@ -0,0 +1,239 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core/core-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+
+#include "plug-in/gimpplugin.h"
+#include "plug-in/gimppluginmanager.h"
+#include "plug-in/gimppluginmanager-file.h"
+
+#include "file/file-save.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-plug-in-workers/" #function, gimp, \
+                        gimp_test_plug_in_workers_ ## function);
+
+
+static GimpImage *
+create_image (Gimp *gimp)
+{
+  GimpImage *image;
+  GimpLayer *layer;
+
+  image = gimp_image_new (gimp, 16, 16,
+                          GIMP_RGB, GIMP_PRECISION_U8_NON_LINEAR);
+
+  layer = gimp_layer_new (image, 16, 16,
+                          gimp_image_get_layer_format (image, TRUE),
+                          "layer1",
+                          1.0 /*opacity*/,
+                          GIMP_LAYER_MODE_NORMAL);
+
+  gimp_image_add_layer (image,
+                        layer,
+                        NULL /*parent*/,
+                        0 /*position*/,
+                        FALSE /*push_undo*/);
+
+  return image;
+}
+
+static void
+export_image (Gimp      *gimp,
+              GimpImage *image,
+              GFile     *file)
+{
+  GimpPlugInProcedure *proc;
+  GimpPDBStatusType    status;
+  GError              *error = NULL;
+
+  proc = gimp_plug_in_manager_file_procedure_find (gimp->plug_in_manager,
+                                                   GIMP_FILE_PROCEDURE_GROUP_EXPORT,
+                                                   file,
+                                                   NULL /*error*/);
+  g_assert_nonnull (proc);
+
+  status = file_save (gimp,
+                      image,
+                      NULL /*progress*/,
+                      file,
+                      proc,
+                      GIMP_RUN_NONINTERACTIVE,
+                      FALSE /*change_saved_state*/,
+                      FALSE /*export_backward*/,
+                      TRUE /*export_forward*/,
+                      &error);
+
+  g_assert_no_error (error);
+  g_assert_cmpint (status, ==, GIMP_PDB_SUCCESS);
+}
+
+static gboolean
+quit_main_loop (GMainLoop *loop)
+{
+  g_main_loop_quit (loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gimp_test_plug_in_workers_reuse:
+ * @data:
+ *
+ * Test that a reusable plug-in is kept running after its procedure
+ * returned, that the next call of one of its procedures is run by the
+ * same process, and that it's quit after having been idle for
+ * "plug-in-worker-timeout" seconds.
+ **/
+static void
+gimp_test_plug_in_workers_reuse (gconstpointer data)
+{
+  Gimp              *gimp    = GIMP (data);
+  GimpPlugInManager *manager = gimp->plug_in_manager;
+  GimpImage         *image;
+  GFile             *file;
+  gchar             *filename;
+  GimpPlugIn        *worker;
+  GMainLoop         *loop;
+
+  g_object_set (gimp->config,
+                "plug-in-workers",        1,
+                "plug-in-worker-timeout", 1,
+                NULL);
+
+  image = create_image (gimp);
+
+  filename = g_build_filename (g_get_tmp_dir (),
+                               "gimp-test-plug-in-workers.png", NULL);
+  file = g_file_new_for_path (filename);
+  g_free (filename);
+
+  g_assert_null (manager->workers);
+
+  export_image (gimp, image, file);
+
+  /*  file-png opted in, so it's kept as an idle worker  */
+  g_assert_cmpuint (g_slist_length (manager->workers), ==, 1);
+
+  worker = manager->workers->data;
+  g_object_add_weak_pointer (G_OBJECT (worker), (gpointer) &worker);
+
+  g_assert_true (worker->open);
+  g_assert_true (worker->reusable);
+  g_assert_cmpuint (worker->worker_timeout_id, !=, 0);
+
+  /*  the second export is run by the same worker, which is then
+   *  idle again
+   */
+  export_image (gimp, image, file);
+
+  g_assert_cmpuint (g_slist_length (manager->workers), ==, 1);
+  g_assert_true (manager->workers->data == worker);
+
+  /*  let the idle timeout quit the worker  */
+  loop = g_main_loop_new (NULL, FALSE);
+  g_timeout_add (2500, (GSourceFunc) quit_main_loop, loop);
+  g_main_loop_run (loop);
+  g_main_loop_unref (loop);
+
+  g_assert_null (manager->workers);
+  g_assert_null (worker);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_object_unref (image);
+}
+
+/**
+ * gimp_test_plug_in_workers_disabled:
+ * @data:
+ *
+ * Test that plug-ins aren't kept running when "plug-in-workers" is 0.
+ **/
+static void
+gimp_test_plug_in_workers_disabled (gconstpointer data)
+{
+  Gimp              *gimp    = GIMP (data);
+  GimpPlugInManager *manager = gimp->plug_in_manager;
+  GimpImage         *image;
+  GFile             *file;
+  gchar             *filename;
+
+  g_object_set (gimp->config,
+                "plug-in-workers", 0,
+                NULL);
+
+  image = create_image (gimp);
+
+  filename = g_build_filename (g_get_tmp_dir (),
+                               "gimp-test-plug-in-workers.png", NULL);
+  file = g_file_new_for_path (filename);
+  g_free (filename);
+
+  export_image (gimp, image, file);
+
+  g_assert_null (manager->workers);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_object_unref (image);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (reuse);
+  ADD_TEST (disabled);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -64,6 +64,9 @@
 #include "core/gimp-parallel.h"
 #include "core/gimpasync.h"
 #include "core/gimpbacktrace.h"
+#include "core/gimpbrushcache.h"
+#include "core/gimpdrawableundo.h"
+#include "core/gimpprojection.h"
 #include "core/gimptempbuf.h"
 #include "core/gimpwaitable.h"
 
@@ -152,9 +155,20 @@ typedef enum
   VARIABLE_ASSIGNED_THREADS,
   VARIABLE_ACTIVE_THREADS,
   VARIABLE_ASYNC_RUNNING,
+  VARIABLE_ASYNC_QUEUED,
+  VARIABLE_ASYNC_STEALS,
   VARIABLE_TILE_ALLOC_TOTAL,
   VARIABLE_SCRATCH_TOTAL,
   VARIABLE_TEMP_BUF_TOTAL,
+  VARIABLE_TEMP_BUF_POOL,
+  VARIABLE_PREFETCH_HITS,
+  VARIABLE_PREFETCH_MISSES,
+  VARIABLE_UNDO_RAW,
+  VARIABLE_UNDO_COMPRESSED,
+  VARIABLE_UNDO_SWAPPED,
+  VARIABLE_BRUSH_CACHE_TOTAL,
+  VARIABLE_BRUSH_CACHE_HITS,
+  VARIABLE_BRUSH_CACHE_MISSES,
 
 
   N_VARIABLES,
@@ -735,6 +749,26 @@ static const VariableInfo variables[] =
     .data             = gimp_async_get_n_running
   },
 
+  [VARIABLE_ASYNC_QUEUED] =
+  { .name             = "async-queued",
+    .title            = NC_("dashboard-variable", "Queued"),
+    .description      = N_("Number of asynchronous operations waiting for "
+                           "a worker thread"),
+    .type             = VARIABLE_TYPE_INTEGER,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_parallel_run_async_get_n_queued
+  },
+
+  [VARIABLE_ASYNC_STEALS] =
+  { .name             = "async-steals",
+    .title            = NC_("dashboard-variable", "Steals"),
+    .description      = N_("Number of asynchronous operations taken over "
+                           "by an idle worker thread"),
+    .type             = VARIABLE_TYPE_INTEGER,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_parallel_run_async_get_n_steals
+  },
+
   [VARIABLE_TILE_ALLOC_TOTAL] =
   { .name             = "tile-alloc-total",
     .title            = NC_("dashboard-variable", "Tile"),
@@ -764,6 +798,94 @@ static const VariableInfo variables[] =
     .type             = VARIABLE_TYPE_SIZE,
     .sample_func      = gimp_dashboard_sample_function,
     .data             = gimp_temp_buf_get_total_memsize
+  },
+
+  [VARIABLE_TEMP_BUF_POOL] =
+  { .name             = "temp-buf-pool",
+    /* Translators:  "TempBuf" is a technical term referring to an internal
+     * GIMP data structure.  It's probably OK to leave it untranslated.
+     */
+    .title            = NC_("dashboard-variable", "TempBuf pool"),
+    .description      = N_("Total size of free temporary buffers retained "
+                           "for reuse"),
+    .type             = VARIABLE_TYPE_SIZE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_temp_buf_get_pool_memsize
+  },
+
+  [VARIABLE_PREFETCH_HITS] =
+  { .name             = "prefetch-hits",
+    .title            = NC_("dashboard-variable", "Prefetch hits"),
+    .description      = N_("Number of image chunks scrolled into view that "
+                           "were prerendered ahead of time"),
+    .type             = VARIABLE_TYPE_INTEGER,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_projection_get_prefetch_hits
+  },
+
+  [VARIABLE_PREFETCH_MISSES] =
+  { .name             = "prefetch-misses",
+    .title            = NC_("dashboard-variable", "Prefetch misses"),
+    .description      = N_("Number of image chunks scrolled into view that "
+                           "were not prerendered ahead of time"),
+    .type             = VARIABLE_TYPE_INTEGER,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_projection_get_prefetch_misses
+  },
+
+  [VARIABLE_UNDO_RAW] =
+  { .name             = "undo-raw",
+    .title            = NC_("dashboard-variable", "Undo raw"),
+    .description      = N_("Uncompressed size of the compressed undo data"),
+    .type             = VARIABLE_TYPE_SIZE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_drawable_undo_get_total_raw_size
+  },
+
+  [VARIABLE_UNDO_COMPRESSED] =
+  { .name             = "undo-compressed",
+    .title            = NC_("dashboard-variable", "Undo compressed"),
+    .description      = N_("Total size of the compressed undo data"),
+    .type             = VARIABLE_TYPE_SIZE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_drawable_undo_get_total_compressed_size
+  },
+
+  [VARIABLE_UNDO_SWAPPED] =
+  { .name             = "undo-swapped",
+    .title            = NC_("dashboard-variable", "Undo swapped"),
+    .description      = N_("Total size of the undo data swapped out to disk"),
+    .type             = VARIABLE_TYPE_SIZE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_drawable_undo_get_total_swap_size
+  },
+
+  [VARIABLE_BRUSH_CACHE_TOTAL] =
+  { .name             = "brush-cache-total",
+    .title            = NC_("dashboard-variable", "Brush cache"),
+    .description      = N_("Total size of the cached brush transforms"),
+    .type             = VARIABLE_TYPE_SIZE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_brush_cache_get_total_memsize
+  },
+
+  [VARIABLE_BRUSH_CACHE_HITS] =
+  { .name             = "brush-cache-hits",
+    .title            = NC_("dashboard-variable", "Brush cache hits"),
+    .description      = N_("Number of brush transforms found in the cache"),
+    .type             = VARIABLE_TYPE_INTEGER,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_brush_cache_get_n_hits
+  },
+
+  [VARIABLE_BRUSH_CACHE_MISSES] =
+  { .name             = "brush-cache-misses",
+    .title            = NC_("dashboard-variable", "Brush cache misses"),
+    .description      = N_("Number of brush transforms which had to be "
+                           "computed"),
+    .type             = VARIABLE_TYPE_INTEGER,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_brush_cache_get_n_misses
   }
 };
 
@@ -972,6 +1094,12 @@ static const GroupInfo groups[] =
                           { .variable       = VARIABLE_ASYNC_RUNNING,
                             .default_active = TRUE
                           },
+                          { .variable       = VARIABLE_ASYNC_QUEUED,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_ASYNC_STEALS,
+                            .default_active = TRUE
+                          },
                           { .variable       = VARIABLE_TILE_ALLOC_TOTAL,
                             .default_active = TRUE
                           },
@@ -981,6 +1109,33 @@ static const GroupInfo groups[] =
                           { .variable       = VARIABLE_TEMP_BUF_TOTAL,
                             .default_active = TRUE
                           },
+                          { .variable       = VARIABLE_TEMP_BUF_POOL,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_PREFETCH_HITS,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_PREFETCH_MISSES,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_UNDO_RAW,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_UNDO_COMPRESSED,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_UNDO_SWAPPED,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_BRUSH_CACHE_TOTAL,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_BRUSH_CACHE_HITS,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_BRUSH_CACHE_MISSES,
+                            .default_active = TRUE
+                          },
 
                           {}
                         }
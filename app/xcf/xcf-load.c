@@ -20,6 +20,10 @@
 #include <string.h>
 #include <zlib.h>
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include <cairo.h>
 #include <gegl.h>
 #include <gegl-plugin.h>
@@ -92,6 +96,7 @@
 #include "xcf-load.h"
 #include "xcf-read.h"
 #include "xcf-seek.h"
+#include "xcf-tile-handler.h"
 #include "xcf-utils.h"
 
 #include "gimp-log.h"
@@ -100,6 +105,12 @@
 
 #define MAX_XCF_PARASITE_DATA_LEN (256L * 1024 * 1024)
 
+/* twice the size of an uncompressed 8-bit RGBA preview, which leaves
+ * plenty of room for the PNG overhead
+ */
+#define MAX_XCF_THUMBNAIL_DATA_LEN \
+  (XCF_THUMBNAIL_SIZE * XCF_THUMBNAIL_SIZE * 4 * 2)
+
 /* #define GIMP_XCF_PATH_DEBUG */
 
 /* Filters can not be created until a layer is attached
@@ -157,6 +168,30 @@ typedef struct
   GimpMatrix3           matrix;
 } LayerTransformData;
 
+/* Per thread data for xcf_load_tile_parallel */
+typedef struct
+{
+  /* Common to all jobs. */
+  const Babl         *format;
+  gint                file_version;
+  XcfCompressionType  compression;
+
+  /* Job specific. */
+  gint                tile;
+  gint                batch_size;
+  GeglRectangle       tile_rect[XCF_TILE_LOAD_BATCH_SIZE];
+
+  /* Compressed data, as read by the main thread. */
+  guchar             *in_data;
+  gsize               in_data_size;
+  gsize               data_offset[XCF_TILE_LOAD_BATCH_SIZE + 1];
+
+  /* Return data. */
+  guchar             *tile_data;
+  gboolean            nonzero[XCF_TILE_LOAD_BATCH_SIZE];
+  gboolean            success;
+} XcfLoadJobData;
+
 static void            xcf_load_add_masks     (GimpImage     *image);
 static void            xcf_load_add_effects   (XcfInfo       *info,
                                                GimpImage     *image);
@@ -214,6 +249,16 @@ static gboolean        xcf_load_buffer        (XcfInfo       *info,
                                                GeglBuffer    *buffer);
 static gboolean        xcf_load_level         (XcfInfo       *info,
                                                GeglBuffer    *buffer);
+static goffset       * xcf_load_offset_table  (XcfInfo       *info,
+                                               goffset        first_offset,
+                                               gint           ntiles,
+                                               goffset        max_data_length);
+static gboolean        xcf_load_level_parallel
+                                              (XcfInfo       *info,
+                                               GeglBuffer    *buffer,
+                                               const goffset *offsets,
+                                               gint           ntiles,
+                                               goffset        max_data_length);
 static gboolean        xcf_load_tile          (XcfInfo       *info,
                                                GeglBuffer    *buffer,
                                                GeglRectangle *tile_rect,
@@ -228,6 +273,34 @@ static gboolean        xcf_load_tile_zlib     (XcfInfo       *info,
                                                GeglRectangle *tile_rect,
                                                const Babl    *format,
                                                gint           data_length);
+static gboolean        xcf_load_decode_rle    (const guchar  *xcfdata,
+                                               gsize          data_length,
+                                               guchar        *tile_data,
+                                               gint           bpp,
+                                               gint           n_pixels,
+                                               gboolean      *nonzero);
+static gboolean        xcf_load_decode_zlib   (const guchar  *xcfdata,
+                                               gsize          data_length,
+                                               guchar        *tile_data,
+                                               gint           tile_size);
+#ifdef HAVE_ZSTD
+static gboolean        xcf_load_decode_zstd   (const guchar  *xcfdata,
+                                               gsize          data_length,
+                                               guchar        *tile_data,
+                                               gint           tile_size);
+#endif
+static gint            xcf_load_sort_job_data (XcfLoadJobData *job1,
+                                               XcfLoadJobData *job2,
+                                               gpointer        user_data);
+static gboolean        xcf_load_read_job      (XcfInfo        *info,
+                                               XcfLoadJobData *job,
+                                               GeglBuffer     *buffer,
+                                               const goffset  *offsets,
+                                               gint            tile,
+                                               gint            ntiles,
+                                               goffset         max_data_length);
+static void            xcf_load_tile_parallel (XcfLoadJobData *job,
+                                               GAsyncQueue    *queue);
 static GimpParasite  * xcf_load_parasite      (XcfInfo       *info);
 static gboolean        xcf_load_old_paths     (XcfInfo       *info,
                                                GimpImage     *image);
@@ -1208,6 +1281,198 @@ xcf_load_image (Gimp     *gimp,
   return NULL;
 }
 
+/* Decodes the @data_length bytes of compressed tile data at @xcfdata
+ * into @tile_data, which has room for @n_pixels pixels of @format.
+ * *@nonzero is set to whether the tile has any non-zero data; if it
+ * hasn't, @tile_data isn't byte-swapped.  This doesn't use any XcfInfo
+ * and is safe to call from any thread.
+ */
+gboolean
+xcf_load_decode_tile (XcfCompressionType  compression,
+                      gint                file_version,
+                      const Babl         *format,
+                      const guchar       *xcfdata,
+                      gsize               data_length,
+                      guchar             *tile_data,
+                      gint                n_pixels,
+                      gboolean           *nonzero)
+{
+  gint     bpp       = babl_format_get_bytes_per_pixel (format);
+  gint     tile_size = n_pixels * bpp;
+  gboolean success   = FALSE;
+
+  *nonzero = FALSE;
+
+  if (data_length == 0)
+    return TRUE;
+
+  switch (compression)
+    {
+    case COMPRESS_RLE:
+      success = xcf_load_decode_rle (xcfdata, data_length, tile_data,
+                                     bpp, n_pixels, nonzero);
+      break;
+
+    case COMPRESS_ZLIB:
+      success = xcf_load_decode_zlib (xcfdata, data_length, tile_data,
+                                      tile_size);
+      break;
+
+#ifdef HAVE_ZSTD
+    case COMPRESS_ZSTD:
+      success = xcf_load_decode_zstd (xcfdata, data_length, tile_data,
+                                      tile_size);
+      break;
+#endif
+
+    default:
+      break;
+    }
+
+  if (! success)
+    return FALSE;
+
+  if (compression != COMPRESS_RLE)
+    *nonzero = ! xcf_data_is_zero (tile_data, tile_size);
+
+  if (*nonzero && file_version >= 12)
+    {
+      gint n_components = babl_format_get_n_components (format);
+
+      xcf_read_from_be (bpp / n_components, tile_data,
+                        tile_size / bpp * n_components);
+    }
+
+  return TRUE;
+}
+
+/* Reads the image's size and base type, whether it has alpha, its
+ * number of layers, and the preview saved along with it, without
+ * loading any drawable.  Returns NULL if the file has no preview.
+ */
+GdkPixbuf *
+xcf_load_thumbnail (XcfInfo           *info,
+                    gint              *image_width,
+                    gint              *image_height,
+                    GimpImageBaseType *image_type,
+                    gboolean          *has_alpha,
+                    gint              *num_layers)
+{
+  GdkPixbuf *pixbuf = NULL;
+  goffset    offset;
+  goffset    bottom_offset = 0;
+  gint       type;
+
+  xcf_read_int32 (info, (guint32 *) image_width,  1);
+  xcf_read_int32 (info, (guint32 *) image_height, 1);
+  xcf_read_int32 (info, (guint32 *) &type,        1);
+
+  if (type < GIMP_RGB || type > GIMP_INDEXED)
+    return NULL;
+
+  *image_type = type;
+
+  if (info->file_version >= 4)
+    {
+      gint precision;
+
+      xcf_read_int32 (info, (guint32 *) &precision, 1);
+    }
+
+  while (TRUE)
+    {
+      PropType prop_type;
+      guint32  prop_size;
+
+      if (! xcf_load_prop (info, &prop_type, &prop_size))
+        goto error;
+
+      if (prop_type == PROP_END)
+        break;
+
+      if (prop_type == PROP_THUMBNAIL && ! pixbuf)
+        {
+          GdkPixbufLoader *loader;
+          guint8          *data;
+          gboolean         success;
+
+          /* the size is read from the file, don't trust it */
+          if (prop_size > MAX_XCF_THUMBNAIL_DATA_LEN)
+            goto error;
+
+          data = g_malloc (prop_size);
+
+          success = (xcf_read_int8 (info, data, prop_size) == prop_size);
+
+          loader = gdk_pixbuf_loader_new_with_type ("png", NULL);
+
+          if (loader)
+            {
+              success = (success &&
+                         gdk_pixbuf_loader_write (loader, data, prop_size,
+                                                  NULL));
+              success = (gdk_pixbuf_loader_close (loader, NULL) && success);
+
+              if (success && gdk_pixbuf_loader_get_pixbuf (loader))
+                pixbuf = g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
+
+              g_object_unref (loader);
+            }
+
+          g_free (data);
+
+          if (! pixbuf)
+            return NULL;
+        }
+      else if (! xcf_seek_pos (info, info->cp + prop_size, NULL))
+        {
+          goto error;
+        }
+    }
+
+  if (! pixbuf)
+    return NULL;
+
+  /* count the layers, without reading them */
+  *num_layers = 0;
+
+  while (xcf_read_offset (info, &offset, 1) == info->bytes_per_offset &&
+         offset != 0)
+    {
+      bottom_offset = offset;
+      (*num_layers)++;
+    }
+
+  /* like gimp_image_has_alpha(), only the type of the bottom layer
+   * matters, and only if it's the only layer
+   */
+  *has_alpha = (*num_layers > 1);
+
+  if (*num_layers == 1 && xcf_seek_pos (info, bottom_offset, NULL))
+    {
+      gint width;
+      gint height;
+
+      xcf_read_int32 (info, (guint32 *) &width,  1);
+      xcf_read_int32 (info, (guint32 *) &height, 1);
+      xcf_read_int32 (info, (guint32 *) &type,   1);
+
+      *has_alpha = (type == GIMP_RGBA_IMAGE  ||
+                    type == GIMP_GRAYA_IMAGE ||
+                    type == GIMP_INDEXEDA_IMAGE);
+    }
+
+  return pixbuf;
+
+ error:
+  g_clear_object (&pixbuf);
+
+  return NULL;
+}
+
+
+/*  private functions  */
+
 static void
 xcf_load_add_masks (GimpImage *image)
 {
@@ -1396,7 +1661,8 @@ xcf_load_image_props (XcfInfo   *info,
             if ((compression != COMPRESS_NONE) &&
                 (compression != COMPRESS_RLE) &&
                 (compression != COMPRESS_ZLIB) &&
-                (compression != COMPRESS_FRACTAL))
+                (compression != COMPRESS_FRACTAL) &&
+                (compression != COMPRESS_ZSTD))
               {
                 gimp_message (info->gimp, G_OBJECT (info->progress),
                               GIMP_MESSAGE_ERROR,
@@ -1405,6 +1671,17 @@ xcf_load_image_props (XcfInfo   *info,
                 return FALSE;
               }
 
+#ifndef HAVE_ZSTD
+            if (compression == COMPRESS_ZSTD)
+              {
+                gimp_message_literal (info->gimp, G_OBJECT (info->progress),
+                                      GIMP_MESSAGE_ERROR,
+                                      "This file uses zstd compression, "
+                                      "which this build does not support");
+                return FALSE;
+              }
+#endif
+
             info->compression = compression;
 
             gimp_image_set_xcf_compression (image,
@@ -1803,6 +2080,12 @@ xcf_load_image_props (XcfInfo   *info,
           }
           break;
 
+        case PROP_THUMBNAIL:
+          /* only read by xcf_load_thumbnail() */
+          if (! xcf_skip_unknown_prop (info, prop_size))
+            return FALSE;
+          break;
+
         default:
 #ifdef GIMP_UNSTABLE
           g_printerr ("unexpected/unknown image property: %d (skipping)\n",
@@ -4360,6 +4643,51 @@ xcf_load_level (XcfInfo    *info,
   n_tile_cols = gimp_gegl_buffer_get_n_tile_cols (buffer, XCF_TILE_WIDTH);
 
   ntiles = n_tile_rows * n_tile_cols;
+
+  /* compressed tiles are decompressed on a thread pool, or on demand
+   * when loading lazily
+   */
+  if (info->compression == COMPRESS_RLE  ||
+      info->compression == COMPRESS_ZLIB ||
+      info->compression == COMPRESS_ZSTD)
+    {
+      goffset  *offsets;
+      goffset   table_end;
+      gboolean  success;
+
+      offsets = xcf_load_offset_table (info, offset, ntiles, max_data_length);
+
+      if (! offsets)
+        return FALSE;
+
+      table_end = info->cp;
+
+      if (info->lazy_file)
+        {
+          GeglTileHandler *handler;
+
+          handler = xcf_tile_handler_new (info->lazy_file,
+                                          info->compression,
+                                          info->file_version,
+                                          format, width, height,
+                                          offsets, max_data_length);
+
+          xcf_tile_handler_assign (XCF_TILE_HANDLER (handler), buffer);
+          g_object_unref (handler);
+
+          success = TRUE;
+        }
+      else
+        {
+          success = xcf_load_level_parallel (info, buffer, offsets, ntiles,
+                                             max_data_length);
+        }
+
+      g_free (offsets);
+
+      return success && xcf_seek_pos (info, table_end, NULL);
+    }
+
   for (i = 0; i < ntiles; i++)
     {
       GeglRectangle rect;
@@ -4513,15 +4841,68 @@ xcf_load_tile_rle (XcfInfo       *info,
                    const Babl    *format,
                    gint           data_length)
 {
-  gint    bpp       = babl_format_get_bytes_per_pixel (format);
-  gint    tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar *tile_data = g_alloca (tile_size);
-  guchar  nonzero   = FALSE;
-  gsize   bytes_read;
-  gint    i;
-  guchar *xcfdata;
-  guchar *xcfodata;
-  guchar *xcfdatalimit;
+  gint     bpp       = babl_format_get_bytes_per_pixel (format);
+  gint     n_pixels  = tile_rect->width * tile_rect->height;
+  gint     tile_size = bpp * n_pixels;
+  guchar  *tile_data = g_alloca (tile_size);
+  gboolean nonzero   = FALSE;
+  gsize    bytes_read;
+  guchar  *xcfdata;
+
+  /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
+   * this tile (return TRUE without storing data) as if it did not
+   * contain any data.  It is better than returning FALSE, which would
+   * skip the whole hierarchy while there may still be some valid
+   * tiles in the file.
+   */
+  if (data_length <= 0)
+    return TRUE;
+
+  xcfdata = g_alloca (data_length);
+
+  /* we have to read directly instead of xcf_read_* because we may be
+   * reading past the end of the file here
+   */
+  g_input_stream_read_all (info->input, xcfdata, data_length,
+                           &bytes_read, NULL, NULL);
+  info->cp += bytes_read;
+
+  if (bytes_read == 0)
+    return TRUE;
+
+  if (! xcf_load_decode_rle (xcfdata, bytes_read, tile_data, bpp, n_pixels,
+                             &nonzero))
+    return FALSE;
+
+  if (nonzero)
+    {
+      if (info->file_version >= 12)
+        {
+          gint n_components = babl_format_get_n_components (format);
+
+          xcf_read_from_be (bpp / n_components, tile_data,
+                            tile_size / bpp * n_components);
+        }
+
+      gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  return TRUE;
+}
+
+static gboolean
+xcf_load_tile_zlib (XcfInfo       *info,
+                    GeglBuffer    *buffer,
+                    GeglRectangle *tile_rect,
+                    const Babl    *format,
+                    gint           data_length)
+{
+  gint      bpp       = babl_format_get_bytes_per_pixel (format);
+  gint      tile_size = bpp * tile_rect->width * tile_rect->height;
+  guchar   *tile_data = g_alloca (tile_size);
+  gsize     bytes_read;
+  guchar   *xcfdata;
 
   /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
    * this tile (return TRUE without storing data) as if it did not
@@ -4532,7 +4913,7 @@ xcf_load_tile_rle (XcfInfo       *info,
   if (data_length <= 0)
     return TRUE;
 
-  xcfdata = xcfodata = g_alloca (data_length);
+  xcfdata = g_alloca (data_length);
 
   /* we have to read directly instead of xcf_read_* because we may be
    * reading past the end of the file here
@@ -4544,13 +4925,46 @@ xcf_load_tile_rle (XcfInfo       *info,
   if (bytes_read == 0)
     return TRUE;
 
-  xcfdatalimit = &xcfodata[bytes_read - 1];
+  if (! xcf_load_decode_zlib (xcfdata, bytes_read, tile_data, tile_size))
+    return FALSE;
+
+  if (! xcf_data_is_zero (tile_data, tile_size))
+    {
+      if (info->file_version >= 12)
+        {
+          gint n_components = babl_format_get_n_components (format);
+
+          xcf_read_from_be (bpp / n_components, tile_data,
+                            tile_size / bpp * n_components);
+        }
+
+      gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  return TRUE;
+}
+
+/* Decodes @data_length bytes of RLE-compressed @xcfdata into @tile_data,
+ * which holds @n_pixels pixels of @bpp bytes each.  Does not touch the
+ * XcfInfo, so it may be called from worker threads.
+ */
+static gboolean
+xcf_load_decode_rle (const guchar *xcfdata,
+                     gsize         data_length,
+                     guchar       *tile_data,
+                     gint          bpp,
+                     gint          n_pixels,
+                     gboolean     *nonzero)
+{
+  const guchar *xcfdatalimit = &xcfdata[data_length - 1];
+  guchar        any          = 0;
+  gint          i;
 
   for (i = 0; i < bpp; i++)
     {
       guchar *data  = tile_data + i;
-      gint    size  = tile_rect->width * tile_rect->height;
-      gint    count = 0;
+      gint    size  = n_pixels;
       guchar  val;
       gint    length;
       gint    j;
@@ -4558,9 +4972,7 @@ xcf_load_tile_rle (XcfInfo       *info,
       while (size > 0)
         {
           if (xcfdata > xcfdatalimit)
-            {
-              goto bogus_rle;
-            }
+            return FALSE;
 
           val = *xcfdata++;
 
@@ -4571,31 +4983,24 @@ xcf_load_tile_rle (XcfInfo       *info,
               if (length == 128)
                 {
                   if (xcfdata >= xcfdatalimit)
-                    {
-                      goto bogus_rle;
-                    }
+                    return FALSE;
 
                   length = (*xcfdata << 8) + xcfdata[1];
                   xcfdata += 2;
                 }
 
-              count += length;
               size -= length;
 
               if (size < 0)
-                {
-                  goto bogus_rle;
-                }
+                return FALSE;
 
               if (&xcfdata[length-1] > xcfdatalimit)
-                {
-                  goto bogus_rle;
-                }
+                return FALSE;
 
               while (length-- > 0)
                 {
                   *data = *xcfdata++;
-                  nonzero |= *data;
+                  any |= *data;
                   data += bpp;
                 }
             }
@@ -4605,29 +5010,22 @@ xcf_load_tile_rle (XcfInfo       *info,
               if (length == 128)
                 {
                   if (xcfdata >= xcfdatalimit)
-                    {
-                      goto bogus_rle;
-                    }
+                    return FALSE;
 
                   length = (*xcfdata << 8) + xcfdata[1];
                   xcfdata += 2;
                 }
 
-              count += length;
               size -= length;
 
               if (size < 0)
-                {
-                  goto bogus_rle;
-                }
+                return FALSE;
 
               if (xcfdata > xcfdatalimit)
-                {
-                  goto bogus_rle;
-                }
+                return FALSE;
 
               val = *xcfdata++;
-              nonzero |= val;
+              any |= val;
 
               for (j = 0; j < length; j++)
                 {
@@ -4638,62 +5036,23 @@ xcf_load_tile_rle (XcfInfo       *info,
         }
     }
 
-  if (nonzero)
-    {
-      if (info->file_version >= 12)
-        {
-          gint n_components = babl_format_get_n_components (format);
-
-          xcf_read_from_be (bpp / n_components, tile_data,
-                            tile_size / bpp * n_components);
-        }
-
-      gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                       GEGL_AUTO_ROWSTRIDE);
-    }
+  *nonzero = (any != 0);
 
   return TRUE;
-
- bogus_rle:
-  return FALSE;
 }
 
+/* Inflates @data_length bytes of @xcfdata into the @tile_size bytes of
+ * @tile_data.  Like xcf_load_decode_rle(), this is thread-safe.
+ */
 static gboolean
-xcf_load_tile_zlib (XcfInfo       *info,
-                    GeglBuffer    *buffer,
-                    GeglRectangle *tile_rect,
-                    const Babl    *format,
-                    gint           data_length)
+xcf_load_decode_zlib (const guchar *xcfdata,
+                      gsize         data_length,
+                      guchar       *tile_data,
+                      gint          tile_size)
 {
-  z_stream  strm;
-  int       action;
-  int       status;
-  gint      bpp       = babl_format_get_bytes_per_pixel (format);
-  gint      tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar   *tile_data = g_alloca (tile_size);
-  gsize     bytes_read;
-  guchar   *xcfdata;
-
-  /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
-   * this tile (return TRUE without storing data) as if it did not
-   * contain any data.  It is better than returning FALSE, which would
-   * skip the whole hierarchy while there may still be some valid
-   * tiles in the file.
-   */
-  if (data_length <= 0)
-    return TRUE;
-
-  xcfdata = g_alloca (data_length);
-
-  /* we have to read directly instead of xcf_read_* because we may be
-   * reading past the end of the file here
-   */
-  g_input_stream_read_all (info->input, xcfdata, data_length,
-                           &bytes_read, NULL, NULL);
-  info->cp += bytes_read;
-
-  if (bytes_read == 0)
-    return TRUE;
+  z_stream strm;
+  int      action;
+  int      status;
 
   strm.next_out  = tile_data;
   strm.avail_out = tile_size;
@@ -4701,8 +5060,8 @@ xcf_load_tile_zlib (XcfInfo       *info,
   strm.zalloc    = Z_NULL;
   strm.zfree     = Z_NULL;
   strm.opaque    = Z_NULL;
-  strm.next_in   = xcfdata;
-  strm.avail_in  = bytes_read;
+  strm.next_in   = (guchar *) xcfdata;
+  strm.avail_in  = data_length;
 
   /* Initialize the stream decompression. */
   status = inflateInit (&strm);
@@ -4739,25 +5098,361 @@ xcf_load_tile_zlib (XcfInfo       *info,
         }
     }
 
-  if (! xcf_data_is_zero (tile_data, tile_size))
+  inflateEnd (&strm);
+
+  return TRUE;
+}
+
+#ifdef HAVE_ZSTD
+/* Decompresses a zstd frame, see xcf_load_decode_zlib(). */
+static gboolean
+xcf_load_decode_zstd (const guchar *xcfdata,
+                      gsize         data_length,
+                      guchar       *tile_data,
+                      gint          tile_size)
+{
+  /* see xcf_save_tile_zstd() */
+  static GPrivate  dctx_private = G_PRIVATE_INIT ((GDestroyNotify) ZSTD_freeDCtx);
+  ZSTD_DCtx       *dctx;
+  size_t           size;
+
+  dctx = g_private_get (&dctx_private);
+
+  if (! dctx)
     {
-      if (info->file_version >= 12)
+      dctx = ZSTD_createDCtx ();
+      if (! dctx)
+        return FALSE;
+
+      g_private_set (&dctx_private, dctx);
+    }
+
+  size = ZSTD_decompressDCtx (dctx, tile_data, tile_size,
+                              xcfdata, data_length);
+
+  if (ZSTD_isError (size))
+    {
+      g_printerr ("xcf: tile decompression failed: %s",
+                  ZSTD_getErrorName (size));
+      return FALSE;
+    }
+  else if (size != tile_size)
+    {
+      g_printerr ("xcf: decompressed tile smaller than the expected size.");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+#endif
+
+static gint
+xcf_load_sort_job_data (XcfLoadJobData *job1,
+                        XcfLoadJobData *job2,
+                        gpointer        user_data)
+{
+  return job1->tile - job2->tile;
+}
+
+/* Reads the compressed data of the next batch of tiles, starting at
+ * @tile, into @job.  @offsets holds the (already validated) offsets of
+ * all @ntiles tiles of the level, plus the terminating 0.
+ */
+static gboolean
+xcf_load_read_job (XcfInfo        *info,
+                   XcfLoadJobData *job,
+                   GeglBuffer     *buffer,
+                   const goffset  *offsets,
+                   gint            tile,
+                   gint            ntiles,
+                   goffset         max_data_length)
+{
+  gsize pos = 0;
+  gint  i;
+
+  job->tile       = tile;
+  job->batch_size = MIN (XCF_TILE_LOAD_BATCH_SIZE, ntiles - tile);
+
+  for (i = 0; i < job->batch_size; i++)
+    {
+      goffset offset  = offsets[tile + i];
+      goffset offset2 = offsets[tile + i + 1];
+      gsize   bytes_read;
+
+      if (offset2 == 0)
+        offset2 = offset + max_data_length;
+
+      gimp_gegl_buffer_get_tile_rect (buffer,
+                                      XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
+                                      tile + i, &job->tile_rect[i]);
+
+      job->data_offset[i] = pos;
+
+      if (offset2 > offset)
         {
-          gint n_components = babl_format_get_n_components (format);
+          if (! xcf_seek_pos (info, offset, NULL))
+            return FALSE;
 
-          xcf_read_from_be (bpp / n_components, tile_data,
-                            tile_size / bpp * n_components);
-        }
+          if (pos + (offset2 - offset) > job->in_data_size)
+            {
+              job->in_data_size = MAX (pos + (offset2 - offset),
+                                       2 * job->in_data_size);
+              job->in_data      = g_realloc (job->in_data, job->in_data_size);
+            }
 
-      gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                       GEGL_AUTO_ROWSTRIDE);
+          /* we have to read directly instead of xcf_read_* because we may
+           * be reading past the end of the file here
+           */
+          g_input_stream_read_all (info->input, job->in_data + pos,
+                                   offset2 - offset, &bytes_read, NULL, NULL);
+          info->cp += bytes_read;
+          pos      += bytes_read;
+        }
     }
 
-  inflateEnd (&strm);
+  job->data_offset[job->batch_size] = pos;
 
   return TRUE;
 }
 
+static void
+xcf_load_tile_parallel (XcfLoadJobData *job,
+                        GAsyncQueue    *queue)
+{
+  gint bpp = babl_format_get_bytes_per_pixel (job->format);
+  gint i;
+
+  job->success = TRUE;
+
+  for (i = 0; i < job->batch_size; i++)
+    {
+      const guchar *xcfdata     = job->in_data + job->data_offset[i];
+      gsize         data_length = job->data_offset[i + 1] -
+                                  job->data_offset[i];
+      gint          n_pixels    = job->tile_rect[i].width *
+                                  job->tile_rect[i].height;
+      guchar       *tile_data;
+      gboolean      nonzero     = FALSE;
+
+      tile_data = job->tile_data + i * XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp;
+
+      if (data_length > 0 &&
+          ! xcf_load_decode_tile (job->compression, job->file_version,
+                                  job->format, xcfdata, data_length,
+                                  tile_data, n_pixels, &nonzero))
+        {
+          job->success = FALSE;
+          break;
+        }
+
+      job->nonzero[i] = nonzero;
+    }
+
+  g_async_queue_push (queue, job);
+}
+
+/* Reads the rest of the tile offset table of a level, whose first
+ * entry is @first_offset, and checks that the tiles' data lengths are
+ * sane.  The returned table has @ntiles + 1 entries, the last one
+ * being 0.
+ */
+static goffset *
+xcf_load_offset_table (XcfInfo *info,
+                       goffset  first_offset,
+                       gint     ntiles,
+                       goffset  max_data_length)
+{
+  goffset *offsets;
+  gint     i;
+
+  offsets    = g_new (goffset, ntiles + 1);
+  offsets[0] = first_offset;
+
+  for (i = 1; i <= ntiles; i++)
+    {
+      if (xcf_read_offset (info, &offsets[i], 1) < info->bytes_per_offset)
+        {
+          GIMP_LOG (XCF, "Failed to read tile offset"
+                    " at offset: %" G_GOFFSET_FORMAT, info->cp);
+          g_free (offsets);
+          return NULL;
+        }
+
+      if (i < ntiles && offsets[i] == 0)
+        {
+          gimp_message_literal (info->gimp, G_OBJECT (info->progress),
+                                GIMP_MESSAGE_ERROR,
+                                "not enough tiles found in level");
+          g_free (offsets);
+          return NULL;
+        }
+    }
+
+  if (offsets[ntiles] != 0)
+    {
+      gimp_message (info->gimp, G_OBJECT (info->progress), GIMP_MESSAGE_ERROR,
+                    "encountered garbage after reading level: %" G_GOFFSET_FORMAT,
+                    offsets[ntiles]);
+      g_free (offsets);
+      return NULL;
+    }
+
+  for (i = 0; i < ntiles; i++)
+    {
+      goffset offset  = offsets[i];
+      goffset offset2 = offsets[i + 1] ? offsets[i + 1] :
+                                         offset + max_data_length;
+
+      if (offset2 < offset || offset2 - offset > max_data_length)
+        {
+          gimp_message (info->gimp, G_OBJECT (info->progress),
+                        GIMP_MESSAGE_ERROR,
+                        "invalid tile data length: %" G_GOFFSET_FORMAT,
+                        offset2 - offset);
+          g_free (offsets);
+          return NULL;
+        }
+    }
+
+  return offsets;
+}
+
+/* Loads a RLE, zlib or zstd-compressed level, given its tile offset
+ * table.  The main thread reads the compressed data of batches of
+ * XCF_TILE_LOAD_BATCH_SIZE tiles, which are decompressed on a thread
+ * pool, and writes the decompressed tiles to @buffer in order.
+ */
+static gboolean
+xcf_load_level_parallel (XcfInfo       *info,
+                         GeglBuffer    *buffer,
+                         const goffset *offsets,
+                         gint           ntiles,
+                         goffset        max_data_length)
+{
+  const Babl     *format = gegl_buffer_get_format (buffer);
+  gint            bpp    = babl_format_get_bytes_per_pixel (format);
+  GThreadPool    *pool;
+  GAsyncQueue    *queue;
+  GQueue          pending   = G_QUEUE_INIT;
+  gint            num_tasks;
+  gint            n_jobs    = 0;
+  gint            next_read = 0;
+  gint            next_tile = 0;
+  gboolean        fail      = FALSE;
+  gint            i;
+
+  num_tasks = GIMP_GEGL_CONFIG (info->gimp->config)->num_processors;
+  num_tasks = CLAMP (num_tasks, 1,
+                     (ntiles + XCF_TILE_LOAD_BATCH_SIZE - 1) /
+                     XCF_TILE_LOAD_BATCH_SIZE);
+
+  queue = g_async_queue_new ();
+  pool  = g_thread_pool_new ((GFunc) xcf_load_tile_parallel, queue,
+                             num_tasks, TRUE, NULL);
+
+  /* Keep two batches per thread in flight, so that the workers don't
+   * starve while the main thread reads and writes tiles.
+   */
+  for (i = 0; i < 2 * num_tasks && next_read < ntiles; i++)
+    {
+      XcfLoadJobData *job = g_slice_new0 (XcfLoadJobData);
+
+      job->format       = format;
+      job->file_version = info->file_version;
+      job->compression  = info->compression;
+      job->tile_data    = g_malloc (XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp *
+                                    XCF_TILE_LOAD_BATCH_SIZE);
+
+      if (! xcf_load_read_job (info, job, buffer, offsets,
+                               next_read, ntiles, max_data_length))
+        {
+          g_free (job->in_data);
+          g_free (job->tile_data);
+          g_slice_free (XcfLoadJobData, job);
+
+          fail = TRUE;
+          break;
+        }
+
+      next_read += job->batch_size;
+
+      g_thread_pool_push (pool, job, NULL);
+      n_jobs++;
+    }
+
+  while (n_jobs > 0)
+    {
+      XcfLoadJobData *job = g_queue_peek_head (&pending);
+
+      if (job && (fail || job->tile == next_tile))
+        {
+          g_queue_pop_head (&pending);
+        }
+      else
+        {
+          job = g_async_queue_pop (queue);
+
+          if (! fail && job->tile != next_tile)
+            {
+              g_queue_insert_sorted (&pending, job,
+                                     (GCompareDataFunc) xcf_load_sort_job_data,
+                                     NULL);
+              continue;
+            }
+        }
+
+      n_jobs--;
+
+      if (! fail && ! job->success)
+        fail = TRUE;
+
+      if (! fail)
+        {
+          for (i = 0; i < job->batch_size; i++)
+            {
+              if (job->nonzero[i])
+                {
+                  guchar *tile_data = job->tile_data +
+                                      i * XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp;
+
+                  gegl_buffer_set (buffer, &job->tile_rect[i], 0, format,
+                                   tile_data, GEGL_AUTO_ROWSTRIDE);
+                }
+            }
+
+          GIMP_LOG (XCF, "loaded tiles %d-%d/%d",
+                    job->tile + 1, job->tile + job->batch_size, ntiles);
+
+          next_tile += job->batch_size;
+
+          if (next_read < ntiles)
+            {
+              if (xcf_load_read_job (info, job, buffer, offsets,
+                                     next_read, ntiles, max_data_length))
+                {
+                  next_read += job->batch_size;
+
+                  g_thread_pool_push (pool, job, NULL);
+                  n_jobs++;
+
+                  continue;
+                }
+
+              fail = TRUE;
+            }
+        }
+
+      g_free (job->in_data);
+      g_free (job->tile_data);
+      g_slice_free (XcfLoadJobData, job);
+    }
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_async_queue_unref (queue);
+
+  return ! fail;
+}
+
 static GimpParasite *
 xcf_load_parasite (XcfInfo *info)
 {
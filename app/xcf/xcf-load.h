@@ -18,6 +18,22 @@
 #pragma once
 
 
-GimpImage * xcf_load_image (Gimp     *gimp,
-                            XcfInfo  *info,
-                            GError  **error);
+GimpImage * xcf_load_image       (Gimp                *gimp,
+                                  XcfInfo             *info,
+                                  GError             **error);
+
+gboolean    xcf_load_decode_tile (XcfCompressionType   compression,
+                                  gint                 file_version,
+                                  const Babl          *format,
+                                  const guchar        *xcfdata,
+                                  gsize                data_length,
+                                  guchar              *tile_data,
+                                  gint                 n_pixels,
+                                  gboolean            *nonzero);
+
+GdkPixbuf * xcf_load_thumbnail   (XcfInfo             *info,
+                                  gint                *image_width,
+                                  gint                *image_height,
+                                  GimpImageBaseType   *image_type,
+                                  gboolean            *has_alpha,
+                                  gint                *num_layers);
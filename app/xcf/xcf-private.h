@@ -22,6 +22,8 @@
 #define XCF_TILE_HEIGHT                 64
 #define XCF_TILE_MAX_DATA_LENGTH_FACTOR 1.5
 #define XCF_TILE_SAVE_BATCH_SIZE        128
+#define XCF_TILE_LOAD_BATCH_SIZE        32
+#define XCF_THUMBNAIL_SIZE              256
 
 typedef enum
 {
@@ -75,6 +77,7 @@ typedef enum
   PROP_VECTOR_LAYER       = 47,
   PROP_LINK_LAYER         = 48,
   PROP_TRANSFORM          = 49,
+  PROP_THUMBNAIL          = 50,
 } PropType;
 
 typedef enum
@@ -82,7 +85,8 @@ typedef enum
   COMPRESS_NONE              =  0,
   COMPRESS_RLE               =  1,
   COMPRESS_ZLIB              =  2,  /* unused */
-  COMPRESS_FRACTAL           =  3   /* unused */
+  COMPRESS_FRACTAL           =  3,  /* unused */
+  COMPRESS_ZSTD              =  4
 } XcfCompressionType;
 
 typedef enum
@@ -115,7 +119,8 @@ typedef enum
   FILTER_PROP_COLOR   = 8,
 } FilterPropType;
 
-typedef struct _XcfInfo  XcfInfo;
+typedef struct _XcfInfo     XcfInfo;
+typedef struct _XcfTileFile XcfTileFile;
 
 struct _XcfInfo
 {
@@ -147,5 +152,18 @@ struct _XcfInfo
   GimpLayer          *floating_sel;
   goffset             floating_sel_offset;
   XcfCompressionType  compression;
+  gint                compression_level;
   gint                file_version;
+
+  /* Incremental saving: the previously saved file of the image, if
+   * unchanged drawables can copy their tiles from it.
+   */
+  XcfInfo            *previous;
+  guint               previous_serial;
+  guint               save_serial;
+
+  /* Lazy loading: the file which the tiles of compressed levels are
+   * read from when they are first accessed, if any.
+   */
+  XcfTileFile        *lazy_file;
 };
@@ -20,6 +20,10 @@
 #include <string.h>
 #include <zlib.h>
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include <cairo.h>
 #include <gegl.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -61,11 +65,13 @@
 #include "core/gimplinklayer.h"
 #include "core/gimplist.h"
 #include "core/gimpparasitelist.h"
+#include "core/gimppickable.h"
 #include "core/gimpprogress.h"
 #include "core/gimprasterizable.h"
 #include "core/gimpsamplepoint.h"
 #include "core/gimpstrokeoptions.h"
 #include "core/gimpsymmetry.h"
+#include "core/gimpviewable.h"
 
 #include "operations/layer-modes/gimp-layer-modes.h"
 
@@ -86,15 +92,30 @@
 #include "xcf-seek.h"
 #include "xcf-write.h"
 
+#include "gimp-log.h"
 #include "gimp-intl.h"
 
 typedef void (* CompressTileFunc) (GeglRectangle  *tile_rect,
                                    guchar         *tile_data,
                                    const Babl     *format,
+                                   gint            level,
                                    guchar         *out_data,
                                    gint            out_data_max_len,
                                    gint           *lenptr);
 
+/* Where a drawable's buffer was written by the last save, attached to
+ * the buffer itself, see xcf_save_drawable_buffer()
+ */
+typedef struct
+{
+  guint       serial;
+  goffset     offset;
+  goffset     end;
+} XcfSavedBuffer;
+
+#define XCF_SAVED_BUFFER_KEY     "gimp-xcf-saved-buffer"
+#define XCF_SAVE_COPY_CHUNK_SIZE (256 * 1024)
+
 /* Per thread data for xcf_save_tile_rle */
 typedef struct
 {
@@ -103,6 +124,7 @@ typedef struct
   gint              file_version;
   gint              max_out_data_len;
   CompressTileFunc  compress;
+  gint              compression_level;
 
   /* Job specific. */
   gint              tile;
@@ -119,6 +141,9 @@ typedef struct
 static gboolean xcf_save_image_props   (XcfInfo           *info,
                                         GimpImage         *image,
                                         GError           **error);
+static gchar  * xcf_save_thumbnail     (XcfInfo           *info,
+                                        GimpImage         *image,
+                                        gsize             *data_size);
 static gboolean xcf_save_layer_props   (XcfInfo           *info,
                                         GimpImage         *image,
                                         GimpLayer         *layer,
@@ -165,6 +190,19 @@ static gboolean xcf_save_path          (XcfInfo           *info,
                                         GimpImage         *image,
                                         GimpPath          *path,
                                         GError           **error);
+static gboolean xcf_save_drawable_buffer
+                                       (XcfInfo           *info,
+                                        GimpImage         *image,
+                                        GimpDrawable      *drawable,
+                                        GError           **error);
+static gboolean xcf_save_buffer_copy   (XcfInfo           *info,
+                                        GeglBuffer        *buffer,
+                                        XcfSavedBuffer    *saved,
+                                        GError           **error);
+static void     xcf_save_buffer_changed
+                                       (GeglBuffer          *buffer,
+                                        const GeglRectangle *rect,
+                                        gpointer             data);
 static gboolean xcf_save_buffer        (XcfInfo           *info,
                                         GimpImage         *image,
                                         GeglBuffer        *buffer,
@@ -187,15 +225,26 @@ static void     xcf_save_tile_parallel (XcfJobData        *job_data,
 static void     xcf_save_tile_rle      (GeglRectangle     *tile_rect,
                                         guchar            *tile_data,
                                         const Babl        *format,
+                                        gint               level,
                                         guchar            *rlebuf,
                                         gint               rlebuf_max_len,
                                         gint              *lenptr);
 static void     xcf_save_tile_zlib     (GeglRectangle     *tile_rect,
                                         guchar            *tile_data,
                                         const Babl        *format,
+                                        gint               level,
                                         guchar            *zlib_data,
                                         gint               zlib_data_max_len,
                                         gint              *lenptr);
+#ifdef HAVE_ZSTD
+static void     xcf_save_tile_zstd     (GeglRectangle     *tile_rect,
+                                        guchar            *tile_data,
+                                        const Babl        *format,
+                                        gint               level,
+                                        guchar            *zstd_data,
+                                        gint               zstd_data_max_len,
+                                        gint              *lenptr);
+#endif
 static gboolean xcf_save_parasite      (XcfInfo           *info,
                                         GimpParasite      *parasite,
                                         GError           **error);
@@ -497,6 +546,8 @@ xcf_save_image_props (XcfInfo    *info,
   GList            *symmetry_parasites = NULL;
   GList            *iter;
   GimpUnit         *unit          = gimp_image_get_unit (image);
+  gchar            *thumbnail;
+  gsize             thumbnail_size;
   gdouble           xres;
   gdouble           yres;
 
@@ -625,6 +676,16 @@ xcf_save_image_props (XcfInfo    *info,
   g_list_free_full (symmetry_parasites,
                     (GDestroyNotify) gimp_parasite_free);
 
+  thumbnail = xcf_save_thumbnail (info, image, &thumbnail_size);
+
+  if (thumbnail)
+    {
+      xcf_check_error (xcf_save_prop (info, image, PROP_THUMBNAIL, error,
+                                      thumbnail, thumbnail_size),
+                       g_free (thumbnail));
+      g_free (thumbnail);
+    }
+
   info->layer_sets = gimp_image_get_stored_item_sets (image, GIMP_TYPE_LAYER);
   info->channel_sets = gimp_image_get_stored_item_sets (image, GIMP_TYPE_CHANNEL);
 
@@ -638,6 +699,62 @@ xcf_save_image_props (XcfInfo    *info,
   return TRUE;
 }
 
+/* Renders a PNG preview of the image's projection, which lets
+ * xcf_load_thumbnail() create thumbnails without loading the image.
+ */
+static gchar *
+xcf_save_thumbnail (XcfInfo   *info,
+                    GimpImage *image,
+                    gsize     *data_size)
+{
+  GdkPixbuf *pixbuf;
+  gchar     *data = NULL;
+  gint       width;
+  gint       height;
+
+  /*  not worth it for the clipboard  */
+  if (! info->file)
+    return NULL;
+
+  width  = gimp_image_get_width  (image);
+  height = gimp_image_get_height (image);
+
+  if (width > XCF_THUMBNAIL_SIZE || height > XCF_THUMBNAIL_SIZE)
+    {
+      if (width < height)
+        {
+          width  = MAX (1, XCF_THUMBNAIL_SIZE * width / height);
+          height = XCF_THUMBNAIL_SIZE;
+        }
+      else
+        {
+          height = MAX (1, XCF_THUMBNAIL_SIZE * height / width);
+          width  = XCF_THUMBNAIL_SIZE;
+        }
+    }
+
+  gimp_pickable_flush (GIMP_PICKABLE (image));
+
+  pixbuf = gimp_viewable_get_new_pixbuf (GIMP_VIEWABLE (image),
+                                         /* random context, unused */
+                                         gimp_get_user_context (image->gimp),
+                                         width, height, NULL);
+
+  /*  when layer previews are disabled, we won't get a pixbuf  */
+  if (! pixbuf)
+    return NULL;
+
+  if (! gdk_pixbuf_save_to_buffer (pixbuf, &data, data_size, "png",
+                                   NULL, NULL))
+    {
+      data = NULL;
+    }
+
+  g_object_unref (pixbuf);
+
+  return data;
+}
+
 static gboolean
 xcf_save_layer_props (XcfInfo    *info,
                       GimpImage  *image,
@@ -1564,6 +1681,20 @@ xcf_save_prop (XcfInfo    *info,
       }
       break;
 
+    case PROP_THUMBNAIL:
+      {
+        const guint8 *data      = va_arg (args, const guint8 *);
+        gsize         data_size = va_arg (args, gsize);
+
+        size = data_size;
+
+        xcf_write_prop_type_check_error (info, prop_type, va_end (args));
+        xcf_write_int32_check_error (info, &size, 1, va_end (args));
+
+        xcf_write_int8_check_error (info, data, size, va_end (args));
+      }
+      break;
+
     case PROP_UNIT:
       {
         GimpUnit *unit       = va_arg (args, GimpUnit *);
@@ -2091,9 +2222,9 @@ xcf_save_layer (XcfInfo    *info,
   for (gint i = 0; i < num_effects + 1; i++)
     xcf_write_zero_offset_check_error (info, 1, ;);
 
-  xcf_check_error (xcf_save_buffer (info, image,
-                                    gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                    error), ;);
+  xcf_check_error (xcf_save_drawable_buffer (info, image,
+                                             GIMP_DRAWABLE (layer),
+                                             error), ;);
 
   offset = info->cp;
 
@@ -2194,9 +2325,9 @@ xcf_save_channel (XcfInfo      *info,
   offset = info->cp + info->bytes_per_offset;
   xcf_write_offset_check_error (info, &offset, 1, ;);
 
-  xcf_check_error (xcf_save_buffer (info, image,
-                                    gimp_drawable_get_buffer (GIMP_DRAWABLE (channel)),
-                                    error), ;);
+  xcf_check_error (xcf_save_drawable_buffer (info, image,
+                                             GIMP_DRAWABLE (channel),
+                                             error), ;);
 
   return TRUE;
 }
@@ -2481,6 +2612,227 @@ xcf_calc_levels (gint size,
 }
 
 
+/* Saves the buffer of @drawable.  If the buffer didn't change since
+ * the previous save of the image, its tile hierarchy is copied from
+ * the previous file instead of being compressed again.
+ *
+ * The record of the previous save is attached to the buffer and
+ * dropped on its first "changed" signal, which every write to the
+ * buffer emits, no matter whether it goes through the drawable.
+ */
+static gboolean
+xcf_save_drawable_buffer (XcfInfo       *info,
+                          GimpImage     *image,
+                          GimpDrawable  *drawable,
+                          GError       **error)
+{
+  GeglBuffer     *buffer = gimp_drawable_get_buffer (drawable);
+  XcfSavedBuffer *saved;
+  goffset         offset = info->cp;
+  gboolean        copied = FALSE;
+
+  saved = g_object_get_data (G_OBJECT (buffer), XCF_SAVED_BUFFER_KEY);
+
+  if (saved                                   &&
+      info->previous                          &&
+      saved->serial == info->previous_serial  &&
+      ! gimp_drawable_is_painting (drawable)  &&
+      ! gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
+    {
+      GError *tmp_error = NULL;
+
+      copied = xcf_save_buffer_copy (info, buffer, saved, &tmp_error);
+
+      if (tmp_error)
+        {
+          g_propagate_error (error, tmp_error);
+          return FALSE;
+        }
+
+      /* the previous file doesn't contain what we expected, start over */
+      if (! copied)
+        xcf_check_error (xcf_seek_pos (info, offset, error), ;);
+    }
+
+  if (! copied)
+    xcf_check_error (xcf_save_buffer (info, image, buffer, error), ;);
+
+  GIMP_LOG (XCF, "%s buffer of '%s'",
+            copied ? "copied" : "saved",
+            gimp_object_get_name (drawable));
+
+  saved = g_new0 (XcfSavedBuffer, 1);
+
+  saved->serial = info->save_serial;
+  saved->offset = offset;
+  saved->end    = info->cp;
+
+  g_object_set_data_full (G_OBJECT (buffer), XCF_SAVED_BUFFER_KEY,
+                          saved, g_free);
+
+  if (! g_signal_handler_find (buffer, G_SIGNAL_MATCH_FUNC,
+                               0, 0, NULL,
+                               xcf_save_buffer_changed, NULL))
+    {
+      gegl_buffer_signal_connect (buffer, "changed",
+                                  G_CALLBACK (xcf_save_buffer_changed),
+                                  NULL);
+    }
+
+  return TRUE;
+}
+
+/* Copies the tile hierarchy which xcf_save_buffer() wrote for @buffer
+ * into the previous file, at @saved, relocating its offsets.  Returns
+ * FALSE, without setting @error, if the previous file doesn't look as
+ * expected; @error is only set if writing fails.
+ */
+static gboolean
+xcf_save_buffer_copy (XcfInfo         *info,
+                      GeglBuffer      *buffer,
+                      XcfSavedBuffer  *saved,
+                      GError         **error)
+{
+  XcfInfo  *previous = info->previous;
+  goffset   delta    = info->cp - saved->offset;
+  goffset  *level_offsets;
+  goffset  *tile_offsets;
+  goffset   level_end;
+  guint32   header[3];
+  guint32   level_header[2];
+  guchar   *data;
+  gint      nlevels;
+  gint      ntiles;
+  gint      i;
+  gboolean  valid     = FALSE;
+  GError   *tmp_error = NULL;
+
+  header[0] = gegl_buffer_get_width (buffer);
+  header[1] = gegl_buffer_get_height (buffer);
+  header[2] = babl_format_get_bytes_per_pixel (gegl_buffer_get_format (buffer));
+
+  nlevels = MAX (xcf_calc_levels (header[0], XCF_TILE_WIDTH),
+                 xcf_calc_levels (header[1], XCF_TILE_HEIGHT));
+  ntiles  = gimp_gegl_buffer_get_n_tile_rows (buffer, XCF_TILE_HEIGHT) *
+            gimp_gegl_buffer_get_n_tile_cols (buffer, XCF_TILE_WIDTH);
+
+  level_offsets = g_new (goffset, nlevels + 1);
+  tile_offsets  = g_new (goffset, ntiles + 1);
+
+  /* read and check the hierarchy and level headers, which are the only
+   * places containing offsets.
+   */
+  if (xcf_seek_pos (previous, saved->offset, NULL))
+    {
+      guint32 old_header[3];
+
+      if (xcf_read_int32 (previous, old_header, 3) == 3 * 4            &&
+          ! memcmp (old_header, header, sizeof (header))               &&
+          xcf_read_offset (previous, level_offsets, nlevels + 1) ==
+          (nlevels + 1) * previous->bytes_per_offset                   &&
+          level_offsets[0] == previous->cp                             &&
+          level_offsets[nlevels] == 0)
+        {
+          level_end = nlevels > 1 ? level_offsets[1] : saved->end;
+
+          valid = (level_end > level_offsets[0] && level_end <= saved->end);
+        }
+    }
+
+  if (valid)
+    {
+      valid = FALSE;
+
+      if (xcf_read_int32 (previous, level_header, 2) == 2 * 4  &&
+          level_header[0] == header[0]                          &&
+          level_header[1] == header[1]                          &&
+          xcf_read_offset (previous, tile_offsets, ntiles + 1) ==
+          (ntiles + 1) * previous->bytes_per_offset             &&
+          tile_offsets[0] == previous->cp                       &&
+          tile_offsets[ntiles] == 0)
+        {
+          valid = TRUE;
+
+          for (i = 1; i < ntiles && valid; i++)
+            {
+              valid = (tile_offsets[i] >= tile_offsets[i - 1] &&
+                       tile_offsets[i] <= level_end);
+            }
+        }
+    }
+
+  if (! valid)
+    {
+      g_free (level_offsets);
+      g_free (tile_offsets);
+
+      return FALSE;
+    }
+
+  for (i = 0; i < nlevels; i++)
+    level_offsets[i] += delta;
+
+  for (i = 0; i < ntiles; i++)
+    tile_offsets[i] += delta;
+
+  xcf_write_int32_check_error  (info, header, 3,
+                                g_free (level_offsets);
+                                g_free (tile_offsets));
+  xcf_write_offset_check_error (info, level_offsets, nlevels + 1,
+                                g_free (level_offsets);
+                                g_free (tile_offsets));
+  xcf_write_int32_check_error  (info, level_header, 2,
+                                g_free (level_offsets);
+                                g_free (tile_offsets));
+  xcf_write_offset_check_error (info, tile_offsets, ntiles + 1,
+                                g_free (level_offsets);
+                                g_free (tile_offsets));
+
+  g_free (level_offsets);
+  g_free (tile_offsets);
+
+  /* the tile data and the dummy levels don't contain any offsets and
+   * are copied verbatim.
+   */
+  data = g_malloc (XCF_SAVE_COPY_CHUNK_SIZE);
+
+  while (previous->cp < saved->end)
+    {
+      gsize size = MIN (saved->end - previous->cp, XCF_SAVE_COPY_CHUNK_SIZE);
+      gsize bytes_read;
+
+      if (! g_input_stream_read_all (previous->input, data, size,
+                                     &bytes_read, NULL, NULL) ||
+          bytes_read != size)
+        {
+          g_free (data);
+
+          return FALSE;
+        }
+
+      previous->cp += bytes_read;
+
+      xcf_write_int8_check_error (info, data, size, g_free (data));
+    }
+
+  g_free (data);
+
+  return TRUE;
+}
+
+/* can be called from any thread writing to the buffer */
+static void
+xcf_save_buffer_changed (GeglBuffer          *buffer,
+                         const GeglRectangle *rect,
+                         gpointer             data)
+{
+  g_object_set_data (G_OBJECT (buffer), XCF_SAVED_BUFFER_KEY, NULL);
+
+  g_signal_handlers_disconnect_by_func (buffer,
+                                        xcf_save_buffer_changed,
+                                        NULL);
+}
+
 static gboolean
 xcf_save_buffer (XcfInfo     *info,
                  GimpImage   *image,
@@ -2637,10 +2989,12 @@ xcf_save_level (XcfInfo     *info,
   offset = info->cp;
 
   if (info->compression == COMPRESS_RLE ||
-      info->compression == COMPRESS_ZLIB)
+      info->compression == COMPRESS_ZLIB ||
+      info->compression == COMPRESS_ZSTD)
     {
       /* parallel implementation */
-      XcfJobData  *job_data;
+      XcfJobData      *job_data;
+      CompressTileFunc compress;
       guchar      *switch_out_data;
       gint         out_data_len[XCF_TILE_SAVE_BATCH_SIZE];
 
@@ -2652,6 +3006,26 @@ xcf_save_level (XcfInfo     *info,
       gint         next_tile = 0;
 
       out_data_max_size = tile_size * XCF_TILE_MAX_DATA_LENGTH_FACTOR;
+
+      switch (info->compression)
+        {
+        case COMPRESS_RLE:
+          compress = xcf_save_tile_rle;
+          break;
+#ifdef HAVE_ZSTD
+        case COMPRESS_ZSTD:
+          compress = xcf_save_tile_zstd;
+          break;
+#endif
+        case COMPRESS_ZLIB:
+          compress = xcf_save_tile_zlib;
+          break;
+        default:
+          g_warning ("xcf: unsupported compression algorithm");
+          g_free (offset_table);
+          return FALSE;
+        }
+
       /* Prepare an additional out_data to quickly switch. */
       switch_out_data   = g_malloc (out_data_max_size * XCF_TILE_SAVE_BATCH_SIZE);
 
@@ -2676,8 +3050,8 @@ xcf_save_level (XcfInfo     *info,
           job_data->buffer        = buffer;
           job_data->file_version  = info->file_version;
           job_data->max_out_data_len = out_data_max_size;
-          job_data->compress      = (info->compression == COMPRESS_RLE) ?
-                                      xcf_save_tile_rle : xcf_save_tile_zlib;
+          job_data->compress      = compress;
+          job_data->compression_level = info->compression_level;
           job_data->tile_data     = g_malloc (tile_size);
           job_data->out_data      = g_malloc (out_data_max_size * XCF_TILE_SAVE_BATCH_SIZE);
 
@@ -2937,6 +3311,7 @@ xcf_save_tile_parallel (XcfJobData  *job_data,
         }
 
       job_data->compress (&tile_rect, job_data->tile_data, format,
+                          job_data->compression_level,
                           job_data->out_data + job_data->max_out_data_len * i,
                           job_data->max_out_data_len,
                           job_data->out_data_len + i);
@@ -2951,6 +3326,7 @@ static void
 xcf_save_tile_rle (GeglRectangle  *tile_rect,
                    guchar         *tile_data,
                    const Babl     *format,
+                   gint            level,
                    guchar         *rlebuf,
                    gint            rlebuf_max_len,
                    gint           *lenptr)
@@ -3069,6 +3445,7 @@ static void
 xcf_save_tile_zlib (GeglRectangle  *tile_rect,
                     guchar         *tile_data,
                     const Babl     *format,
+                    gint            level,
                     guchar         *zlib_data,
                     gint            zlib_data_max_len,
                     gint           *lenptr)
@@ -3129,6 +3506,52 @@ xcf_save_tile_zlib (GeglRectangle  *tile_rect,
   deflateEnd (&strm);
 }
 
+#ifdef HAVE_ZSTD
+static void
+xcf_save_tile_zstd (GeglRectangle  *tile_rect,
+                    guchar         *tile_data,
+                    const Babl     *format,
+                    gint            level,
+                    guchar         *zstd_data,
+                    gint            zstd_data_max_len,
+                    gint           *lenptr)
+{
+  /* compression contexts are reused across the tiles a worker thread
+   * compresses, allocating them is not cheap at higher levels.
+   */
+  static GPrivate  cctx_private = G_PRIVATE_INIT ((GDestroyNotify) ZSTD_freeCCtx);
+  ZSTD_CCtx       *cctx;
+  gint             bpp          = babl_format_get_bytes_per_pixel (format);
+  gint             tile_size    = bpp * tile_rect->width * tile_rect->height;
+  size_t           size;
+
+  *lenptr = 0;
+
+  cctx = g_private_get (&cctx_private);
+
+  if (! cctx)
+    {
+      cctx = ZSTD_createCCtx ();
+      if (! cctx)
+        return;
+
+      g_private_set (&cctx_private, cctx);
+    }
+
+  size = ZSTD_compressCCtx (cctx, zstd_data, zstd_data_max_len,
+                            tile_data, tile_size, level);
+
+  if (ZSTD_isError (size))
+    {
+      g_printerr ("xcf: tile compression failed: %s",
+                  ZSTD_getErrorName (size));
+      return;
+    }
+
+  *lenptr = size;
+}
+#endif
+
 static gboolean
 xcf_save_parasite (XcfInfo       *info,
                    GimpParasite  *parasite,
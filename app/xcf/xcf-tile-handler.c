@@ -0,0 +1,673 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core/core-types.h"
+
+#include "core/gimp.h"
+
+#include "xcf-private.h"
+#include "xcf-load.h"
+#include "xcf-tile-handler.h"
+
+#include "gimp-intl.h"
+
+
+struct _XcfTileFile
+{
+  gint          ref_count;
+  Gimp         *gimp;
+  GFile        *file;
+  GInputStream *input;
+  GMutex        mutex;
+
+  /*  the file as it was when it was opened  */
+  goffset       size;
+  guint64       mtime;
+  guint32       mtime_usec;
+
+  gboolean      modified;
+  gint          failed;
+};
+
+#define XCF_TILE_FILE_ATTRIBUTES    \
+  G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+
+static void       xcf_tile_handler_finalize  (GObject         *object);
+
+static gpointer   xcf_tile_handler_command   (GeglTileSource  *source,
+                                              GeglTileCommand  command,
+                                              gint             x,
+                                              gint             y,
+                                              gint             z,
+                                              gpointer         data);
+
+static GeglTile * xcf_tile_handler_load_tile (XcfTileHandler  *handler,
+                                              gint             x,
+                                              gint             y);
+static void       xcf_tile_handler_loaded    (XcfTileHandler  *handler,
+                                              gint             x,
+                                              gint             y);
+
+static gsize      xcf_tile_file_read         (XcfTileFile     *file,
+                                              goffset          offset,
+                                              guchar          *data,
+                                              gsize            length);
+static void       xcf_tile_file_failed       (XcfTileFile     *file);
+static gboolean   xcf_tile_file_report_idle  (XcfTileFile     *file);
+
+
+G_DEFINE_TYPE (XcfTileHandler, xcf_tile_handler, GEGL_TYPE_TILE_HANDLER)
+
+#define parent_class xcf_tile_handler_parent_class
+
+/*  all handlers, so that their tiles can be loaded before their file
+ *  is overwritten
+ */
+static GList  *xcf_tile_handlers = NULL;
+static GMutex  xcf_tile_handlers_mutex;
+
+
+static void
+xcf_tile_handler_class_init (XcfTileHandlerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = xcf_tile_handler_finalize;
+}
+
+static void
+xcf_tile_handler_init (XcfTileHandler *handler)
+{
+  GeglTileSource *source = GEGL_TILE_SOURCE (handler);
+
+  source->command = xcf_tile_handler_command;
+
+  g_mutex_init (&handler->mutex);
+}
+
+static void
+xcf_tile_handler_finalize (GObject *object)
+{
+  XcfTileHandler *handler = XCF_TILE_HANDLER (object);
+
+  g_mutex_lock (&xcf_tile_handlers_mutex);
+  xcf_tile_handlers = g_list_remove (xcf_tile_handlers, handler);
+  g_mutex_unlock (&xcf_tile_handlers_mutex);
+
+  g_clear_pointer (&handler->file, xcf_tile_file_unref);
+  g_clear_pointer (&handler->offsets, g_free);
+  g_clear_pointer (&handler->lengths, g_free);
+  g_clear_pointer (&handler->pending, g_free);
+
+  g_mutex_clear (&handler->mutex);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gpointer
+xcf_tile_handler_command (GeglTileSource  *source,
+                          GeglTileCommand  command,
+                          gint             x,
+                          gint             y,
+                          gint             z,
+                          gpointer         data)
+{
+  XcfTileHandler *handler = XCF_TILE_HANDLER (source);
+  gboolean        pending = FALSE;
+  GeglTile       *tile    = NULL;
+
+  /*  n_pending only ever decreases, so once it's 0 we don't need to
+   *  lock anymore
+   */
+  if (z != 0 || ! g_atomic_int_get (&handler->n_pending) ||
+      x < 0  || x >= handler->n_tile_cols                 ||
+      y < 0  || y >= handler->n_tile_rows)
+    {
+      return gegl_tile_handler_source_command (source, command, x, y, z, data);
+    }
+
+  g_mutex_lock (&handler->mutex);
+
+  if (handler->pending)
+    pending = handler->pending[y * handler->n_tile_cols + x];
+
+  if (pending)
+    {
+      switch (command)
+        {
+        case GEGL_TILE_GET:
+        case GEGL_TILE_COPY:
+          tile = xcf_tile_handler_load_tile (handler, x, y);
+
+          xcf_tile_handler_loaded (handler, x, y);
+          break;
+
+        case GEGL_TILE_SET:
+        case GEGL_TILE_VOID:
+          /*  the tile is being overwritten, don't load it anymore  */
+          xcf_tile_handler_loaded (handler, x, y);
+          break;
+
+        case GEGL_TILE_EXIST:
+          g_mutex_unlock (&handler->mutex);
+
+          return GINT_TO_POINTER (TRUE);
+
+        default:
+          break;
+        }
+    }
+
+  g_mutex_unlock (&handler->mutex);
+
+  if (tile)
+    {
+      if (command == GEGL_TILE_GET)
+        return tile;
+
+      /*  store the loaded tile below us, so that it can be copied from
+       *  there
+       */
+      gegl_tile_handler_source_command (source, GEGL_TILE_SET, x, y, 0, tile);
+      gegl_tile_unref (tile);
+    }
+
+  return gegl_tile_handler_source_command (source, command, x, y, z, data);
+}
+
+/*  returns NULL if the tile is empty in the file  */
+static GeglTile *
+xcf_tile_handler_load_tile (XcfTileHandler *handler,
+                            gint            x,
+                            gint            y)
+{
+  GeglTile      *tile = NULL;
+  GeglRectangle  tile_rect;
+  guchar        *tile_data;
+  gint           tile_stride;
+  guchar        *in_data;
+  guchar        *xcf_data;
+  gsize          in_size;
+  gint           bpp;
+  gint           row;
+  gint           col;
+
+  bpp         = babl_format_get_bytes_per_pixel (handler->format);
+  tile_stride = handler->tile_width * bpp;
+
+  tile_rect.x      = x * handler->tile_width;
+  tile_rect.y      = y * handler->tile_height;
+  tile_rect.width  = handler->tile_width;
+  tile_rect.height = handler->tile_height;
+
+  if (! gegl_rectangle_intersect (&tile_rect, &tile_rect,
+                                  GEGL_RECTANGLE (0, 0,
+                                                  handler->width,
+                                                  handler->height)))
+    {
+      return NULL;
+    }
+
+  in_size  = XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp *
+             XCF_TILE_MAX_DATA_LENGTH_FACTOR;
+  in_data  = gegl_scratch_alloc (in_size);
+  xcf_data = gegl_scratch_alloc (XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp);
+
+  for (row  = tile_rect.y / XCF_TILE_HEIGHT;
+       row <= (tile_rect.y + tile_rect.height - 1) / XCF_TILE_HEIGHT;
+       row++)
+    {
+      for (col  = tile_rect.x / XCF_TILE_WIDTH;
+           col <= (tile_rect.x + tile_rect.width - 1) / XCF_TILE_WIDTH;
+           col++)
+        {
+          gint          i = row * handler->n_cols + col;
+          GeglRectangle xcf_rect;
+          GeglRectangle rect;
+          gsize         length;
+          gboolean      nonzero;
+          gint          j;
+
+          if (handler->lengths[i] <= 0)
+            continue;
+
+          length = xcf_tile_file_read (handler->file, handler->offsets[i],
+                                       in_data,
+                                       MIN (handler->lengths[i], in_size));
+
+          xcf_rect.x      = col * XCF_TILE_WIDTH;
+          xcf_rect.y      = row * XCF_TILE_HEIGHT;
+          xcf_rect.width  = MIN (XCF_TILE_WIDTH,  handler->width  - xcf_rect.x);
+          xcf_rect.height = MIN (XCF_TILE_HEIGHT, handler->height - xcf_rect.y);
+
+          if (length == 0 ||
+              ! xcf_load_decode_tile (handler->compression,
+                                      handler->file_version,
+                                      handler->format,
+                                      in_data, length, xcf_data,
+                                      xcf_rect.width * xcf_rect.height,
+                                      &nonzero))
+            {
+              /*  the tile is left transparent, but the user needs to
+               *  know that the image isn't what was saved
+               */
+              xcf_tile_file_failed (handler->file);
+              continue;
+            }
+
+          if (! nonzero)
+            continue;
+
+          if (! tile)
+            {
+              tile = gegl_tile_handler_get_source_tile (
+                GEGL_TILE_HANDLER (handler), x, y, 0, FALSE);
+
+              gegl_tile_lock (tile);
+
+              tile_data = gegl_tile_get_data (tile);
+
+              memset (tile_data, 0, tile_stride * handler->tile_height);
+            }
+
+          gegl_rectangle_intersect (&rect, &xcf_rect, &tile_rect);
+
+          for (j = 0; j < rect.height; j++)
+            {
+              memcpy (tile_data +
+                      (rect.y - y * handler->tile_height + j) * tile_stride +
+                      (rect.x - x * handler->tile_width) * bpp,
+                      xcf_data +
+                      ((rect.y - xcf_rect.y + j) * xcf_rect.width +
+                       (rect.x - xcf_rect.x)) * bpp,
+                      rect.width * bpp);
+            }
+        }
+    }
+
+  if (tile)
+    gegl_tile_unlock (tile);
+
+  gegl_scratch_free (xcf_data);
+  gegl_scratch_free (in_data);
+
+  return tile;
+}
+
+/*  must be called with the handler's mutex held  */
+static void
+xcf_tile_handler_loaded (XcfTileHandler *handler,
+                         gint            x,
+                         gint            y)
+{
+  handler->pending[y * handler->n_tile_cols + x] = FALSE;
+
+  if (g_atomic_int_dec_and_test (&handler->n_pending))
+    {
+      /*  everything is loaded, we don't need the file anymore  */
+      g_clear_pointer (&handler->file, xcf_tile_file_unref);
+      g_clear_pointer (&handler->offsets, g_free);
+      g_clear_pointer (&handler->lengths, g_free);
+      g_clear_pointer (&handler->pending, g_free);
+    }
+}
+
+static gsize
+xcf_tile_file_read (XcfTileFile *file,
+                    goffset      offset,
+                    guchar      *data,
+                    gsize        length)
+{
+  GFileInfo *info;
+  gsize      bytes_read = 0;
+
+  g_mutex_lock (&file->mutex);
+
+  /*  the file may have been overwritten in place by another program,
+   *  don't read garbage from it then
+   */
+  if (! file->modified)
+    {
+      info = g_file_input_stream_query_info (G_FILE_INPUT_STREAM (file->input),
+                                             XCF_TILE_FILE_ATTRIBUTES,
+                                             NULL, NULL);
+
+      if (! info                                                         ||
+          g_file_info_get_size (info) != file->size                      ||
+          g_file_info_get_attribute_uint64 (
+            info, G_FILE_ATTRIBUTE_TIME_MODIFIED)      != file->mtime    ||
+          g_file_info_get_attribute_uint32 (
+            info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC) != file->mtime_usec)
+        {
+          file->modified = TRUE;
+        }
+
+      g_clear_object (&info);
+    }
+
+  /*  we may be reading past the end of the file here, like
+   *  xcf_load_tile_rle() and friends
+   */
+  if (! file->modified &&
+      g_seekable_seek (G_SEEKABLE (file->input), offset, G_SEEK_SET,
+                       NULL, NULL))
+    {
+      g_input_stream_read_all (file->input, data, length,
+                               &bytes_read, NULL, NULL);
+    }
+
+  g_mutex_unlock (&file->mutex);
+
+  return bytes_read;
+}
+
+/*  may be called from any thread  */
+static void
+xcf_tile_file_failed (XcfTileFile *file)
+{
+  /*  only tell the user once per file  */
+  if (g_atomic_int_compare_and_exchange (&file->failed, FALSE, TRUE))
+    {
+      g_idle_add_full (G_PRIORITY_DEFAULT,
+                       (GSourceFunc) xcf_tile_file_report_idle,
+                       xcf_tile_file_ref (file),
+                       (GDestroyNotify) xcf_tile_file_unref);
+    }
+}
+
+static gboolean
+xcf_tile_file_report_idle (XcfTileFile *file)
+{
+  gboolean modified;
+
+  g_mutex_lock (&file->mutex);
+  modified = file->modified;
+  g_mutex_unlock (&file->mutex);
+
+  if (modified)
+    gimp_message (file->gimp, NULL, GIMP_MESSAGE_WARNING,
+                  _("'%s' was modified while the image loaded from it "
+                    "was still open.  The parts of the image which were "
+                    "not loaded yet have been left transparent."),
+                  gimp_file_get_utf8_name (file->file));
+  else
+    gimp_message (file->gimp, NULL, GIMP_MESSAGE_WARNING,
+                  _("Some of the pixel data of '%s' could not be read.  "
+                    "The affected areas of the image have been left "
+                    "transparent."),
+                  gimp_file_get_utf8_name (file->file));
+
+  return G_SOURCE_REMOVE;
+}
+
+
+/*  public functions  */
+
+XcfTileFile *
+xcf_tile_file_new (Gimp  *gimp,
+                   GFile *file)
+{
+  XcfTileFile  *tile_file;
+  GInputStream *input;
+  GFileInfo    *info;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  input = G_INPUT_STREAM (g_file_read (file, NULL, NULL));
+
+  if (! input)
+    return NULL;
+
+  if (! G_IS_SEEKABLE (input) || ! g_seekable_can_seek (G_SEEKABLE (input)))
+    {
+      g_object_unref (input);
+
+      return NULL;
+    }
+
+  info = g_file_input_stream_query_info (G_FILE_INPUT_STREAM (input),
+                                         XCF_TILE_FILE_ATTRIBUTES,
+                                         NULL, NULL);
+
+  if (! info)
+    {
+      g_object_unref (input);
+
+      return NULL;
+    }
+
+  tile_file = g_slice_new0 (XcfTileFile);
+
+  tile_file->ref_count  = 1;
+  tile_file->gimp       = gimp;
+  tile_file->file       = g_object_ref (file);
+  tile_file->input      = input;
+  tile_file->size       = g_file_info_get_size (info);
+  tile_file->mtime      = g_file_info_get_attribute_uint64 (
+                            info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  tile_file->mtime_usec = g_file_info_get_attribute_uint32 (
+                            info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+  g_object_unref (info);
+
+  g_mutex_init (&tile_file->mutex);
+
+  return tile_file;
+}
+
+XcfTileFile *
+xcf_tile_file_ref (XcfTileFile *file)
+{
+  g_return_val_if_fail (file != NULL, NULL);
+
+  g_atomic_int_inc (&file->ref_count);
+
+  return file;
+}
+
+void
+xcf_tile_file_unref (XcfTileFile *file)
+{
+  g_return_if_fail (file != NULL);
+
+  if (g_atomic_int_dec_and_test (&file->ref_count))
+    {
+      g_input_stream_close (file->input, NULL, NULL);
+      g_object_unref (file->input);
+      g_object_unref (file->file);
+
+      g_mutex_clear (&file->mutex);
+
+      g_slice_free (XcfTileFile, file);
+    }
+}
+
+/*  @offsets is the level's tile offset table, as read by
+ *  xcf_load_level(), including its terminating 0
+ */
+GeglTileHandler *
+xcf_tile_handler_new (XcfTileFile        *file,
+                      XcfCompressionType  compression,
+                      gint                file_version,
+                      const Babl         *format,
+                      gint                width,
+                      gint                height,
+                      const goffset      *offsets,
+                      goffset             max_data_length)
+{
+  XcfTileHandler *handler;
+  gint            n_tiles;
+  gint            i;
+
+  g_return_val_if_fail (file != NULL, NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (offsets != NULL, NULL);
+
+  handler = g_object_new (XCF_TYPE_TILE_HANDLER, NULL);
+
+  handler->file         = xcf_tile_file_ref (file);
+  handler->compression  = compression;
+  handler->file_version = file_version;
+  handler->format       = format;
+  handler->width        = width;
+  handler->height       = height;
+
+  handler->n_cols = (width + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH;
+  n_tiles         = handler->n_cols *
+                    ((height + XCF_TILE_HEIGHT - 1) / XCF_TILE_HEIGHT);
+
+  handler->offsets = g_new (goffset, n_tiles);
+  handler->lengths = g_new (gint,    n_tiles);
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      goffset offset2 = offsets[i + 1] ? offsets[i + 1] :
+                                         offsets[i] + max_data_length;
+
+      handler->offsets[i] = offsets[i];
+      handler->lengths[i] = offset2 - offsets[i];
+    }
+
+  g_mutex_lock (&xcf_tile_handlers_mutex);
+  xcf_tile_handlers = g_list_prepend (xcf_tile_handlers, handler);
+  g_mutex_unlock (&xcf_tile_handlers_mutex);
+
+  return GEGL_TILE_HANDLER (handler);
+}
+
+void
+xcf_tile_handler_assign (XcfTileHandler *handler,
+                         GeglBuffer     *buffer)
+{
+  g_return_if_fail (XCF_IS_TILE_HANDLER (handler));
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (handler->buffer == NULL);
+
+  g_object_get (buffer,
+                "tile-width",  &handler->tile_width,
+                "tile-height", &handler->tile_height,
+                NULL);
+
+  handler->n_tile_cols = (handler->width  + handler->tile_width  - 1) /
+                         handler->tile_width;
+  handler->n_tile_rows = (handler->height + handler->tile_height - 1) /
+                         handler->tile_height;
+
+  handler->pending   = g_new (guint8, handler->n_tile_cols *
+                                      handler->n_tile_rows);
+  handler->n_pending = handler->n_tile_cols * handler->n_tile_rows;
+
+  memset (handler->pending, TRUE, handler->n_pending);
+
+  /*  the buffer owns the handler, don't create a reference cycle  */
+  handler->buffer = buffer;
+
+  gegl_buffer_add_handler (buffer, handler);
+}
+
+/*  loads all the tiles which weren't accessed yet  */
+void
+xcf_tile_handler_load_all (XcfTileHandler *handler)
+{
+  gint x;
+  gint y;
+
+  g_return_if_fail (XCF_IS_TILE_HANDLER (handler));
+
+  for (y = 0; y < handler->n_tile_rows; y++)
+    {
+      for (x = 0; x < handler->n_tile_cols; x++)
+        {
+          GeglBufferIterator *iter;
+          gboolean            pending;
+
+          if (! g_atomic_int_get (&handler->n_pending))
+            return;
+
+          g_mutex_lock (&handler->mutex);
+          pending = handler->pending[y * handler->n_tile_cols + x];
+          g_mutex_unlock (&handler->mutex);
+
+          if (! pending)
+            continue;
+
+          /*  reading the tile's data through the buffer loads it, and
+           *  puts it in the buffer's cache
+           */
+          iter = gegl_buffer_iterator_new (
+            handler->buffer,
+            GEGL_RECTANGLE (x * handler->tile_width,
+                            y * handler->tile_height,
+                            handler->tile_width,
+                            handler->tile_height),
+            0, handler->format,
+            GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+
+          while (gegl_buffer_iterator_next (iter));
+        }
+    }
+}
+
+/*  loads the pending tiles of all buffers loaded from @file, which is
+ *  about to be overwritten
+ */
+void
+xcf_tile_handler_load_file (GFile *file)
+{
+  GList *handlers = NULL;
+  GList *list;
+
+  g_return_if_fail (G_IS_FILE (file));
+
+  g_mutex_lock (&xcf_tile_handlers_mutex);
+
+  for (list = xcf_tile_handlers; list; list = g_list_next (list))
+    {
+      XcfTileHandler *handler = list->data;
+      gboolean        matches = FALSE;
+
+      g_mutex_lock (&handler->mutex);
+
+      if (handler->file && handler->buffer)
+        matches = g_file_equal (handler->file->file, file);
+
+      g_mutex_unlock (&handler->mutex);
+
+      if (matches)
+        handlers = g_list_prepend (handlers, g_object_ref (handler));
+    }
+
+  g_mutex_unlock (&xcf_tile_handlers_mutex);
+
+  for (list = handlers; list; list = g_list_next (list))
+    xcf_tile_handler_load_all (list->data);
+
+  g_list_free_full (handlers, g_object_unref);
+}
@@ -0,0 +1,94 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gegl-buffer-backend.h>
+
+
+/***
+ * XcfTileHandler is a GeglTileHandler which loads the tiles of a
+ * buffer from an XCF file the first time they are accessed.
+ */
+
+#define XCF_TYPE_TILE_HANDLER            (xcf_tile_handler_get_type ())
+#define XCF_TILE_HANDLER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), XCF_TYPE_TILE_HANDLER, XcfTileHandler))
+#define XCF_TILE_HANDLER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  XCF_TYPE_TILE_HANDLER, XcfTileHandlerClass))
+#define XCF_IS_TILE_HANDLER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), XCF_TYPE_TILE_HANDLER))
+#define XCF_IS_TILE_HANDLER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  XCF_TYPE_TILE_HANDLER))
+#define XCF_TILE_HANDLER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  XCF_TYPE_TILE_HANDLER, XcfTileHandlerClass))
+
+
+typedef struct _XcfTileHandler      XcfTileHandler;
+typedef struct _XcfTileHandlerClass XcfTileHandlerClass;
+
+struct _XcfTileHandler
+{
+  GeglTileHandler     parent_instance;
+
+  GMutex              mutex;
+
+  XcfTileFile        *file;
+  XcfCompressionType  compression;
+  gint                file_version;
+  const Babl         *format;
+  gint                width;
+  gint                height;
+
+  /*  the level's XCF tiles  */
+  gint                n_cols;
+  goffset            *offsets;
+  gint               *lengths;
+
+  /*  the buffer's tiles which are still to be loaded  */
+  GeglBuffer         *buffer;
+  gint                tile_width;
+  gint                tile_height;
+  gint                n_tile_cols;
+  gint                n_tile_rows;
+  guint8             *pending;
+  gint                n_pending;
+};
+
+struct _XcfTileHandlerClass
+{
+  GeglTileHandlerClass  parent_class;
+};
+
+
+XcfTileFile     * xcf_tile_file_new          (Gimp               *gimp,
+                                              GFile              *file);
+XcfTileFile     * xcf_tile_file_ref          (XcfTileFile        *file);
+void              xcf_tile_file_unref        (XcfTileFile        *file);
+
+
+GType             xcf_tile_handler_get_type  (void) G_GNUC_CONST;
+
+GeglTileHandler * xcf_tile_handler_new       (XcfTileFile        *file,
+                                              XcfCompressionType  compression,
+                                              gint                file_version,
+                                              const Babl         *format,
+                                              gint                width,
+                                              gint                height,
+                                              const goffset      *offsets,
+                                              goffset             max_data_length);
+
+void              xcf_tile_handler_assign    (XcfTileHandler     *handler,
+                                              GeglBuffer         *buffer);
+
+void              xcf_tile_handler_load_all  (XcfTileHandler     *handler);
+void              xcf_tile_handler_load_file (GFile              *file);
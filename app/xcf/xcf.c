@@ -29,8 +29,13 @@
 
 #include "core/core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "core/gimp.h"
 #include "core/gimpimage.h"
+#include "core/gimpimage-undo.h"
+#include "core/gimplayer.h"
+#include "core/gimplayer-new.h"
 #include "core/gimpdrawable.h"
 #include "core/gimpparamspecs.h"
 #include "core/gimpprogress.h"
@@ -43,6 +48,7 @@
 #include "xcf-load.h"
 #include "xcf-read.h"
 #include "xcf-save.h"
+#include "xcf-tile-handler.h"
 
 #include "gimp-intl.h"
 
@@ -51,6 +57,22 @@ typedef GimpImage * GimpXcfLoaderFunc (Gimp     *gimp,
                                        XcfInfo  *info,
                                        GError  **error);
 
+/* What we need to know about the last file an image was saved to, so
+ * that the next save can copy the unchanged drawables from it.
+ */
+typedef struct
+{
+  GFile              *file;
+  gchar              *etag;
+  guint               serial;
+  gint                file_version;
+  gint                bytes_per_offset;
+  XcfCompressionType  compression;
+  gint                compression_level;
+} XcfSaveState;
+
+#define XCF_SAVE_STATE_KEY "gimp-xcf-save-state"
+
 
 static GimpValueArray * xcf_load_invoker (GimpProcedure         *procedure,
                                           Gimp                  *gimp,
@@ -58,6 +80,13 @@ static GimpValueArray * xcf_load_invoker (GimpProcedure         *procedure,
                                           GimpProgress          *progress,
                                           const GimpValueArray  *args,
                                           GError               **error);
+static GimpValueArray * xcf_load_thumb_invoker
+                                         (GimpProcedure         *procedure,
+                                          Gimp                  *gimp,
+                                          GimpContext           *context,
+                                          GimpProgress          *progress,
+                                          const GimpValueArray  *args,
+                                          GError               **error);
 static GimpValueArray * xcf_save_invoker (GimpProcedure         *procedure,
                                           Gimp                  *gimp,
                                           GimpContext           *context,
@@ -65,6 +94,17 @@ static GimpValueArray * xcf_save_invoker (GimpProcedure         *procedure,
                                           const GimpValueArray  *args,
                                           GError               **error);
 
+static gboolean         xcf_load_header        (XcfInfo               *info);
+
+static gchar          * xcf_save_get_etag      (GFile                 *file);
+static void             xcf_save_state_free    (XcfSaveState          *state);
+static void             xcf_save_state_update  (GimpImage             *image,
+                                                XcfInfo               *info,
+                                                GFile                 *file);
+static gboolean         xcf_save_open_previous (GimpImage             *image,
+                                                XcfInfo               *info,
+                                                XcfInfo               *previous);
+
 
 static GimpXcfLoaderFunc * const xcf_loaders[] =
 {
@@ -94,6 +134,7 @@ static GimpXcfLoaderFunc * const xcf_loaders[] =
   xcf_load_image,   /* version 23 */
   xcf_load_image,   /* version 24 */
   xcf_load_image,   /* version 25 */
+  xcf_load_image,   /* version 26 */
 };
 
 
@@ -190,6 +231,7 @@ xcf_init (Gimp *gimp)
                                         "0,string,gimp\\040xcf\\040");
   gimp_plug_in_procedure_set_mime_types (proc, "image/x-xcf");
   gimp_plug_in_procedure_set_handles_remote (proc);
+  gimp_plug_in_procedure_set_thumb_loader (proc, "gimp-xcf-load-thumb");
 
   gimp_object_set_static_name (GIMP_OBJECT (procedure), "gimp-xcf-load");
   gimp_procedure_set_static_help (procedure,
@@ -227,6 +269,80 @@ xcf_init (Gimp *gimp)
                                                           GIMP_PARAM_READWRITE));
   gimp_plug_in_manager_add_procedure (gimp->plug_in_manager, proc);
   g_object_unref (procedure);
+
+  /*  gimp-xcf-load-thumb  */
+  file = g_file_new_for_path ("gimp-xcf-load-thumb");
+  procedure = gimp_plug_in_procedure_new (GIMP_PDB_PROC_TYPE_PLUGIN, file);
+  g_object_unref (file);
+
+  procedure->proc_type    = GIMP_PDB_PROC_TYPE_INTERNAL;
+  procedure->marshal_func = xcf_load_thumb_invoker;
+
+  proc = GIMP_PLUG_IN_PROCEDURE (procedure);
+
+  gimp_object_set_static_name (GIMP_OBJECT (procedure), "gimp-xcf-load-thumb");
+  gimp_procedure_set_static_help (procedure,
+                                  "Loads the preview of a file saved in the "
+                                  ".xcf file format",
+                                  "This procedure loads the preview which "
+                                  "is saved in XCF files, without loading "
+                                  "the image itself.  It fails if the file "
+                                  "has no preview.",
+                                  NULL);
+  gimp_procedure_set_static_attribution (procedure,
+                                         "Spencer Kimball & Peter Mattis",
+                                         "Spencer Kimball & Peter Mattis",
+                                         "1995-1996");
+
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_object ("file",
+                                                    "File",
+                                                    "The file to load",
+                                                    G_TYPE_FILE,
+                                                    GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_int ("thumb-size",
+                                                 "Thumb Size",
+                                                 "Preferred thumbnail size",
+                                                 16, GIMP_MAX_IMAGE_SIZE, 256,
+                                                 GIMP_PARAM_READWRITE));
+
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_image ("image",
+                                                          "Image",
+                                                          "Thumbnail image",
+                                                          FALSE,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_int ("image-width",
+                                                     "Image Width",
+                                                     "Width of the full-sized "
+                                                     "image",
+                                                     0, GIMP_MAX_IMAGE_SIZE, 0,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_int ("image-height",
+                                                     "Image Height",
+                                                     "Height of the full-sized "
+                                                     "image",
+                                                     0, GIMP_MAX_IMAGE_SIZE, 0,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_enum ("image-type",
+                                                         "Image Type",
+                                                         "Type of the image",
+                                                         GIMP_TYPE_IMAGE_TYPE,
+                                                         GIMP_RGB_IMAGE,
+                                                         GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_int ("num-layers",
+                                                     "Num Layers",
+                                                     "Number of layers in "
+                                                     "the image",
+                                                     0, G_MAXINT, 0,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_plug_in_manager_add_procedure (gimp->plug_in_manager, proc);
+  g_object_unref (procedure);
 }
 
 void
@@ -245,7 +361,6 @@ xcf_load_stream (Gimp          *gimp,
   XcfInfo      info  = { 0, };
   const gchar *filename;
   GimpImage   *image = NULL;
-  gchar        id[14];
   gboolean     success;
 
   g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
@@ -267,33 +382,16 @@ xcf_load_stream (Gimp          *gimp,
   info.file             = input_file;
   info.compression      = COMPRESS_NONE;
 
+  /* load the tiles of compressed levels from the file on first
+   * access, instead of all of them up front
+   */
+  if (input_file && gimp->config->xcf_lazy_load)
+    info.lazy_file = xcf_tile_file_new (gimp, input_file);
+
   if (progress)
     gimp_progress_start (progress, FALSE, _("Opening '%s'"), filename);
 
-  success = TRUE;
-
-  xcf_read_int8 (&info, (guint8 *) id, 14);
-
-  if (! g_str_has_prefix (id, "gimp xcf "))
-    {
-      success = FALSE;
-    }
-  else if (strcmp (id + 9, "file") == 0)
-    {
-      info.file_version = 0;
-    }
-  else if (id[9]  == 'v' &&
-           id[13] == '\0')
-    {
-      info.file_version = atoi (id + 10);
-    }
-  else
-    {
-      success = FALSE;
-    }
-
-  if (info.file_version >= 11)
-    info.bytes_per_offset = 8;
+  success = xcf_load_header (&info);
 
   if (success)
     {
@@ -316,6 +414,8 @@ xcf_load_stream (Gimp          *gimp,
         }
     }
 
+  g_clear_pointer (&info.lazy_file, xcf_tile_file_unref);
+
   if (progress)
     gimp_progress_end (progress);
 
@@ -330,7 +430,9 @@ xcf_save_stream (Gimp           *gimp,
                  GimpProgress   *progress,
                  GError        **error)
 {
+  static guint  serial   = 0;
   XcfInfo       info     = { 0, };
+  XcfInfo       previous = { 0, };
   const gchar  *filename;
   gboolean      success  = FALSE;
   GError       *my_error = NULL;
@@ -356,23 +458,48 @@ xcf_save_stream (Gimp           *gimp,
   info.file             = output_file;
 
   if (gimp_image_get_xcf_compression (image))
-    info.compression = COMPRESS_ZLIB;
+    {
+#ifdef HAVE_ZSTD
+      if (gimp->config->xcf_zstd_level > 0)
+        {
+          info.compression       = COMPRESS_ZSTD;
+          info.compression_level = gimp->config->xcf_zstd_level;
+        }
+      else
+#endif
+        {
+          info.compression = COMPRESS_ZLIB;
+        }
+    }
   else
-    info.compression = COMPRESS_RLE;
+    {
+      info.compression = COMPRESS_RLE;
+    }
 
   info.file_version = gimp_image_get_xcf_version (image,
-                                                  info.compression ==
-                                                  COMPRESS_ZLIB,
+                                                  info.compression !=
+                                                  COMPRESS_RLE,
                                                   NULL, NULL, NULL);
 
   if (info.file_version >= 11)
     info.bytes_per_offset = 8;
 
+  info.save_serial = ++serial;
+
+  if (xcf_save_open_previous (image, &info, &previous))
+    info.previous = &previous;
+
   if (progress)
     gimp_progress_start (progress, FALSE, _("Saving '%s'"), filename);
 
   success = xcf_save_image (&info, image, &my_error);
 
+  if (previous.input)
+    {
+      g_input_stream_close (previous.input, NULL, NULL);
+      g_object_unref (previous.input);
+    }
+
   cancellable = g_cancellable_new ();
   if (success)
     {
@@ -393,6 +520,11 @@ xcf_save_stream (Gimp           *gimp,
   success = g_output_stream_close (info.output, cancellable, &my_error);
   g_object_unref (cancellable);
 
+  if (success && output_file)
+    xcf_save_state_update (image, &info, output_file);
+  else
+    g_object_set_data (G_OBJECT (image), XCF_SAVE_STATE_KEY, NULL);
+
   if (! success && my_error)
     g_propagate_prefixed_error (error, my_error,
                                 _("Error writing '%s': "), filename);
@@ -403,6 +535,17 @@ xcf_save_stream (Gimp           *gimp,
   return success;
 }
 
+/*  loads whatever the images which were lazily loaded from @file still
+ *  need from it, so that @file can be overwritten
+ */
+void
+xcf_release_file (GFile *file)
+{
+  g_return_if_fail (G_IS_FILE (file));
+
+  xcf_tile_handler_load_file (file);
+}
+
 
 /*  private functions  */
 
@@ -450,6 +593,117 @@ xcf_load_invoker (GimpProcedure         *procedure,
   return return_vals;
 }
 
+static GimpValueArray *
+xcf_load_thumb_invoker (GimpProcedure         *procedure,
+                        Gimp                  *gimp,
+                        GimpContext           *context,
+                        GimpProgress          *progress,
+                        const GimpValueArray  *args,
+                        GError               **error)
+{
+  GimpValueArray    *return_vals;
+  GimpImage         *image  = NULL;
+  GdkPixbuf         *pixbuf = NULL;
+  GFile             *file;
+  GInputStream      *input;
+  gint               width      = 0;
+  gint               height     = 0;
+  GimpImageBaseType  base_type  = GIMP_RGB;
+  gboolean           has_alpha  = FALSE;
+  gint               num_layers = 0;
+  GError            *my_error   = NULL;
+
+  file = g_value_get_object (gimp_value_array_index (args, 0));
+
+  input = G_INPUT_STREAM (g_file_read (file, NULL, &my_error));
+
+  if (input)
+    {
+      XcfInfo info = { 0, };
+
+      info.gimp             = gimp;
+      info.input            = input;
+      info.seekable         = G_SEEKABLE (input);
+      info.bytes_per_offset = 4;
+      info.file             = file;
+      info.compression      = COMPRESS_NONE;
+
+      /*  only the image header and properties are read, the preview
+       *  has a fixed size and is scaled by the caller.  Files saved
+       *  before previews were added to XCF have none, which is not
+       *  worth an error message: we fail quietly and the caller falls
+       *  back to loading the image
+       */
+      if (xcf_load_header (&info))
+        pixbuf = xcf_load_thumbnail (&info, &width, &height, &base_type,
+                                     &has_alpha, &num_layers);
+
+      g_object_unref (input);
+    }
+  else
+    {
+      g_propagate_prefixed_error (error, my_error,
+                                  _("Could not open '%s' for reading: "),
+                                  gimp_file_get_utf8_name (file));
+    }
+
+  if (pixbuf)
+    {
+      GimpLayer *layer;
+
+      image = gimp_create_image (gimp,
+                                 gdk_pixbuf_get_width  (pixbuf),
+                                 gdk_pixbuf_get_height (pixbuf),
+                                 GIMP_RGB,
+                                 GIMP_PRECISION_U8_NON_LINEAR,
+                                 FALSE);
+
+      gimp_image_undo_disable (image);
+
+      layer = gimp_layer_new_from_pixbuf (pixbuf, image,
+                                          gimp_image_get_layer_format (image,
+                                                                       gdk_pixbuf_get_has_alpha (pixbuf)),
+                                          _("Background"),
+                                          GIMP_OPACITY_OPAQUE,
+                                          gimp_image_get_default_new_layer_mode (image));
+
+      gimp_image_add_layer (image, layer, NULL, 0, FALSE);
+
+      g_object_unref (pixbuf);
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, image != NULL,
+                                                  error ? *error : NULL);
+
+  if (image)
+    {
+      GimpImageType image_type = GIMP_RGB_IMAGE;
+
+      switch (base_type)
+        {
+        case GIMP_RGB:
+          image_type = has_alpha ? GIMP_RGBA_IMAGE : GIMP_RGB_IMAGE;
+          break;
+
+        case GIMP_GRAY:
+          image_type = has_alpha ? GIMP_GRAYA_IMAGE : GIMP_GRAY_IMAGE;
+          break;
+
+        case GIMP_INDEXED:
+          image_type = has_alpha ? GIMP_INDEXEDA_IMAGE : GIMP_INDEXED_IMAGE;
+          break;
+        }
+
+      g_value_set_object (gimp_value_array_index (return_vals, 1), image);
+      g_value_set_int    (gimp_value_array_index (return_vals, 2), width);
+      g_value_set_int    (gimp_value_array_index (return_vals, 3), height);
+      g_value_set_enum   (gimp_value_array_index (return_vals, 4), image_type);
+      g_value_set_int    (gimp_value_array_index (return_vals, 5), num_layers);
+    }
+
+  return return_vals;
+}
+
 static GimpValueArray *
 xcf_save_invoker (GimpProcedure         *procedure,
                   Gimp                  *gimp,
@@ -470,6 +724,8 @@ xcf_save_invoker (GimpProcedure         *procedure,
   image = g_value_get_object (gimp_value_array_index (args, 1));
   file  = g_value_get_object (gimp_value_array_index (args, 2));
 
+  xcf_release_file (file);
+
   output = G_OUTPUT_STREAM (g_file_replace (file,
                                             NULL, FALSE, G_FILE_CREATE_NONE,
                                             NULL, &my_error));
@@ -494,3 +750,158 @@ xcf_save_invoker (GimpProcedure         *procedure,
 
   return return_vals;
 }
+
+/* Reads the XCF header, and sets the file version accordingly */
+static gboolean
+xcf_load_header (XcfInfo *info)
+{
+  gchar id[14];
+
+  if (xcf_read_int8 (info, (guint8 *) id, 14) != 14)
+    return FALSE;
+
+  if (! g_str_has_prefix (id, "gimp xcf "))
+    {
+      return FALSE;
+    }
+  else if (strcmp (id + 9, "file") == 0)
+    {
+      info->file_version = 0;
+    }
+  else if (id[9]  == 'v' &&
+           id[13] == '\0')
+    {
+      info->file_version = atoi (id + 10);
+    }
+  else
+    {
+      return FALSE;
+    }
+
+  if (info->file_version >= 11)
+    info->bytes_per_offset = 8;
+
+  return TRUE;
+}
+
+static gchar *
+xcf_save_get_etag (GFile *file)
+{
+  GFileInfo *info;
+  gchar     *etag = NULL;
+
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_ETAG_VALUE ","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+  if (info)
+    {
+      const gchar *value = g_file_info_get_etag (info);
+
+      if (value)
+        {
+          etag = g_strdup_printf ("%s:%" G_GOFFSET_FORMAT,
+                                  value, g_file_info_get_size (info));
+        }
+
+      g_object_unref (info);
+    }
+
+  return etag;
+}
+
+static void
+xcf_save_state_free (XcfSaveState *state)
+{
+  g_object_unref (state->file);
+  g_free (state->etag);
+
+  g_slice_free (XcfSaveState, state);
+}
+
+static void
+xcf_save_state_update (GimpImage *image,
+                       XcfInfo   *info,
+                       GFile     *file)
+{
+  XcfSaveState *state = NULL;
+  gchar        *etag  = xcf_save_get_etag (file);
+
+  if (etag)
+    {
+      state = g_slice_new0 (XcfSaveState);
+
+      state->file              = g_object_ref (file);
+      state->etag              = etag;
+      state->serial            = info->save_serial;
+      state->file_version      = info->file_version;
+      state->bytes_per_offset  = info->bytes_per_offset;
+      state->compression       = info->compression;
+      state->compression_level = info->compression_level;
+    }
+
+  g_object_set_data_full (G_OBJECT (image), XCF_SAVE_STATE_KEY, state,
+                          (GDestroyNotify) xcf_save_state_free);
+}
+
+/* Opens the file @image was last saved to as @previous, if its tile
+ * data can be copied into the file described by @info.  Note that the
+ * output stream is already open at this point, so if it truncated the
+ * previous file in place, the etag won't match anymore.
+ */
+static gboolean
+xcf_save_open_previous (GimpImage *image,
+                        XcfInfo   *info,
+                        XcfInfo   *previous)
+{
+  XcfSaveState *state;
+  gchar        *etag;
+  gboolean      matches;
+
+  if (! image->gimp->config->xcf_incremental_save)
+    return FALSE;
+
+  state = g_object_get_data (G_OBJECT (image), XCF_SAVE_STATE_KEY);
+
+  if (! state                                                      ||
+      state->compression       != info->compression                ||
+      state->compression_level != info->compression_level          ||
+      state->bytes_per_offset  != info->bytes_per_offset           ||
+      (state->file_version >= 12) != (info->file_version >= 12))
+    {
+      return FALSE;
+    }
+
+  etag    = xcf_save_get_etag (state->file);
+  matches = ! g_strcmp0 (etag, state->etag);
+  g_free (etag);
+
+  if (! matches)
+    return FALSE;
+
+  previous->input = G_INPUT_STREAM (g_file_read (state->file, NULL, NULL));
+
+  if (! previous->input)
+    return FALSE;
+
+  if (! G_IS_SEEKABLE (previous->input) ||
+      ! g_seekable_can_seek (G_SEEKABLE (previous->input)))
+    {
+      g_clear_object (&previous->input);
+
+      return FALSE;
+    }
+
+  previous->gimp             = info->gimp;
+  previous->progress         = info->progress;
+  previous->seekable         = G_SEEKABLE (previous->input);
+  previous->file             = state->file;
+  previous->bytes_per_offset = state->bytes_per_offset;
+  previous->file_version     = state->file_version;
+  previous->compression      = state->compression;
+
+  info->previous_serial = state->serial;
+
+  return TRUE;
+}
@@ -33,3 +33,5 @@ gboolean    xcf_save_stream (Gimp           *gimp,
                              GFile          *output_file,
                              GimpProgress   *progress,
                              GError        **error);
+
+void        xcf_release_file (GFile          *file);
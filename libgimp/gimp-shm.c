@@ -60,8 +60,11 @@
 #include "gimp.h"
 #include "gimp-shm.h"
 
+#include "libgimpbase/gimpprotocol.h"
 
-#define TILE_MAP_SIZE     (gimp_tile_width () * gimp_tile_height () * 32)
+
+#define TILE_MAP_SIZE     (gimp_tile_width () * gimp_tile_height () * 32 * \
+                           GP_TILE_BATCH_MAX_TILES)
 #define ERRMSG_SHM_FAILED "Could not attach to gimp shared memory segment"
 
 
@@ -82,6 +85,10 @@ _gimp_shm_addr (void)
 void
 _gimp_shm_open (gint shm_ID)
 {
+  /*  already attached by the previous procedure of a reusable plug-in  */
+  if (_shm_ID != -1 && _shm_ID == shm_ID)
+    return;
+
   _shm_ID = shm_ID;
 
   if (_shm_ID != -1)
@@ -196,3 +203,84 @@ _gimp_shm_close (void)
 
 #endif
 }
+
+/*  maps a drawable store created by the core for this plug-in.  the
+ *  store is private to the plug-in, so writing to the mapped pixels
+ *  is fine.  returns NULL if the store can't be mapped, the caller
+ *  then falls back to reading tiles one by one.
+ */
+guchar *
+_gimp_shm_map_store (gint  store_ID,
+                     gsize size)
+{
+  guchar *store_addr = NULL;
+
+  if (_shm_ID == -1 || store_ID == -1)
+    return NULL;
+
+#if defined(USE_SYSV_SHM)
+
+  store_addr = (guchar *) shmat (store_ID, NULL, 0);
+
+  if (store_addr == (guchar *) -1)
+    {
+      g_printerr ("shmat() failed: %s\n", g_strerror (errno));
+
+      store_addr = NULL;
+    }
+
+#elif defined(USE_POSIX_SHM)
+
+  {
+    gchar map_file[48];
+    gint  shm_fd;
+
+    /* The store is named after the main segment */
+    g_snprintf (map_file, sizeof (map_file), "/gimp-shm-%d-%d",
+                _shm_ID, store_ID);
+
+    shm_fd = shm_open (map_file, O_RDONLY, 0600);
+
+    if (shm_fd != -1)
+      {
+        /* A private mapping, our changes are copied on write */
+        store_addr = (guchar *) mmap (NULL, size,
+                                      PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                                      shm_fd, 0);
+
+        if (store_addr == MAP_FAILED)
+          {
+            g_printerr ("mmap() failed: %s\n", g_strerror (errno));
+
+            store_addr = NULL;
+          }
+
+        close (shm_fd);
+      }
+    else
+      {
+        g_printerr ("shm_open() failed: %s\n", g_strerror (errno));
+      }
+  }
+
+#endif
+
+  return store_addr;
+}
+
+void
+_gimp_shm_unmap_store (guchar *store_addr,
+                       gsize   size)
+{
+  g_return_if_fail (store_addr != NULL);
+
+#if defined(USE_SYSV_SHM)
+
+  shmdt ((char *) store_addr);
+
+#elif defined(USE_POSIX_SHM)
+
+  munmap (store_addr, size);
+
+#endif
+}
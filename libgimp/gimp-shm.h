@@ -24,10 +24,15 @@
 G_BEGIN_DECLS
 
 
-guchar * _gimp_shm_addr  (void);
+guchar * _gimp_shm_addr        (void);
 
-void     _gimp_shm_open  (gint shm_ID);
-void     _gimp_shm_close (void);
+void     _gimp_shm_open        (gint    shm_ID);
+void     _gimp_shm_close       (void);
+
+guchar * _gimp_shm_map_store   (gint    store_ID,
+                                gsize   size);
+void     _gimp_shm_unmap_store (guchar *store_addr,
+                                gsize   size);
 
 
 G_END_DECLS
@@ -1155,10 +1155,16 @@ _gimp_config (GPConfig *config)
   _export_comment       = config->export_comment;
   _num_processors       = config->num_processors;
   _default_display_id   = config->default_display_id;
-  _wm_class             = g_strdup (config->wm_class);
-  _display_name         = g_strdup (config->display_name);
   _monitor_number       = config->monitor_number;
   _timestamp            = config->timestamp;
+
+  /*  a reusable plug-in receives a config for each procedure it runs  */
+  g_free (_wm_class);
+  g_free (_display_name);
+  g_free (_icon_theme_dir);
+
+  _wm_class             = g_strdup (config->wm_class);
+  _display_name         = g_strdup (config->display_name);
   _icon_theme_dir       = g_strdup (config->icon_theme_dir);
 
   if (config->app_name)
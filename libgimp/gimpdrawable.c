@@ -285,7 +285,45 @@ gimp_drawable_get_buffer (GimpDrawable *drawable)
       GeglTileBackend *backend;
       GeglBuffer      *buffer;
 
-      backend = _gimp_tile_backend_plugin_new (drawable, FALSE);
+      backend = _gimp_tile_backend_plugin_new (drawable, FALSE, FALSE);
+      buffer = gegl_buffer_new_for_backend (NULL, backend);
+      g_object_unref (backend);
+
+      return buffer;
+    }
+
+  return NULL;
+}
+
+/**
+ * gimp_drawable_get_mapped_buffer:
+ * @drawable: the ID of the #GimpDrawable to get the buffer for.
+ *
+ * Returns a #GeglBuffer of a specified drawable, like
+ * gimp_drawable_get_buffer(). The first time the buffer is read, the
+ * core copies all of the drawable's pixels into a shared memory
+ * segment at once, which the buffer then reads without asking the
+ * core for every single tile.
+ *
+ * Copying the whole drawable takes time and memory, so this is only
+ * worth it for plug-ins which read all of the drawable, such as most
+ * export plug-ins. Other plug-ins should use gimp_drawable_get_buffer().
+ *
+ * Returns: (transfer full): The #GeglBuffer.
+ *
+ * See Also: gimp_drawable_get_buffer()
+ *
+ * Since: 3.2
+ */
+GeglBuffer *
+gimp_drawable_get_mapped_buffer (GimpDrawable *drawable)
+{
+  if (gimp_item_is_valid (GIMP_ITEM (drawable)))
+    {
+      GeglTileBackend *backend;
+      GeglBuffer      *buffer;
+
+      backend = _gimp_tile_backend_plugin_new (drawable, FALSE, TRUE);
       buffer = gegl_buffer_new_for_backend (NULL, backend);
       g_object_unref (backend);
 
@@ -316,7 +354,7 @@ gimp_drawable_get_shadow_buffer (GimpDrawable *drawable)
       GeglTileBackend *backend;
       GeglBuffer      *buffer;
 
-      backend = _gimp_tile_backend_plugin_new (drawable, TRUE);
+      backend = _gimp_tile_backend_plugin_new (drawable, TRUE, FALSE);
       buffer = gegl_buffer_new_for_backend (NULL, backend);
       g_object_unref (backend);
 
@@ -58,6 +58,7 @@ struct _GimpDrawableClass
 GimpDrawable       * gimp_drawable_get_by_id              (gint32                 drawable_id);
 
 GeglBuffer         * gimp_drawable_get_buffer             (GimpDrawable           *drawable) G_GNUC_WARN_UNUSED_RESULT;
+GeglBuffer         * gimp_drawable_get_mapped_buffer      (GimpDrawable           *drawable) G_GNUC_WARN_UNUSED_RESULT;
 GeglBuffer         * gimp_drawable_get_shadow_buffer      (GimpDrawable           *drawable) G_GNUC_WARN_UNUSED_RESULT;
 
 const Babl         * gimp_drawable_get_format             (GimpDrawable           *drawable);
@@ -30,6 +30,7 @@
 #include "gimppdb_pdb.h"
 #include "gimppdbprocedure.h"
 #include "gimpplugin-private.h"
+#include "gimptilebackendplugin.h"
 
 #include "libgimp-intl.h"
 
@@ -454,6 +455,9 @@ _gimp_pdb_run_procedure_array (GimpPDB              *pdb,
   proc_run.n_params = gimp_value_array_length (arguments);
   proc_run.params   = _gimp_value_array_to_gp_params (arguments, FALSE);
 
+  /*  the procedure may change drawables whose tiles were prefetched  */
+  _gimp_tile_backend_plugin_invalidate ();
+
   if (! gp_proc_run_write (_gimp_plug_in_get_write_channel (pdb->plug_in),
                            &proc_run, pdb->plug_in))
     gimp_quit ();
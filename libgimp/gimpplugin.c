@@ -96,8 +96,6 @@
  */
 
 
-#define WRITE_BUFFER_SIZE 1024
-
 /**
  * gimp_plug_in_error_quark:
  *
@@ -135,11 +133,12 @@ typedef struct _GimpPlugInPrivate
   GIOChannel *read_channel;
   GIOChannel *write_channel;
 
-  gchar       write_buffer[WRITE_BUFFER_SIZE];
-  gulong      write_buffer_index;
+  GimpWireBuffer *write_buffer;
 
   guint       persistent_source_id;
 
+  gboolean    reusable;
+
   gchar      *translation_domain_name;
   GFile      *translation_domain_path;
 
@@ -301,6 +300,7 @@ gimp_plug_in_init (GimpPlugIn *plug_in)
   priv->procedure_stack     = NULL;
   priv->ran_procedure_stack = NULL;
   priv->temp_procedures     = NULL;
+  priv->write_buffer        = gimp_wire_buffer_new ();
 }
 
 static void
@@ -355,6 +355,7 @@ gimp_plug_in_finalize (GObject *object)
   priv = gimp_plug_in_get_instance_private (plug_in);
 
   g_clear_pointer (&priv->program_name, g_free);
+  g_clear_pointer (&priv->write_buffer, gimp_wire_buffer_free);
   g_clear_pointer (&priv->translation_domain_name, g_free);
   g_clear_object  (&priv->translation_domain_path);
 
@@ -885,6 +886,40 @@ gimp_plug_in_get_pdb_error_handler (GimpPlugIn *plug_in)
   return _gimp_plug_in_get_pdb_error_handler ();
 }
 
+/**
+ * gimp_plug_in_set_reusable:
+ * @plug_in:  A #GimpPlugIn
+ * @reusable: Whether the plug-in can run several procedures
+ *
+ * Declares that the plug-in's process can run any number of its
+ * procedures one after another, so GIMP may keep it running between
+ * calls instead of starting a new process each time. This is only
+ * worth it for plug-ins which are expensive to start, and only safe
+ * for plug-ins which don't leave global state behind from one
+ * procedure to the next.
+ *
+ * Whether GIMP actually keeps reusable plug-ins running is up to the
+ * user's "plug-in-workers" setting.
+ *
+ * This function must be called in the instance init function of the
+ * plug-in, so it is in effect both when the plug-in is queried and
+ * when it runs.
+ *
+ * Since: 3.2
+ **/
+void
+gimp_plug_in_set_reusable (GimpPlugIn *plug_in,
+                           gboolean    reusable)
+{
+  GimpPlugInPrivate *priv;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  priv = gimp_plug_in_get_instance_private (plug_in);
+
+  priv->reusable = reusable ? TRUE : FALSE;
+}
+
 
 /*  internal functions  */
 
@@ -900,6 +935,9 @@ _gimp_plug_in_query (GimpPlugIn *plug_in)
   if (GIMP_PLUG_IN_GET_CLASS (plug_in)->init_procedures)
     gp_has_init_write (priv->write_channel, plug_in);
 
+  if (priv->reusable)
+    gp_reusable_write (priv->write_channel, plug_in);
+
   if (GIMP_PLUG_IN_GET_CLASS (plug_in)->query_procedures)
     {
       GList *procedures =
@@ -1257,33 +1295,7 @@ gimp_plug_in_write (GIOChannel   *channel,
 
   priv = gimp_plug_in_get_instance_private (plug_in);
 
-  while (count > 0)
-    {
-      gulong bytes;
-
-      if ((priv->write_buffer_index + count) >= WRITE_BUFFER_SIZE)
-        {
-          bytes = WRITE_BUFFER_SIZE - priv->write_buffer_index;
-          memcpy (&priv->write_buffer[priv->write_buffer_index],
-                  buf, bytes);
-          priv->write_buffer_index += bytes;
-
-          if (! gimp_wire_flush (channel, plug_in))
-            return FALSE;
-        }
-      else
-        {
-          bytes = count;
-          memcpy (&priv->write_buffer[priv->write_buffer_index],
-                  buf, bytes);
-          priv->write_buffer_index += bytes;
-        }
-
-      buf   += bytes;
-      count -= bytes;
-    }
-
-  return TRUE;
+  return gimp_wire_buffer_write (priv->write_buffer, channel, buf, count);
 }
 
 static gboolean
@@ -1295,50 +1307,7 @@ gimp_plug_in_flush (GIOChannel *channel,
 
   priv = gimp_plug_in_get_instance_private (plug_in);
 
-  if (priv->write_buffer_index > 0)
-    {
-      gsize count = 0;
-
-      while (count != priv->write_buffer_index)
-        {
-          GIOStatus status;
-          gsize     bytes;
-          GError   *error = NULL;
-
-          do
-            {
-              bytes = 0;
-              status = g_io_channel_write_chars (channel,
-                                                 &priv->write_buffer[count],
-                                                 (priv->write_buffer_index - count),
-                                                 &bytes,
-                                                 &error);
-            }
-          while (status == G_IO_STATUS_AGAIN);
-
-          if (status != G_IO_STATUS_NORMAL)
-            {
-              if (error)
-                {
-                  g_warning ("%s: gimp_flush(): error: %s",
-                             g_get_prgname (), error->message);
-                  g_error_free (error);
-                }
-              else
-                {
-                  g_warning ("%s: gimp_flush(): error", g_get_prgname ());
-                }
-
-              return FALSE;
-            }
-
-          count += bytes;
-        }
-
-      priv->write_buffer_index = 0;
-    }
-
-  return TRUE;
+  return gimp_wire_buffer_flush (priv->write_buffer, channel);
 }
 
 static gboolean
@@ -1380,12 +1349,23 @@ gimp_plug_in_loop (GimpPlugIn *plug_in)
         case GP_TILE_REQ:
         case GP_TILE_ACK:
         case GP_TILE_DATA:
+        case GP_TILE_BATCH_REQ:
+        case GP_TILE_BATCH_DATA:
+        case GP_DRAWABLE_STORE_REQ:
+        case GP_DRAWABLE_STORE:
           g_warning ("unexpected tile message received (should not happen)");
           break;
 
         case GP_PROC_RUN:
           gimp_plug_in_main_proc_run (plug_in, msg.data);
           gimp_wire_destroy (&msg);
+
+          /*  wait for the next procedure, the core closes the pipe
+           *  if it doesn't keep us around
+           */
+          if (priv->reusable)
+            continue;
+
           return;
 
         case GP_PROC_RETURN:
@@ -1407,6 +1387,10 @@ gimp_plug_in_loop (GimpPlugIn *plug_in)
         case GP_HAS_INIT:
           g_warning ("unexpected has init message received (should not happen)");
           break;
+
+        case GP_REUSABLE:
+          g_warning ("unexpected reusable message received (should not happen)");
+          break;
         }
 
       gimp_wire_destroy (&msg);
@@ -1445,6 +1429,10 @@ gimp_plug_in_process_message (GimpPlugIn      *plug_in,
     case GP_TILE_REQ:
     case GP_TILE_ACK:
     case GP_TILE_DATA:
+    case GP_TILE_BATCH_REQ:
+    case GP_TILE_BATCH_DATA:
+    case GP_DRAWABLE_STORE_REQ:
+    case GP_DRAWABLE_STORE:
       g_warning ("unexpected tile message received (should not happen)");
       break;
     case GP_PROC_RUN:
@@ -1465,6 +1453,9 @@ gimp_plug_in_process_message (GimpPlugIn      *plug_in,
     case GP_HAS_INIT:
       g_warning ("unexpected has init message received (should not happen)");
       break;
+    case GP_REUSABLE:
+      g_warning ("unexpected reusable message received (should not happen)");
+      break;
     }
 }
 
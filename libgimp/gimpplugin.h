@@ -214,6 +214,9 @@ void            gimp_plug_in_set_pdb_error_handler  (GimpPlugIn    *plug_in,
 GimpPDBErrorHandler
                 gimp_plug_in_get_pdb_error_handler  (GimpPlugIn    *plug_in);
 
+void            gimp_plug_in_set_reusable           (GimpPlugIn    *plug_in,
+                                                     gboolean       reusable);
+
 
 G_END_DECLS
 
@@ -51,18 +51,50 @@ struct _GimpTile
 };
 
 
+typedef struct _GimpTileStore GimpTileStore;
+
+/*  a drawable store mapped from the core, it stays mapped as long as
+ *  there are tiles using its pixels
+ */
+struct _GimpTileStore
+{
+  gint    ref_count;
+  guchar *data;
+  gsize   size;
+};
+
+
 struct _GimpTileBackendPluginPrivate
 {
-  gint32   drawable_id;
-  gboolean shadow;
-  gint     width;
-  gint     height;
-  gint     bpp;
-  gint     ntile_rows;
-  gint     ntile_cols;
+  gint32    drawable_id;
+  gboolean  shadow;
+  gint      width;
+  gint      height;
+  gint      bpp;
+  gint      ntile_rows;
+  gint      ntile_cols;
+
+  /*  sequential reads fetch the following tiles in advance  */
+  gint      last_tile_num;
+  guint     prefetch_serial;
+  gint      prefetch_first;
+  gint      n_prefetched;
+  GeglTile *prefetched[GP_TILE_BATCH_MAX_TILES];
+
+  /*  if requested, reading the drawable maps all of its tiles at once  */
+  gboolean       use_store;
+  GimpTileStore *store;
+  guint          store_serial;
+  gboolean       store_failed;
+
+  /*  written tiles are committed to the core together  */
+  GimpTile  pending[GP_TILE_BATCH_MAX_TILES];
+  gint      n_pending;
 };
 
 
+static void       gimp_tile_backend_plugin_finalize (GObject        *object);
+
 static gpointer   gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
                                                     GeglTileCommand  command,
                                                     gint             x,
@@ -86,8 +118,30 @@ static void       gimp_tile_unset (GimpTileBackendPlugin *backend_plugin,
                                    GimpTile              *tile);
 static void       gimp_tile_get   (GimpTileBackendPlugin *backend_plugin,
                                    GimpTile              *tile);
-static void       gimp_tile_put   (GimpTileBackendPlugin *backend_plugin,
-                                   GimpTile              *tile);
+
+static GeglTile * gimp_tile_read_batch       (GimpTileBackendPlugin *backend_plugin,
+                                              gint                   tile_num,
+                                              gint                   n_tiles);
+static GeglTile * gimp_tile_take_prefetched  (GimpTileBackendPlugin *backend_plugin,
+                                              gint                   tile_num);
+static void       gimp_tile_drop_prefetched  (GimpTileBackendPlugin *backend_plugin);
+static void       gimp_tile_copy_from_gimp   (GimpTileBackendPlugin *backend_plugin,
+                                              guchar                *tile_data,
+                                              const guchar          *gimp_tile_data,
+                                              gint                   ewidth,
+                                              gint                   eheight);
+
+static GeglTile * gimp_tile_read_store       (GimpTileBackendPlugin *backend_plugin,
+                                              GimpTile              *gimp_tile);
+static gboolean   gimp_tile_map_store        (GimpTileBackendPlugin *backend_plugin);
+static void       gimp_tile_drop_store       (GimpTileBackendPlugin *backend_plugin);
+static GimpTileStore *
+                  gimp_tile_store_ref        (GimpTileStore         *store);
+static void       gimp_tile_store_unref      (GimpTileStore         *store);
+
+static void       gimp_tile_queue_write      (GimpTileBackendPlugin *backend_plugin,
+                                              GimpTile              *gimp_tile);
+static void       gimp_tile_commit           (GimpTileBackendPlugin *backend_plugin);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpTileBackendPlugin, _gimp_tile_backend_plugin,
@@ -98,10 +152,21 @@ G_DEFINE_TYPE_WITH_PRIVATE (GimpTileBackendPlugin, _gimp_tile_backend_plugin,
 
 static GMutex backend_plugin_mutex;
 
+/*  incremented by every PDB call, which may change the drawables,
+ *  and therefore invalidates all the prefetched tiles
+ */
+static guint  backend_plugin_prefetch_serial = 1;
+
+/*  the backends with written tiles which are not committed yet  */
+static GList *backend_plugin_pending = NULL;
+
 
 static void
 _gimp_tile_backend_plugin_class_init (GimpTileBackendPluginClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gimp_tile_backend_plugin_finalize;
 }
 
 static void
@@ -111,9 +176,29 @@ _gimp_tile_backend_plugin_init (GimpTileBackendPlugin *backend)
 
   backend->priv = _gimp_tile_backend_plugin_get_instance_private (backend);
 
+  /*  reading tile 0 first counts as a sequential read  */
+  backend->priv->last_tile_num = -1;
+
   source->command = gimp_tile_backend_plugin_command;
 }
 
+static void
+gimp_tile_backend_plugin_finalize (GObject *object)
+{
+  GimpTileBackendPlugin *backend_plugin = GIMP_TILE_BACKEND_PLUGIN (object);
+
+  g_mutex_lock (&backend_plugin_mutex);
+
+  gimp_tile_commit (backend_plugin);
+
+  g_mutex_unlock (&backend_plugin_mutex);
+
+  gimp_tile_drop_prefetched (backend_plugin);
+  gimp_tile_drop_store (backend_plugin);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static gpointer
 gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
                                   GeglTileCommand  command,
@@ -156,6 +241,12 @@ gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
       break;
 
     case GEGL_TILE_FLUSH:
+      g_mutex_lock (&backend_plugin_mutex);
+
+      gimp_tile_commit (backend_plugin);
+      gimp_tile_drop_prefetched (backend_plugin);
+
+      g_mutex_unlock (&backend_plugin_mutex);
       break;
 
     default:
@@ -172,7 +263,8 @@ gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
 
 GeglTileBackend *
 _gimp_tile_backend_plugin_new (GimpDrawable *drawable,
-                               gint          shadow)
+                               gint          shadow,
+                               gboolean      use_store)
 {
   GeglTileBackend       *backend;
   GimpTileBackendPlugin *backend_plugin;
@@ -190,6 +282,7 @@ _gimp_tile_backend_plugin_new (GimpDrawable *drawable,
 
   backend_plugin->priv->drawable_id = gimp_item_get_id (GIMP_ITEM (drawable));
   backend_plugin->priv->shadow      = shadow;
+  backend_plugin->priv->use_store   = use_store;
   backend_plugin->priv->width       = width;
   backend_plugin->priv->height      = height;
   backend_plugin->priv->bpp         = gimp_drawable_get_bpp (drawable);
@@ -202,6 +295,20 @@ _gimp_tile_backend_plugin_new (GimpDrawable *drawable,
   return backend;
 }
 
+void
+_gimp_tile_backend_plugin_invalidate (void)
+{
+  /*  the procedure must see all the tiles written so far  */
+  g_mutex_lock (&backend_plugin_mutex);
+
+  while (backend_plugin_pending)
+    gimp_tile_commit (backend_plugin_pending->data);
+
+  g_mutex_unlock (&backend_plugin_mutex);
+
+  g_atomic_int_inc (&backend_plugin_prefetch_serial);
+}
+
 
 /*  private functions  */
 
@@ -215,35 +322,56 @@ gimp_tile_read (GimpTileBackendPlugin *backend_plugin,
   GeglTile                     *tile;
   GimpTile                      gimp_tile = { 0, };
   gint                          tile_size;
-  guchar                       *tile_data;
+  gboolean                      sequential;
 
   if (! gimp_tile_init (backend_plugin, &gimp_tile, y, x))
     return NULL;
 
-  tile_size  = gegl_tile_backend_get_tile_size (backend);
-  tile       = gegl_tile_new (tile_size);
-  tile_data  = gegl_tile_get_data (tile);
+  tile = gimp_tile_read_store (backend_plugin, &gimp_tile);
 
-  gimp_tile_get (backend_plugin, &gimp_tile);
+  if (tile)
+    return tile;
 
-  if (gimp_tile.ewidth * gimp_tile.eheight * priv->bpp == tile_size)
+  /*  the core has to know about our changes before we read from it  */
+  gimp_tile_commit (backend_plugin);
+
+  tile = gimp_tile_take_prefetched (backend_plugin, gimp_tile.tile_num);
+
+  if (tile)
     {
-      memcpy (tile_data, gimp_tile.data, tile_size);
+      priv->last_tile_num = gimp_tile.tile_num;
+
+      return tile;
     }
-  else
+
+  sequential = ((gint) gimp_tile.tile_num == priv->last_tile_num + 1);
+
+  priv->last_tile_num = gimp_tile.tile_num;
+
+  if (sequential)
     {
-      gint  tile_stride      = TILE_WIDTH * priv->bpp;
-      gint  gimp_tile_stride = gimp_tile.ewidth * priv->bpp;
-      guint row;
+      /*  don't prefetch past the end of the tile row: a region which
+       *  is narrower than the drawable continues on the next row, at
+       *  its own left edge, and the tiles in between would be wasted
+       */
+      gint n_tiles = MIN (GP_TILE_BATCH_MAX_TILES,
+                          priv->ntile_cols -
+                          gimp_tile.tile_num % priv->ntile_cols);
 
-      for (row = 0; row < gimp_tile.eheight; row++)
-        {
-          memcpy (tile_data      + row * tile_stride,
-                  gimp_tile.data + row * gimp_tile_stride,
-                  gimp_tile_stride);
-        }
+      if (n_tiles > 1)
+        return gimp_tile_read_batch (backend_plugin, gimp_tile.tile_num,
+                                     n_tiles);
     }
 
+  tile_size  = gegl_tile_backend_get_tile_size (backend);
+  tile       = gegl_tile_new (tile_size);
+
+  gimp_tile_get (backend_plugin, &gimp_tile);
+
+  gimp_tile_copy_from_gimp (backend_plugin,
+                            gegl_tile_get_data (tile), gimp_tile.data,
+                            gimp_tile.ewidth, gimp_tile.eheight);
+
   gimp_tile_unset (backend_plugin, &gimp_tile);
 
   return tile;
@@ -264,9 +392,28 @@ gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
   if (! gimp_tile_init (backend_plugin, &gimp_tile, y, x))
     return FALSE;
 
+  /*  a prefetched copy of the tile would be outdated now  */
+  if (gimp_tile.tile_num >= priv->prefetch_first &&
+      gimp_tile.tile_num <  priv->prefetch_first + priv->n_prefetched)
+    {
+      g_clear_pointer (&priv->prefetched[gimp_tile.tile_num -
+                                         priv->prefetch_first],
+                       gegl_tile_unref);
+    }
+
   tile_size = gegl_tile_backend_get_tile_size (backend);
   tile_data = gegl_tile_get_data (tile);
 
+  /*  keep the store in sync, unless the tile already uses its pixels  */
+  if (priv->store)
+    {
+      guchar *store_data = priv->store->data +
+                           (gsize) gimp_tile.tile_num * tile_size;
+
+      if (store_data != tile_data)
+        memcpy (store_data, tile_data, tile_size);
+    }
+
   gimp_tile.data = g_new (guchar,
                           gimp_tile.ewidth * gimp_tile.eheight *
                           priv->bpp);
@@ -289,8 +436,7 @@ gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
         }
     }
 
-  gimp_tile_put (backend_plugin, &gimp_tile);
-  gimp_tile_unset (backend_plugin, &gimp_tile);
+  gimp_tile_queue_write (backend_plugin, &gimp_tile);
 
   return TRUE;
 }
@@ -399,58 +545,425 @@ gimp_tile_get (GimpTileBackendPlugin *backend_plugin,
   gimp_wire_destroy (&msg);
 }
 
-static void
-gimp_tile_put (GimpTileBackendPlugin *backend_plugin,
-               GimpTile              *tile)
+/*  reads @n_tiles tiles starting at @tile_num using a single
+ *  GP_TILE_BATCH_REQ, returns the first one and keeps the others
+ *  until they are read
+ */
+static GeglTile *
+gimp_tile_read_batch (GimpTileBackendPlugin *backend_plugin,
+                      gint                   tile_num,
+                      gint                   n_tiles)
 {
   GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
+  GeglTileBackend              *backend = GEGL_TILE_BACKEND (backend_plugin);
   GimpPlugIn                   *plug_in = gimp_get_plug_in ();
-  GPTileReq                     tile_req;
-  GPTileData                    tile_data;
-  GPTileData                   *tile_info;
+  GPTileBatchReq                batch_req;
+  GPTileBatchData              *batch_data;
   GimpWireMessage               msg;
+  guint32                       tile_nums[GP_TILE_BATCH_MAX_TILES];
+  const guchar                 *shm_data;
+  gint                          tile_size;
+  gint                          i;
 
-  tile_req.drawable_id = -1;
-  tile_req.tile_num    = 0;
-  tile_req.shadow      = 0;
+  gimp_tile_drop_prefetched (backend_plugin);
 
-  if (! gp_tile_req_write (_gimp_plug_in_get_write_channel (plug_in),
-                           &tile_req, plug_in))
+  for (i = 0; i < n_tiles; i++)
+    tile_nums[i] = tile_num + i;
+
+  batch_req.drawable_id = priv->drawable_id;
+  batch_req.shadow      = priv->shadow;
+  batch_req.n_tiles     = n_tiles;
+  batch_req.tile_nums   = tile_nums;
+
+  if (! gp_tile_batch_req_write (_gimp_plug_in_get_write_channel (plug_in),
+                                 &batch_req, plug_in))
     gimp_quit ();
 
-  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_DATA);
+  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_BATCH_DATA);
 
-  tile_info = msg.data;
+  batch_data = msg.data;
 
-  tile_data.drawable_id = priv->drawable_id;
-  tile_data.tile_num    = tile->tile_num;
-  tile_data.shadow      = priv->shadow;
-  tile_data.bpp         = priv->bpp;
-  tile_data.width       = tile->ewidth;
-  tile_data.height      = tile->eheight;
-  tile_data.use_shm     = tile_info->use_shm;
-  tile_data.data        = NULL;
+  if (batch_data->drawable_id != priv->drawable_id ||
+      batch_data->shadow      != priv->shadow      ||
+      batch_data->bpp         != priv->bpp         ||
+      batch_data->n_tiles     != n_tiles)
+    {
+      g_printerr ("received tile info did not match computed tile info");
+      gimp_quit ();
+    }
 
-  if (tile_info->use_shm)
+  tile_size = gegl_tile_backend_get_tile_size (backend);
+  shm_data  = _gimp_shm_addr ();
+
+  priv->prefetch_serial = g_atomic_int_get (&backend_plugin_prefetch_serial);
+  priv->prefetch_first  = tile_num;
+  priv->n_prefetched    = n_tiles;
+
+  for (i = 0; i < n_tiles; i++)
     {
-      memcpy (_gimp_shm_addr (),
-              tile->data,
-              tile->ewidth * tile->eheight * priv->bpp);
+      GPTileBatchTile *batch_tile = &batch_data->tiles[i];
+      GimpTile         gimp_tile  = { 0, };
+      const guchar    *data;
+
+      gimp_tile_init (backend_plugin, &gimp_tile,
+                      (tile_num + i) / priv->ntile_cols,
+                      (tile_num + i) % priv->ntile_cols);
+
+      if (batch_tile->tile_num != gimp_tile.tile_num ||
+          batch_tile->width    != gimp_tile.ewidth   ||
+          batch_tile->height   != gimp_tile.eheight)
+        {
+          g_printerr ("received tile info did not match computed tile info");
+          gimp_quit ();
+        }
+
+      if (batch_data->use_shm)
+        {
+          data      = shm_data;
+          shm_data += gimp_tile.ewidth * gimp_tile.eheight * priv->bpp;
+        }
+      else
+        {
+          data = batch_tile->data;
+        }
+
+      priv->prefetched[i] = gegl_tile_new (tile_size);
+
+      gimp_tile_copy_from_gimp (backend_plugin,
+                                gegl_tile_get_data (priv->prefetched[i]),
+                                data,
+                                gimp_tile.ewidth, gimp_tile.eheight);
+    }
+
+  if (! gp_tile_ack_write (_gimp_plug_in_get_write_channel (plug_in),
+                           plug_in))
+    gimp_quit ();
+
+  gimp_wire_destroy (&msg);
+
+  return gimp_tile_take_prefetched (backend_plugin, tile_num);
+}
+
+static GeglTile *
+gimp_tile_take_prefetched (GimpTileBackendPlugin *backend_plugin,
+                           gint                   tile_num)
+{
+  GimpTileBackendPluginPrivate *priv = backend_plugin->priv;
+  GeglTile                     *tile;
+
+  if (priv->prefetch_serial !=
+      g_atomic_int_get (&backend_plugin_prefetch_serial))
+    {
+      gimp_tile_drop_prefetched (backend_plugin);
+
+      return NULL;
+    }
+
+  if (tile_num <  priv->prefetch_first ||
+      tile_num >= priv->prefetch_first + priv->n_prefetched)
+    {
+      return NULL;
+    }
+
+  /*  GEGL caches the tile from now on, hand our reference over  */
+  tile = priv->prefetched[tile_num - priv->prefetch_first];
+
+  priv->prefetched[tile_num - priv->prefetch_first] = NULL;
+
+  return tile;
+}
+
+static void
+gimp_tile_drop_prefetched (GimpTileBackendPlugin *backend_plugin)
+{
+  GimpTileBackendPluginPrivate *priv = backend_plugin->priv;
+  gint                          i;
+
+  for (i = 0; i < priv->n_prefetched; i++)
+    g_clear_pointer (&priv->prefetched[i], gegl_tile_unref);
+
+  priv->n_prefetched = 0;
+}
+
+static void
+gimp_tile_copy_from_gimp (GimpTileBackendPlugin *backend_plugin,
+                          guchar                *tile_data,
+                          const guchar          *gimp_tile_data,
+                          gint                   ewidth,
+                          gint                   eheight)
+{
+  GimpTileBackendPluginPrivate *priv      = backend_plugin->priv;
+  GeglTileBackend              *backend   = GEGL_TILE_BACKEND (backend_plugin);
+  gint                          tile_size;
+
+  tile_size = gegl_tile_backend_get_tile_size (backend);
+
+  if (ewidth * eheight * priv->bpp == tile_size)
+    {
+      memcpy (tile_data, gimp_tile_data, tile_size);
     }
   else
     {
-      tile_data.data = tile->data;
+      gint tile_stride      = TILE_WIDTH * priv->bpp;
+      gint gimp_tile_stride = ewidth * priv->bpp;
+      gint row;
+
+      for (row = 0; row < eheight; row++)
+        {
+          memcpy (tile_data      + row * tile_stride,
+                  gimp_tile_data + row * gimp_tile_stride,
+                  gimp_tile_stride);
+        }
     }
+}
+
+/*  returns a tile using the pixels of the mapped drawable store.  the
+ *  store is only used by the buffers returned by
+ *  gimp_drawable_get_mapped_buffer(), and requested by their first read.
+ */
+static GeglTile *
+gimp_tile_read_store (GimpTileBackendPlugin *backend_plugin,
+                      GimpTile              *gimp_tile)
+{
+  GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
+  GeglTileBackend              *backend = GEGL_TILE_BACKEND (backend_plugin);
+  GeglTile                     *tile;
+  gint                          tile_size;
+
+  if (priv->store &&
+      priv->store_serial != g_atomic_int_get (&backend_plugin_prefetch_serial))
+    {
+      gimp_tile_drop_store (backend_plugin);
+    }
+
+  if (! priv->store)
+    {
+      if (! priv->use_store || priv->store_failed)
+        return NULL;
+
+      if (! gimp_tile_map_store (backend_plugin))
+        return NULL;
+    }
+
+  tile_size = gegl_tile_backend_get_tile_size (backend);
+
+  tile = gegl_tile_new_bare ();
 
-  if (! gp_tile_data_write (_gimp_plug_in_get_write_channel (plug_in),
-                            &tile_data, plug_in))
+  gegl_tile_set_data_full (tile,
+                           priv->store->data +
+                           (gsize) gimp_tile->tile_num * tile_size,
+                           tile_size,
+                           (GDestroyNotify) gimp_tile_store_unref,
+                           gimp_tile_store_ref (priv->store));
+
+  return tile;
+}
+
+static gboolean
+gimp_tile_map_store (GimpTileBackendPlugin *backend_plugin)
+{
+  GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
+  GeglTileBackend              *backend = GEGL_TILE_BACKEND (backend_plugin);
+  GimpPlugIn                   *plug_in = gimp_get_plug_in ();
+  GPDrawableStoreReq            store_req;
+  GPDrawableStore              *drawable_store;
+  GimpWireMessage               msg;
+  gsize                         size;
+  guchar                       *data = NULL;
+
+  gimp_tile_commit (backend_plugin);
+
+  store_req.drawable_id = priv->drawable_id;
+  store_req.shadow      = priv->shadow;
+
+  if (! gp_drawable_store_req_write (_gimp_plug_in_get_write_channel (plug_in),
+                                     &store_req, plug_in))
     gimp_quit ();
 
-  if (! tile_info->use_shm)
-    tile_data.data = NULL;
+  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_DRAWABLE_STORE);
+
+  drawable_store = msg.data;
+
+  if (drawable_store->drawable_id != priv->drawable_id ||
+      drawable_store->shadow      != priv->shadow      ||
+      drawable_store->bpp         != priv->bpp         ||
+      drawable_store->width       != priv->width       ||
+      drawable_store->height      != priv->height)
+    {
+      g_printerr ("received tile info did not match computed tile info");
+      gimp_quit ();
+    }
+
+  size = (gsize) gegl_tile_backend_get_tile_size (backend) *
+         priv->ntile_rows * priv->ntile_cols;
+
+  if (drawable_store->store_id != -1)
+    {
+      data = _gimp_shm_map_store (drawable_store->store_id, size);
+
+      /*  the core releases the store once it's mapped  */
+      if (! gp_tile_ack_write (_gimp_plug_in_get_write_channel (plug_in),
+                               plug_in))
+        gimp_quit ();
+    }
 
   gimp_wire_destroy (&msg);
 
+  if (! data)
+    {
+      priv->store_failed = TRUE;
+
+      return FALSE;
+    }
+
+  priv->store            = g_slice_new (GimpTileStore);
+  priv->store->ref_count = 1;
+  priv->store->data      = data;
+  priv->store->size      = size;
+  priv->store_serial     = g_atomic_int_get (&backend_plugin_prefetch_serial);
+
+  return TRUE;
+}
+
+static void
+gimp_tile_drop_store (GimpTileBackendPlugin *backend_plugin)
+{
+  g_clear_pointer (&backend_plugin->priv->store, gimp_tile_store_unref);
+}
+
+static GimpTileStore *
+gimp_tile_store_ref (GimpTileStore *store)
+{
+  g_atomic_int_inc (&store->ref_count);
+
+  return store;
+}
+
+static void
+gimp_tile_store_unref (GimpTileStore *store)
+{
+  if (g_atomic_int_dec_and_test (&store->ref_count))
+    {
+      _gimp_shm_unmap_store (store->data, store->size);
+
+      g_slice_free (GimpTileStore, store);
+    }
+}
+
+/*  takes ownership of @gimp_tile's data, and commits the written tiles
+ *  once there are enough of them
+ */
+static void
+gimp_tile_queue_write (GimpTileBackendPlugin *backend_plugin,
+                       GimpTile              *gimp_tile)
+{
+  GimpTileBackendPluginPrivate *priv = backend_plugin->priv;
+  gint                          i;
+
+  for (i = 0; i < priv->n_pending; i++)
+    {
+      if (priv->pending[i].tile_num == gimp_tile->tile_num)
+        {
+          gimp_tile_unset (backend_plugin, &priv->pending[i]);
+
+          priv->pending[i] = *gimp_tile;
+
+          return;
+        }
+    }
+
+  if (priv->n_pending == 0)
+    backend_plugin_pending = g_list_prepend (backend_plugin_pending,
+                                             backend_plugin);
+
+  priv->pending[priv->n_pending++] = *gimp_tile;
+
+  if (priv->n_pending == GP_TILE_BATCH_MAX_TILES)
+    gimp_tile_commit (backend_plugin);
+}
+
+/*  sends all the written tiles to the core in a single
+ *  GP_TILE_BATCH_DATA.  like gimp_tile_put() used to, it first asks
+ *  the core for permission with a GP_TILE_BATCH_REQ for drawable -1,
+ *  the shared memory segment is only written while the core waits for
+ *  the data.
+ */
+static void
+gimp_tile_commit (GimpTileBackendPlugin *backend_plugin)
+{
+  GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
+  GimpPlugIn                   *plug_in = gimp_get_plug_in ();
+  GPTileBatchReq                batch_req;
+  GPTileBatchData              *batch_info;
+  GPTileBatchData               batch_data;
+  GPTileBatchTile               tiles[GP_TILE_BATCH_MAX_TILES];
+  GimpWireMessage               msg;
+  guchar                       *shm_data = NULL;
+  gint                          i;
+
+  if (priv->n_pending == 0)
+    return;
+
+  batch_req.drawable_id = -1;
+  batch_req.shadow      = 0;
+  batch_req.n_tiles     = 0;
+  batch_req.tile_nums   = NULL;
+
+  if (! gp_tile_batch_req_write (_gimp_plug_in_get_write_channel (plug_in),
+                                 &batch_req, plug_in))
+    gimp_quit ();
+
+  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_BATCH_DATA);
+
+  batch_info = msg.data;
+
+  if (batch_info->use_shm)
+    shm_data = _gimp_shm_addr ();
+
+  gimp_wire_destroy (&msg);
+
+  batch_data.drawable_id = priv->drawable_id;
+  batch_data.shadow      = priv->shadow;
+  batch_data.bpp         = priv->bpp;
+  batch_data.use_shm     = (shm_data != NULL);
+  batch_data.n_tiles     = priv->n_pending;
+  batch_data.tiles       = tiles;
+
+  for (i = 0; i < priv->n_pending; i++)
+    {
+      GimpTile *gimp_tile = &priv->pending[i];
+      gsize     length;
+
+      length = gimp_tile->ewidth * gimp_tile->eheight * priv->bpp;
+
+      tiles[i].tile_num = gimp_tile->tile_num;
+      tiles[i].width    = gimp_tile->ewidth;
+      tiles[i].height   = gimp_tile->eheight;
+      tiles[i].data     = NULL;
+
+      if (batch_data.use_shm)
+        {
+          memcpy (shm_data, gimp_tile->data, length);
+          shm_data += length;
+        }
+      else
+        {
+          tiles[i].data = gimp_tile->data;
+        }
+    }
+
+  if (! gp_tile_batch_data_write (_gimp_plug_in_get_write_channel (plug_in),
+                                  &batch_data, plug_in))
+    gimp_quit ();
+
+  for (i = 0; i < priv->n_pending; i++)
+    gimp_tile_unset (backend_plugin, &priv->pending[i]);
+
+  priv->n_pending = 0;
+
+  backend_plugin_pending = g_list_remove (backend_plugin_pending,
+                                          backend_plugin);
+
   _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_ACK);
 
   gimp_wire_destroy (&msg);
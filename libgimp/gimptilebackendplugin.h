@@ -53,7 +53,10 @@ struct _GimpTileBackendPluginClass
 GType             _gimp_tile_backend_plugin_get_type (void) G_GNUC_CONST;
 
 GeglTileBackend * _gimp_tile_backend_plugin_new      (GimpDrawable *drawable,
-                                                      gint          shadow);
+                                                      gint          shadow,
+                                                      gboolean      use_store);
+
+void              _gimp_tile_backend_plugin_invalidate (void);
 
 G_END_DECLS
 
@@ -129,9 +129,15 @@ enum
   ARCH_X86_INTEL_FEATURE_SSSE3    = 1 << 9,
   ARCH_X86_INTEL_FEATURE_SSE4_1   = 1 << 19,
   ARCH_X86_INTEL_FEATURE_SSE4_2   = 1 << 20,
+  ARCH_X86_INTEL_FEATURE_OSXSAVE  = 1 << 27,
   ARCH_X86_INTEL_FEATURE_AVX      = 1 << 28
 };
 
+enum
+{
+  ARCH_X86_INTEL_FEATURE_AVX2     = 1 << 5
+};
+
 #if !defined(ARCH_X86_64) && (defined(PIC) || defined(__PIC__))
 #define cpuid(op,eax,ebx,ecx,edx)  \
   __asm__ ("movl %%ebx, %%esi\n\t" \
@@ -142,6 +148,16 @@ enum
              "=c" (ecx),           \
              "=d" (edx)            \
            : "0" (op))
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
+  __asm__ ("movl %%ebx, %%esi\n\t"            \
+           "cpuid\n\t"                        \
+           "xchgl %%ebx,%%esi"                \
+           : "=a" (eax),                      \
+             "=S" (ebx),                      \
+             "=c" (ecx),                      \
+             "=d" (edx)                       \
+           : "0" (op),                        \
+             "2" (count))
 #else
 #define cpuid(op,eax,ebx,ecx,edx)  \
   __asm__ ("cpuid"                 \
@@ -150,6 +166,14 @@ enum
              "=c" (ecx),           \
              "=d" (edx)            \
            : "0" (op))
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
+  __asm__ ("cpuid"                            \
+           : "=a" (eax),                      \
+             "=b" (ebx),                      \
+             "=c" (ecx),                      \
+             "=d" (edx)                       \
+           : "0" (op),                        \
+             "2" (count))
 #endif
 
 
@@ -230,6 +254,22 @@ arch_get_vendor (void)
   return ARCH_X86_VENDOR_UNKNOWN;
 }
 
+#ifdef USE_SSE
+static gboolean
+arch_accel_avx_os_support (void)
+{
+  guint32 eax, edx;
+
+  /*  XCR0 must have both the sse and the avx state enabled  */
+  __asm__ ("xgetbv"
+           : "=a" (eax),
+             "=d" (edx)
+           : "c" (0));
+
+  return (eax & 0x6) == 0x6;
+}
+#endif /* USE_SSE */
+
 static guint32
 arch_accel_intel (void)
 {
@@ -267,6 +307,22 @@ arch_accel_intel (void)
 
     if (ecx & ARCH_X86_INTEL_FEATURE_AVX)
       caps |= GIMP_CPU_ACCEL_X86_AVX;
+
+    /*  AVX2 needs the OS to save the full ymm registers, too  */
+    if ((ecx & ARCH_X86_INTEL_FEATURE_AVX)     &&
+        (ecx & ARCH_X86_INTEL_FEATURE_OSXSAVE) &&
+        arch_accel_avx_os_support ())
+      {
+        cpuid (0, eax, ebx, ecx, edx);
+
+        if (eax >= 7)
+          {
+            cpuid_count (7, 0, eax, ebx, ecx, edx);
+
+            if (ebx & ARCH_X86_INTEL_FEATURE_AVX2)
+              caps |= GIMP_CPU_ACCEL_X86_AVX2;
+          }
+      }
 #endif /* USE_SSE */
   }
 #endif /* USE_MMX */
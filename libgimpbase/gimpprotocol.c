@@ -71,6 +71,38 @@ static void _gp_tile_data_write          (GIOChannel       *channel,
                                           gpointer          user_data);
 static void _gp_tile_data_destroy        (GimpWireMessage  *msg);
 
+static void _gp_tile_batch_req_read      (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_batch_req_write     (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_batch_req_destroy   (GimpWireMessage  *msg);
+
+static void _gp_tile_batch_data_read     (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_batch_data_write    (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_batch_data_destroy  (GimpWireMessage  *msg);
+
+static void _gp_drawable_store_req_read    (GIOChannel       *channel,
+                                            GimpWireMessage  *msg,
+                                            gpointer          user_data);
+static void _gp_drawable_store_req_write   (GIOChannel       *channel,
+                                            GimpWireMessage  *msg,
+                                            gpointer          user_data);
+static void _gp_drawable_store_req_destroy (GimpWireMessage  *msg);
+
+static void _gp_drawable_store_read      (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_drawable_store_write     (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_drawable_store_destroy   (GimpWireMessage  *msg);
+
 static void _gp_proc_run_read            (GIOChannel       *channel,
                                           GimpWireMessage  *msg,
                                           gpointer          user_data);
@@ -147,6 +179,14 @@ static void _gp_has_init_write           (GIOChannel       *channel,
                                           gpointer          user_data);
 static void _gp_has_init_destroy         (GimpWireMessage  *msg);
 
+static void _gp_reusable_read            (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_reusable_write           (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_reusable_destroy         (GimpWireMessage  *msg);
+
 
 
 void
@@ -204,6 +244,26 @@ gp_init (void)
                       _gp_has_init_read,
                       _gp_has_init_write,
                       _gp_has_init_destroy);
+  gimp_wire_register (GP_TILE_BATCH_REQ,
+                      _gp_tile_batch_req_read,
+                      _gp_tile_batch_req_write,
+                      _gp_tile_batch_req_destroy);
+  gimp_wire_register (GP_TILE_BATCH_DATA,
+                      _gp_tile_batch_data_read,
+                      _gp_tile_batch_data_write,
+                      _gp_tile_batch_data_destroy);
+  gimp_wire_register (GP_DRAWABLE_STORE_REQ,
+                      _gp_drawable_store_req_read,
+                      _gp_drawable_store_req_write,
+                      _gp_drawable_store_req_destroy);
+  gimp_wire_register (GP_DRAWABLE_STORE,
+                      _gp_drawable_store_read,
+                      _gp_drawable_store_write,
+                      _gp_drawable_store_destroy);
+  gimp_wire_register (GP_REUSABLE,
+                      _gp_reusable_read,
+                      _gp_reusable_write,
+                      _gp_reusable_destroy);
 }
 
 /* public writing API */
@@ -301,6 +361,82 @@ gp_tile_data_write (GIOChannel *channel,
   return TRUE;
 }
 
+gboolean
+gp_tile_batch_req_write (GIOChannel     *channel,
+                         GPTileBatchReq *tile_batch_req,
+                         gpointer        user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILE_BATCH_REQ;
+  msg.data = tile_batch_req;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_tile_batch_data_write (GIOChannel      *channel,
+                          GPTileBatchData *tile_batch_data,
+                          gpointer         user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILE_BATCH_DATA;
+  msg.data = tile_batch_data;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_drawable_store_req_write (GIOChannel         *channel,
+                             GPDrawableStoreReq *drawable_store_req,
+                             gpointer            user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_DRAWABLE_STORE_REQ;
+  msg.data = drawable_store_req;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_drawable_store_write (GIOChannel      *channel,
+                         GPDrawableStore *drawable_store,
+                         gpointer         user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_DRAWABLE_STORE;
+  msg.data = drawable_store;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
 gboolean
 gp_proc_run_write (GIOChannel *channel,
                    GPProcRun  *proc_run,
@@ -451,6 +587,24 @@ gp_has_init_write (GIOChannel *channel,
   return TRUE;
 }
 
+gboolean
+gp_reusable_write (GIOChannel *channel,
+                   gpointer    user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_REUSABLE;
+  msg.data = NULL;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
 /*  quit  */
 
 static void
@@ -926,6 +1080,357 @@ _gp_tile_data_destroy (GimpWireMessage *msg)
     }
 }
 
+/*  tile_batch_req  */
+
+static void
+_gp_tile_batch_req_read (GIOChannel      *channel,
+                         GimpWireMessage *msg,
+                         gpointer         user_data)
+{
+  GPTileBatchReq *tile_batch_req = g_slice_new0 (GPTileBatchReq);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tile_batch_req->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch_req->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch_req->n_tiles, 1, user_data))
+    goto cleanup;
+
+  if (tile_batch_req->n_tiles > GP_TILE_BATCH_MAX_TILES)
+    {
+      _gimp_wire_set_error ();
+      goto cleanup;
+    }
+
+  tile_batch_req->tile_nums = g_new (guint32, tile_batch_req->n_tiles);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               tile_batch_req->tile_nums,
+                               tile_batch_req->n_tiles, user_data))
+    goto cleanup;
+
+  msg->data = tile_batch_req;
+  return;
+
+ cleanup:
+  g_free (tile_batch_req->tile_nums);
+  g_slice_free (GPTileBatchReq, tile_batch_req);
+  msg->data = NULL;
+}
+
+static void
+_gp_tile_batch_req_write (GIOChannel      *channel,
+                          GimpWireMessage *msg,
+                          gpointer         user_data)
+{
+  GPTileBatchReq *tile_batch_req = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tile_batch_req->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch_req->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch_req->n_tiles, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                tile_batch_req->tile_nums,
+                                tile_batch_req->n_tiles, user_data))
+    return;
+}
+
+static void
+_gp_tile_batch_req_destroy (GimpWireMessage *msg)
+{
+  GPTileBatchReq *tile_batch_req = msg->data;
+
+  if (tile_batch_req)
+    {
+      g_free (tile_batch_req->tile_nums);
+
+      g_slice_free (GPTileBatchReq, tile_batch_req);
+    }
+}
+
+/*  tile_batch_data  */
+
+static void
+_gp_tile_batch_data_read (GIOChannel      *channel,
+                          GimpWireMessage *msg,
+                          gpointer         user_data)
+{
+  GPTileBatchData *tile_batch_data = g_slice_new0 (GPTileBatchData);
+  gint             i;
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tile_batch_data->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch_data->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch_data->bpp, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch_data->use_shm, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch_data->n_tiles, 1, user_data))
+    goto cleanup;
+
+  if (tile_batch_data->n_tiles > GP_TILE_BATCH_MAX_TILES)
+    {
+      _gimp_wire_set_error ();
+      goto cleanup;
+    }
+
+  tile_batch_data->tiles = g_new0 (GPTileBatchTile, tile_batch_data->n_tiles);
+
+  for (i = 0; i < tile_batch_data->n_tiles; i++)
+    {
+      GPTileBatchTile *tile = &tile_batch_data->tiles[i];
+
+      if (! _gimp_wire_read_int32 (channel,
+                                   &tile->tile_num, 1, user_data))
+        goto cleanup;
+      if (! _gimp_wire_read_int32 (channel,
+                                   &tile->width, 1, user_data))
+        goto cleanup;
+      if (! _gimp_wire_read_int32 (channel,
+                                   &tile->height, 1, user_data))
+        goto cleanup;
+
+      if (! tile_batch_data->use_shm)
+        {
+          guint length = tile->width * tile->height * tile_batch_data->bpp;
+
+          tile->data = g_new (guchar, length);
+
+          if (! _gimp_wire_read_int8 (channel,
+                                      (guint8 *) tile->data, length,
+                                      user_data))
+            goto cleanup;
+        }
+    }
+
+  msg->data = tile_batch_data;
+  return;
+
+ cleanup:
+  if (tile_batch_data->tiles)
+    {
+      for (i = 0; i < tile_batch_data->n_tiles; i++)
+        g_free (tile_batch_data->tiles[i].data);
+
+      g_free (tile_batch_data->tiles);
+    }
+
+  g_slice_free (GPTileBatchData, tile_batch_data);
+  msg->data = NULL;
+}
+
+static void
+_gp_tile_batch_data_write (GIOChannel      *channel,
+                           GimpWireMessage *msg,
+                           gpointer         user_data)
+{
+  GPTileBatchData *tile_batch_data = msg->data;
+  gint             i;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tile_batch_data->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch_data->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch_data->bpp, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch_data->use_shm, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch_data->n_tiles, 1, user_data))
+    return;
+
+  for (i = 0; i < tile_batch_data->n_tiles; i++)
+    {
+      GPTileBatchTile *tile = &tile_batch_data->tiles[i];
+
+      if (! _gimp_wire_write_int32 (channel,
+                                    &tile->tile_num, 1, user_data))
+        return;
+      if (! _gimp_wire_write_int32 (channel,
+                                    &tile->width, 1, user_data))
+        return;
+      if (! _gimp_wire_write_int32 (channel,
+                                    &tile->height, 1, user_data))
+        return;
+
+      if (! tile_batch_data->use_shm)
+        {
+          guint length = tile->width * tile->height * tile_batch_data->bpp;
+
+          if (! _gimp_wire_write_int8 (channel,
+                                       (const guint8 *) tile->data, length,
+                                       user_data))
+            return;
+        }
+    }
+}
+
+static void
+_gp_tile_batch_data_destroy (GimpWireMessage *msg)
+{
+  GPTileBatchData *tile_batch_data = msg->data;
+
+  if (tile_batch_data)
+    {
+      gint i;
+
+      for (i = 0; i < tile_batch_data->n_tiles; i++)
+        g_free (tile_batch_data->tiles[i].data);
+
+      g_free (tile_batch_data->tiles);
+
+      g_slice_free (GPTileBatchData, tile_batch_data);
+    }
+}
+
+/*  drawable_store_req  */
+
+static void
+_gp_drawable_store_req_read (GIOChannel      *channel,
+                             GimpWireMessage *msg,
+                             gpointer         user_data)
+{
+  GPDrawableStoreReq *drawable_store_req = g_slice_new0 (GPDrawableStoreReq);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &drawable_store_req->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &drawable_store_req->shadow, 1, user_data))
+    goto cleanup;
+
+  msg->data = drawable_store_req;
+  return;
+
+ cleanup:
+  g_slice_free (GPDrawableStoreReq, drawable_store_req);
+  msg->data = NULL;
+}
+
+static void
+_gp_drawable_store_req_write (GIOChannel      *channel,
+                              GimpWireMessage *msg,
+                              gpointer         user_data)
+{
+  GPDrawableStoreReq *drawable_store_req = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &drawable_store_req->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &drawable_store_req->shadow, 1, user_data))
+    return;
+}
+
+static void
+_gp_drawable_store_req_destroy (GimpWireMessage *msg)
+{
+  GPDrawableStoreReq *drawable_store_req = msg->data;
+
+  if (drawable_store_req)
+    g_slice_free (GPDrawableStoreReq, drawable_store_req);
+}
+
+/*  drawable_store  */
+
+static void
+_gp_drawable_store_read (GIOChannel      *channel,
+                         GimpWireMessage *msg,
+                         gpointer         user_data)
+{
+  GPDrawableStore *drawable_store = g_slice_new0 (GPDrawableStore);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &drawable_store->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &drawable_store->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &drawable_store->bpp, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &drawable_store->width, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &drawable_store->height, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &drawable_store->store_id, 1,
+                               user_data))
+    goto cleanup;
+
+  msg->data = drawable_store;
+  return;
+
+ cleanup:
+  g_slice_free (GPDrawableStore, drawable_store);
+  msg->data = NULL;
+}
+
+static void
+_gp_drawable_store_write (GIOChannel      *channel,
+                          GimpWireMessage *msg,
+                          gpointer         user_data)
+{
+  GPDrawableStore *drawable_store = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &drawable_store->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &drawable_store->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &drawable_store->bpp, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &drawable_store->width, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &drawable_store->height, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &drawable_store->store_id, 1,
+                                user_data))
+    return;
+}
+
+static void
+_gp_drawable_store_destroy (GimpWireMessage *msg)
+{
+  GPDrawableStore *drawable_store = msg->data;
+
+  if (drawable_store)
+    g_slice_free (GPDrawableStore, drawable_store);
+}
+
 /*  proc_run  */
 
 static void
@@ -2525,3 +3030,24 @@ static void
 _gp_has_init_destroy (GimpWireMessage *msg)
 {
 }
+
+/* reusable */
+
+static void
+_gp_reusable_read (GIOChannel      *channel,
+                   GimpWireMessage *msg,
+                   gpointer         user_data)
+{
+}
+
+static void
+_gp_reusable_write (GIOChannel      *channel,
+                    GimpWireMessage *msg,
+                    gpointer         user_data)
+{
+}
+
+static void
+_gp_reusable_destroy (GimpWireMessage *msg)
+{
+}
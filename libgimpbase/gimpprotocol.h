@@ -26,7 +26,13 @@ G_BEGIN_DECLS
 
 /* Increment every time the protocol changes
  */
-#define GIMP_PROTOCOL_VERSION  0x0115
+#define GIMP_PROTOCOL_VERSION  0x0119
+
+
+/* The maximum number of tiles requested by a single GP_TILE_BATCH_REQ.
+ * The shared memory segment is large enough to hold as many tiles.
+ */
+#define GP_TILE_BATCH_MAX_TILES  16
 
 
 enum
@@ -43,7 +49,12 @@ enum
   GP_PROC_INSTALL,
   GP_PROC_UNINSTALL,
   GP_EXTENSION_ACK,
-  GP_HAS_INIT
+  GP_HAS_INIT,
+  GP_TILE_BATCH_REQ,
+  GP_TILE_BATCH_DATA,
+  GP_DRAWABLE_STORE_REQ,
+  GP_DRAWABLE_STORE,
+  GP_REUSABLE
 };
 
 typedef enum
@@ -88,6 +99,11 @@ typedef struct _GPConfig                 GPConfig;
 typedef struct _GPTileReq                GPTileReq;
 typedef struct _GPTileAck                GPTileAck;
 typedef struct _GPTileData               GPTileData;
+typedef struct _GPTileBatchReq           GPTileBatchReq;
+typedef struct _GPTileBatchTile          GPTileBatchTile;
+typedef struct _GPTileBatchData          GPTileBatchData;
+typedef struct _GPDrawableStoreReq       GPDrawableStoreReq;
+typedef struct _GPDrawableStore          GPDrawableStore;
 typedef struct _GPParamDef               GPParamDef;
 typedef struct _GPParamDefInt            GPParamDefInt;
 typedef struct _GPParamDefUnit           GPParamDefUnit;
@@ -177,6 +193,57 @@ struct _GPTileData
   guchar  *data;
 };
 
+struct _GPTileBatchReq
+{
+  gint32   drawable_id;
+  guint32  shadow;
+  guint32  n_tiles;
+  guint32 *tile_nums;
+};
+
+struct _GPTileBatchTile
+{
+  guint32  tile_num;
+  guint32  width;
+  guint32  height;
+  guchar  *data;
+};
+
+/* If use_shm is set, the tiles' data is stored one after the other
+ * in the shared memory segment, and their data pointers are NULL.
+ */
+struct _GPTileBatchData
+{
+  gint32           drawable_id;
+  guint32          shadow;
+  guint32          bpp;
+  guint32          use_shm;
+  guint32          n_tiles;
+  GPTileBatchTile *tiles;
+};
+
+struct _GPDrawableStoreReq
+{
+  gint32   drawable_id;
+  guint32  shadow;
+};
+
+/* The drawable store is a shared memory segment holding a copy of all
+ * the drawable's tiles in row-major order.  Every tile takes the space
+ * of a full tile, partial tiles at the right and bottom edges use the
+ * rowstride of a full tile.  store_id is -1 if no store could be
+ * created.
+ */
+struct _GPDrawableStore
+{
+  gint32   drawable_id;
+  guint32  shadow;
+  guint32  bpp;
+  guint32  width;
+  guint32  height;
+  gint32   store_id;
+};
+
 struct _GPParamDefInt
 {
   gint64 min_val;
@@ -395,6 +462,18 @@ gboolean  gp_tile_ack_write         (GIOChannel      *channel,
 gboolean  gp_tile_data_write        (GIOChannel      *channel,
                                      GPTileData      *tile_data,
                                      gpointer         user_data);
+gboolean  gp_tile_batch_req_write   (GIOChannel      *channel,
+                                     GPTileBatchReq  *tile_batch_req,
+                                     gpointer         user_data);
+gboolean  gp_tile_batch_data_write  (GIOChannel      *channel,
+                                     GPTileBatchData *tile_batch_data,
+                                     gpointer         user_data);
+gboolean  gp_drawable_store_req_write (GIOChannel         *channel,
+                                       GPDrawableStoreReq *drawable_store_req,
+                                       gpointer            user_data);
+gboolean  gp_drawable_store_write   (GIOChannel      *channel,
+                                     GPDrawableStore *drawable_store,
+                                     gpointer         user_data);
 gboolean  gp_proc_run_write         (GIOChannel      *channel,
                                      GPProcRun       *proc_run,
                                      gpointer         user_data);
@@ -417,6 +496,8 @@ gboolean  gp_extension_ack_write    (GIOChannel      *channel,
                                      gpointer         user_data);
 gboolean  gp_has_init_write         (GIOChannel      *channel,
                                      gpointer         user_data);
+gboolean  gp_reusable_write         (GIOChannel      *channel,
+                                     gpointer         user_data);
 
 
 G_END_DECLS
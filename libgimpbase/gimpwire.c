@@ -22,11 +22,25 @@
 
 #include <glib-object.h>
 
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <sys/uio.h>
+#endif
+
 #include <libgimpcolor/gimpcolortypes.h>
 
 #include "gimpwire.h"
 
 
+/*  Writes which don't fit into the buffer anymore are not copied, they
+ *  are written out together with the buffered data in a single call.
+ */
+#define GIMP_WIRE_BUFFER_SIZE  8192
+
+/*  Number of array elements converted to network byte order at once  */
+#define GIMP_WIRE_CHUNK_SIZE   256
+
+
 typedef struct _GimpWireHandler  GimpWireHandler;
 
 struct _GimpWireHandler
@@ -37,6 +51,12 @@ struct _GimpWireHandler
   GimpWireDestroyFunc destroy_func;
 };
 
+struct _GimpWireBuffer
+{
+  guint8 data[GIMP_WIRE_BUFFER_SIZE];
+  gsize  length;
+};
+
 
 static GHashTable        *wire_ht         = NULL;
 static GimpWireIOFunc     wire_read_func  = NULL;
@@ -45,7 +65,15 @@ static GimpWireFlushFunc  wire_flush_func = NULL;
 static gboolean           wire_error_val  = FALSE;
 
 
-static void  gimp_wire_init (void);
+static void      gimp_wire_init         (void);
+static gboolean  gimp_wire_write_chars  (GIOChannel   *channel,
+                                         const guint8 *buf,
+                                         gsize         count);
+static gboolean  gimp_wire_write_vector (GIOChannel   *channel,
+                                         const guint8 *buf1,
+                                         gsize         count1,
+                                         const guint8 *buf2,
+                                         gsize         count2);
 
 
 void
@@ -173,45 +201,10 @@ gimp_wire_write (GIOChannel   *channel,
           return FALSE;
         }
     }
-  else
+  else if (! gimp_wire_write_chars (channel, buf, count))
     {
-      GIOStatus  status;
-      GError    *error = NULL;
-      gsize      bytes;
-
-      while (count > 0)
-        {
-          do
-            {
-              bytes = 0;
-              status = g_io_channel_write_chars (channel,
-                                                 (const gchar *) buf, count,
-                                                 &bytes,
-                                                 &error);
-            }
-          while (G_UNLIKELY (status == G_IO_STATUS_AGAIN));
-
-          if (G_UNLIKELY (status != G_IO_STATUS_NORMAL))
-            {
-              if (error)
-                {
-                  g_warning ("%s: gimp_wire_write(): error: %s",
-                             g_get_prgname (), error->message);
-                  g_error_free (error);
-                }
-              else
-                {
-                  g_warning ("%s: gimp_wire_write(): error",
-                             g_get_prgname ());
-                }
-
-              wire_error_val = TRUE;
-              return FALSE;
-            }
-
-          count -= bytes;
-          buf += bytes;
-        }
+      wire_error_val = TRUE;
+      return FALSE;
     }
 
   return TRUE;
@@ -227,6 +220,68 @@ gimp_wire_flush (GIOChannel *channel,
   return FALSE;
 }
 
+GimpWireBuffer *
+gimp_wire_buffer_new (void)
+{
+  return g_slice_new0 (GimpWireBuffer);
+}
+
+void
+gimp_wire_buffer_free (GimpWireBuffer *buffer)
+{
+  if (buffer)
+    g_slice_free (GimpWireBuffer, buffer);
+}
+
+/*  Appends @buf to @buffer.  If it doesn't fit, the buffered data and
+ *  @buf are written to @channel at once, so large writes like tile data
+ *  are neither copied nor split into many small writes.
+ */
+gboolean
+gimp_wire_buffer_write (GimpWireBuffer *buffer,
+                        GIOChannel     *channel,
+                        const guint8   *buf,
+                        gsize           count)
+{
+  g_return_val_if_fail (buffer != NULL, FALSE);
+
+  if (buffer->length + count <= GIMP_WIRE_BUFFER_SIZE)
+    {
+      memcpy (buffer->data + buffer->length, buf, count);
+      buffer->length += count;
+
+      return TRUE;
+    }
+
+  if (! gimp_wire_write_vector (channel,
+                                buffer->data, buffer->length,
+                                buf, count))
+    return FALSE;
+
+  buffer->length = 0;
+
+  return TRUE;
+}
+
+gboolean
+gimp_wire_buffer_flush (GimpWireBuffer *buffer,
+                        GIOChannel     *channel)
+{
+  g_return_val_if_fail (buffer != NULL, FALSE);
+
+  if (buffer->length > 0)
+    {
+      if (! gimp_wire_write_vector (channel,
+                                    buffer->data, buffer->length,
+                                    NULL, 0))
+        return FALSE;
+
+      buffer->length = 0;
+    }
+
+  return TRUE;
+}
+
 gboolean
 gimp_wire_error (void)
 {
@@ -310,6 +365,15 @@ gimp_wire_destroy (GimpWireMessage *msg)
   (* handler->destroy_func) (msg);
 }
 
+/*  called by the message readers when a message is malformed, so that
+ *  reading it fails like a broken connection
+ */
+void
+_gimp_wire_set_error (void)
+{
+  wire_error_val = TRUE;
+}
+
 gboolean
 _gimp_wire_read_int64 (GIOChannel *channel,
                        guint64    *data,
@@ -541,18 +605,21 @@ _gimp_wire_write_int64 (GIOChannel    *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
+  while (count > 0)
     {
-      gint i;
+      guint64 tmp[GIMP_WIRE_CHUNK_SIZE];
+      gint    n = MIN (count, GIMP_WIRE_CHUNK_SIZE);
+      gint    i;
 
-      for (i = 0; i < count; i++)
-        {
-          guint64 tmp = GUINT64_TO_BE (data[i]);
+      for (i = 0; i < n; i++)
+        tmp[i] = GUINT64_TO_BE (data[i]);
 
-          if (! _gimp_wire_write_int8 (channel,
-                                       (const guint8 *) &tmp, 8, user_data))
-            return FALSE;
-        }
+      if (! _gimp_wire_write_int8 (channel,
+                                   (const guint8 *) tmp, n * 8, user_data))
+        return FALSE;
+
+      data  += n;
+      count -= n;
     }
 
   return TRUE;
@@ -566,18 +633,21 @@ _gimp_wire_write_int32 (GIOChannel    *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
+  while (count > 0)
     {
-      gint i;
+      guint32 tmp[GIMP_WIRE_CHUNK_SIZE];
+      gint    n = MIN (count, GIMP_WIRE_CHUNK_SIZE);
+      gint    i;
 
-      for (i = 0; i < count; i++)
-        {
-          guint32 tmp = g_htonl (data[i]);
+      for (i = 0; i < n; i++)
+        tmp[i] = g_htonl (data[i]);
 
-          if (! _gimp_wire_write_int8 (channel,
-                                       (const guint8 *) &tmp, 4, user_data))
-            return FALSE;
-        }
+      if (! _gimp_wire_write_int8 (channel,
+                                   (const guint8 *) tmp, n * 4, user_data))
+        return FALSE;
+
+      data  += n;
+      count -= n;
     }
 
   return TRUE;
@@ -591,18 +661,21 @@ _gimp_wire_write_int16 (GIOChannel    *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
+  while (count > 0)
     {
-      gint i;
+      guint16 tmp[GIMP_WIRE_CHUNK_SIZE];
+      gint    n = MIN (count, GIMP_WIRE_CHUNK_SIZE);
+      gint    i;
 
-      for (i = 0; i < count; i++)
-        {
-          guint16 tmp = g_htons (data[i]);
+      for (i = 0; i < n; i++)
+        tmp[i] = g_htons (data[i]);
 
-          if (! _gimp_wire_write_int8 (channel,
-                                       (const guint8 *) &tmp, 2, user_data))
-            return FALSE;
-        }
+      if (! _gimp_wire_write_int8 (channel,
+                                   (const guint8 *) tmp, n * 2, user_data))
+        return FALSE;
+
+      data  += n;
+      count -= n;
     }
 
   return TRUE;
@@ -625,34 +698,39 @@ _gimp_wire_write_double (GIOChannel    *channel,
                          gint           count,
                          gpointer       user_data)
 {
-  gdouble *t;
-  guint8   tmp[8];
-  gint     i;
+  guint8 tmp[GIMP_WIRE_CHUNK_SIZE * 8];
+  gint   n = 0;
+  gint   i;
 #if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
-  gint     j;
+  gint   j;
 #endif
 
   g_return_val_if_fail (count >= 0, FALSE);
 
-  t = (gdouble *) tmp;
-
   for (i = 0; i < count; i++)
     {
-      *t = data[i];
+      guint8 *t = tmp + n * 8;
+
+      memcpy (t, &data[i], 8);
 
 #if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
       for (j = 0; j < 4; j++)
         {
           guint8 swap;
 
-          swap       = tmp[j];
-          tmp[j]     = tmp[7 - j];
-          tmp[7 - j] = swap;
+          swap     = t[j];
+          t[j]     = t[7 - j];
+          t[7 - j] = swap;
         }
 #endif
 
-      if (! _gimp_wire_write_int8 (channel, tmp, 8, user_data))
-        return FALSE;
+      if (++n == GIMP_WIRE_CHUNK_SIZE || i == count - 1)
+        {
+          if (! _gimp_wire_write_int8 (channel, tmp, n * 8, user_data))
+            return FALSE;
+
+          n = 0;
+        }
 
 #if 0
       {
@@ -661,7 +739,7 @@ _gimp_wire_write_double (GIOChannel    *channel,
         g_print ("Wire representation of %f:\t", data[i]);
 
         for (k = 0; k < 8; k++)
-          g_print ("%02x ", tmp[k]);
+          g_print ("%02x ", t[k]);
 
         g_print ("\n");
       }
@@ -763,3 +841,116 @@ gimp_wire_init (void)
     wire_ht = g_hash_table_new ((GHashFunc) gimp_wire_hash,
                                 (GCompareFunc) gimp_wire_compare);
 }
+
+static gboolean
+gimp_wire_write_chars (GIOChannel   *channel,
+                       const guint8 *buf,
+                       gsize         count)
+{
+  GIOStatus  status;
+  GError    *error = NULL;
+  gsize      bytes;
+
+  while (count > 0)
+    {
+      do
+        {
+          bytes = 0;
+          status = g_io_channel_write_chars (channel,
+                                             (const gchar *) buf, count,
+                                             &bytes,
+                                             &error);
+        }
+      while (G_UNLIKELY (status == G_IO_STATUS_AGAIN));
+
+      if (G_UNLIKELY (status != G_IO_STATUS_NORMAL))
+        {
+          if (error)
+            {
+              g_warning ("%s: gimp_wire_write(): error: %s",
+                         g_get_prgname (), error->message);
+              g_error_free (error);
+            }
+          else
+            {
+              g_warning ("%s: gimp_wire_write(): error",
+                         g_get_prgname ());
+            }
+
+          return FALSE;
+        }
+
+      count -= bytes;
+      buf += bytes;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gimp_wire_write_vector (GIOChannel   *channel,
+                        const guint8 *buf1,
+                        gsize         count1,
+                        const guint8 *buf2,
+                        gsize         count2)
+{
+#ifdef G_OS_UNIX
+  struct iovec  iov[2];
+  struct iovec *vec   = iov;
+  gint          n_vec = 0;
+  gint          fd;
+
+  /*  the channels are unbuffered, so the fd can be written directly  */
+  fd = g_io_channel_unix_get_fd (channel);
+
+  if (count1 > 0)
+    {
+      iov[n_vec].iov_base = (gpointer) buf1;
+      iov[n_vec].iov_len  = count1;
+      n_vec++;
+    }
+
+  if (count2 > 0)
+    {
+      iov[n_vec].iov_base = (gpointer) buf2;
+      iov[n_vec].iov_len  = count2;
+      n_vec++;
+    }
+
+  while (n_vec > 0)
+    {
+      gssize bytes;
+
+      do
+        {
+          bytes = writev (fd, vec, n_vec);
+        }
+      while (G_UNLIKELY (bytes < 0 && (errno == EINTR || errno == EAGAIN)));
+
+      if (G_UNLIKELY (bytes < 0))
+        {
+          g_warning ("%s: gimp_wire_write(): error: %s",
+                     g_get_prgname (), g_strerror (errno));
+          return FALSE;
+        }
+
+      while (n_vec > 0 && (gsize) bytes >= vec->iov_len)
+        {
+          bytes -= vec->iov_len;
+          vec++;
+          n_vec--;
+        }
+
+      if (n_vec > 0)
+        {
+          vec->iov_base  = (guint8 *) vec->iov_base + bytes;
+          vec->iov_len  -= bytes;
+        }
+    }
+
+  return TRUE;
+#else
+  return (gimp_wire_write_chars (channel, buf1, count1) &&
+          gimp_wire_write_chars (channel, buf2, count2));
+#endif
+}
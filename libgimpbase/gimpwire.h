@@ -25,6 +25,7 @@ G_BEGIN_DECLS
 
 
 typedef struct _GimpWireMessage  GimpWireMessage;
+typedef struct _GimpWireBuffer   GimpWireBuffer;
 
 typedef void     (* GimpWireReadFunc)    (GIOChannel      *channel,
                                           GimpWireMessage *msg,
@@ -68,6 +69,15 @@ gboolean  gimp_wire_write         (GIOChannel          *channel,
 gboolean  gimp_wire_flush         (GIOChannel          *channel,
                                    gpointer             user_data);
 
+GimpWireBuffer * gimp_wire_buffer_new   (void);
+void             gimp_wire_buffer_free  (GimpWireBuffer      *buffer);
+gboolean         gimp_wire_buffer_write (GimpWireBuffer      *buffer,
+                                         GIOChannel          *channel,
+                                         const guint8        *buf,
+                                         gsize                count);
+gboolean         gimp_wire_buffer_flush (GimpWireBuffer      *buffer,
+                                         GIOChannel          *channel);
+
 gboolean  gimp_wire_error         (void);
 void      gimp_wire_clear_error   (void);
 
@@ -83,6 +93,8 @@ void      gimp_wire_destroy       (GimpWireMessage     *msg);
 
 /*  for internal use in libgimpbase  */
 
+G_GNUC_INTERNAL void      _gimp_wire_set_error    (void);
+
 G_GNUC_INTERNAL gboolean  _gimp_wire_read_int64   (GIOChannel     *channel,
                                                    guint64        *data,
                                                    gint            count,
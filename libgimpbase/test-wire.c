@@ -0,0 +1,287 @@
+/* A small benchmark for the wire protocol, measuring the throughput of
+ * typical PDB traffic between the core and a plug-in.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib-object.h>
+
+#include "gimpbasetypes.h"
+#include "gimpchoice.h"
+#include "gimpparasite.h"
+#include "gimpprotocol.h"
+#include "gimpwire.h"
+
+
+#define N_MESSAGES   20000
+#define N_IDS        1024
+#define TILE_SIZE    64
+#define TILE_BPP     4
+
+
+typedef struct
+{
+  const gchar *name;
+  gboolean  (* write_func) (GIOChannel *channel,
+                            gpointer    user_data);
+} Traffic;
+
+
+static GimpWireBuffer *buffer        = NULL;
+static guint64         bytes_written = 0;
+
+
+/*  writers  */
+
+static gboolean
+wire_write_direct (GIOChannel   *channel,
+                   const guint8 *buf,
+                   gulong        count,
+                   gpointer      user_data)
+{
+  bytes_written += count;
+
+  while (count > 0)
+    {
+      gssize bytes = write (g_io_channel_unix_get_fd (channel), buf, count);
+
+      if (bytes < 0)
+        return FALSE;
+
+      buf   += bytes;
+      count -= bytes;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+wire_flush_direct (GIOChannel *channel,
+                   gpointer    user_data)
+{
+  return TRUE;
+}
+
+static gboolean
+wire_write_buffered (GIOChannel   *channel,
+                     const guint8 *buf,
+                     gulong        count,
+                     gpointer      user_data)
+{
+  bytes_written += count;
+
+  return gimp_wire_buffer_write (buffer, channel, buf, count);
+}
+
+static gboolean
+wire_flush_buffered (GIOChannel *channel,
+                     gpointer    user_data)
+{
+  return gimp_wire_buffer_flush (buffer, channel);
+}
+
+
+/*  traffic  */
+
+static gboolean
+write_proc_run (GIOChannel *channel,
+                gpointer    user_data)
+{
+  GPProcRun proc_run = { 0, };
+  GPParam   params[12];
+  gint      i;
+
+  memset (params, 0, sizeof (params));
+
+  params[0].param_type    = GP_PARAM_TYPE_INT;
+  params[0].type_name     = "GimpRunMode";
+  params[0].data.d_int    = 1;
+
+  params[1].param_type    = GP_PARAM_TYPE_INT;
+  params[1].type_name     = "GimpImage";
+  params[1].data.d_int    = 1;
+
+  params[2].param_type    = GP_PARAM_TYPE_STRING;
+  params[2].type_name     = "gchararray";
+  params[2].data.d_string = "gegl:gaussian-blur";
+
+  for (i = 3; i < 12; i++)
+    {
+      params[i].param_type    = GP_PARAM_TYPE_DOUBLE;
+      params[i].type_name     = "gdouble";
+      params[i].data.d_double = i * 0.5;
+    }
+
+  proc_run.name     = "plug-in-benchmark";
+  proc_run.n_params = G_N_ELEMENTS (params);
+  proc_run.params   = params;
+
+  return gp_proc_run_write (channel, &proc_run, user_data);
+}
+
+static gboolean
+write_proc_run_ids (GIOChannel *channel,
+                    gpointer    user_data)
+{
+  static gint32 ids[N_IDS];
+  GPProcRun     proc_run = { 0, };
+  GPParam       params[2];
+  gint          i;
+
+  for (i = 0; i < N_IDS; i++)
+    ids[i] = i;
+
+  memset (params, 0, sizeof (params));
+
+  params[0].param_type                = GP_PARAM_TYPE_INT;
+  params[0].type_name                 = "GimpRunMode";
+  params[0].data.d_int                = 1;
+
+  params[1].param_type                = GP_PARAM_TYPE_ID_ARRAY;
+  params[1].type_name                 = "GimpCoreObjectArray";
+  params[1].data.d_id_array.type_name = "GimpLayer";
+  params[1].data.d_id_array.size      = N_IDS;
+  params[1].data.d_id_array.data      = ids;
+
+  proc_run.name     = "plug-in-benchmark";
+  proc_run.n_params = G_N_ELEMENTS (params);
+  proc_run.params   = params;
+
+  return gp_proc_run_write (channel, &proc_run, user_data);
+}
+
+static gboolean
+write_tile_data (GIOChannel *channel,
+                 gpointer    user_data)
+{
+  static guchar data[TILE_SIZE * TILE_SIZE * TILE_BPP];
+  GPTileData    tile_data = { 0, };
+
+  tile_data.drawable_id = 1;
+  tile_data.bpp         = TILE_BPP;
+  tile_data.width       = TILE_SIZE;
+  tile_data.height      = TILE_SIZE;
+  tile_data.use_shm     = FALSE;
+  tile_data.data        = data;
+
+  return gp_tile_data_write (channel, &tile_data, user_data);
+}
+
+
+/*  reader  */
+
+static gpointer
+wire_reader (gpointer data)
+{
+  GIOChannel *channel = data;
+  gint        i;
+
+  for (i = 0; i < N_MESSAGES; i++)
+    {
+      GimpWireMessage msg;
+
+      if (! gimp_wire_read_msg (channel, &msg, NULL))
+        return GINT_TO_POINTER (FALSE);
+
+      gimp_wire_destroy (&msg);
+    }
+
+  return GINT_TO_POINTER (TRUE);
+}
+
+static void
+wire_benchmark (const Traffic *traffic,
+                gboolean       buffered)
+{
+  GIOChannel *read_channel;
+  GIOChannel *write_channel;
+  GThread    *thread;
+  gint64      start_time;
+  gdouble     seconds;
+  gboolean    success = TRUE;
+  gint        fds[2];
+  gint        i;
+
+  if (pipe (fds) != 0)
+    {
+      g_printerr ("  could not create pipe\n");
+      exit (EXIT_FAILURE);
+    }
+
+  read_channel  = g_io_channel_unix_new (fds[0]);
+  write_channel = g_io_channel_unix_new (fds[1]);
+
+  g_io_channel_set_encoding (read_channel, NULL, NULL);
+  g_io_channel_set_encoding (write_channel, NULL, NULL);
+  g_io_channel_set_buffered (write_channel, FALSE);
+
+  if (buffered)
+    {
+      gimp_wire_set_writer (wire_write_buffered);
+      gimp_wire_set_flusher (wire_flush_buffered);
+    }
+  else
+    {
+      gimp_wire_set_writer (wire_write_direct);
+      gimp_wire_set_flusher (wire_flush_direct);
+    }
+
+  bytes_written = 0;
+  start_time    = g_get_monotonic_time ();
+
+  thread = g_thread_new ("wire-reader", wire_reader, read_channel);
+
+  for (i = 0; i < N_MESSAGES && success; i++)
+    success = traffic->write_func (write_channel, NULL);
+
+  if (! GPOINTER_TO_INT (g_thread_join (thread)) || ! success)
+    {
+      g_printerr ("  %-16s: error\n", traffic->name);
+      exit (EXIT_FAILURE);
+    }
+
+  seconds = (g_get_monotonic_time () - start_time) / (gdouble) G_USEC_PER_SEC;
+
+  g_printerr ("  %-16s %-9s: %10.0f msgs/s  %8.1f MiB/s\n",
+              traffic->name, buffered ? "buffered" : "direct",
+              N_MESSAGES / seconds,
+              bytes_written / seconds / (1024.0 * 1024.0));
+
+  g_io_channel_shutdown (read_channel, FALSE, NULL);
+  g_io_channel_shutdown (write_channel, FALSE, NULL);
+  g_io_channel_unref (read_channel);
+  g_io_channel_unref (write_channel);
+}
+
+int
+main (void)
+{
+  const Traffic traffic[] =
+  {
+    { "proc-run",     write_proc_run     },
+    { "proc-run-ids", write_proc_run_ids },
+    { "tile-data",    write_tile_data    }
+  };
+  gint i;
+
+  gp_init ();
+
+  buffer = gimp_wire_buffer_new ();
+
+  g_printerr ("Benchmarking the wire protocol (%d messages each)...\n",
+              N_MESSAGES);
+
+  for (i = 0; i < G_N_ELEMENTS (traffic); i++)
+    {
+      wire_benchmark (&traffic[i], FALSE);
+      wire_benchmark (&traffic[i], TRUE);
+    }
+
+  gimp_wire_buffer_free (buffer);
+
+  return EXIT_SUCCESS;
+}
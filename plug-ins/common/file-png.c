@@ -233,6 +233,10 @@ png_class_init (PngClass *klass)
 static void
 png_init (Png *png)
 {
+  /*  spares the startup of a new process for each file, when
+   *  loading or exporting many of them
+   */
+  gimp_plug_in_set_reusable (GIMP_PLUG_IN (png), TRUE);
 }
 
 static GList *
@@ -1765,6 +1769,9 @@ export_image (GFile        *file,
                 NULL);
 #endif
 
+  /*  left over from the previous export, if the plug-in is reused  */
+  memset (&pngg, 0, sizeof (pngg));
+
   g_object_get (config,
                 "interlaced",            &save_interlaced,
                 "bkgd",                  &save_bkgd,
@@ -1931,7 +1938,7 @@ export_image (GFile        *file,
    * Get the buffer for the current image...
    */
 
-  buffer = gimp_drawable_get_buffer (drawable);
+  buffer = gimp_drawable_get_mapped_buffer (drawable);
   width  = gegl_buffer_get_width (buffer);
   height = gegl_buffer_get_height (buffer);
   type   = gimp_drawable_type (drawable);
@@ -352,7 +352,7 @@ save_layer (TIFF        *tif,
   rowsperstrip = tile_height;
 
   drawable_type = gimp_drawable_type (GIMP_DRAWABLE (layer));
-  buffer        = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  buffer        = gimp_drawable_get_mapped_buffer (GIMP_DRAWABLE (layer));
 
   format = gegl_buffer_get_format (buffer);
   type   = babl_format_get_type (format, 0);